@@ -0,0 +1,423 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+
+#include "AsyncLog.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+static constexpr unsigned DEFAULT_RATE_LIMIT = 200;
+// Longest conversion specification (ex: "%-+08.3lld") that is captured
+static constexpr unsigned MAX_SPEC_LEN = 32;
+
+AsyncLog::AsyncLog(FILE* out)
+:   _out(out),
+    _ring(std::make_unique<MpscRing<Record, RING_SIZE>>()) {
+    for (unsigned i = 0; i < LEVEL_COUNT; i++) {
+        _rateLimit[i].store(DEFAULT_RATE_LIMIT, std::memory_order_relaxed);
+        _rateWindow[i].store(0, std::memory_order_relaxed);
+        _rateCount[i].store(0, std::memory_order_relaxed);
+        _rateDropped[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+AsyncLog::~AsyncLog() {
+    stop();
+}
+
+void AsyncLog::start() {
+    if (_running.load())
+        return;
+    _running.store(true);
+    _writer = std::thread(&AsyncLog::_writerLoop, this);
+}
+
+void AsyncLog::stop() {
+    if (!_running.load())
+        return;
+    _running.store(false);
+    _writer.join();
+    // Anything that slipped in while the writer was stopping
+    Record r;
+    char msg[MAX_LINE_LEN];
+    while (_ring->pop(r)) {
+        _format(r, msg, sizeof(msg));
+        _write(r.timeUs, r.sev, msg);
+    }
+    fflush(_out);
+}
+
+void AsyncLog::setRateLimit(Level level, unsigned perSecond) {
+    _rateLimit[level].store(perSecond, std::memory_order_relaxed);
+}
+
+uint64_t AsyncLog::_nowUs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+AsyncLog::Level AsyncLog::_level(const char* sev) {
+    switch (sev ? sev[0] : 'I') {
+    case 'D': return DEBUG;
+    case 'W': return WARN;
+    case 'E': return ERROR;
+    default: return INFO;
+    }
+}
+
+bool AsyncLog::_allow(Level level, uint64_t nowUs) {
+    const uint32_t limit = _rateLimit[level].load(std::memory_order_relaxed);
+    if (limit == 0)
+        return true;
+    // A fixed one-second window. The reset can race with another
+    // thread's count, which only makes the limit approximate.
+    const uint64_t second = nowUs / 1000000;
+    uint64_t window = _rateWindow[level].load(std::memory_order_relaxed);
+    if (window != second &&
+        _rateWindow[level].compare_exchange_strong(window, second, std::memory_order_relaxed))
+        _rateCount[level].store(0, std::memory_order_relaxed);
+    if (_rateCount[level].fetch_add(1, std::memory_order_relaxed) >= limit) {
+        _rateDropped[level].fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void AsyncLog::_log(const char* sev, const char* fmt, va_list args) {
+
+    const uint64_t nowUs = _nowUs();
+
+    if (!_running.load(std::memory_order_acquire)) {
+        char msg[MAX_LINE_LEN];
+        vsnprintf(msg, sizeof(msg), fmt, args);
+        _write(nowUs, sev, msg);
+        fflush(_out);
+        return;
+    }
+
+    if (!_allow(_level(sev), nowUs))
+        return;
+
+    Record r;
+    r.timeUs = nowUs;
+    r.sev = sev;
+    va_list copy;
+    va_copy(copy, args);
+    if (!_capture(r, fmt, copy)) {
+        // Something unusual in the format, so it gets formatted here
+        // (but still written on the writer thread).
+        vsnprintf(r.strings, sizeof(r.strings), fmt, args);
+        r.fmt = "%s";
+        r.argCount = 1;
+        r.args[0].type = ArgType::STR;
+        r.args[0].strOffset = 0;
+    }
+    va_end(copy);
+
+    if (!_ring->push(r))
+        _fullDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Walks the format and pulls each argument off of the va_list according
+ * to its conversion. Integers are narrowed here as the length modifier
+ * requires and are then stored as long long. Strings are copied.
+ *
+ * @returns false if the format can't be captured (too many arguments,
+ *   not enough string space, %n, wide strings, etc.).
+ */
+bool AsyncLog::_capture(Record& r, const char* fmt, va_list args) {
+
+    r.fmt = fmt;
+    r.argCount = 0;
+    unsigned strUsed = 0;
+    const char* p = fmt;
+
+    auto addInt = [&r](long long v) {
+        if (r.argCount == MAX_ARGS)
+            return false;
+        r.args[r.argCount].type = ArgType::INT;
+        r.args[r.argCount++].i = v;
+        return true;
+    };
+
+    while (*p) {
+        if (*p++ != '%')
+            continue;
+        if (*p == '%') {
+            p++;
+            continue;
+        }
+        const char* specStart = p - 1;
+        while (*p && strchr("-+ #0'", *p))
+            p++;
+        if (*p == '*') {
+            if (!addInt(va_arg(args, int)))
+                return false;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9')
+                p++;
+        }
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                if (!addInt(va_arg(args, int)))
+                    return false;
+                p++;
+            } else {
+                while (*p >= '0' && *p <= '9')
+                    p++;
+            }
+        }
+        // Length modifiers
+        char len0 = 0, len1 = 0;
+        if (*p && strchr("hljztL", *p)) {
+            len0 = *p++;
+            if ((len0 == 'h' || len0 == 'l') && *p == len0)
+                len1 = *p++;
+        }
+        const char conv = *p;
+        if (conv == 0 || (unsigned)(p + 1 - specStart) > MAX_SPEC_LEN || r.argCount == MAX_ARGS)
+            return false;
+        p++;
+
+        Arg& a = r.args[r.argCount];
+        switch (conv) {
+        case 'd': case 'i':
+            a.type = ArgType::INT;
+            if (len0 == 'h')
+                a.i = len1 ? (long long)(signed char)va_arg(args, int) :
+                    (long long)(short)va_arg(args, int);
+            else if (len0 == 'l')
+                a.i = len1 ? va_arg(args, long long) : va_arg(args, long);
+            else if (len0 == 'j')
+                a.i = va_arg(args, intmax_t);
+            else if (len0 == 'z')
+                a.i = (long long)va_arg(args, size_t);
+            else if (len0 == 't')
+                a.i = va_arg(args, ptrdiff_t);
+            else
+                a.i = va_arg(args, int);
+            break;
+        case 'u': case 'o': case 'x': case 'X':
+            a.type = ArgType::UINT;
+            if (len0 == 'h')
+                a.u = len1 ? (unsigned long long)(unsigned char)va_arg(args, unsigned) :
+                    (unsigned long long)(unsigned short)va_arg(args, unsigned);
+            else if (len0 == 'l')
+                a.u = len1 ? va_arg(args, unsigned long long) : va_arg(args, unsigned long);
+            else if (len0 == 'j')
+                a.u = va_arg(args, uintmax_t);
+            else if (len0 == 'z')
+                a.u = va_arg(args, size_t);
+            else if (len0 == 't')
+                a.u = (unsigned long long)va_arg(args, ptrdiff_t);
+            else
+                a.u = va_arg(args, unsigned);
+            break;
+        case 'c':
+            if (len0)
+                return false;
+            a.type = ArgType::INT;
+            a.i = va_arg(args, int);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if (len0 == 'L') {
+                a.type = ArgType::LONG_DOUBLE;
+                a.d = (double)va_arg(args, long double);
+            } else {
+                a.type = ArgType::DOUBLE;
+                a.d = va_arg(args, double);
+            }
+            break;
+        case 'p':
+            a.type = ArgType::PTR;
+            a.p = va_arg(args, void*);
+            break;
+        case 's': {
+            if (len0)
+                return false;
+            const char* s = va_arg(args, const char*);
+            if (!s)
+                s = "(null)";
+            const size_t sLen = strlen(s);
+            if (strUsed + sLen + 1 > MAX_STRING_SPACE)
+                return false;
+            memcpy(r.strings + strUsed, s, sLen + 1);
+            a.type = ArgType::STR;
+            a.strOffset = strUsed;
+            strUsed += sLen + 1;
+            break;
+        }
+        default:
+            // %n and anything we don't know about
+            return false;
+        }
+        r.argCount++;
+    }
+    return true;
+}
+
+/**
+ * Formats a captured record one conversion at a time. Each conversion
+ * is rewritten with the length modifier that matches the captured type.
+ *
+ * @returns The length of the message.
+ */
+unsigned AsyncLog::_format(const Record& r, char* out, unsigned outLen) {
+
+    unsigned pos = 0;
+    unsigned argIx = 0;
+    const char* p = r.fmt;
+
+    auto append = [&pos, out, outLen](int n) {
+        if (n > 0)
+            pos += n;
+        if (pos >= outLen)
+            pos = outLen - 1;
+    };
+
+    while (*p && pos < outLen - 1) {
+        if (*p != '%') {
+            out[pos++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[pos++] = '%';
+            p += 2;
+            continue;
+        }
+        // Build the conversion without its length modifier
+        char spec[MAX_SPEC_LEN + 4];
+        unsigned specLen = 0;
+        int stars[2];
+        unsigned starCount = 0;
+        spec[specLen++] = *p++;
+        while (*p && !strchr("diuoxXcfFeEgGaApsn", *p)) {
+            if (*p == '*' && starCount < 2)
+                stars[starCount++] = (int)r.args[argIx++].i;
+            if (!strchr("hljztL", *p))
+                spec[specLen++] = *p;
+            p++;
+        }
+        const char conv = *p++;
+        const Arg& a = r.args[argIx++];
+        if (a.type == ArgType::INT && conv != 'c') {
+            spec[specLen++] = 'l';
+            spec[specLen++] = 'l';
+        } else if (a.type == ArgType::UINT) {
+            spec[specLen++] = 'l';
+            spec[specLen++] = 'l';
+        } else if (a.type == ArgType::LONG_DOUBLE) {
+            spec[specLen++] = 'L';
+        }
+        spec[specLen++] = conv;
+        spec[specLen] = 0;
+
+        char* o = out + pos;
+        const size_t room = outLen - pos;
+        auto emit = [&](auto v) {
+            if (starCount == 0)
+                return snprintf(o, room, spec, v);
+            else if (starCount == 1)
+                return snprintf(o, room, spec, stars[0], v);
+            else
+                return snprintf(o, room, spec, stars[0], stars[1], v);
+        };
+        switch (a.type) {
+        case ArgType::INT:
+            append((conv == 'c') ? emit((int)a.i) : emit(a.i));
+            break;
+        case ArgType::UINT: append(emit(a.u)); break;
+        case ArgType::DOUBLE: append(emit(a.d)); break;
+        case ArgType::LONG_DOUBLE: append(emit((long double)a.d)); break;
+        case ArgType::PTR: append(emit(a.p)); break;
+        case ArgType::STR: append(emit(r.strings + a.strOffset)); break;
+        }
+    }
+    out[pos] = 0;
+    return pos;
+}
+
+std::string AsyncLog::formatCaptured(const char* fmt, va_list args) {
+    Record r;
+    va_list copy;
+    va_copy(copy, args);
+    const bool ok = _capture(r, fmt, copy);
+    va_end(copy);
+    char msg[MAX_LINE_LEN];
+    if (ok)
+        _format(r, msg, sizeof(msg));
+    else
+        vsnprintf(msg, sizeof(msg), fmt, args);
+    return msg;
+}
+
+void AsyncLog::_write(uint64_t timeUs, const char* sev, const char* msg) {
+    const time_t t = timeUs / 1000000;
+    tm ltm;
+    localtime_r(&t, &ltm);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &ltm);
+    std::lock_guard<std::mutex> lock(_writeLock);
+    fprintf(_out, "%s.%03u %s %s\n", stamp, (unsigned)((timeUs / 1000) % 1000),
+        sev ? sev : "", msg);
+    _written.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncLog::_reportDrops() {
+    uint32_t rate = 0;
+    for (unsigned i = 0; i < LEVEL_COUNT; i++)
+        rate += _rateDropped[i].load(std::memory_order_relaxed);
+    const uint32_t full = _fullDropped.load(std::memory_order_relaxed);
+    if (rate + full == _reportedDrops)
+        return;
+    const uint64_t now = _nowUs();
+    if (_lastDropReportUs != 0 && now - _lastDropReportUs < DROP_REPORT_MS * 1000)
+        return;
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Log dropped %u messages (%u rate limited, %u ring full)",
+        rate + full - _reportedDrops, rate, full);
+    _write(now, "W", msg);
+    _reportedDrops = rate + full;
+    _lastDropReportUs = now;
+}
+
+void AsyncLog::_writerLoop() {
+    char msg[MAX_LINE_LEN];
+    while (_running.load(std::memory_order_acquire)) {
+        const unsigned count = _ring->drain([this, &msg](const Record& r) {
+            _format(r, msg, sizeof(msg));
+            _write(r.timeUs, r.sev, msg);
+        });
+        _reportDrops();
+        if (count)
+            fflush(_out);
+        else
+            std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_SLEEP_MS));
+    }
+}
+
+    }
+}
@@ -0,0 +1,182 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "kc1fsz-tools/Log.h"
+
+#include "MpscRing.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A Log that keeps formatting and I/O off of the calling thread.
+ *
+ * Once start() has been called, a log call only captures its arguments
+ * (the format pointer, the numbers, and copies of any strings) into a
+ * preallocated lock-free ring. A background thread does the formatting
+ * and the writing. The caller never allocates, takes a lock or touches
+ * the output. When the ring is full, or a level goes over its rate limit,
+ * the message is dropped and counted. The writer reports the drops
+ * periodically.
+ *
+ * The format string must be a literal (or otherwise outlive the call)
+ * since only the pointer is captured.
+ *
+ * Before start() (and after stop()) messages are formatted and written
+ * on the calling thread, like MTLog, and there is no rate limit.
+ */
+class AsyncLog : public Log {
+public:
+
+    enum Level { DEBUG, INFO, WARN, ERROR, LEVEL_COUNT };
+
+    static constexpr unsigned RING_SIZE = 1024;
+    static constexpr unsigned MAX_ARGS = 12;
+    // Space for all of the string arguments of one message
+    static constexpr unsigned MAX_STRING_SPACE = 256;
+    static constexpr unsigned MAX_LINE_LEN = 1024;
+    // How long the writer sleeps when there is nothing to write
+    static constexpr unsigned IDLE_SLEEP_MS = 5;
+    // How often the writer reports drops
+    static constexpr unsigned DROP_REPORT_MS = 10000;
+
+    /**
+     * @param out Where the messages are written. Not closed by this object.
+     */
+    AsyncLog(FILE* out = stdout);
+    ~AsyncLog();
+
+    /**
+     * Starts the writer thread. From here on logging is asynchronous.
+     */
+    void start();
+
+    /**
+     * Writes everything that is waiting and stops the writer thread.
+     * From here on logging is synchronous.
+     */
+    void stop();
+
+    bool isAsync() const { return _running.load(std::memory_order_relaxed); }
+
+    /**
+     * Limits the number of messages of a level that are accepted each
+     * second while logging asynchronously. The default is 200.
+     *
+     * @param perSecond The limit, or 0 for no limit.
+     */
+    void setRateLimit(Level level, unsigned perSecond);
+
+    /**
+     * @returns The number of messages of the level that were dropped
+     *   because of the rate limit.
+     */
+    uint32_t getRateDroppedCount(Level level) const {
+        return _rateDropped[level].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @returns The number of messages dropped because the ring was full.
+     */
+    uint32_t getFullDroppedCount() const {
+        return _fullDropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @returns The number of messages written.
+     */
+    uint32_t getWrittenCount() const {
+        return _written.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Formats a message from captured arguments. This is the same as
+     * vsnprintf() except that the arguments come from a capture. Exposed
+     * for testing.
+     */
+    static std::string formatCaptured(const char* fmt, va_list args);
+
+protected:
+
+    void _log(const char* sev, const char* fmt, va_list args) override;
+
+private:
+
+    enum class ArgType : uint8_t { INT, UINT, DOUBLE, LONG_DOUBLE, PTR, STR };
+
+    struct Arg {
+        ArgType type;
+        union {
+            long long i;
+            unsigned long long u;
+            double d;
+            const void* p;
+            // Offset of the copy in the string space
+            uint16_t strOffset;
+        };
+    };
+
+    struct Record {
+        uint64_t timeUs;
+        const char* sev;
+        const char* fmt;
+        uint8_t argCount;
+        Arg args[MAX_ARGS];
+        char strings[MAX_STRING_SPACE];
+    };
+
+    static Level _level(const char* sev);
+    static bool _capture(Record& r, const char* fmt, va_list args);
+    static unsigned _format(const Record& r, char* out, unsigned outLen);
+    static uint64_t _nowUs();
+
+    bool _allow(Level level, uint64_t nowUs);
+    void _write(uint64_t timeUs, const char* sev, const char* msg);
+    void _writerLoop();
+    void _reportDrops();
+
+    FILE* _out;
+    std::mutex _writeLock;
+    std::unique_ptr<MpscRing<Record, RING_SIZE>> _ring;
+    std::atomic<bool> _running = false;
+    std::thread _writer;
+
+    std::atomic<uint32_t> _rateLimit[LEVEL_COUNT];
+    std::atomic<uint64_t> _rateWindow[LEVEL_COUNT];
+    std::atomic<uint32_t> _rateCount[LEVEL_COUNT];
+    std::atomic<uint32_t> _rateDropped[LEVEL_COUNT];
+    std::atomic<uint32_t> _fullDropped = 0;
+    std::atomic<uint32_t> _written = 0;
+
+    // Writer-owned
+    uint32_t _reportedDrops = 0;
+    uint64_t _lastDropReportUs = 0;
+};
+
+    }
+}
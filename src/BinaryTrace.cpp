@@ -0,0 +1,233 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+#include "BinaryTrace.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+std::atomic<uint64_t> BinaryTrace::_nextInstanceId = 1;
+
+BinaryTrace::BinaryTrace()
+:   _instanceId(_nextInstanceId.fetch_add(1)),
+    _history(std::make_unique<TraceRecord[]>(HISTORY_SIZE)) {
+    memset(_events, 0, sizeof(_events));
+    defineEvent(RXV, "RXV", 1);
+    defineEvent(UNK, "UNK", 0);
+    defineEvent(POV, "POV", 1);
+    defineEvent(POI, "POI", 0);
+    defineEvent(OVR, "OVR", 2);
+}
+
+BinaryTrace::~BinaryTrace() {
+    if (_spillMap) {
+        collect();
+        munmap(_spillMap, _spillSize);
+    }
+    if (_spillFd != -1)
+        close(_spillFd);
+}
+
+uint64_t BinaryTrace::nowUs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int BinaryTrace::defineEvent(uint16_t id, const char* name, unsigned argCount) {
+    if (id >= MAX_EVENTS || argCount > MAX_ARGS || strlen(name) == 0 ||
+        strlen(name) > MAX_NAME_LEN)
+        return -1;
+    strcpy(_events[id].name, name);
+    _events[id].argCount = argCount;
+    _writeEventTable();
+    return 0;
+}
+
+BinaryTrace::Ring* BinaryTrace::_ring() {
+    // The last ring used by this thread. This is only wrong (and
+    // slower) when a thread writes to more than one BinaryTrace.
+    thread_local uint64_t cacheInstanceId = 0;
+    thread_local Ring* cacheRing = nullptr;
+    if (cacheInstanceId != _instanceId) {
+        cacheRing = _register();
+        cacheInstanceId = cacheRing ? _instanceId : 0;
+    }
+    return cacheRing;
+}
+
+BinaryTrace::Ring* BinaryTrace::_register() {
+    std::lock_guard<std::mutex> lock(_registerLock);
+    const std::thread::id self = std::this_thread::get_id();
+    const unsigned count = _ringCount.load(std::memory_order_relaxed);
+    for (unsigned i = 0; i < count; i++)
+        if (_rings[i]->owner == self)
+            return _rings[i].get();
+    if (count == MAX_THREADS)
+        return nullptr;
+    _rings[count] = std::make_unique<Ring>();
+    _rings[count]->owner = self;
+    _rings[count]->id = count;
+    // Publishes the new ring to the collector
+    _ringCount.store(count + 1, std::memory_order_release);
+    return _rings[count].get();
+}
+
+void BinaryTrace::traceAt(uint64_t timeUs, uint16_t event, uint32_t callId,
+    int64_t arg0, int64_t arg1) {
+    if (!_enabled.load(std::memory_order_relaxed))
+        return;
+    Ring* ring = _ring();
+    if (!ring) {
+        _noRingCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceRecord r;
+    r.timeUs = timeUs;
+    r.event = event;
+    r.thread = ring->id;
+    r.callId = callId;
+    r.args[0] = arg0;
+    r.args[1] = arg1;
+    if (!ring->records.push(r))
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t BinaryTrace::getDroppedCount() const {
+    uint32_t total = _noRingCount.load(std::memory_order_relaxed);
+    const unsigned count = _ringCount.load(std::memory_order_acquire);
+    for (unsigned i = 0; i < count; i++)
+        total += _rings[i]->dropped.load(std::memory_order_relaxed);
+    return total;
+}
+
+int BinaryTrace::openSpill(const char* fileName, unsigned capacity) {
+    if (_spillMap || capacity == 0)
+        return -1;
+    const size_t size = SPILL_HEADER_SIZE + (size_t)capacity * sizeof(TraceRecord);
+    int fd = ::open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        return -1;
+    }
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    _spillFd = fd;
+    _spillMap = (uint8_t*)map;
+    _spillSize = size;
+    _spillCapacity = capacity;
+    _spillCount = 0;
+
+    SpillHeader* h = (SpillHeader*)_spillMap;
+    memcpy(h->magic, SPILL_MAGIC, sizeof(h->magic));
+    h->version = SPILL_VERSION;
+    h->recordSize = sizeof(TraceRecord);
+    h->capacity = capacity;
+    h->count = 0;
+    _writeEventTable();
+    return 0;
+}
+
+void BinaryTrace::_writeEventTable() {
+    if (!_spillMap)
+        return;
+    SpillEventDef* defs = (SpillEventDef*)(_spillMap + sizeof(SpillHeader));
+    for (unsigned i = 0; i < MAX_EVENTS; i++) {
+        memcpy(defs[i].name, _events[i].name, sizeof(defs[i].name));
+        defs[i].argCount = _events[i].argCount;
+        defs[i].reserved = 0;
+    }
+}
+
+unsigned BinaryTrace::collect() {
+    TraceRecord* spill = _spillMap ?
+        (TraceRecord*)(_spillMap + SPILL_HEADER_SIZE) : nullptr;
+    unsigned total = 0;
+    const unsigned count = _ringCount.load(std::memory_order_acquire);
+    for (unsigned i = 0; i < count; i++) {
+        total += _rings[i]->records.drain([this, spill](const TraceRecord& r) {
+            _history[_collectedCount % HISTORY_SIZE] = r;
+            _collectedCount++;
+            if (spill) {
+                spill[_spillCount % _spillCapacity] = r;
+                _spillCount++;
+            }
+        });
+    }
+    if (spill && total)
+        ((SpillHeader*)_spillMap)->count = _spillCount;
+    return total;
+}
+
+void BinaryTrace::snapshot(std::vector<TraceRecord>& out, unsigned maxRecords) {
+    collect();
+    const uint64_t available = std::min<uint64_t>(_collectedCount, HISTORY_SIZE);
+    const uint64_t n = std::min<uint64_t>(available, maxRecords);
+    out.clear();
+    out.reserve(n);
+    for (uint64_t i = _collectedCount - n; i < _collectedCount; i++)
+        out.push_back(_history[i % HISTORY_SIZE]);
+    // Each thread's records are in order but the threads are interleaved
+    std::stable_sort(out.begin(), out.end(),
+        [](const TraceRecord& a, const TraceRecord& b) { return a.timeUs < b.timeUs; });
+}
+
+void BinaryTrace::dump(std::ostream& str, unsigned maxRecords) {
+    std::vector<TraceRecord> records;
+    snapshot(records, maxRecords);
+    for (const TraceRecord& r : records)
+        str << decode(r) << "\n";
+}
+
+std::string BinaryTrace::decode(const TraceRecord& r) const {
+    std::string result = std::to_string(r.timeUs);
+    result += ", ";
+    unsigned argCount = MAX_ARGS;
+    if (r.event < MAX_EVENTS && _events[r.event].name[0] != 0) {
+        result += _events[r.event].name;
+        argCount = _events[r.event].argCount;
+    } else {
+        result += "E" + std::to_string(r.event);
+    }
+    for (unsigned i = 0; i < argCount; i++)
+        result += ", " + std::to_string(r.args[i]);
+    result += ", " + std::to_string(r.callId);
+    return result;
+}
+
+void BinaryTrace::audioRateTick(uint32_t) {
+    if (++_tickCount == COLLECT_TICKS) {
+        _tickCount = 0;
+        collect();
+    }
+}
+
+    }
+}
@@ -0,0 +1,246 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kc1fsz-tools/Runnable2.h"
+
+#include "SpscRing.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * One trace event. This is also the on-disk format of the spill file
+ * (little-endian).
+ */
+struct TraceRecord {
+    uint64_t timeUs;
+    uint16_t event;
+    // The order in which the writing thread first traced
+    uint16_t thread;
+    uint32_t callId;
+    int64_t args[2];
+};
+
+static_assert(sizeof(TraceRecord) == 32, "TraceRecord layout");
+
+/**
+ * A binary alternative to TraceLog that is cheap enough to leave on in
+ * production. Tracing an event copies a fixed-size record into a
+ * lock-free ring that belongs to the calling thread: no formatting, no
+ * allocation and no locks.
+ *
+ * A single collector (this object's task, on shard 0) moves the records
+ * out of the per-thread rings into a history of the most recent events
+ * and, optionally, into a circular spill file that is mmap'd. Records
+ * are only turned into text when someone asks for them (dump()). The
+ * text form is the capture format read by sw/python/analyzer-jb.py and
+ * amp-replay, and analyzer-jb.py can also read the spill file directly.
+ *
+ * If a thread produces events faster than they are collected the
+ * excess events are dropped (and counted), tracing never blocks.
+ */
+class BinaryTrace : public Runnable2 {
+public:
+
+    static constexpr unsigned MAX_THREADS = 32;
+    // Per thread, enough for 100ms of 50 events/s on 800 calls
+    static constexpr unsigned RING_SIZE = 4096;
+    static constexpr unsigned HISTORY_SIZE = 8192;
+    static constexpr unsigned MAX_EVENTS = 64;
+    static constexpr unsigned MAX_NAME_LEN = 7;
+    static constexpr unsigned MAX_ARGS = 2;
+    // Collect every 5th audio tick (100ms)
+    static constexpr unsigned COLLECT_TICKS = 5;
+
+    /**
+     * The events that are defined by default. The names match the
+     * ones used in the text capture files.
+     */
+    enum Event : uint16_t {
+        // Voice frame received (args: origin ms)
+        RXV = 1,
+        // Unkey received
+        UNK = 2,
+        // Frame played out of the jitter buffer (args: origin ms)
+        POV = 3,
+        // Frame concealed by the jitter buffer
+        POI = 4,
+        // Audio tick ran late (args: shard, tick interval us)
+        OVR = 5
+    };
+
+    /**
+     * Spill file layout: a SpillHeader, then the event table (MAX_EVENTS
+     * SpillEventDefs), then capacity TraceRecords starting at
+     * SPILL_HEADER_SIZE. Record i is at (i % capacity) and the records
+     * are in collection order, not necessarily time order.
+     */
+    static constexpr char SPILL_MAGIC[8] = { 'A', 'M', 'P', 'T', 'R', 'A', 'C', 'E' };
+    static constexpr uint32_t SPILL_VERSION = 1;
+    static constexpr unsigned SPILL_HEADER_SIZE = 4096;
+
+    struct SpillHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t capacity;
+        // Total number of records ever written
+        uint64_t count;
+        uint8_t reserved[32];
+    };
+
+    struct SpillEventDef {
+        char name[MAX_NAME_LEN + 1];
+        uint32_t argCount;
+        uint32_t reserved;
+    };
+
+    BinaryTrace();
+    ~BinaryTrace();
+
+    void setEnabled(bool b) { _enabled.store(b, std::memory_order_relaxed); }
+    bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * Defines (or redefines) an event so that it can be decoded.
+     *
+     * @param name Up to MAX_NAME_LEN characters.
+     * @returns 0 on success, -1 if the ID, name or argument count is
+     *   out of range.
+     */
+    int defineEvent(uint16_t id, const char* name, unsigned argCount);
+
+    /**
+     * Records an event at the current time. Safe to call from any thread.
+     */
+    void trace(uint16_t event, uint32_t callId, int64_t arg0 = 0, int64_t arg1 = 0) {
+        if (_enabled.load(std::memory_order_relaxed))
+            traceAt(nowUs(), event, callId, arg0, arg1);
+    }
+
+    /**
+     * Records an event with an explicit timestamp (ex: simulated time).
+     * Safe to call from any thread.
+     */
+    void traceAt(uint64_t timeUs, uint16_t event, uint32_t callId,
+        int64_t arg0 = 0, int64_t arg1 = 0);
+
+    /**
+     * Starts copying everything that is collected into a circular file.
+     * The file is created (or truncated) and stays mapped until this
+     * object is destroyed.
+     *
+     * @param capacity The number of records the file holds.
+     * @returns 0 on success, -1 on error.
+     */
+    int openSpill(const char* fileName, unsigned capacity);
+
+    /**
+     * (Collector) Moves waiting records out of the per-thread rings. Only
+     * one thread may call this (and the other collector methods).
+     *
+     * @returns The number of records collected.
+     */
+    unsigned collect();
+
+    /**
+     * (Collector) Collects and then returns up to maxRecords of the most
+     * recent events, in time order.
+     */
+    void snapshot(std::vector<TraceRecord>& out, unsigned maxRecords = HISTORY_SIZE);
+
+    /**
+     * (Collector) Collects and then writes the most recent events to
+     * the stream in text form, one per line.
+     */
+    void dump(std::ostream& str, unsigned maxRecords = HISTORY_SIZE);
+
+    /**
+     * @returns The text form of a record: "timeUs, NAME, args..., callId".
+     */
+    std::string decode(const TraceRecord& r) const;
+
+    uint64_t getCollectedCount() const { return _collectedCount; }
+
+    /**
+     * @returns The number of events lost because a ring was full or
+     *   there were too many threads. Safe to call from any thread.
+     */
+    uint32_t getDroppedCount() const;
+
+    static uint64_t nowUs();
+
+    // ----- Runnable2 ----------------------------------------------------
+
+    void audioRateTick(uint32_t tickTimeMs) override;
+
+private:
+
+    struct Ring {
+        SpscRing<TraceRecord, RING_SIZE> records;
+        std::thread::id owner;
+        uint16_t id;
+        std::atomic<uint32_t> dropped = 0;
+    };
+
+    struct EventDef {
+        char name[MAX_NAME_LEN + 1];
+        unsigned argCount;
+    };
+
+    Ring* _ring();
+    Ring* _register();
+    void _writeEventTable();
+
+    // Distinguishes instances in the thread-local ring cache
+    static std::atomic<uint64_t> _nextInstanceId;
+    const uint64_t _instanceId;
+
+    std::atomic<bool> _enabled = true;
+    std::atomic<uint32_t> _noRingCount = 0;
+
+    std::mutex _registerLock;
+    std::unique_ptr<Ring> _rings[MAX_THREADS];
+    std::atomic<unsigned> _ringCount = 0;
+
+    EventDef _events[MAX_EVENTS];
+
+    // Collector-owned
+    std::unique_ptr<TraceRecord[]> _history;
+    uint64_t _collectedCount = 0;
+    unsigned _tickCount = 0;
+
+    int _spillFd = -1;
+    uint8_t* _spillMap = nullptr;
+    size_t _spillSize = 0;
+    uint64_t _spillCapacity = 0;
+    uint64_t _spillCount = 0;
+};
+
+    }
+}
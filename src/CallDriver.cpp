@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cmath>
+#include <cstdlib>
+
+// amp-core
+#include "IAX2Util.h"
+
+#include "UlawCodec.h"
+#include "CallDriver.h"
+
+using namespace std;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+// 20ms of audio
+static const unsigned ULAW_FRAME_SAMPLES = 160;
+static const unsigned SLIN16_FRAME_SAMPLES = 320;
+// Mean absolute sample value that counts as voice. The tone is at 8000.
+static const unsigned VOICE_LEVEL = 500;
+
+static bool isSignal(const Message& msg, Message::SignalType type) {
+    return msg.getType() == Message::Type::SIGNAL && msg.getFormat() == (unsigned)type;
+}
+
+CallDriver::CallDriver(MessageConsumer& bus, unsigned lineId, Codec codec)
+:   _bus(bus),
+    _lineId(lineId),
+    _format(codec == Codec::ULAW ? CODECType::IAX2_CODEC_G711_ULAW :
+        CODECType::IAX2_CODEC_SLIN_16K) {
+    for (unsigned i = 0; i < 16000; i++)
+        _tone.push_back(8000 * sin(2.0 * M_PI * 440.0 * i / 16000.0));
+}
+
+int CallDriver::_find(unsigned lineId, unsigned callId) const {
+    for (unsigned i = 0; i < _calls.size(); i++)
+        if (_calls[i].up && _calls[i].lineId == lineId && _calls[i].callId == callId)
+            return i;
+    return -1;
+}
+
+int CallDriver::findLine(unsigned lineId) const {
+    for (int i = _calls.size() - 1; i >= 0; i--)
+        if (_calls[i].lineId == lineId)
+            return i;
+    return -1;
+}
+
+void CallDriver::consume(const Message& msg) {
+    const unsigned lineId = msg.getSourceBusId();
+    const unsigned callId = msg.getSourceCallId();
+    if (isSignal(msg, Message::SignalType::CALL_START)) {
+        if (_find(lineId, callId) >= 0)
+            return;
+        Call call;
+        call.lineId = lineId;
+        call.callId = callId;
+        call.up = true;
+        call.format = _format;
+        _calls.push_back(call);
+        _upCount++;
+    }
+    else if (isSignal(msg, Message::SignalType::CALL_END)) {
+        int i = _find(lineId, callId);
+        if (i >= 0) {
+            _calls[i].up = false;
+            _upCount--;
+        }
+    }
+    else if (msg.getType() == Message::Type::AUDIO) {
+        int i = _find(lineId, callId);
+        if (i < 0) {
+            _unknownCount++;
+            return;
+        }
+        Call& call = _calls[i];
+        call.framesReceived++;
+        // Answer in whatever the far end uses
+        call.format = msg.getFormat();
+        uint64_t sum = 0;
+        unsigned n = 0;
+        if (call.format == CODECType::IAX2_CODEC_G711_ULAW) {
+            n = msg.size();
+            for (unsigned k = 0; k < n; k++)
+                sum += abs(UlawCodec::decodeSample(msg.body()[k]));
+        } else {
+            n = msg.size() / 2;
+            for (unsigned k = 0; k < n; k++)
+                sum += abs((int16_t)(msg.body()[2 * k] | (msg.body()[2 * k + 1] << 8)));
+        }
+        const bool voice = n > 0 && sum / n > VOICE_LEVEL;
+        if (voice)
+            call.voiceReceived++;
+        if (_audioHandler)
+            _audioHandler(i, voice);
+    }
+}
+
+int CallDriver::sendVoice(unsigned index, uint32_t originMs) {
+    if (index >= _calls.size() || !_calls[index].up)
+        return -1;
+    Call& call = _calls[index];
+    uint8_t frame[SLIN16_FRAME_SAMPLES * 2];
+    unsigned len;
+    if (call.format == CODECType::IAX2_CODEC_G711_ULAW) {
+        // Every other sample of the 16K tone
+        for (unsigned k = 0; k < ULAW_FRAME_SAMPLES; k++)
+            frame[k] = UlawCodec::encodeSample(
+                _tone[(call.tonePos + 2 * k) % _tone.size()]);
+        len = ULAW_FRAME_SAMPLES;
+    } else {
+        for (unsigned k = 0; k < SLIN16_FRAME_SAMPLES; k++) {
+            const int16_t s = _tone[(call.tonePos + k) % _tone.size()];
+            frame[2 * k] = s & 0xff;
+            frame[2 * k + 1] = (s >> 8) & 0xff;
+        }
+        len = SLIN16_FRAME_SAMPLES * 2;
+    }
+    call.tonePos = (call.tonePos + SLIN16_FRAME_SAMPLES) % _tone.size();
+    Message msg(Message::Type::AUDIO, call.format, len, frame, originMs, 0);
+    msg.setSource(_lineId, call.callId);
+    msg.setDest(call.lineId, call.callId);
+    _bus.consume(msg);
+    call.voiceSent++;
+    return 0;
+}
+
+    }
+}
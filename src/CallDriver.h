@@ -0,0 +1,121 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// amp-core
+#include "Message.h"
+#include "MessageConsumer.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * Takes the place of the Bridge behind the LineIAX2s that a test client
+ * (amp-replay, amp-loadgen) uses to place calls. The lines are built
+ * with this driver's line ID as their bridge line ID. The driver learns
+ * the calls from the lines' call start/end signals, sends a tone into
+ * any of them on request and reports whether each frame that comes back
+ * from the far end has voice in it.
+ *
+ * Not thread-safe, everything runs on the client's one thread.
+ */
+class CallDriver : public MessageConsumer {
+public:
+
+    enum class Codec { ULAW, SLIN16 };
+
+    struct Call {
+        unsigned lineId = 0;
+        unsigned callId = 0;
+        bool up = false;
+        // The format of the frames that are sent
+        unsigned format = 0;
+        uint32_t voiceSent = 0;
+        uint32_t framesReceived = 0;
+        uint32_t voiceReceived = 0;
+        unsigned tonePos = 0;
+    };
+
+    /**
+     * Called for every audio frame that comes back on a call.
+     *
+     * @param index The call's index.
+     * @param voice True if the frame has more than a little energy.
+     */
+    using AudioHandler = std::function<void(unsigned index, bool voice)>;
+
+    /**
+     * @param bus Where the frames for the lines are sent.
+     * @param lineId This driver's line ID.
+     * @param codec What is sent until the far end sends something
+     *   else.
+     */
+    CallDriver(MessageConsumer& bus, unsigned lineId, Codec codec = Codec::ULAW);
+
+    void setAudioHandler(AudioHandler h) { _audioHandler = h; }
+
+    /**
+     * The signals and audio from the lines.
+     */
+    void consume(const Message& msg) override;
+
+    /**
+     * Sends 20ms of tone into a call.
+     *
+     * @param originMs The origin time that the frame carries.
+     * @returns 0 on success, -1 if the call isn't up.
+     */
+    int sendVoice(unsigned index, uint32_t originMs);
+
+    /**
+     * @returns The calls in the order that they came up (a call keeps
+     *   its index after it ends).
+     */
+    const std::vector<Call>& getCalls() const { return _calls; }
+
+    unsigned getUpCount() const { return _upCount; }
+
+    /**
+     * @returns The index of the (last) call on a line, or -1.
+     */
+    int findLine(unsigned lineId) const;
+
+    uint32_t getUnknownCount() const { return _unknownCount; }
+
+private:
+
+    int _find(unsigned lineId, unsigned callId) const;
+
+    MessageConsumer& _bus;
+    const unsigned _lineId;
+    const unsigned _format;
+    std::vector<Call> _calls;
+    unsigned _upCount = 0;
+    // Audio for a call that was never started
+    uint32_t _unknownCount = 0;
+    AudioHandler _audioHandler;
+    // One second of tone at 16K, which loops cleanly
+    std::vector<int16_t> _tone;
+};
+
+    }
+}
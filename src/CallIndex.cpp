@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <netinet/in.h>
+
+#include <cstring>
+
+#include "CallIndex.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+bool CallIndex::Key::operator==(const Key& other) const {
+    return callNum == other.callNum && port == other.port &&
+        addr[0] == other.addr[0] && addr[1] == other.addr[1] &&
+        addr[2] == other.addr[2] && addr[3] == other.addr[3];
+}
+
+CallIndex::CallIndex() {
+    clear();
+}
+
+void CallIndex::clear() {
+    for (unsigned i = 0; i < TABLE_SIZE; i++)
+        _table[i].used = false;
+    for (unsigned i = 0; i < CALL_NUMBER_SPACE; i++)
+        _byLocal[i] = NOT_FOUND;
+    _count = 0;
+}
+
+bool CallIndex::_makeKey(const sockaddr& peer, uint16_t callNum, Key& key) {
+    memset(&key, 0, sizeof(key));
+    key.callNum = callNum & 0x7fff;
+    if (peer.sa_family == AF_INET) {
+        const sockaddr_in& in = (const sockaddr_in&)peer;
+        key.addr[3] = in.sin_addr.s_addr;
+        key.port = in.sin_port;
+        return true;
+    } 
+    else if (peer.sa_family == AF_INET6) {
+        const sockaddr_in6& in6 = (const sockaddr_in6&)peer;
+        memcpy(key.addr, &in6.sin6_addr, 16);
+        key.port = in6.sin6_port;
+        return true;
+    }
+    return false;
+}
+
+unsigned CallIndex::_hash(const Key& key) {
+    // Multiply-xorshift mix of the key words
+    uint64_t h = ((uint64_t)key.callNum << 16) | key.port;
+    for (unsigned i = 0; i < 4; i++) {
+        h ^= key.addr[i];
+        h *= 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 29;
+    }
+    return (unsigned)(h >> 32) & TABLE_MASK;
+}
+
+int CallIndex::_find(const Key& key) const {
+    for (unsigned i = _hash(key); _table[i].used; i = (i + 1) & TABLE_MASK)
+        if (_table[i].key == key)
+            return i;
+    return NOT_FOUND;
+}
+
+int CallIndex::add(const sockaddr& peer, uint16_t remoteCallNum, uint16_t localCallNum,
+    unsigned callSlot) {
+    Key key;
+    localCallNum &= 0x7fff;
+    if (callSlot > MAX_CALL_SLOT || !_makeKey(peer, remoteCallNum, key) || 
+        _count == MAX_CALLS || _byLocal[localCallNum] != NOT_FOUND || 
+        _find(key) != NOT_FOUND)
+        return -1;
+    unsigned i = _hash(key);
+    while (_table[i].used)
+        i = (i + 1) & TABLE_MASK;
+    _table[i].key = key;
+    _table[i].slot = callSlot;
+    _table[i].localCallNum = localCallNum;
+    _table[i].used = true;
+    _byLocal[localCallNum] = callSlot;
+    _count++;
+    return 0;
+}
+
+int CallIndex::remove(const sockaddr& peer, uint16_t remoteCallNum, uint16_t localCallNum) {
+    Key key;
+    if (!_makeKey(peer, remoteCallNum, key))
+        return -1;
+    int found = _find(key);
+    if (found == NOT_FOUND || _table[found].localCallNum != (localCallNum & 0x7fff))
+        return -1;
+    _byLocal[_table[found].localCallNum] = NOT_FOUND;
+    _count--;
+
+    // Backward-shift deletion: pull later members of the probe run into 
+    // the hole if the hole is between their home slot and where they are.
+    unsigned hole = found;
+    unsigned i = hole;
+    while (true) {
+        i = (i + 1) & TABLE_MASK;
+        if (!_table[i].used)
+            break;
+        const unsigned home = _hash(_table[i].key);
+        // Distance from home to the current position vs. to the hole
+        if (((i - home) & TABLE_MASK) >= ((i - hole) & TABLE_MASK)) {
+            _table[hole] = _table[i];
+            hole = i;
+        }
+    }
+    _table[hole].used = false;
+    return 0;
+}
+
+int CallIndex::setRemoteCallNum(const sockaddr& peer, uint16_t oldRemoteCallNum, 
+    uint16_t newRemoteCallNum, uint16_t localCallNum) {
+    const int slot = findFull(localCallNum);
+    if (slot == NOT_FOUND || findMini(peer, newRemoteCallNum) != NOT_FOUND ||
+        remove(peer, oldRemoteCallNum, localCallNum) != 0)
+        return -1;
+    return add(peer, newRemoteCallNum, localCallNum, slot);
+}
+
+int CallIndex::findMini(const sockaddr& peer, uint16_t sourceCallNum) const {
+    Key key;
+    if (!_makeKey(peer, sourceCallNum, key))
+        return NOT_FOUND;
+    int i = _find(key);
+    return (i == NOT_FOUND) ? NOT_FOUND : _table[i].slot;
+}
+
+    }
+}
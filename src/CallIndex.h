@@ -0,0 +1,146 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <sys/socket.h>
+
+#include <cstdint>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * Maps incoming IAX2 frames to calls in constant time, regardless of the
+ * number of active calls.
+ *
+ * - A mini frame only carries the peer's (source) call number, so it is 
+ *   looked up by (peer address, source call number) in an open-addressing
+ *   hash table with linear probing. Removal uses backward shifting so 
+ *   there are no tombstones to degrade the probe length over time.
+ * - A full frame carries our (destination) call number. Call numbers are
+ *   15 bits, so this is a direct array lookup.
+ *
+ * The index stores a caller-defined call slot number (i.e. an index into
+ * the line's call table). All storage is inside the object.
+ */
+class CallIndex {
+public:
+
+    static constexpr unsigned MAX_CALLS = 4096;
+    static constexpr int NOT_FOUND = -1;
+
+    /**
+     * Call numbers are 15 bits, zero is not used.
+     */
+    static constexpr unsigned CALL_NUMBER_SPACE = 32768;
+
+    /**
+     * Call slots are stored in 16 bits.
+     */
+    static constexpr unsigned MAX_CALL_SLOT = INT16_MAX;
+
+    CallIndex();
+
+    /**
+     * Removes everything.
+     */
+    void clear();
+
+    /**
+     * Indexes a call.
+     *
+     * @param peer The address that the peer's frames come from.
+     * @param remoteCallNum The peer's call number (source call number of 
+     *   inbound frames).
+     * @param localCallNum Our call number (destination call number of 
+     *   inbound full frames).
+     * @param callSlot At most MAX_CALL_SLOT.
+     * @returns 0 on success, -1 if the index is full, the local call number
+     *   is already in use, the (peer, remote call number) pair is already
+     *   indexed, or the call slot is out of range.
+     */
+    int add(const sockaddr& peer, uint16_t remoteCallNum, uint16_t localCallNum,
+        unsigned callSlot);
+
+    /**
+     * Forgets a call.
+     *
+     * @returns 0 on success, -1 if the call wasn't indexed (with this
+     *   local call number).
+     */
+    int remove(const sockaddr& peer, uint16_t remoteCallNum, uint16_t localCallNum);
+
+    /**
+     * Sets or changes the peer call number for a call that was indexed 
+     * before the peer's call number was known (ex: an outbound call 
+     * waiting for ACCEPT).
+     */
+    int setRemoteCallNum(const sockaddr& peer, uint16_t oldRemoteCallNum, 
+        uint16_t newRemoteCallNum, uint16_t localCallNum);
+
+    /**
+     * @returns The call slot for a mini frame, or NOT_FOUND.
+     */
+    int findMini(const sockaddr& peer, uint16_t sourceCallNum) const;
+
+    /**
+     * @returns The call slot for a full frame, or NOT_FOUND.
+     */
+    int findFull(uint16_t destCallNum) const {
+        destCallNum &= 0x7fff;
+        return _byLocal[destCallNum];
+    }
+
+    unsigned size() const { return _count; }
+
+private:
+
+    static constexpr unsigned TABLE_SIZE = MAX_CALLS * 2;
+    static constexpr unsigned TABLE_MASK = TABLE_SIZE - 1;
+
+    /**
+     * The parts of the peer address that matter, in a fixed layout.
+     */
+    struct Key {
+        uint32_t addr[4];
+        uint16_t port;
+        uint16_t callNum;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct Entry {
+        Key key;
+        int16_t slot;
+        // The _byLocal entry that belongs to this call
+        uint16_t localCallNum;
+        bool used;
+    };
+
+    static bool _makeKey(const sockaddr& peer, uint16_t callNum, Key& key);
+    static unsigned _hash(const Key& key);
+
+    int _find(const Key& key) const;
+
+    Entry _table[TABLE_SIZE];
+    int16_t _byLocal[CALL_NUMBER_SPACE];
+    unsigned _count = 0;
+};
+
+    }
+}
@@ -0,0 +1,161 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "kc1fsz-tools/Log.h"
+
+#include "ConfigWatcher.h"
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+ConfigWatcher::ConfigWatcher(Log& log, const char* fileName, Handler changeCb, 
+    Handler startCb)
+:   _log(log),
+    _fileName(fileName),
+    _changeCb(changeCb),
+    _startCb(startCb) {
+
+    string dir = ".";
+    const size_t slash = _fileName.rfind('/');
+    if (slash == string::npos)
+        _baseName = _fileName;
+    else {
+        dir = (slash == 0) ? "/" : _fileName.substr(0, slash);
+        _baseName = _fileName.substr(slash + 1);
+    }
+
+    _inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotifyFd >= 0 && 
+        inotify_add_watch(_inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        ::close(_inotifyFd);
+        _inotifyFd = -1;
+    }
+    if (_inotifyFd < 0)
+        _log.info("Unable to watch %s (%d), polling instead", dir.c_str(), errno);
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    if (_inotifyFd >= 0)
+        ::close(_inotifyFd);
+}
+
+int ConfigWatcher::getPolls(pollfd* fds, unsigned fdsCapacity) {
+    if (_inotifyFd < 0 || fdsCapacity < 1)
+        return 0;
+    fds[0].fd = _inotifyFd;
+    fds[0].events = POLLIN;
+    return 1;
+}
+
+bool ConfigWatcher::run2() {
+
+    if (!_started) {
+        _started = true;
+        _load();
+        return true;
+    }
+
+    if (_inotifyFd < 0)
+        return false;
+
+    // The events are variable length, this is big enough for several
+    alignas(inotify_event) char buf[4096];
+    bool changed = false;
+    bool activity = false;
+    while (true) {
+        const ssize_t len = ::read(_inotifyFd, buf, sizeof(buf));
+        if (len <= 0)
+            break;
+        activity = true;
+        for (ssize_t i = 0; i < len; ) {
+            const inotify_event* ev = (const inotify_event*)(buf + i);
+            // Events were lost, so assume the worst
+            if (ev->mask & IN_Q_OVERFLOW)
+                changed = true;
+            else if (ev->len > 0 && _baseName == ev->name)
+                changed = true;
+            i += sizeof(inotify_event) + ev->len;
+        }
+    }
+    if (changed)
+        _load();
+    return activity;
+}
+
+void ConfigWatcher::oneSecTick() {
+    if (_inotifyFd >= 0 || !_started)
+        return;
+    struct stat st;
+    if (::stat(_fileName.c_str(), &st) == 0 && st.st_mtime != _lastMtime) {
+        _lastMtime = st.st_mtime;
+        _load();
+    }
+}
+
+void ConfigWatcher::tenSecTick() {
+    if (!_retry || _lastText.empty())
+        return;
+    _retry = false;
+    _log.info("Applying configuration %s again", _fileName.c_str());
+    _changeCount++;
+    _changeCb(json::parse(_lastText));
+}
+
+void ConfigWatcher::_load() {
+
+    ifstream str(_fileName);
+    if (!str.good()) {
+        _log.error("Unable to read configuration %s", _fileName.c_str());
+        return;
+    }
+    stringstream text;
+    text << str.rdbuf();
+    if (text.str() == _lastText)
+        return;
+
+    json cfg = json::parse(text.str(), nullptr, false);
+    if (cfg.is_discarded()) {
+        _log.error("Configuration %s is not valid JSON, ignored", _fileName.c_str());
+        return;
+    }
+    _lastText = text.str();
+    if (_inotifyFd < 0) {
+        struct stat st;
+        if (::stat(_fileName.c_str(), &st) == 0)
+            _lastMtime = st.st_mtime;
+    }
+
+    _changeCount++;
+    _changeCb(cfg);
+    if (_changeCount == 1)
+        _startCb(cfg);
+}
+
+    }
+}
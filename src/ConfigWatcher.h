@@ -0,0 +1,106 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <sys/types.h>
+#include <ctime>
+#include <functional>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "kc1fsz-tools/Runnable2.h"
+
+namespace kc1fsz {
+
+class Log;
+
+    namespace amp {
+
+/**
+ * Watches the configuration file and hands each new version of the 
+ * document to a handler. A drop-in for ConfigPoller that is driven by
+ * inotify instead of polling the file: the EventLoop sleeps on the 
+ * inotify descriptor (getPolls()) and nothing is read until the file 
+ * has been closed after writing or renamed into place.
+ *
+ * The directory is watched rather than the file so that editors (and 
+ * the WebUi) that write a new file and rename it over the old one are
+ * seen. A rewrite with identical contents and a document that doesn't 
+ * parse (ex: a half-finished edit) are both ignored. If inotify isn't 
+ * available the file's modification time is checked once a second.
+ *
+ * Everything happens on the thread that runs this task.
+ */
+class ConfigWatcher : public Runnable2 {
+public:
+
+    using Handler = std::function<void(const nlohmann::json&)>;
+
+    /**
+     * @param changeCb Called with the document at startup and then on 
+     *   every change.
+     * @param startCb Called once at startup, after changeCb.
+     */
+    ConfigWatcher(Log& log, const char* fileName, Handler changeCb, Handler startCb);
+    ~ConfigWatcher();
+
+    /**
+     * @returns false if the file is being polled instead.
+     */
+    bool isWatching() const { return _inotifyFd >= 0; }
+
+    /**
+     * @returns The number of times that changeCb has been called.
+     */
+    unsigned getChangeCount() const { return _changeCount; }
+
+    /**
+     * Hands the current document to changeCb again on the next 
+     * tenSecTick(), even though it hasn't changed. Used when some of it
+     * couldn't be applied (ex: a sound device that isn't plugged in).
+     */
+    void retry() { _retry = true; }
+
+    // ----- Runnable2 ----------------------------------------------------
+
+    int getPolls(pollfd* fds, unsigned fdsCapacity) override;
+    bool run2() override;
+    void oneSecTick() override;
+    void tenSecTick() override;
+
+private:
+
+    void _load();
+
+    Log& _log;
+    const std::string _fileName;
+    // The name of the file within its directory
+    std::string _baseName;
+    Handler _changeCb;
+    Handler _startCb;
+    int _inotifyFd = -1;
+    bool _started = false;
+    std::string _lastText;
+    // Only used when polling
+    time_t _lastMtime = 0;
+    unsigned _changeCount = 0;
+    bool _retry = false;
+};
+
+    }
+}
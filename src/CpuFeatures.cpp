@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "CpuFeatures.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+bool isSupported(SimdImpl impl) {
+    switch (impl) {
+    case SimdImpl::SCALAR:
+        return true;
+#if defined(__x86_64__)
+    case SimdImpl::SSE41:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1");
+    case SimdImpl::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__aarch64__)
+    // NEON is part of the base arm64 architecture
+    case SimdImpl::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+SimdImpl detectSimd() {
+    if (isSupported(SimdImpl::AVX2))
+        return SimdImpl::AVX2;
+    else if (isSupported(SimdImpl::SSE41))
+        return SimdImpl::SSE41;
+    else if (isSupported(SimdImpl::NEON))
+        return SimdImpl::NEON;
+    else
+        return SimdImpl::SCALAR;
+}
+
+const char* simdImplName(SimdImpl impl) {
+    switch (impl) {
+    case SimdImpl::SCALAR: return "scalar";
+    case SimdImpl::SSE41: return "sse4.1";
+    case SimdImpl::AVX2: return "avx2";
+    case SimdImpl::NEON: return "neon";
+    default: return "?";
+    }
+}
+
+    }
+}
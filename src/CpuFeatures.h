@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * The vector instruction sets that the DSP kernels know how to use. 
+ * The kernels are compiled for all of the sets that apply to the target
+ * architecture and the choice is made at runtime.
+ */
+enum class SimdImpl { SCALAR, SSE41, AVX2, NEON };
+
+/**
+ * @returns true if the running CPU supports the instruction set.
+ */
+bool isSupported(SimdImpl impl);
+
+/**
+ * @returns The best instruction set supported by the running CPU.
+ */
+SimdImpl detectSimd();
+
+const char* simdImplName(SimdImpl impl);
+
+    }
+}
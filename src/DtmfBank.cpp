@@ -0,0 +1,317 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "DtmfBank.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+static const unsigned TONES = DtmfBank::TONE_COUNT;
+
+static const char KEYS[4][4] = {
+    { '1', '2', '3', 'A' },
+    { '4', '5', '6', 'B' },
+    { '7', '8', '9', 'C' },
+    { '*', '0', '#', 'D' }
+};
+
+// ===== Scalar ===============================================================
+
+static void goertzelScalar(const int16_t* const* frames, unsigned n, unsigned len,
+    const float* coeffs, float* powers) {
+    for (unsigned c = 0; c < n; c++) {
+        float s1[TONES] = { }, s2[TONES] = { };
+        for (unsigned k = 0; k < len; k++) {
+            const float x = frames[c][k];
+            for (unsigned t = 0; t < TONES; t++) {
+                const float s = x + coeffs[t] * s1[t] - s2[t];
+                s2[t] = s1[t];
+                s1[t] = s;
+            }
+        }
+        for (unsigned t = 0; t < TONES; t++)
+            powers[c * TONES + t] = s1[t] * s1[t] + s2[t] * s2[t] - coeffs[t] * s1[t] * s2[t];
+    }
+}
+
+#if defined(__x86_64__)
+
+// ===== SSE4.1 ===============================================================
+
+// Two channels at a time, tones 0-3 and 4-7 in separate registers
+
+__attribute__((target("sse4.1")))
+static inline void stepSse41(__m128 x, __m128 c, __m128& s1, __m128& s2) {
+    __m128 s = _mm_sub_ps(_mm_add_ps(x, _mm_mul_ps(c, s1)), s2);
+    s2 = s1;
+    s1 = s;
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128 powerSse41(__m128 c, __m128 s1, __m128 s2) {
+    return _mm_sub_ps(_mm_add_ps(_mm_mul_ps(s1, s1), _mm_mul_ps(s2, s2)),
+        _mm_mul_ps(c, _mm_mul_ps(s1, s2)));
+}
+
+__attribute__((target("sse4.1")))
+static void goertzelSse41(const int16_t* const* frames, unsigned n, unsigned len,
+    const float* coeffs, float* powers) {
+    const __m128 cLo = _mm_loadu_ps(coeffs);
+    const __m128 cHi = _mm_loadu_ps(coeffs + 4);
+    unsigned c = 0;
+    for (; c + 2 <= n; c += 2) {
+        const int16_t* f0 = frames[c];
+        const int16_t* f1 = frames[c + 1];
+        __m128 a1Lo = _mm_setzero_ps(), a2Lo = a1Lo, a1Hi = a1Lo, a2Hi = a1Lo;
+        __m128 b1Lo = a1Lo, b2Lo = a1Lo, b1Hi = a1Lo, b2Hi = a1Lo;
+        for (unsigned k = 0; k < len; k++) {
+            const __m128 x0 = _mm_set1_ps(f0[k]);
+            const __m128 x1 = _mm_set1_ps(f1[k]);
+            stepSse41(x0, cLo, a1Lo, a2Lo);
+            stepSse41(x0, cHi, a1Hi, a2Hi);
+            stepSse41(x1, cLo, b1Lo, b2Lo);
+            stepSse41(x1, cHi, b1Hi, b2Hi);
+        }
+        _mm_storeu_ps(powers + c * TONES, powerSse41(cLo, a1Lo, a2Lo));
+        _mm_storeu_ps(powers + c * TONES + 4, powerSse41(cHi, a1Hi, a2Hi));
+        _mm_storeu_ps(powers + (c + 1) * TONES, powerSse41(cLo, b1Lo, b2Lo));
+        _mm_storeu_ps(powers + (c + 1) * TONES + 4, powerSse41(cHi, b1Hi, b2Hi));
+    }
+    goertzelScalar(frames + c, n - c, len, coeffs, powers + c * TONES);
+}
+
+// ===== AVX2 =================================================================
+
+// Four channels at a time, all eight tones in one register
+
+__attribute__((target("avx2")))
+static inline void stepAvx2(__m256 x, __m256 c, __m256& s1, __m256& s2) {
+    __m256 s = _mm256_sub_ps(_mm256_add_ps(x, _mm256_mul_ps(c, s1)), s2);
+    s2 = s1;
+    s1 = s;
+}
+
+__attribute__((target("avx2")))
+static inline __m256 powerAvx2(__m256 c, __m256 s1, __m256 s2) {
+    return _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(s1, s1), _mm256_mul_ps(s2, s2)),
+        _mm256_mul_ps(c, _mm256_mul_ps(s1, s2)));
+}
+
+__attribute__((target("avx2")))
+static void goertzelAvx2(const int16_t* const* frames, unsigned n, unsigned len,
+    const float* coeffs, float* powers) {
+    const __m256 co = _mm256_loadu_ps(coeffs);
+    unsigned c = 0;
+    for (; c + 4 <= n; c += 4) {
+        const int16_t* f0 = frames[c];
+        const int16_t* f1 = frames[c + 1];
+        const int16_t* f2 = frames[c + 2];
+        const int16_t* f3 = frames[c + 3];
+        __m256 a1 = _mm256_setzero_ps(), a2 = a1, b1 = a1, b2 = a1;
+        __m256 d1 = a1, d2 = a1, e1 = a1, e2 = a1;
+        for (unsigned k = 0; k < len; k++) {
+            stepAvx2(_mm256_set1_ps(f0[k]), co, a1, a2);
+            stepAvx2(_mm256_set1_ps(f1[k]), co, b1, b2);
+            stepAvx2(_mm256_set1_ps(f2[k]), co, d1, d2);
+            stepAvx2(_mm256_set1_ps(f3[k]), co, e1, e2);
+        }
+        _mm256_storeu_ps(powers + c * TONES, powerAvx2(co, a1, a2));
+        _mm256_storeu_ps(powers + (c + 1) * TONES, powerAvx2(co, b1, b2));
+        _mm256_storeu_ps(powers + (c + 2) * TONES, powerAvx2(co, d1, d2));
+        _mm256_storeu_ps(powers + (c + 3) * TONES, powerAvx2(co, e1, e2));
+    }
+    goertzelSse41(frames + c, n - c, len, coeffs, powers + c * TONES);
+}
+
+#endif
+
+#if defined(__aarch64__)
+
+// ===== NEON =================================================================
+
+// Two channels at a time, tones 0-3 and 4-7 in separate registers
+
+static inline void stepNeon(float32x4_t x, float32x4_t c, float32x4_t& s1,
+    float32x4_t& s2) {
+    float32x4_t s = vsubq_f32(vaddq_f32(x, vmulq_f32(c, s1)), s2);
+    s2 = s1;
+    s1 = s;
+}
+
+static inline float32x4_t powerNeon(float32x4_t c, float32x4_t s1, float32x4_t s2) {
+    return vsubq_f32(vaddq_f32(vmulq_f32(s1, s1), vmulq_f32(s2, s2)),
+        vmulq_f32(c, vmulq_f32(s1, s2)));
+}
+
+static void goertzelNeon(const int16_t* const* frames, unsigned n, unsigned len,
+    const float* coeffs, float* powers) {
+    const float32x4_t cLo = vld1q_f32(coeffs);
+    const float32x4_t cHi = vld1q_f32(coeffs + 4);
+    unsigned c = 0;
+    for (; c + 2 <= n; c += 2) {
+        const int16_t* f0 = frames[c];
+        const int16_t* f1 = frames[c + 1];
+        float32x4_t a1Lo = vdupq_n_f32(0), a2Lo = a1Lo, a1Hi = a1Lo, a2Hi = a1Lo;
+        float32x4_t b1Lo = a1Lo, b2Lo = a1Lo, b1Hi = a1Lo, b2Hi = a1Lo;
+        for (unsigned k = 0; k < len; k++) {
+            const float32x4_t x0 = vdupq_n_f32(f0[k]);
+            const float32x4_t x1 = vdupq_n_f32(f1[k]);
+            stepNeon(x0, cLo, a1Lo, a2Lo);
+            stepNeon(x0, cHi, a1Hi, a2Hi);
+            stepNeon(x1, cLo, b1Lo, b2Lo);
+            stepNeon(x1, cHi, b1Hi, b2Hi);
+        }
+        vst1q_f32(powers + c * TONES, powerNeon(cLo, a1Lo, a2Lo));
+        vst1q_f32(powers + c * TONES + 4, powerNeon(cHi, a1Hi, a2Hi));
+        vst1q_f32(powers + (c + 1) * TONES, powerNeon(cLo, b1Lo, b2Lo));
+        vst1q_f32(powers + (c + 1) * TONES + 4, powerNeon(cHi, b1Hi, b2Hi));
+    }
+    goertzelScalar(frames + c, n - c, len, coeffs, powers + c * TONES);
+}
+
+#endif
+
+// ===== DtmfBank =============================================================
+
+DtmfBank::DtmfBank(unsigned channelCount, unsigned frameLen, unsigned sampleRate, Impl impl)
+:   _channelCount(channelCount),
+    _frameLen(frameLen),
+    _impl(isSupported(impl) ? impl : Impl::SCALAR),
+    _goertzel(goertzelScalar),
+    _channels(std::make_unique<Channel[]>(channelCount)),
+    _powers(std::make_unique<float[]>(channelCount * TONE_COUNT)),
+    _energies(std::make_unique<float[]>(channelCount)) {
+
+    for (unsigned t = 0; t < TONE_COUNT; t++)
+        _coeffs[t] = 2.0f * cos(2.0 * M_PI * TONES_HZ[t] / sampleRate);
+    _normalTwist = pow(10.0f, MAX_NORMAL_TWIST_DB / 10.0f);
+    _reverseTwist = pow(10.0f, MAX_REVERSE_TWIST_DB / 10.0f);
+    _relativePeak = pow(10.0f, MIN_RELATIVE_PEAK_DB / 10.0f);
+    // A tone with amplitude A gives a power of about (A * N / 2)^2
+    const float amplitude = MIN_TONE_RMS * sqrt(2.0f);
+    _minPower = (amplitude * frameLen / 2) * (amplitude * frameLen / 2);
+
+#if defined(__x86_64__)
+    if (_impl == Impl::SSE41)
+        _goertzel = goertzelSse41;
+    else if (_impl == Impl::AVX2)
+        _goertzel = goertzelAvx2;
+#endif
+#if defined(__aarch64__)
+    if (_impl == Impl::NEON)
+        _goertzel = goertzelNeon;
+#endif
+}
+
+void DtmfBank::resetChannel(unsigned channel) {
+    _channels[channel] = Channel();
+}
+
+void DtmfBank::analyze(const int16_t* const* frames, float* powers, float* energies) {
+    // Runs of channels with audio go through the kernel together
+    unsigned c = 0;
+    while (c < _channelCount) {
+        if (!frames[c]) {
+            memset(powers + c * TONE_COUNT, 0, TONE_COUNT * sizeof(float));
+            energies[c] = 0;
+            c++;
+            continue;
+        }
+        unsigned end = c + 1;
+        while (end < _channelCount && frames[end])
+            end++;
+        _goertzel(frames + c, end - c, _frameLen, _coeffs, powers + c * TONE_COUNT);
+        for (; c < end; c++) {
+            float e = 0;
+            for (unsigned k = 0; k < _frameLen; k++)
+                e += (float)frames[c][k] * frames[c][k];
+            energies[c] = e;
+        }
+    }
+}
+
+char DtmfBank::classify(const float* p, float energy) const {
+
+    unsigned row = 0, col = 4;
+    for (unsigned t = 1; t < 4; t++)
+        if (p[t] > p[row])
+            row = t;
+    for (unsigned t = 5; t < 8; t++)
+        if (p[t] > p[col])
+            col = t;
+
+    if (p[row] < _minPower || p[col] < _minPower)
+        return 0;
+    if (p[row] > p[col] * _normalTwist || p[col] > p[row] * _reverseTwist)
+        return 0;
+    for (unsigned t = 0; t < TONE_COUNT; t++) {
+        if (t == row || t == col)
+            continue;
+        if (p[t] * _relativePeak > ((t < 4) ? p[row] : p[col]))
+            return 0;
+    }
+    // Each tone's share of the frame energy is 2 * power / N
+    if (2.0f * (p[row] + p[col]) / _frameLen < MIN_ENERGY_FRACTION * energy)
+        return 0;
+
+    return KEYS[row][col - 4];
+}
+
+unsigned DtmfBank::process(const int16_t* const* frames, char* digits) {
+
+    analyze(frames, _powers.get(), _energies.get());
+
+    unsigned downs = 0;
+    for (unsigned c = 0; c < _channelCount; c++) {
+        Channel& ch = _channels[c];
+        char newDown = 0;
+        if (!frames[c])
+            ch = Channel();
+        else {
+            const char d = classify(_powers.get() + c * TONE_COUNT, _energies[c]);
+            if (d == ch.candidate) {
+                if (ch.count < MIN_FRAMES)
+                    ch.count++;
+            }
+            else {
+                ch.candidate = d;
+                ch.count = 1;
+            }
+            if (ch.count == MIN_FRAMES && ch.down != ch.candidate) {
+                ch.down = ch.candidate;
+                newDown = ch.down;
+            }
+        }
+        if (newDown)
+            downs++;
+        if (digits)
+            digits[c] = newDown;
+    }
+    return downs;
+}
+
+    }
+}
@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "CpuFeatures.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * DTMF detection for many channels (ex: every call on a hub) with one
+ * call per audio frame.
+ *
+ * The kernel runs the Goertzel filters for all eight DTMF tones of a
+ * channel at once, one tone per vector lane (AVX2 does all eight in one
+ * register, SSE4.1 and NEON use two), with several channels interleaved
+ * to hide the multiply-add latency. The best implementation for the
+ * running CPU is picked at runtime, with a scalar fallback.
+ *
+ * Each frame is then classified (strongest row and column tone, level,
+ * twist, how far the other tones of each group are below the peak, and
+ * how much of the frame's energy the pair accounts for) and a digit is
+ * reported once it has been seen in MIN_FRAMES consecutive frames. The
+ * key is released after MIN_FRAMES frames without it.
+ *
+ * All storage is allocated in the constructor.
+ */
+class DtmfBank {
+public:
+
+    using Impl = SimdImpl;
+
+    static constexpr unsigned TONE_COUNT = 8;
+    static constexpr float TONES_HZ[TONE_COUNT] = { 697, 770, 852, 941,
+        1209, 1336, 1477, 1633 };
+
+    // Consecutive frames needed for a key down (or up). 2 x 20ms meets
+    // the 40ms minimum tone duration.
+    static constexpr unsigned MIN_FRAMES = 2;
+    // The quietest tone (RMS, in counts) that is detected, about -35 dBFS
+    static constexpr float MIN_TONE_RMS = 400;
+    // The row tone may be this much stronger than the column tone
+    static constexpr float MAX_NORMAL_TWIST_DB = 8;
+    // The column tone may be this much stronger than the row tone
+    static constexpr float MAX_REVERSE_TWIST_DB = 4;
+    // The other tones in a group must be this far below the peak
+    static constexpr float MIN_RELATIVE_PEAK_DB = 6;
+    // The pair must account for this much of the frame energy. A tone 1.5%
+    // off frequency still gives about 0.6, 3.5% off gives less than 0.25.
+    static constexpr float MIN_ENERGY_FRACTION = 0.5f;
+
+    /**
+     * @param channelCount The number of channels.
+     * @param frameLen Samples per frame.
+     * @param sampleRate In Hz.
+     */
+    DtmfBank(unsigned channelCount, unsigned frameLen = 160, unsigned sampleRate = 8000,
+        Impl impl = detectSimd());
+
+    Impl getImpl() const { return _impl; }
+
+    unsigned getChannelCount() const { return _channelCount; }
+
+    /**
+     * Runs one frame from every channel through the detectors.
+     *
+     * @param frames One frame per channel. nullptr means no audio (the
+     *   channel's key is released immediately).
+     * @param digits If not nullptr, set to the digit ('0'-'9', 'A'-'D',
+     *   '*', '#') that went down on each channel during this frame, or 0.
+     * @returns The number of digits that went down.
+     */
+    unsigned process(const int16_t* const* frames, char* digits);
+
+    /**
+     * @returns The digit that is currently down on a channel, or 0.
+     */
+    char getDigit(unsigned channel) const { return _channels[channel].down; }
+
+    /**
+     * Releases a channel's key and forgets its history (ex: when a call
+     * ends and the channel is reused).
+     */
+    void resetChannel(unsigned channel);
+
+    /**
+     * Just the filters: the power of each tone (powers[channel *
+     * TONE_COUNT + tone]) and the total energy of each frame. A nullptr
+     * frame gives zeros. Exposed for testing.
+     */
+    void analyze(const int16_t* const* frames, float* powers, float* energies);
+
+    /**
+     * The per-frame decision, without the debouncing. Exposed for testing.
+     *
+     * @returns The digit, or 0.
+     */
+    char classify(const float* powers, float energy) const;
+
+private:
+
+    using GoertzelFn = void (*)(const int16_t* const* frames, unsigned n, unsigned len,
+        const float* coeffs, float* powers);
+
+    struct Channel {
+        // The digit that is down
+        char down = 0;
+        // The digit seen in the most recent frames, and how many frames
+        char candidate = 0;
+        unsigned count = 0;
+    };
+
+    const unsigned _channelCount;
+    const unsigned _frameLen;
+    Impl _impl;
+    GoertzelFn _goertzel;
+    alignas(32) float _coeffs[TONE_COUNT];
+    // The dB limits as power ratios
+    float _normalTwist;
+    float _reverseTwist;
+    float _relativePeak;
+    // The tone power (Goertzel units) at MIN_TONE_RMS
+    float _minPower;
+    std::unique_ptr<Channel[]> _channels;
+    std::unique_ptr<float[]> _powers;
+    std::unique_ptr<float[]> _energies;
+};
+
+    }
+}
@@ -0,0 +1,147 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * Lets the bridge output encode each distinct (mix, codec) pair only once
+ * per frame. On a large bridge most participants are listening, and every
+ * listener hears the same full mix, so the listeners that negotiated the
+ * same codec can all share one encoded frame.
+ *
+ * The cache only holds the current frame. startFrame() forgets everything
+ * from the previous one. All storage is inside the object.
+ */
+class EncodeCache {
+public:
+
+    /**
+     * The mix ID used for the full mix (i.e. what every participant
+     * that isn't talking hears).
+     */
+    static constexpr uint32_t FULL_MIX = 0;
+
+    static constexpr unsigned MAX_ENTRIES = 16;
+
+    /**
+     * Big enough for 20ms of 16-bit audio at 48K.
+     */
+    static constexpr unsigned MAX_ENCODED_SIZE = 1920;
+
+    /**
+     * Forgets all of the encodings from the previous frame.
+     */
+    void startFrame() {
+        _entryCount = 0;
+    }
+
+    /**
+     * Returns the encoded frame for a (mix, codec) pair, encoding it only if
+     * this is the first request for that pair in the current frame.
+     *
+     * @param mixId Identifies the mix. Participants that hear exactly the
+     *   same audio must use the same ID (ex: FULL_MIX for listeners),
+     *   everyone else must use a distinct ID.
+     * @param codec Identifies the codec.
+     * @param len Set to the length of the encoded frame.
+     * @param encode Called on a miss as encode(uint8_t* out, unsigned
+     *   outCapacity) and returns the encoded length, or a negative number
+     *   on error.
+     * @param overflow Caller storage of MAX_ENCODED_SIZE bytes. When all 
+     *   MAX_ENTRIES slots are taken a new pair is encoded into it and
+     *   isn't remembered.
+     * @returns The encoded frame, or nullptr if the encoder failed. A frame
+     *   in the cache is valid until the next startFrame(), one in overflow
+     *   for as long as the caller leaves it alone.
+     */
+    template<typename F>
+    const uint8_t* get(uint32_t mixId, unsigned codec, unsigned& len, F encode,
+        uint8_t* overflow) {
+        for (unsigned i = 0; i < _entryCount; i++) {
+            if (_entries[i].mixId == mixId && _entries[i].codec == codec) {
+                _savedCount++;
+                len = _entries[i].len;
+                return _entries[i].data;
+            }
+        }
+        if (_entryCount == MAX_ENTRIES) {
+            int rc = encode(overflow, MAX_ENCODED_SIZE);
+            _encodeCount++;
+            _overflowCount++;
+            if (rc < 0)
+                return nullptr;
+            len = rc;
+            return overflow;
+        }
+        Entry& e = _entries[_entryCount];
+        int rc = encode(e.data, MAX_ENCODED_SIZE);
+        _encodeCount++;
+        if (rc < 0)
+            return nullptr;
+        e.mixId = mixId;
+        e.codec = codec;
+        e.len = rc;
+        _entryCount++;
+        len = e.len;
+        return e.data;
+    }
+
+    /**
+     * @returns The number of times the encoder was actually called.
+     */
+    uint32_t getEncodeCount() const { return _encodeCount; }
+
+    /**
+     * @returns The number of encodes that were avoided by sharing.
+     */
+    uint32_t getSavedCount() const { return _savedCount; }
+
+    /**
+     * @returns The number of encodes that went into the caller's 
+     *   overflow storage because the table was full.
+     */
+    uint32_t getOverflowCount() const { return _overflowCount; }
+
+    void resetCounters() {
+        _encodeCount = 0;
+        _savedCount = 0;
+        _overflowCount = 0;
+    }
+
+private:
+
+    struct Entry {
+        uint32_t mixId;
+        unsigned codec;
+        unsigned len;
+        uint8_t data[MAX_ENCODED_SIZE];
+    };
+
+    Entry _entries[MAX_ENTRIES];
+    unsigned _entryCount = 0;
+    uint32_t _encodeCount = 0;
+    uint32_t _savedCount = 0;
+    uint32_t _overflowCount = 0;
+};
+
+    }
+}
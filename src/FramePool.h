@@ -0,0 +1,155 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cassert>
+#include <atomic>
+#include <memory>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A fixed-capacity slab of frames with reference counts. A frame is
+ * copied into the pool once and then any number of consumers (possibly
+ * on different threads) can hold a handle to it. The frame goes back
+ * to the pool when the last handle is released.
+ *
+ * The free list is a lock-free stack of slot indices. The head carries
+ * a tag that is bumped on every change to avoid the ABA problem. All
+ * storage is allocated in the constructor.
+ */
+template<typename T> class FramePool {
+public:
+
+    using Handle = uint32_t;
+    static constexpr Handle NO_HANDLE = 0xffffffff;
+
+    FramePool(unsigned capacity)
+    :   _capacity(capacity),
+        _slots(std::make_unique<Slot[]>(capacity)) {
+        for (unsigned i = 0; i < capacity; i++) {
+            _slots[i].refs.store(0, std::memory_order_relaxed);
+            _slots[i].next.store((i + 1 < capacity) ? i + 1 : NO_HANDLE,
+                std::memory_order_relaxed);
+        }
+        _freeHead.store(_pack(0, capacity ? 0 : NO_HANDLE), std::memory_order_release);
+    }
+
+    /**
+     * Copies a frame into the pool.
+     *
+     * @param refs The initial reference count.
+     * @returns The handle, or NO_HANDLE if the pool is exhausted.
+     */
+    Handle alloc(const T& frame, unsigned refs = 1) {
+        uint64_t head = _freeHead.load(std::memory_order_acquire);
+        Handle h;
+        while (true) {
+            h = _index(head);
+            if (h == NO_HANDLE) {
+                _exhaustedCount.fetch_add(1, std::memory_order_relaxed);
+                return NO_HANDLE;
+            }
+            uint64_t newHead = _pack(_tag(head) + 1,
+                _slots[h].next.load(std::memory_order_relaxed));
+            if (_freeHead.compare_exchange_weak(head, newHead,
+                std::memory_order_acq_rel, std::memory_order_acquire))
+                break;
+        }
+        _slots[h].item = frame;
+        _slots[h].refs.store(refs, std::memory_order_release);
+        _allocCount.fetch_add(1, std::memory_order_relaxed);
+        unsigned inUse = _inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+        unsigned hw = _highWater.load(std::memory_order_relaxed);
+        while (inUse > hw &&
+            !_highWater.compare_exchange_weak(hw, inUse, std::memory_order_relaxed));
+        return h;
+    }
+
+    /**
+     * Adds a reference to a frame that the caller already holds.
+     */
+    void addRef(Handle h) {
+        _slots[h].refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Adds a reference to a frame that the caller does not hold. This
+     * fails if the frame has already gone back to the pool.
+     */
+    bool tryAddRef(Handle h) {
+        unsigned refs = _slots[h].refs.load(std::memory_order_relaxed);
+        while (refs != 0) {
+            if (_slots[h].refs.compare_exchange_weak(refs, refs + 1,
+                std::memory_order_acquire, std::memory_order_relaxed))
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * Drops a reference. The last release puts the slot back on the free list.
+     */
+    void release(Handle h) {
+        if (_slots[h].refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        _inUse.fetch_sub(1, std::memory_order_relaxed);
+        uint64_t head = _freeHead.load(std::memory_order_acquire);
+        while (true) {
+            _slots[h].next.store(_index(head), std::memory_order_relaxed);
+            if (_freeHead.compare_exchange_weak(head, _pack(_tag(head) + 1, h),
+                std::memory_order_acq_rel, std::memory_order_acquire))
+                break;
+        }
+    }
+
+    const T& get(Handle h) const {
+        assert(h < _capacity);
+        return _slots[h].item;
+    }
+
+    unsigned getCapacity() const { return _capacity; }
+    unsigned getInUse() const { return _inUse.load(std::memory_order_relaxed); }
+    unsigned getHighWater() const { return _highWater.load(std::memory_order_relaxed); }
+    uint32_t getAllocCount() const { return _allocCount.load(std::memory_order_relaxed); }
+    uint32_t getExhaustedCount() const { return _exhaustedCount.load(std::memory_order_relaxed); }
+
+private:
+
+    struct Slot {
+        std::atomic<unsigned> refs;
+        std::atomic<Handle> next;
+        T item;
+    };
+
+    static uint64_t _pack(uint32_t tag, Handle h) { return ((uint64_t)tag << 32) | h; }
+    static uint32_t _tag(uint64_t v) { return v >> 32; }
+    static Handle _index(uint64_t v) { return v & 0xffffffff; }
+
+    const unsigned _capacity;
+    std::unique_ptr<Slot[]> _slots;
+    std::atomic<uint64_t> _freeHead;
+    std::atomic<unsigned> _inUse = 0;
+    std::atomic<unsigned> _highWater = 0;
+    std::atomic<uint32_t> _allocCount = 0;
+    std::atomic<uint32_t> _exhaustedCount = 0;
+};
+
+    }
+}
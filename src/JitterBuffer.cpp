@@ -0,0 +1,193 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "JitterBuffer.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+JitterBuffer::JitterBuffer(unsigned frameLen, Concealer* concealer)
+:   _frameLen(frameLen),
+    _concealer(concealer) {
+    assert(frameLen <= MAX_FRAME_LEN);
+    reset();
+}
+
+void JitterBuffer::reset() {
+    _haveEstimate = false;
+    _d = 0;
+    _v = 0;
+    _playing = false;
+    _ending = false;
+    _nextN = 0;
+    _missRun = 0;
+    _haveLastOrigin = false;
+    _playoutDelay = 0;
+    _avgBuffered = 0;
+    for (unsigned i = 0; i < SLOT_COUNT; i++)
+        _slots[i].full = false;
+    _stats = Stats();
+}
+
+void JitterBuffer::_track(int32_t transit) {
+    if (!_haveEstimate) {
+        _d = transit;
+        _v = INITIAL_VARIATION_MS;
+        _haveEstimate = true;
+        return;
+    }
+    _d = ALPHA * _d + (1.0 - ALPHA) * transit;
+    _v = ALPHA * _v + (1.0 - ALPHA) * std::fabs(_d - transit);
+}
+
+void JitterBuffer::_startSpurt(uint32_t originMs) {
+    _playing = true;
+    _ending = false;
+    _baseOrigin = originMs;
+    _nextN = 0;
+    _missRun = 0;
+    _playoutDelay = BETA * _v;
+    _offset = std::lround(_d + _playoutDelay);
+    for (unsigned i = 0; i < SLOT_COUNT; i++)
+        _slots[i].full = false;
+    _stats.spurts++;
+}
+
+uint32_t JitterBuffer::_playTime(int32_t n) const {
+    return _baseOrigin + n * FRAME_MS + _offset;
+}
+
+int JitterBuffer::consume(uint32_t originMs, uint32_t rxMs, const int16_t* frame,
+    const LatencyStamp* stamp) {
+
+    _stats.received++;
+    _track((int32_t)(rxMs - originMs));
+
+    if (!_playing) {
+        // Stragglers from the talkspurt that just ended don't start 
+        // a new one. Anything far enough back is assumed to be a 
+        // timestamp reset.
+        const int32_t sinceLast = (int32_t)(originMs - _lastOrigin);
+        if (_haveLastOrigin && sinceLast <= (int32_t)FRAME_MS / 2 &&
+            sinceLast > -(int32_t)(SLOT_COUNT * FRAME_MS)) {
+            _stats.late++;
+            return -1;
+        }
+        _startSpurt(originMs);
+    }
+
+    // Round to the nearest frame position
+    const int32_t delta = (int32_t)(originMs - _baseOrigin);
+    if (delta < -(int32_t)FRAME_MS / 2) {
+        _stats.late++;
+        return -1;
+    }
+    const int32_t n = (delta + (int32_t)FRAME_MS / 2) / (int32_t)FRAME_MS;
+    if (n < _nextN) {
+        _stats.late++;
+        return -1;
+    }
+    if (n >= _nextN + (int32_t)SLOT_COUNT) {
+        _stats.overflow++;
+        return -3;
+    }
+    Slot& slot = _slots[n % SLOT_COUNT];
+    if (slot.full && slot.n == n) {
+        _stats.duplicate++;
+        return -2;
+    }
+    slot.n = n;
+    slot.full = true;
+    slot.rxMs = rxMs;
+    if (stamp)
+        slot.stamp = *stamp;
+    else
+        slot.stamp.clear();
+    memcpy(slot.samples, frame, _frameLen * sizeof(int16_t));
+    return 0;
+}
+
+bool JitterBuffer::playOut(uint32_t nowMs, int16_t* out, LatencyStamp* stamp) {
+
+    if (!_playing || (int32_t)(nowMs - _playTime(_nextN)) < 0)
+        return false;
+
+    Slot& slot = _slots[_nextN % SLOT_COUNT];
+    if (slot.full && slot.n == _nextN) {
+        memcpy(out, slot.samples, _frameLen * sizeof(int16_t));
+        slot.full = false;
+        if (_concealer)
+            _concealer->goodFrame(out, _frameLen);
+        _stats.played++;
+        _stats.concealed += _missRun;
+        _missRun = 0;
+        const float buffered = (int32_t)(nowMs - slot.rxMs);
+        _avgBuffered = (_stats.played == 1) ? buffered : 
+            0.95f * _avgBuffered + 0.05f * buffered;
+        _lastOrigin = _baseOrigin + _nextN * FRAME_MS;
+        _lastRx = slot.rxMs;
+        _haveLastOrigin = true;
+        if (stamp)
+            *stamp = slot.stamp;
+    } 
+    else {
+        if ((_ending && !_anyBuffered()) || _missRun == MAX_CONCEAL_FRAMES) {
+            _stopSpurt();
+            return false;
+        }
+        _missRun++;
+        if (stamp)
+            stamp->clear();
+        if (_concealer)
+            _concealer->badFrame(out, _frameLen);
+        else
+            memset(out, 0, _frameLen * sizeof(int16_t));
+    }
+    _nextN++;
+    return true;
+}
+
+void JitterBuffer::endSpurt() {
+    if (_playing)
+        _ending = true;
+}
+
+void JitterBuffer::_stopSpurt() {
+    for (unsigned i = 0; i < SLOT_COUNT; i++) {
+        if (_slots[i].full) {
+            _slots[i].full = false;
+            _stats.dropped++;
+        }
+    }
+    _playing = false;
+    _ending = false;
+    _missRun = 0;
+}
+
+bool JitterBuffer::_anyBuffered() const {
+    for (unsigned i = 0; i < SLOT_COUNT; i++)
+        if (_slots[i].full)
+            return true;
+    return false;
+}
+
+    }
+}
@@ -0,0 +1,226 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "LatencyProbe.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * Fills in for frames that did not arrive in time (packet loss 
+ * concealment).
+ */
+class Concealer {
+public:
+
+    virtual ~Concealer() { }
+
+    /**
+     * Called with every frame that is played normally so the 
+     * concealer has history to work from.
+     */
+    virtual void goodFrame(const int16_t* frame, unsigned len) = 0;
+
+    /**
+     * Synthesizes a replacement for a missing frame.
+     */
+    virtual void badFrame(int16_t* out, unsigned len) = 0;
+};
+
+/**
+ * An adaptive jitter buffer for one inbound voice stream. This is the 
+ * model from sw/python/jitter.py:
+ *
+ * - For each frame the transit time n(i) (local arrival time minus the
+ *   origin timestamp, including any clock offset) is tracked with the
+ *   RFC793 style estimators d(i) = a * d(i-1) + (1 - a) * n(i) and 
+ *   v(i) = a * v(i-1) + (1 - a) * |d(i) - n(i)|.
+ * - At the start of each talkspurt the playout point is fixed at
+ *   d(i) + b * v(i). It stays put for the rest of the talkspurt so the
+ *   audio is never stretched or squeezed mid-sentence.
+ *
+ * Frames are held in a fixed ring of slots indexed by their position in
+ * the talkspurt (derived from the origin timestamp), so arrival order 
+ * does not matter. A frame that is missing at its playout point is 
+ * concealed, and a talkspurt ends after MAX_CONCEAL_FRAMES consecutive 
+ * misses (or an explicit endSpurt()).
+ *
+ * All storage is inside the object.
+ */
+class JitterBuffer {
+public:
+
+    static constexpr unsigned FRAME_MS = 20;
+    static constexpr unsigned SLOT_COUNT = 64;
+    static constexpr unsigned MAX_FRAME_LEN = 960;
+    static constexpr unsigned MAX_CONCEAL_FRAMES = 3;
+
+    static constexpr float ALPHA = 0.998002f;
+    static constexpr float BETA = 4.0f;
+
+    /**
+     * The variation estimate used before anything has been measured.
+     */
+    static constexpr float INITIAL_VARIATION_MS = 10.0f;
+
+    struct Stats {
+        uint32_t received = 0;
+        uint32_t played = 0;
+        // Arrived after the playout point had passed
+        uint32_t late = 0;
+        // Missing at the playout point
+        uint32_t concealed = 0;
+        uint32_t duplicate = 0;
+        // Too far ahead of the playout point to fit in the ring
+        uint32_t overflow = 0;
+        // Still buffered when the talkspurt ended
+        uint32_t dropped = 0;
+        uint32_t spurts = 0;
+    };
+
+    /**
+     * @param frameLen Samples per 20ms frame.
+     * @param concealer Used for missing frames, or nullptr to play 
+     *   silence instead.
+     */
+    JitterBuffer(unsigned frameLen, Concealer* concealer = nullptr);
+
+    /**
+     * Forgets everything, including the statistics.
+     */
+    void reset();
+
+    /**
+     * Accepts a frame from the network.
+     *
+     * @param originMs The origin timestamp of the frame.
+     * @param rxMs The local time that the frame arrived.
+     * @param stamp If not nullptr, kept with the frame and handed back 
+     *   when it is played.
+     * @returns 0 if the frame was queued, -1 if it arrived too late, -2 
+     *   if it is a duplicate, -3 if it is too far in the future.
+     */
+    int consume(uint32_t originMs, uint32_t rxMs, const int16_t* frame,
+        const LatencyStamp* stamp = nullptr);
+
+    /**
+     * Called once per 20ms audio tick.
+     *
+     * @param stamp If not nullptr, set to the stamp that came with the 
+     *   frame that was played (cleared for a concealed frame).
+     * @returns true if a frame (real or concealed) was written to out, 
+     *   false if nothing is playing.
+     */
+    bool playOut(uint32_t nowMs, int16_t* out, LatencyStamp* stamp = nullptr);
+
+    /**
+     * Ends the current talkspurt (ex: on an unkey). Frames that are 
+     * already buffered (or still arriving) are played out, and the 
+     * talkspurt stops without concealment once the buffer runs dry. The
+     * next frame after that starts a new talkspurt.
+     */
+    void endSpurt();
+
+    bool isPlaying() const { return _playing; }
+
+    /**
+     * @returns The current variation estimate v(i).
+     */
+    float getVariationMs() const { return _v; }
+
+    /**
+     * @returns The jitter allowance (playout point minus the mean transit)
+     *   that was chosen for the current/most recent talkspurt.
+     */
+    float getPlayoutDelayMs() const { return _playoutDelay; }
+
+    /**
+     * @returns The average time that played frames spent in the buffer.
+     */
+    float getAvgBufferedMs() const { return _avgBuffered; }
+
+    /**
+     * @returns The origin timestamp of the most recent frame that was 
+     *   played (not concealed).
+     */
+    uint32_t getLastPlayedOriginMs() const { return _lastOrigin; }
+
+    /**
+     * @returns The arrival time of the most recent frame that was played
+     *   (not concealed).
+     */
+    uint32_t getLastPlayedRxMs() const { return _lastRx; }
+
+    const Stats& getStats() const { return _stats; }
+
+private:
+
+    struct Slot {
+        // Position in the talkspurt
+        int32_t n;
+        bool full;
+        uint32_t rxMs;
+        LatencyStamp stamp;
+        int16_t samples[MAX_FRAME_LEN];
+    };
+
+    void _track(int32_t transit);
+    void _startSpurt(uint32_t originMs);
+    void _stopSpurt();
+    bool _anyBuffered() const;
+    uint32_t _playTime(int32_t n) const;
+
+    const unsigned _frameLen;
+    Concealer* _concealer;
+
+    bool _haveEstimate = false;
+    // Double because the transit includes the (possibly large) offset
+    // between the two clocks.
+    double _d = 0;
+    double _v = 0;
+
+    bool _playing = false;
+    // An unkey was seen
+    bool _ending = false;
+    // The origin timestamp of the first frame of the talkspurt
+    uint32_t _baseOrigin = 0;
+    // Transit allowance for this talkspurt (d + b * v)
+    int32_t _offset = 0;
+    float _playoutDelay = 0;
+    // The next position to be played
+    int32_t _nextN = 0;
+    // Consecutive concealed frames. These are only counted as concealed
+    // once a real frame follows them, since the concealment at the end of
+    // a talkspurt doesn't replace anything.
+    unsigned _missRun = 0;
+    // The end of the most recent talkspurt, to recognize stragglers
+    bool _haveLastOrigin = false;
+    uint32_t _lastOrigin = 0;
+    uint32_t _lastRx = 0;
+
+    float _avgBuffered = 0;
+
+    Slot _slots[SLOT_COUNT];
+    Stats _stats;
+};
+
+    }
+}
@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A histogram of durations in microseconds with HDR-style log-linear
+ * buckets: values below 16 have their own bucket and above that every
+ * power of two is split into 16 buckets, so any value is within about
+ * 6% of its bucket's bounds. Values up to MAX_VALUE_US (about 134
+ * seconds) are tracked, anything larger lands in the last bucket.
+ *
+ * Exactly one thread may call record(). Any thread can read the counts
+ * at any time without locking (the counts are relaxed atomics, so a
+ * reader might see a count without the matching sum, which is fine for
+ * monitoring). Nothing is ever reset, the counts are cumulative.
+ */
+class LatencyHistogram {
+public:
+
+    static constexpr unsigned SUB_BITS = 4;
+    static constexpr unsigned SUB_COUNT = 1 << SUB_BITS;
+    static constexpr unsigned MAX_SHIFT = 22;
+    static constexpr unsigned BUCKET_COUNT = (MAX_SHIFT + 2) * SUB_COUNT;
+    static constexpr uint64_t MAX_VALUE_US = (uint64_t)(2 * SUB_COUNT) << MAX_SHIFT;
+
+    /**
+     * @returns The bucket that a value falls into.
+     */
+    static unsigned bucketOf(uint64_t us) {
+        if (us < SUB_COUNT)
+            return us;
+        if (us >= MAX_VALUE_US)
+            return BUCKET_COUNT - 1;
+        const unsigned msb = 63 - __builtin_clzll(us);
+        const unsigned shift = msb - SUB_BITS;
+        return (shift + 1) * SUB_COUNT + ((us >> shift) - SUB_COUNT);
+    }
+
+    /**
+     * @returns The largest value that falls into a bucket.
+     */
+    static uint64_t bucketUpperUs(unsigned bucket) {
+        if (bucket < SUB_COUNT)
+            return bucket;
+        const unsigned shift = bucket / SUB_COUNT - 1;
+        const uint64_t mantissa = SUB_COUNT + bucket % SUB_COUNT;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    /**
+     * (Writer only)
+     */
+    void record(uint64_t us) {
+        // Single writer, so no read-modify-write is needed
+        std::atomic<uint32_t>& b = _buckets[bucketOf(us)];
+        b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        _count.store(_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        _sumUs.store(_sumUs.load(std::memory_order_relaxed) + us, std::memory_order_relaxed);
+        if (us > _maxUs.load(std::memory_order_relaxed))
+            _maxUs.store(us, std::memory_order_relaxed);
+    }
+
+    uint64_t getCount() const { return _count.load(std::memory_order_relaxed); }
+    uint64_t getSumUs() const { return _sumUs.load(std::memory_order_relaxed); }
+    uint64_t getMaxUs() const { return _maxUs.load(std::memory_order_relaxed); }
+
+    uint32_t getBucketCount(unsigned bucket) const {
+        return _buckets[bucket].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @param p The percentile (0-100).
+     * @returns The upper bound of the bucket that holds the percentile
+     *   (never more than the maximum), or 0 if nothing has been recorded.
+     */
+    uint64_t percentileUs(double p) const {
+        uint64_t total = 0;
+        for (unsigned i = 0; i < BUCKET_COUNT; i++)
+            total += getBucketCount(i);
+        if (total == 0)
+            return 0;
+        uint64_t rank = (uint64_t)(p / 100.0 * total + 0.5);
+        if (rank < 1)
+            rank = 1;
+        if (rank > total)
+            rank = total;
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < BUCKET_COUNT; i++) {
+            seen += getBucketCount(i);
+            if (seen >= rank) {
+                const uint64_t upper = bucketUpperUs(i);
+                const uint64_t max = getMaxUs();
+                return (upper < max) ? upper : max;
+            }
+        }
+        return getMaxUs();
+    }
+
+private:
+
+    std::atomic<uint32_t> _buckets[BUCKET_COUNT] = { };
+    std::atomic<uint64_t> _count = 0;
+    std::atomic<uint64_t> _sumUs = 0;
+    std::atomic<uint64_t> _maxUs = 0;
+};
+
+    }
+}
@@ -0,0 +1,132 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "LatencyHistogram.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * The times (monotonic microseconds) that an audio frame passed each
+ * point on its way through the server. This is small enough to travel
+ * with the frame. A time of 0 means the point wasn't marked.
+ */
+struct LatencyStamp {
+
+    enum Point {
+        // Read from the device (ALSA/serial) or received from the network
+        CAPTURE,
+        // Handed to the bridge (entered the jitter buffer)
+        QUEUED,
+        // Taken out of the jitter buffer for mixing
+        PLAYOUT,
+        // Mixed, encoded and sent (or written to the device)
+        SENT,
+        POINT_COUNT
+    };
+
+    uint64_t us[POINT_COUNT] = { };
+
+    void mark(Point p, uint64_t nowUs) { us[p] = nowUs; }
+    bool has(Point p) const { return us[p] != 0; }
+    void clear() { memset(us, 0, sizeof(us)); }
+};
+
+/**
+ * Per-direction distributions of the time that frames spend in each
+ * stage between the points of a LatencyStamp:
+ *
+ * - INPUT is CAPTURE to QUEUED (device buffering, line receive queues)
+ * - JITTER is QUEUED to PLAYOUT (jitter buffering)
+ * - BRIDGE is PLAYOUT to SENT (mixing, encoding, send queueing)
+ * - TOTAL is CAPTURE to SENT
+ *
+ * A direction is something like "IAX2->USB". Directions are added up
+ * front (no allocation after that). Each direction must only be
+ * recorded from one thread, anyone can read.
+ *
+ * In amp-server (--latency) each ShardMailbox is a direction, named for
+ * the line that it delivers to (see ShardMailbox::setProbe()).
+ */
+class LatencyProbe {
+public:
+
+    enum Stage { INPUT, JITTER, BRIDGE, TOTAL, STAGE_COUNT };
+
+    static constexpr unsigned MAX_PATHS = 16;
+    static constexpr unsigned MAX_NAME_LEN = 32;
+
+    static const char* stageName(Stage s) {
+        static const char* names[] = { "input", "jitter", "bridge", "total" };
+        return names[s];
+    }
+
+    /**
+     * @returns The direction's index, or -1 if there are too many.
+     */
+    int addPath(const char* name) {
+        if (_pathCount == MAX_PATHS)
+            return -1;
+        strncpy(_paths[_pathCount].name, name, MAX_NAME_LEN - 1);
+        return _pathCount++;
+    }
+
+    unsigned getPathCount() const { return _pathCount; }
+    const char* getPathName(unsigned path) const { return _paths[path].name; }
+
+    const LatencyHistogram& getHistogram(unsigned path, Stage stage) const {
+        return _paths[path].stages[stage];
+    }
+
+    /**
+     * Records the stages of a frame that has reached the end of a
+     * direction. A stage is skipped unless both of its points are
+     * marked.
+     */
+    void record(unsigned path, const LatencyStamp& stamp) {
+        LatencyHistogram* h = _paths[path].stages;
+        _stage(h[INPUT], stamp, LatencyStamp::CAPTURE, LatencyStamp::QUEUED);
+        _stage(h[JITTER], stamp, LatencyStamp::QUEUED, LatencyStamp::PLAYOUT);
+        _stage(h[BRIDGE], stamp, LatencyStamp::PLAYOUT, LatencyStamp::SENT);
+        _stage(h[TOTAL], stamp, LatencyStamp::CAPTURE, LatencyStamp::SENT);
+    }
+
+private:
+
+    static void _stage(LatencyHistogram& h, const LatencyStamp& stamp,
+        LatencyStamp::Point from, LatencyStamp::Point to) {
+        // A clock that went backwards counts as no time
+        if (stamp.has(from) && stamp.has(to))
+            h.record(stamp.us[to] > stamp.us[from] ? stamp.us[to] - stamp.us[from] : 0);
+    }
+
+    struct Path {
+        char name[MAX_NAME_LEN] = { };
+        LatencyHistogram stages[STAGE_COUNT];
+    };
+
+    unsigned _pathCount = 0;
+    Path _paths[MAX_PATHS];
+};
+
+    }
+}
@@ -0,0 +1,323 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "kc1fsz-tools/threadsafequeue2.h"
+
+// amp-core
+#include "TraceLog.h"
+#include "MultiRouter.h"
+#include "LineIAX2.h"
+#include "Bridge.h"
+#include "BridgeCall.h"
+
+#include "CallDriver.h"
+#include "LineReplay.h"
+#include "ReplayClock.h"
+#include "StaticRegistry.h"
+
+using namespace std;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+static const unsigned SERVER_LINE_ID = 1;
+static const unsigned BRIDGE_LINE_ID = 10;
+static const unsigned DRIVER_LINE_ID = 99;
+// Client N uses line CLIENT_LINE_ID + N
+static const unsigned CLIENT_LINE_ID = 100;
+static const char* SERVER_NODE = "1000";
+static const unsigned CLIENT_NODE = 2000;
+static const uint32_t TICK_MS = 20;
+// How long after its last frame a call still counts as talking
+static const uint32_t HANG_MS = 100;
+static const unsigned TRACE_LOG_LEN = 64;
+// Limits the work done at one step if something never goes idle
+static const unsigned MAX_ROUNDS = 1000;
+
+static double cpuSec() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double wallSec() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void loopback(sockaddr_storage& addr, uint16_t port) {
+    memset(&addr, 0, sizeof(addr));
+    sockaddr_in& a = (sockaddr_in&)addr;
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    a.sin_port = htons(port);
+}
+
+uint32_t LineReplay::Report::latencyPercentile(double p) const {
+    if (onsetLatencyMs.empty())
+        return 0;
+    std::vector<uint32_t> sorted(onsetLatencyMs);
+    size_t i = std::min(sorted.size() - 1, (size_t)(p / 100.0 * sorted.size()));
+    std::nth_element(sorted.begin(), sorted.begin() + i, sorted.end());
+    return sorted[i];
+}
+
+double LineReplay::Report::cpuUsPerCallSecond() const {
+    if (calls == 0 || simulatedSec == 0)
+        return 0;
+    return serverCpuSec * 1e6 / (calls * simulatedSec);
+}
+
+LineReplay::Report LineReplay::run(Log& log, const std::vector<ReplayEvent>& timeline,
+    const Options& opts) {
+
+    Report r;
+
+    // Only the voice is sent
+    std::vector<ReplayEvent> events;
+    for (const ReplayEvent& e : timeline)
+        if (e.type == ReplayEvent::Type::VOICE)
+            events.push_back(e);
+    std::stable_sort(events.begin(), events.end(),
+        [](const ReplayEvent& a, const ReplayEvent& b) { return a.timeUs < b.timeUs; });
+    if (events.empty())
+        return r;
+
+    // Timeline call IDs to clients, and the shortest flight time seen on
+    // each call. The rest of a frame's flight time is what the client's
+    // clock is set back by when the frame is sent.
+    std::map<uint32_t, unsigned> clientOfCall;
+    std::vector<int64_t> minFlightMs;
+    for (const ReplayEvent& e : events) {
+        const int64_t flightMs = (int64_t)(e.timeUs / 1000) - e.originMs;
+        auto it = clientOfCall.find(e.callId);
+        if (it == clientOfCall.end()) {
+            clientOfCall[e.callId] = minFlightMs.size();
+            minFlightMs.push_back(flightMs);
+        } else
+            minFlightMs[it->second] = std::min(minFlightMs[it->second], flightMs);
+    }
+    const unsigned calls = minFlightMs.size();
+    r.calls = calls;
+
+    ReplayClock serverClock;
+    std::unique_ptr<std::string[]> traceLogData(new std::string[TRACE_LOG_LEN]);
+    TraceLog traceLog(serverClock, traceLogData.get(), TRACE_LOG_LEN);
+    threadsafequeue2<Message> respQueue;
+    MultiRouter router(respQueue);
+
+    sockaddr_storage serverAddr;
+    loopback(serverAddr, opts.basePort);
+    StaticRegistry registry;
+    registry.add(SERVER_NODE, serverAddr);
+
+    // The server side, wired the way amp-server wires it
+    amp::Bridge bridge(log, traceLog, serverClock, router, amp::BridgeCall::Mode::NORMAL,
+        BRIDGE_LINE_ID, 0, 0, 0, 1);
+    bridge.setLocalNodeNumber(SERVER_NODE);
+    router.addRoute(&bridge, BRIDGE_LINE_ID);
+    LineIAX2 server(log, traceLog, serverClock, SERVER_LINE_ID, router, 0, 0, &registry,
+        BRIDGE_LINE_ID);
+    router.addRoute(&server, SERVER_LINE_ID);
+    if (opts.trace)
+        server.setTrace(true);
+    if (server.open(AF_INET, opts.basePort, "radio") < 0) {
+        log.error("Unable to open port %u", (unsigned)opts.basePort);
+        return r;
+    }
+
+    // The client side
+    CallDriver driver(router, DRIVER_LINE_ID);
+    router.addRoute(&driver, DRIVER_LINE_ID);
+    std::vector<std::unique_ptr<ReplayClock>> clientClocks;
+    std::vector<std::unique_ptr<LineIAX2>> clients;
+    for (unsigned c = 0; c < calls; c++) {
+        clientClocks.push_back(std::make_unique<ReplayClock>(serverClock.time()));
+        clients.push_back(std::unique_ptr<LineIAX2>(new LineIAX2(log, traceLog, 
+            *clientClocks[c], CLIENT_LINE_ID + c, router, 0, 0, &registry, DRIVER_LINE_ID)));
+        router.addRoute(clients[c].get(), CLIENT_LINE_ID + c);
+        if (clients[c]->open(AF_INET, opts.basePort + 1 + c, "radio") < 0) {
+            log.error("Unable to open port %u", opts.basePort + 1 + c);
+            return r;
+        }
+    }
+
+    double serverCpu = 0;
+    // Runs everything until there is nothing left to do. The loopback
+    // socket has a sent datagram ready to read right away.
+    auto settle = [&]() {
+        for (unsigned round = 0; round < MAX_ROUNDS; round++) {
+            bool worked = false;
+            for (auto& client : clients)
+                if (client->run2())
+                    worked = true;
+            const double t0 = cpuSec();
+            if (server.run2())
+                worked = true;
+            if (bridge.run2())
+                worked = true;
+            serverCpu += cpuSec() - t0;
+            if (!worked)
+                break;
+        }
+    };
+
+    uint64_t ticks = 0;
+    uint32_t nextTickMs = serverClock.time() + TICK_MS;
+    auto setClocks = [&](uint32_t t) {
+        serverClock.set(t);
+        for (auto& clock : clientClocks)
+            clock->set(t);
+    };
+    // Moves simulated time forward, ticking everything on the way
+    auto advanceTo = [&](uint32_t t) {
+        while ((int32_t)(t - nextTickMs) >= 0) {
+            setClocks(nextTickMs);
+            for (auto& client : clients)
+                client->audioRateTick(nextTickMs);
+            double t0 = cpuSec();
+            server.audioRateTick(nextTickMs);
+            bridge.audioRateTick(nextTickMs);
+            serverCpu += cpuSec() - t0;
+            ticks++;
+            if (ticks % (1000 / TICK_MS) == 0) {
+                for (auto& client : clients)
+                    client->oneSecTick();
+                t0 = cpuSec();
+                server.oneSecTick();
+                bridge.oneSecTick();
+                serverCpu += cpuSec() - t0;
+            }
+            if (ticks % (10000 / TICK_MS) == 0) {
+                for (auto& client : clients)
+                    client->tenSecTick();
+                t0 = cpuSec();
+                server.tenSecTick();
+                bridge.tenSecTick();
+                serverCpu += cpuSec() - t0;
+            }
+            settle();
+            nextTickMs += TICK_MS;
+        }
+        setClocks(t);
+    };
+
+    // Every call has to be up before the timeline starts
+    for (unsigned c = 0; c < calls; c++)
+        clients[c]->call(to_string(CLIENT_NODE + c).c_str(), SERVER_NODE);
+    settle();
+    const uint32_t setupEndMs = serverClock.time() + opts.setupTimeoutMs;
+    while (driver.getUpCount() < calls && (int32_t)(serverClock.time() - setupEndMs) < 0)
+        advanceTo(serverClock.time() + TICK_MS);
+    r.connected = driver.getUpCount();
+    if (r.connected < calls) {
+        log.error("Only %u of %u calls connected", r.connected, calls);
+        return r;
+    }
+    // The driver numbers the calls in the order that they came up
+    std::vector<unsigned> driverIndex(calls), clientOfIndex(calls);
+    for (unsigned c = 0; c < calls; c++) {
+        driverIndex[c] = driver.findLine(CLIENT_LINE_ID + c);
+        clientOfIndex[driverIndex[c]] = c;
+    }
+
+    // Talkspurt onsets
+    std::vector<bool> talking(calls, false);
+    std::vector<uint32_t> lastVoiceMs(calls, 0);
+    unsigned talkingCount = 0;
+    std::vector<bool> waiting(calls, false);
+    unsigned waitingCount = 0;
+    uint32_t onsetMs = 0;
+    driver.setAudioHandler([&](unsigned index, bool voice) {
+        const unsigned c = clientOfIndex[index];
+        if (voice && waiting[c]) {
+            r.onsetLatencyMs.push_back(serverClock.time() - onsetMs);
+            waiting[c] = false;
+            waitingCount--;
+        }
+    });
+
+    const double wall0 = wallSec();
+    serverCpu = 0;
+    const uint32_t startMs = serverClock.time();
+    const uint64_t firstUs = events.front().timeUs;
+    for (const ReplayEvent& e : events) {
+        const uint32_t now = startMs + (e.timeUs - firstUs) / 1000;
+        advanceTo(now);
+        const unsigned c = clientOfCall[e.callId];
+
+        for (unsigned k = 0; k < calls; k++) {
+            if (talking[k] && now - lastVoiceMs[k] > HANG_MS) {
+                talking[k] = false;
+                talkingCount--;
+            }
+        }
+        if (!talking[c]) {
+            // A talkspurt that starts in silence. Whoever didn't hear
+            // the last one never will.
+            if (talkingCount == 0) {
+                r.missedOnsets += waitingCount;
+                for (unsigned k = 0; k < calls; k++)
+                    waiting[k] = (k != c);
+                waitingCount = calls - 1;
+                onsetMs = now;
+                r.onsets++;
+            }
+            talking[c] = true;
+            talkingCount++;
+        }
+        lastVoiceMs[c] = now;
+        if (talkingCount == 1)
+            r.voiceExpected += calls - 1;
+
+        // The client's clock is set back by the frame's extra flight
+        // time while the frame is sent
+        const int64_t extraMs = (int64_t)(e.timeUs / 1000) - e.originMs - minFlightMs[c];
+        clientClocks[c]->set(now - (uint32_t)extraMs);
+        driver.sendVoice(driverIndex[c], now - (uint32_t)extraMs);
+        for (unsigned round = 0; round < MAX_ROUNDS && clients[c]->run2(); round++);
+        clientClocks[c]->set(now);
+        settle();
+    }
+    // Let the last frames play out
+    advanceTo(serverClock.time() + 1000);
+    r.missedOnsets += waitingCount;
+
+    r.simulatedSec = (events.back().timeUs - firstUs) / 1e6;
+    r.wallSec = wallSec() - wall0;
+    r.serverCpuSec = serverCpu;
+    for (const CallDriver::Call& call : driver.getCalls()) {
+        r.voiceSent += call.voiceSent;
+        r.framesReceived += call.framesReceived;
+        r.voiceReceived += call.voiceReceived;
+    }
+    return r;
+}
+
+    }
+}
@@ -0,0 +1,94 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "kc1fsz-tools/Log.h"
+
+#include "ReplayHarness.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * Replays a packet timeline through the same LineIAX2 -> Bridge that
+ * amp-server runs, in simulated time.
+ *
+ * The server side is a LineIAX2 (line 1) and a Bridge (line 10) on a
+ * loopback UDP port. Each call in the timeline is placed by its own
+ * client LineIAX2 with its own ReplayClock, and a CallDriver plays the
+ * bridge for all of the clients. A VOICE event is sent by the call's
+ * client with its clock set from the origin time, so the IAX2 timestamps
+ * carry the recorded jitter, and it reaches the server at the event's
+ * arrival time. Everything runs on one thread: the server's clock only
+ * moves between events and 20ms ticks, and every line and bridge is run
+ * until it is idle at each step.
+ *
+ * UNKEY events are not sent, a talkspurt ends when its frames stop.
+ */
+class LineReplay {
+public:
+
+    struct Options {
+        // The server uses this port, the clients the ones after it
+        uint16_t basePort = 46000;
+        unsigned setupTimeoutMs = 10000;
+        bool trace = false;
+    };
+
+    struct Report {
+        unsigned calls = 0;
+        unsigned connected = 0;
+        double simulatedSec = 0;
+        double wallSec = 0;
+        // Spent in the server's LineIAX2 and Bridge only
+        double serverCpuSec = 0;
+        uint32_t voiceSent = 0;
+        uint32_t framesReceived = 0;
+        uint32_t voiceReceived = 0;
+        // Voice frames that each listener should have heard: frames sent
+        // while only one call was talking, times the other calls
+        uint64_t voiceExpected = 0;
+        // Talkspurts that started while nobody else was talking
+        uint32_t onsets = 0;
+        // Listeners that didn't hear one of those before it ended
+        uint32_t missedOnsets = 0;
+        // From the start of a talkspurt at the server to its first
+        // voice frame at each listener
+        std::vector<uint32_t> onsetLatencyMs;
+
+        /**
+         * @param p In the range 0-100.
+         */
+        uint32_t latencyPercentile(double p) const;
+
+        double cpuUsPerCallSecond() const;
+    };
+
+    /**
+     * @returns The report. Nothing is replayed unless every call
+     *   connects (see Report::connected).
+     */
+    static Report run(Log& log, const std::vector<ReplayEvent>& events,
+        const Options& opts);
+};
+
+    }
+}
@@ -0,0 +1,201 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <string>
+
+#include "LoadGenerator.h"
+
+using namespace std;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+static const uint32_t FRAME_MS = 20;
+// Limits the work done in one service() if the line never goes idle
+static const unsigned MAX_ROUNDS = 64;
+
+uint32_t LoadGenerator::Stats::latencyPercentile(double p) const {
+    if (latencyMs.empty())
+        return 0;
+    std::vector<uint32_t> sorted(latencyMs);
+    size_t i = std::min(sorted.size() - 1, (size_t)(p / 100.0 * sorted.size()));
+    std::nth_element(sorted.begin(), sorted.begin() + i, sorted.end());
+    return sorted[i];
+}
+
+LoadGenerator::LoadGenerator(Log& log, Clock& clock, const Options& opts)
+:   _log(log),
+    _clock(clock),
+    _opts(opts),
+    _traceLogData(new std::string[TRACE_LOG_LEN]),
+    _traceLog(clock, _traceLogData.get(), TRACE_LOG_LEN),
+    _router(_respQueue),
+    _line(log, _traceLog, clock, LINE_ID, _router, 0, 0, &_registry, DRIVER_LINE_ID),
+    _driver(_router, DRIVER_LINE_ID, opts.codec),
+    _rng(opts.seed) {
+    _registry.add(_opts.calledNumber, _opts.target);
+    _router.addRoute(&_line, LINE_ID);
+    _router.addRoute(&_driver, DRIVER_LINE_ID);
+    _driver.setAudioHandler([this](unsigned index, bool voice) { _onAudio(index, voice); });
+}
+
+int LoadGenerator::open() {
+    if (_line.open(_opts.target.ss_family, _opts.localPort, "radio") < 0) {
+        _log.error("Unable to open port %u", (unsigned)_opts.localPort);
+        return -1;
+    }
+    return 0;
+}
+
+int LoadGenerator::getPolls(pollfd* fds, unsigned fdsCapacity) {
+    return _line.getPolls(fds, fdsCapacity);
+}
+
+void LoadGenerator::_runLine() {
+    for (unsigned round = 0; round < MAX_ROUNDS && _line.run2(); round++);
+}
+
+void LoadGenerator::service() {
+
+    const uint32_t now = _clock.time();
+    if (!_running) {
+        _running = true;
+        _firstServiceMs = now;
+        _nextTickMs = now;
+        _spurtChangeMs = now;
+    }
+
+    // Ramp up
+    const uint64_t allowed = (uint64_t)(now - _firstServiceMs) * _opts.rampRate / 1000 + 1;
+    while (_stats.callsStarted < _opts.calls && _stats.callsStarted < allowed) {
+        const string calling = to_string(_opts.firstCallingNumber + _stats.callsStarted);
+        _line.call(calling.c_str(), _opts.calledNumber.c_str());
+        _pendingStarts.push_back(now);
+        _stats.callsStarted++;
+    }
+
+    _runLine();
+
+    if ((int32_t)(now - _nextTickMs) >= 0) {
+        _tick(now);
+        _nextTickMs += FRAME_MS;
+        if ((int32_t)(now - _nextTickMs) >= 0)
+            _nextTickMs = now + FRAME_MS;
+        _runLine();
+    }
+}
+
+void LoadGenerator::_tick(uint32_t now) {
+
+    _line.audioRateTick(now);
+    _ticks++;
+    if (_ticks % (1000 / FRAME_MS) == 0)
+        _line.oneSecTick();
+    if (_ticks % (10000 / FRAME_MS) == 0)
+        _line.tenSecTick();
+
+    // Calls that came up, oldest first
+    const std::vector<CallDriver::Call>& calls = _driver.getCalls();
+    while (_answeredSeen < calls.size()) {
+        _answeredSeen++;
+        _stats.callsAnswered++;
+        if (!_pendingStarts.empty())
+            _pendingStarts.pop_front();
+    }
+    while (!_pendingStarts.empty() && now - _pendingStarts.front() > _opts.setupTimeoutMs) {
+        _pendingStarts.pop_front();
+        _stats.callsFailed++;
+    }
+    _talking.resize(calls.size(), false);
+    _listening.resize(calls.size(), false);
+
+    _schedule(now);
+
+    unsigned talkingCount = 0;
+    for (unsigned i = 0; i < calls.size(); i++) {
+        if (_talking[i] && calls[i].up) {
+            _driver.sendVoice(i, now);
+            talkingCount++;
+        }
+    }
+    // Everybody who is up hears the others
+    if (talkingCount > 0)
+        for (unsigned i = 0; i < calls.size(); i++)
+            if (calls[i].up && talkingCount > (_talking[i] ? 1u : 0u))
+                _stats.voiceExpected++;
+
+    _stats.callsEnded = calls.size() - _driver.getUpCount();
+    _stats.voiceSent = 0;
+    _stats.framesReceived = 0;
+    _stats.voiceReceived = 0;
+    for (const CallDriver::Call& call : calls) {
+        _stats.voiceSent += call.voiceSent;
+        _stats.framesReceived += call.framesReceived;
+        _stats.voiceReceived += call.voiceReceived;
+    }
+}
+
+void LoadGenerator::_schedule(uint32_t now) {
+
+    if ((int32_t)(now - _spurtChangeMs) < 0)
+        return;
+
+    if (_spurtOn) {
+        for (unsigned i = 0; i < _talking.size(); i++) {
+            _talking[i] = false;
+            if (_listening[i]) {
+                _listening[i] = false;
+                _stats.missedOnsets++;
+            }
+        }
+        _spurtOn = false;
+        std::exponential_distribution<double> gap(1.0 / _opts.gapMeanMs);
+        _spurtChangeMs = now + FRAME_MS + (uint32_t)gap(_rng);
+        return;
+    }
+
+    // Pick the next talkers round-robin from the calls that are up
+    const std::vector<CallDriver::Call>& calls = _driver.getCalls();
+    std::vector<unsigned> up;
+    for (unsigned i = 0; i < calls.size(); i++)
+        if (calls[i].up)
+            up.push_back(i);
+    // Need at least one listener
+    if (up.size() < _opts.talkers + 1)
+        return;
+    for (unsigned k = 0; k < _opts.talkers; k++)
+        _talking[up[(_nextTalker + k) % up.size()]] = true;
+    _nextTalker += _opts.talkers;
+    for (unsigned i : up)
+        _listening[i] = !_talking[i];
+    _spurtOn = true;
+    _spurtStartMs = now;
+    _stats.spurts++;
+    std::exponential_distribution<double> spurt(1.0 / _opts.spurtMeanMs);
+    _spurtChangeMs = now + FRAME_MS + (uint32_t)spurt(_rng);
+}
+
+void LoadGenerator::_onAudio(unsigned index, bool voice) {
+    if (voice && index < _listening.size() && _listening[index]) {
+        _listening[index] = false;
+        _stats.latencyMs.push_back(_clock.time() - _spurtStartMs);
+    }
+}
+
+    }
+}
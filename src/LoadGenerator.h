@@ -0,0 +1,178 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/Clock.h"
+#include "kc1fsz-tools/threadsafequeue2.h"
+
+// amp-core
+#include "TraceLog.h"
+#include "MultiRouter.h"
+#include "LineIAX2.h"
+
+#include "CallDriver.h"
+#include "StaticRegistry.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * Places many simultaneous IAX2 calls into a server and plays a
+ * talkspurt/silence pattern into them to find out how many calls a
+ * Bridge can carry.
+ *
+ * The calls are placed by one LineIAX2, the same one amp-server uses,
+ * with a CallDriver in place of its Bridge. At any moment a fixed number
+ * of calls (the talkers) are sending voice and the rest are listening.
+ * Each time a new talkspurt starts, every listener measures how long it
+ * takes for the talker's audio to show up in what the server sends
+ * back. This is the round-trip audio latency through the server (jitter
+ * buffer, mixer and encoder included).
+ *
+ * Only unauthenticated (guest) calls are supported.
+ */
+class LoadGenerator {
+public:
+
+    using Codec = CallDriver::Codec;
+
+    struct Options {
+        sockaddr_storage target;
+        std::string calledNumber = "1000";
+        // Call N comes from this number plus N
+        unsigned firstCallingNumber = 2000;
+        // Where the calls are placed from
+        uint16_t localPort = 4570;
+        unsigned calls = 100;
+        // New calls per second
+        unsigned rampRate = 20;
+        // How long a call has to come up
+        unsigned setupTimeoutMs = 10000;
+        Codec codec = Codec::ULAW;
+        // Calls talking at the same time
+        unsigned talkers = 1;
+        unsigned spurtMeanMs = 2000;
+        unsigned gapMeanMs = 1000;
+        unsigned seed = 1;
+    };
+
+    struct Stats {
+        uint32_t callsStarted = 0;
+        uint32_t callsAnswered = 0;
+        // Didn't come up in time
+        uint32_t callsFailed = 0;
+        // Came up and then ended
+        uint32_t callsEnded = 0;
+        uint32_t voiceSent = 0;
+        uint32_t framesReceived = 0;
+        uint32_t voiceReceived = 0;
+        // One for each listener on each tick that somebody else talked
+        uint32_t voiceExpected = 0;
+        uint32_t spurts = 0;
+        // Listeners that never heard a talkspurt
+        uint32_t missedOnsets = 0;
+        std::vector<uint32_t> latencyMs;
+
+        uint32_t latencyPercentile(double p) const;
+    };
+
+    /**
+     * @param clock The real time.
+     */
+    LoadGenerator(Log& log, Clock& clock, const Options& opts);
+
+    /**
+     * Opens the local port.
+     * @returns 0 on success, -1 on error.
+     */
+    int open();
+
+    /**
+     * @returns The number of pollfds filled in, for waiting between
+     *   calls to service().
+     */
+    int getPolls(pollfd* fds, unsigned fdsCapacity);
+
+    /**
+     * Does everything that is due: starts calls, runs the line, sends
+     * voice. Call at least every few milliseconds.
+     */
+    void service();
+
+    /**
+     * @returns The number of calls that are up.
+     */
+    unsigned getActiveCount() const { return _driver.getUpCount(); }
+
+    const Stats& getStats() const { return _stats; }
+
+private:
+
+    static constexpr unsigned LINE_ID = 1;
+    static constexpr unsigned DRIVER_LINE_ID = 10;
+    static constexpr unsigned TRACE_LOG_LEN = 64;
+
+    void _runLine();
+    void _tick(uint32_t nowMs);
+    void _schedule(uint32_t nowMs);
+    void _onAudio(unsigned index, bool voice);
+
+    Log& _log;
+    Clock& _clock;
+    Options _opts;
+    std::unique_ptr<std::string[]> _traceLogData;
+    TraceLog _traceLog;
+    threadsafequeue2<Message> _respQueue;
+    MultiRouter _router;
+    StaticRegistry _registry;
+    LineIAX2 _line;
+    CallDriver _driver;
+
+    bool _running = false;
+    uint32_t _firstServiceMs = 0;
+    uint32_t _nextTickMs = 0;
+    uint64_t _ticks = 0;
+    // When each call that hasn't come up yet was placed
+    std::deque<uint32_t> _pendingStarts;
+    unsigned _answeredSeen = 0;
+
+    // Talkspurt schedule, by the driver's call index
+    std::vector<bool> _talking;
+    std::vector<bool> _listening;
+    bool _spurtOn = false;
+    uint32_t _spurtChangeMs = 0;
+    uint32_t _spurtStartMs = 0;
+    unsigned _nextTalker = 0;
+    std::mt19937 _rng;
+
+    Stats _stats;
+};
+
+    }
+}
@@ -0,0 +1,45 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "LocalRegistryStd.h"
+
+namespace kc1fsz {
+
+bool LocalRegistryStd::lookup(const char* destNumber, sockaddr_storage& addr,
+    fixedstring& user, fixedstring& password) {
+
+    const amp::NodeDb::Record* r = _db.find(destNumber);
+    if (r) {
+        r->getAddr(addr);
+        user = r->user[0] ? r->user : DEFAULT_USER;
+        password = r->password;
+        _dbHits++;
+        return true;
+    }
+
+    if (_cache &&
+        _cache->lookup(destNumber, addr) == amp::ResolverCache::Result::HIT) {
+        user = DEFAULT_USER;
+        password = "";
+        _cacheHits++;
+        return true;
+    }
+
+    _misses++;
+    return false;
+}
+
+}
@@ -15,35 +15,66 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #pragma once
-#include <cstring>
+
+#include <atomic>
+#include <cstdint>
 
 #include "kc1fsz-tools/fixedstring.h"
-#include "kc1fsz-tools/NetUtils.h"
 
 #include "LineIAX2.h"
+#include "NodeDb.h"
+#include "ResolverCache.h"
 
 namespace kc1fsz {
 
-// #### TODO: Need a real implementation for this.
+/**
+ * Where the IAX2 lines look up a node before they go to DNS.
+ *
+ * 1. The node database (--nodedb), which has the address and the
+ *    credentials. This is a read-only mmap, so it is safe from any shard.
+ * 2. The resolver cache, for everything else. An address that has been
+ *    resolved before comes back from memory. The first call to a node
+ *    (and any call to a node that doesn't exist) returns false so the
+ *    line uses its own DNS lookup, while the cache resolves it in the
+ *    background for next time.
+ */
 class LocalRegistryStd : public LocalRegistry {
 public:
-    virtual bool lookup(const char* destNumber, sockaddr_storage& addr, 
-        fixedstring& user, fixedstring& password) {
-        if (strcmp(destNumber, "2000") == 0) {
-            addr.ss_family = AF_INET;
-            setIPAddr(addr,"192.168.8.143");
-            setIPPort(addr, 4569);
-            user = "bruce";
-            password = "hello";
-            return true;
-        }
-        else {
-            // At the moment there is nothing in the local registry
-            return false;
-        }
-    }
-};
 
-}
+    // What public ASL nodes expect from a caller that isn't in the
+    // database
+    static constexpr const char* DEFAULT_USER = "radio";
+
+    /**
+     * (Setup only)
+     *
+     * @returns 0 on success, -1 if the database can't be opened.
+     */
+    int openDatabase(const char* fileName) { return _db.open(fileName); }
 
+    unsigned getDatabaseCount() const { return _db.getCount(); }
 
+    /**
+     * (Setup only)
+     *
+     * @param cache Must exist for the life of this object.
+     */
+    void setResolverCache(amp::ResolverCache* cache) { _cache = cache; }
+
+    virtual bool lookup(const char* destNumber, sockaddr_storage& addr,
+        fixedstring& user, fixedstring& password);
+
+    uint64_t getDatabaseHits() const { return _dbHits; }
+    uint64_t getCacheHits() const { return _cacheHits; }
+    uint64_t getMisses() const { return _misses; }
+
+private:
+
+    amp::NodeDb _db;
+    amp::ResolverCache* _cache = nullptr;
+    std::atomic<uint64_t> _dbHits = 0;
+    std::atomic<uint64_t> _cacheHits = 0;
+    std::atomic<uint64_t> _misses = 0;
+};
+
+}
@@ -0,0 +1,202 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <sstream>
+
+#include <nlohmann/json.hpp>
+
+#include "MetricsFormat.h"
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+static json histogramJson(const LatencyHistogram& h) {
+    json j;
+    j["count"] = h.getCount();
+    j["sumUs"] = h.getSumUs();
+    j["maxUs"] = h.getMaxUs();
+    j["p50Us"] = h.percentileUs(50);
+    j["p90Us"] = h.percentileUs(90);
+    j["p99Us"] = h.percentileUs(99);
+    j["p999Us"] = h.percentileUs(99.9);
+    return j;
+}
+
+string renderMetricsJson(const vector<ShardMetrics>& shards, const LatencyProbe* latency) {
+    json doc;
+    doc["shards"] = json::array();
+    for (const ShardMetrics& s : shards) {
+        json js;
+        js["id"] = s.id;
+        js["ticks"] = s.ticks;
+        js["overruns"] = s.overruns;
+        js["worstTickUs"] = s.worstTickUs;
+        if (s.worstOffender.empty())
+            js["worstOffender"] = nullptr;
+        else
+            js["worstOffender"] = s.worstOffender;
+        js["tickWork"] = histogramJson(*s.tickWork);
+        js["tickInterval"] = histogramJson(*s.tickInterval);
+        js["tasks"] = json::array();
+        for (const ShardMetrics::Task& t : s.tasks) {
+            json jt;
+            jt["name"] = t.name;
+            jt["overruns"] = t.overruns;
+            jt["tick"] = histogramJson(*t.tick);
+            jt["run"] = histogramJson(*t.run);
+            js["tasks"].push_back(jt);
+        }
+        doc["shards"].push_back(js);
+    }
+    if (latency) {
+        doc["latency"] = json::array();
+        for (unsigned p = 0; p < latency->getPathCount(); p++) {
+            json jp;
+            jp["path"] = latency->getPathName(p);
+            for (unsigned st = 0; st < LatencyProbe::STAGE_COUNT; st++) {
+                const LatencyProbe::Stage stage = (LatencyProbe::Stage)st;
+                jp[LatencyProbe::stageName(stage)] = 
+                    histogramJson(latency->getHistogram(p, stage));
+            }
+            doc["latency"].push_back(jp);
+        }
+    }
+    return doc.dump();
+}
+
+/**
+ * Escapes a Prometheus label value.
+ */
+static string label(const string& v) {
+    string r;
+    for (char c : v) {
+        if (c == '\\' || c == '"')
+            r += '\\';
+        if (c == '\n')
+            r += "\\n";
+        else
+            r += c;
+    }
+    return r;
+}
+
+static void histogramText(ostream& str, const char* name, const string& labels,
+    const LatencyHistogram& h) {
+    // Cumulative counts at each bound, walking the buckets once
+    uint64_t cumulative = 0;
+    unsigned bucket = 0;
+    for (uint64_t bound : METRICS_BOUNDS_US) {
+        for (; bucket < LatencyHistogram::BUCKET_COUNT &&
+            LatencyHistogram::bucketUpperUs(bucket) <= bound; bucket++)
+            cumulative += h.getBucketCount(bucket);
+        str << name << "_bucket{" << labels << ",le=\"" << bound << "\"} "
+            << cumulative << "\n";
+    }
+    for (; bucket < LatencyHistogram::BUCKET_COUNT; bucket++)
+        cumulative += h.getBucketCount(bucket);
+    str << name << "_bucket{" << labels << ",le=\"+Inf\"} " << cumulative << "\n";
+    str << name << "_sum{" << labels << "} " << h.getSumUs() << "\n";
+    str << name << "_count{" << labels << "} " << cumulative << "\n";
+}
+
+static void quantileText(ostream& str, const char* name, const string& labels,
+    const LatencyHistogram& h) {
+    for (double q : { 0.5, 0.9, 0.99 })
+        str << name << "{" << labels << ",quantile=\"" << q << "\"} "
+            << h.percentileUs(q * 100) << "\n";
+}
+
+string renderMetricsPrometheus(const vector<ShardMetrics>& shards, 
+    const LatencyProbe* latency) {
+
+    ostringstream str;
+
+    str << "# HELP amp_shard_ticks_total Audio ticks run\n";
+    str << "# TYPE amp_shard_ticks_total counter\n";
+    for (const ShardMetrics& s : shards)
+        str << "amp_shard_ticks_total{shard=\"" << s.id << "\"} " << s.ticks << "\n";
+
+    str << "# HELP amp_shard_overruns_total Audio ticks that started late\n";
+    str << "# TYPE amp_shard_overruns_total counter\n";
+    for (const ShardMetrics& s : shards)
+        str << "amp_shard_overruns_total{shard=\"" << s.id << "\"} " << s.overruns << "\n";
+
+    str << "# HELP amp_shard_worst_tick_us Longest interval between audio ticks\n";
+    str << "# TYPE amp_shard_worst_tick_us gauge\n";
+    for (const ShardMetrics& s : shards)
+        str << "amp_shard_worst_tick_us{shard=\"" << s.id << "\"} " << s.worstTickUs << "\n";
+
+    str << "# HELP amp_tick_work_us Time spent in all audio tick handlers per tick\n";
+    str << "# TYPE amp_tick_work_us histogram\n";
+    for (const ShardMetrics& s : shards)
+        histogramText(str, "amp_tick_work_us", "shard=\"" + to_string(s.id) + "\"",
+            *s.tickWork);
+
+    str << "# HELP amp_tick_work_quantile_us Quantiles of the time spent in all audio tick handlers per tick since start\n";
+    str << "# TYPE amp_tick_work_quantile_us gauge\n";
+    for (const ShardMetrics& s : shards)
+        quantileText(str, "amp_tick_work_quantile_us", "shard=\"" + to_string(s.id) + "\"",
+            *s.tickWork);
+
+    str << "# HELP amp_tick_interval_us Time between the starts of audio ticks\n";
+    str << "# TYPE amp_tick_interval_us histogram\n";
+    for (const ShardMetrics& s : shards)
+        histogramText(str, "amp_tick_interval_us", "shard=\"" + to_string(s.id) + "\"",
+            *s.tickInterval);
+
+    str << "# HELP amp_task_tick_us Time spent in a task's audio tick handler\n";
+    str << "# TYPE amp_task_tick_us histogram\n";
+    for (const ShardMetrics& s : shards)
+        for (const ShardMetrics::Task& t : s.tasks)
+            histogramText(str, "amp_task_tick_us", "shard=\"" + to_string(s.id) +
+                "\",task=\"" + label(t.name) + "\"", *t.tick);
+
+    str << "# HELP amp_task_run_us Time spent in a task per event loop pass\n";
+    str << "# TYPE amp_task_run_us histogram\n";
+    for (const ShardMetrics& s : shards)
+        for (const ShardMetrics::Task& t : s.tasks)
+            histogramText(str, "amp_task_run_us", "shard=\"" + to_string(s.id) +
+                "\",task=\"" + label(t.name) + "\"", *t.run);
+
+    str << "# HELP amp_task_overruns_total Tick overruns where the task made the slowest call\n";
+    str << "# TYPE amp_task_overruns_total counter\n";
+    for (const ShardMetrics& s : shards)
+        for (const ShardMetrics::Task& t : s.tasks)
+            str << "amp_task_overruns_total{shard=\"" << s.id << "\",task=\""
+                << label(t.name) << "\"} " << t.overruns << "\n";
+
+    if (latency) {
+        str << "# HELP amp_message_latency_us Time a message spends in each stage on its way to a line\n";
+        str << "# TYPE amp_message_latency_us histogram\n";
+        for (unsigned p = 0; p < latency->getPathCount(); p++)
+            for (unsigned st = 0; st < LatencyProbe::STAGE_COUNT; st++) {
+                const LatencyProbe::Stage stage = (LatencyProbe::Stage)st;
+                histogramText(str, "amp_message_latency_us", "path=\"" + 
+                    label(latency->getPathName(p)) + "\",stage=\"" + 
+                    LatencyProbe::stageName(stage) + "\"", 
+                    latency->getHistogram(p, stage));
+            }
+    }
+
+    return str.str();
+}
+
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.h"
+#include "LatencyProbe.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A read-only view of one shard's timing for reporting. The histograms
+ * are live (owned by the shard), everything else is a copy.
+ */
+struct ShardMetrics {
+
+    struct Task {
+        std::string name;
+        uint32_t overruns = 0;
+        const LatencyHistogram* run = nullptr;
+        const LatencyHistogram* tick = nullptr;
+    };
+
+    unsigned id = 0;
+    uint32_t ticks = 0;
+    uint32_t overruns = 0;
+    uint32_t worstTickUs = 0;
+    // Empty if there hasn't been an overrun
+    std::string worstOffender;
+    const LatencyHistogram* tickWork = nullptr;
+    const LatencyHistogram* tickInterval = nullptr;
+    std::vector<Task> tasks;
+};
+
+/**
+ * The "le" bounds used for the Prometheus histograms, in microseconds.
+ * These are approximate (see LatencyHistogram).
+ */
+static constexpr uint64_t METRICS_BOUNDS_US[] = { 10, 50, 100, 250, 500, 1000, 2500,
+    5000, 10000, 20000, 50000, 100000 };
+
+/**
+ * @param latency The message latency of each direction, or nullptr
+ *   if it isn't being measured.
+ * @returns The metrics as a JSON document (count, sum, max and the
+ *   p50/p90/p99/p99.9 of each histogram).
+ */
+std::string renderMetricsJson(const std::vector<ShardMetrics>& shards,
+    const LatencyProbe* latency = nullptr);
+
+/**
+ * @param latency The message latency of each direction, or nullptr
+ *   if it isn't being measured.
+ * @returns The metrics in the Prometheus text exposition format.
+ */
+std::string renderMetricsPrometheus(const std::vector<ShardMetrics>& shards,
+    const LatencyProbe* latency = nullptr);
+
+    }
+}
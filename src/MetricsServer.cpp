@@ -0,0 +1,168 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+
+#include "httplib.h"
+
+#include "kc1fsz-tools/Log.h"
+
+#include "ThreadUtil.h"
+#include "Shard.h"
+#include "StatusBoard.h"
+#include "MetricsServer.h"
+
+using namespace std;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+MetricsServer::MetricsServer(Log& log, const std::vector<Shard*>& shards)
+:   _log(log),
+    _shards(shards),
+    _server(std::make_unique<httplib::Server>()) {
+
+    _server->Get("/metrics", [this](const httplib::Request&, httplib::Response& res) {
+        res.set_content(renderMetricsPrometheus(collect(_shards), _latency), 
+            "text/plain; version=0.0.4");
+    });
+    _server->Get("/metrics.json", [this](const httplib::Request&, httplib::Response& res) {
+        res.set_content(renderMetricsJson(collect(_shards), _latency), "application/json");
+    });
+}
+
+MetricsServer::~MetricsServer() {
+    _stopping = true;
+    if (_thread.joinable()) {
+        _server->stop();
+        _thread.join();
+    }
+}
+
+int MetricsServer::start(int port) {
+    if (!_server->bind_to_port("0.0.0.0", port)) {
+        _log.error("Metrics server unable to bind to port %d", port);
+        return -1;
+    }
+    _thread = std::thread([this]() {
+        amp::setThreadName("amp-metrics");
+        _server->listen_after_bind();
+    });
+    _log.info("Metrics server listening on port %d", port);
+    return 0;
+}
+
+void MetricsServer::setStatusBoard(const StatusBoard* board, unsigned periodMs) {
+    _status = board;
+    _statusPeriodMs = std::max(periodMs, MIN_STATUS_PERIOD_MS);
+    _addStatusRoutes();
+}
+
+/**
+ * What a stream has already sent.
+ */
+struct StreamState {
+    std::vector<int64_t> prev;
+    std::vector<int64_t> cur;
+    uint64_t seq = 0;
+    bool started = false;
+    unsigned quietMs = 0;
+};
+
+void MetricsServer::_addStatusRoutes() {
+
+    _server->Get("/status", [this](const httplib::Request&, httplib::Response& res) {
+        std::vector<int64_t> values(_status->getFieldCount());
+        const uint64_t seq = _status->snapshot(values.data());
+        res.set_content(_status->renderDelta(seq, nullptr, values.data()), 
+            "application/json");
+    });
+
+    _server->Get("/status/stream", [this](const httplib::Request&, httplib::Response& res) {
+        if (_streamCount.fetch_add(1) >= MAX_STREAMS) {
+            _streamCount.fetch_sub(1);
+            res.status = 503;
+            return;
+        }
+        auto state = std::make_shared<StreamState>();
+        state->prev.resize(_status->getFieldCount());
+        state->cur.resize(_status->getFieldCount());
+        res.set_header("Cache-Control", "no-cache");
+        res.set_chunked_content_provider("text/event-stream",
+            [this, state](size_t, httplib::DataSink& sink) {
+                // The first event goes out right away
+                if (state->started) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(_statusPeriodMs));
+                    if (_stopping)
+                        return false;
+                }
+                const uint64_t seq = _status->snapshot(state->cur.data());
+                string event;
+                // A publication that didn't change anything isn't sent
+                if (!state->started || (seq != state->seq && state->cur != state->prev)) {
+                    const string delta = _status->renderDelta(seq, 
+                        state->started ? state->prev.data() : nullptr, state->cur.data());
+                    event = "data: " + delta + "\n\n";
+                    state->prev.swap(state->cur);
+                    state->seq = seq;
+                    state->started = true;
+                    state->quietMs = 0;
+                } 
+                // Nothing new, but proxies drop idle connections
+                else if ((state->quietMs += _statusPeriodMs) >= KEEPALIVE_MS) {
+                    event = ": keepalive\n\n";
+                    state->quietMs = 0;
+                }
+                if (!event.empty() && !sink.write(event.data(), event.size()))
+                    return false;
+                return true;
+            },
+            [this](bool) {
+                _streamCount.fetch_sub(1);
+            });
+    });
+}
+
+std::vector<ShardMetrics> MetricsServer::collect(const std::vector<Shard*>& shards) {
+    std::vector<ShardMetrics> result;
+    for (const Shard* shard : shards) {
+        ShardMetrics m;
+        m.id = shard->getId();
+        m.ticks = shard->getTickCount();
+        m.overruns = shard->getOverrunCount();
+        m.worstTickUs = shard->getWorstTickUs();
+        const TimedTask* worst = shard->getWorstOffender();
+        if (worst)
+            m.worstOffender = worst->getName();
+        m.tickWork = &shard->getTickWorkHistogram();
+        m.tickInterval = &shard->getTickIntervalHistogram();
+        for (const auto& t : shard->getTimedTasks()) {
+            ShardMetrics::Task task;
+            task.name = t->getName();
+            task.overruns = t->getOverrunCount();
+            task.run = &t->getRunHistogram();
+            task.tick = &t->getTickHistogram();
+            m.tasks.push_back(task);
+        }
+        result.push_back(m);
+    }
+    return result;
+}
+
+    }
+}
@@ -0,0 +1,123 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "MetricsFormat.h"
+
+namespace httplib {
+    class Server;
+}
+
+namespace kc1fsz {
+
+class Log;
+
+    namespace amp {
+
+class Shard;
+class StatusBoard;
+
+/**
+ * A small HTTP server, on its own thread, that publishes the shard
+ * timing metrics:
+ *
+ * - GET /metrics is the Prometheus text format.
+ * - GET /metrics.json is JSON.
+ *
+ * If a LatencyProbe is attached its histograms are included in both.
+ *
+ * If a StatusBoard is attached it is also served:
+ *
+ * - GET /status is the latest snapshot as JSON.
+ * - GET /status/stream is a Server-Sent Events stream. The first event 
+ *   has every field, after that an event is only sent when a field
+ *   changed and it only has the changed fields.
+ *
+ * The metrics are read without locking, so serving them never gets in
+ * the way of the shards. The status JSON is built on the HTTP worker
+ * threads, each stream holds one of them.
+ */
+class MetricsServer {
+public:
+
+    /**
+     * @param shards Must all exist (with all of their tasks added) for 
+     *   the life of this object.
+     */
+    MetricsServer(Log& log, const std::vector<Shard*>& shards);
+    ~MetricsServer();
+
+    /**
+     * Starts listening on a background thread.
+     *
+     * @returns 0 on success, -1 if the port can't be bound.
+     */
+    int start(int port);
+
+    /**
+     * The shortest period that a stream can look for changes at.
+     */
+    static constexpr unsigned MIN_STATUS_PERIOD_MS = 50;
+
+    /**
+     * (Call before start())
+     *
+     * @param board Must exist for the life of this object.
+     * @param periodMs How often the streams look for changes, at least
+     *   MIN_STATUS_PERIOD_MS.
+     */
+    void setStatusBoard(const StatusBoard* board, unsigned periodMs);
+
+    /**
+     * (Call before start()) Adds the message latency of each direction
+     * to the metrics.
+     *
+     * @param probe Must exist for the life of this object.
+     */
+    void setLatencyProbe(const LatencyProbe* probe) { _latency = probe; }
+
+    /**
+     * @returns The current view of the shards.
+     */
+    static std::vector<ShardMetrics> collect(const std::vector<Shard*>& shards);
+
+private:
+
+    // Each stream ties up a worker thread, leave some for /metrics
+    static constexpr unsigned MAX_STREAMS = 4;
+    static constexpr unsigned KEEPALIVE_MS = 15000;
+
+    void _addStatusRoutes();
+
+    Log& _log;
+    const std::vector<Shard*> _shards;
+    std::unique_ptr<httplib::Server> _server;
+    std::thread _thread;
+    const StatusBoard* _status = nullptr;
+    const LatencyProbe* _latency = nullptr;
+    unsigned _statusPeriodMs = 250;
+    std::atomic<unsigned> _streamCount = 0;
+    std::atomic<bool> _stopping = false;
+};
+
+    }
+}
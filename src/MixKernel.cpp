@@ -0,0 +1,213 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cassert>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "MixKernel.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+static const unsigned GAIN_SHIFT = 12;
+
+// ===== Scalar ===============================================================
+
+static inline int16_t sat16(int32_t v) {
+    if (v > 32767)
+        return 32767;
+    else if (v < -32768)
+        return -32768;
+    else
+        return v;
+}
+
+static void sumScalar(const int16_t* in, int16_t gain, int32_t* acc, unsigned len) {
+    for (unsigned k = 0; k < len; k++)
+        acc[k] += ((int32_t)in[k] * gain) >> GAIN_SHIFT;
+}
+
+static void minusScalar(const int32_t* acc, const int16_t* in, int16_t gain,
+    int16_t* out, unsigned len) {
+    if (in) {
+        for (unsigned k = 0; k < len; k++)
+            out[k] = sat16(acc[k] - (((int32_t)in[k] * gain) >> GAIN_SHIFT));
+    } else {
+        for (unsigned k = 0; k < len; k++)
+            out[k] = sat16(acc[k]);
+    }
+}
+
+#if defined(__x86_64__)
+
+// ===== SSE4.1 ===============================================================
+
+__attribute__((target("sse4.1")))
+static void sumSse41(const int16_t* in, int16_t gain, int32_t* acc, unsigned len) {
+    const __m128i g = _mm_set1_epi32(gain);
+    unsigned k = 0;
+    for (; k + 4 <= len; k += 4) {
+        __m128i x = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(in + k)));
+        __m128i s = _mm_srai_epi32(_mm_mullo_epi32(x, g), GAIN_SHIFT);
+        __m128i a = _mm_loadu_si128((const __m128i*)(acc + k));
+        _mm_storeu_si128((__m128i*)(acc + k), _mm_add_epi32(a, s));
+    }
+    sumScalar(in + k, gain, acc + k, len - k);
+}
+
+__attribute__((target("sse4.1")))
+static void minusSse41(const int32_t* acc, const int16_t* in, int16_t gain,
+    int16_t* out, unsigned len) {
+    const __m128i g = _mm_set1_epi32(gain);
+    unsigned k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m128i a0 = _mm_loadu_si128((const __m128i*)(acc + k));
+        __m128i a1 = _mm_loadu_si128((const __m128i*)(acc + k + 4));
+        if (in) {
+            __m128i x0 = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(in + k)));
+            __m128i x1 = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(in + k + 4)));
+            a0 = _mm_sub_epi32(a0, _mm_srai_epi32(_mm_mullo_epi32(x0, g), GAIN_SHIFT));
+            a1 = _mm_sub_epi32(a1, _mm_srai_epi32(_mm_mullo_epi32(x1, g), GAIN_SHIFT));
+        }
+        // Saturating pack does the clipping
+        _mm_storeu_si128((__m128i*)(out + k), _mm_packs_epi32(a0, a1));
+    }
+    minusScalar(acc + k, in ? in + k : nullptr, gain, out + k, len - k);
+}
+
+// ===== AVX2 =================================================================
+
+__attribute__((target("avx2")))
+static void sumAvx2(const int16_t* in, int16_t gain, int32_t* acc, unsigned len) {
+    const __m256i g = _mm256_set1_epi32(gain);
+    unsigned k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(in + k)));
+        __m256i s = _mm256_srai_epi32(_mm256_mullo_epi32(x, g), GAIN_SHIFT);
+        __m256i a = _mm256_loadu_si256((const __m256i*)(acc + k));
+        _mm256_storeu_si256((__m256i*)(acc + k), _mm256_add_epi32(a, s));
+    }
+    sumScalar(in + k, gain, acc + k, len - k);
+}
+
+__attribute__((target("avx2")))
+static void minusAvx2(const int32_t* acc, const int16_t* in, int16_t gain,
+    int16_t* out, unsigned len) {
+    const __m256i g = _mm256_set1_epi32(gain);
+    unsigned k = 0;
+    for (; k + 8 <= len; k += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(acc + k));
+        if (in) {
+            __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(in + k)));
+            a = _mm256_sub_epi32(a, _mm256_srai_epi32(_mm256_mullo_epi32(x, g), GAIN_SHIFT));
+        }
+        // Saturating pack does the clipping
+        __m128i r = _mm_packs_epi32(_mm256_castsi256_si128(a),
+            _mm256_extracti128_si256(a, 1));
+        _mm_storeu_si128((__m128i*)(out + k), r);
+    }
+    minusScalar(acc + k, in ? in + k : nullptr, gain, out + k, len - k);
+}
+
+#endif
+
+#if defined(__aarch64__)
+
+// ===== NEON =================================================================
+
+static void sumNeon(const int16_t* in, int16_t gain, int32_t* acc, unsigned len) {
+    unsigned k = 0;
+    for (; k + 8 <= len; k += 8) {
+        int16x8_t x = vld1q_s16(in + k);
+        int32x4_t s0 = vshrq_n_s32(vmull_n_s16(vget_low_s16(x), gain), GAIN_SHIFT);
+        int32x4_t s1 = vshrq_n_s32(vmull_high_n_s16(x, gain), GAIN_SHIFT);
+        vst1q_s32(acc + k, vaddq_s32(vld1q_s32(acc + k), s0));
+        vst1q_s32(acc + k + 4, vaddq_s32(vld1q_s32(acc + k + 4), s1));
+    }
+    sumScalar(in + k, gain, acc + k, len - k);
+}
+
+static void minusNeon(const int32_t* acc, const int16_t* in, int16_t gain,
+    int16_t* out, unsigned len) {
+    unsigned k = 0;
+    for (; k + 8 <= len; k += 8) {
+        int32x4_t a0 = vld1q_s32(acc + k);
+        int32x4_t a1 = vld1q_s32(acc + k + 4);
+        if (in) {
+            int16x8_t x = vld1q_s16(in + k);
+            a0 = vsubq_s32(a0, vshrq_n_s32(vmull_n_s16(vget_low_s16(x), gain), GAIN_SHIFT));
+            a1 = vsubq_s32(a1, vshrq_n_s32(vmull_high_n_s16(x, gain), GAIN_SHIFT));
+        }
+        // Saturating narrow does the clipping
+        vst1q_s16(out + k, vcombine_s16(vqmovn_s32(a0), vqmovn_s32(a1)));
+    }
+    minusScalar(acc + k, in ? in + k : nullptr, gain, out + k, len - k);
+}
+
+#endif
+
+// ===== MixKernel ============================================================
+
+MixKernel::MixKernel(Impl impl)
+:   _impl(isSupported(impl) ? impl : Impl::SCALAR),
+    _sum(sumScalar),
+    _minus(minusScalar) {
+#if defined(__x86_64__)
+    if (_impl == Impl::SSE41) {
+        _sum = sumSse41;
+        _minus = minusSse41;
+    } else if (_impl == Impl::AVX2) {
+        _sum = sumAvx2;
+        _minus = minusAvx2;
+    }
+#endif
+#if defined(__aarch64__)
+    if (_impl == Impl::NEON) {
+        _sum = sumNeon;
+        _minus = minusNeon;
+    }
+#endif
+}
+
+void MixKernel::mix(unsigned n, const int16_t* const* inputs, const int16_t* gains,
+    int16_t* const* outputs, int16_t* fullMix, unsigned frameLen) {
+
+    assert(frameLen <= MAX_FRAME_LEN);
+
+    // Pass 1: sum everyone who is contributing
+    memset(_acc, 0, sizeof(int32_t) * frameLen);
+    for (unsigned i = 0; i < n; i++)
+        if (inputs[i])
+            _sum(inputs[i], gains[i], _acc, frameLen);
+
+    // Pass 2: each participant hears the sum minus themselves
+    for (unsigned i = 0; i < n; i++)
+        if (outputs[i])
+            _minus(_acc, inputs[i], gains[i], outputs[i], frameLen);
+
+    if (fullMix)
+        _minus(_acc, nullptr, 0, fullMix, frameLen);
+}
+
+    }
+}
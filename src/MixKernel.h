@@ -0,0 +1,89 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "CpuFeatures.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * The conference ("mix-minus") kernel: each participant hears the sum of
+ * every other participant, with a per-participant gain applied and the
+ * result clipped to 16 bits.
+ *
+ * Rather than summing N-1 inputs for each of N outputs (O(N^2)), the
+ * kernel sums everything once and then subtracts each participant's own
+ * contribution (O(N)). The arithmetic is all integer so every
+ * implementation produces bit-identical results.
+ *
+ * Vectorized implementations are provided for AVX2 and SSE4.1 (x86-64) and
+ * NEON (arm64). The best one for the running CPU is picked at runtime,
+ * with a scalar fallback.
+ */
+class MixKernel {
+public:
+
+    /**
+     * The largest frame supported (20ms at 48K)
+     */
+    static constexpr unsigned MAX_FRAME_LEN = 960;
+
+    /**
+     * The gain that leaves a participant's level unchanged. Gains are
+     * Q12 fixed point.
+     */
+    static constexpr int16_t UNITY_GAIN = 4096;
+
+    using Impl = SimdImpl;
+
+    MixKernel(Impl impl = detectSimd());
+
+    Impl getImpl() const { return _impl; }
+
+    /**
+     * @param n The number of participants.
+     * @param inputs One frame per participant. A nullptr means that the
+     *   participant is not contributing anything (i.e. not talking).
+     * @param gains Q12 gain per participant, applied to its input.
+     * @param outputs Where to write the mix heard by each participant. A
+     *   nullptr means that the output isn't needed. A participant that
+     *   isn't contributing hears exactly the full mix.
+     * @param fullMix Optional, where to write the sum of all participants.
+     * @param frameLen The number of samples in each frame, no more than
+     *   MAX_FRAME_LEN.
+     */
+    void mix(unsigned n, const int16_t* const* inputs, const int16_t* gains,
+        int16_t* const* outputs, int16_t* fullMix, unsigned frameLen);
+
+private:
+
+    using SumFn = void (*)(const int16_t* in, int16_t gain, int32_t* acc, unsigned len);
+    using MinusFn = void (*)(const int32_t* acc, const int16_t* in, int16_t gain,
+        int16_t* out, unsigned len);
+
+    Impl _impl;
+    SumFn _sum;
+    MinusFn _minus;
+    alignas(32) int32_t _acc[MAX_FRAME_LEN];
+};
+
+    }
+}
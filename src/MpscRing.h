@@ -0,0 +1,147 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A bounded, lock-free, multi-producer/single-consumer ring. Any number
+ * of threads may call push() concurrently, but only one thread may call
+ * pop()/drain().
+ *
+ * This is the bounded queue described by Dmitry Vyukov: each slot carries
+ * a sequence number that tells producers and the consumer whether the slot
+ * is free, claimed, or ready. Producers only contend on the tail index.
+ * All slots are allocated up front and each slot starts on its own cache
+ * line.
+ *
+ * @tparam N The capacity, must be a power of two.
+ */
+template<typename T, unsigned N> class MpscRing {
+
+    static_assert(N > 0 && (N & (N - 1)) == 0, "Capacity must be a power of two");
+
+public:
+
+    static constexpr unsigned CACHE_LINE_SIZE = 64;
+
+    MpscRing() {
+        for (unsigned i = 0; i < N; i++)
+            _slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    /**
+     * (Any thread)
+     * @returns false if the ring is full.
+     */
+    bool push(const T& item) {
+        unsigned pos = _tail.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = _slots[pos & (N - 1)];
+            const unsigned seq = slot.seq.load(std::memory_order_acquire);
+            const int diff = (int)(seq - pos);
+            if (diff == 0) {
+                // The slot is free, try to claim it
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.item = item;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+                // NOTE: A failed CAS reloads pos
+            }
+            else if (diff < 0) {
+                // The consumer hasn't released this slot yet
+                return false;
+            }
+            else {
+                // Another producer got here first
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * (Consumer only)
+     * @returns false if the ring is empty.
+     */
+    bool pop(T& item) {
+        const unsigned pos = _head.load(std::memory_order_relaxed);
+        Slot& slot = _slots[pos & (N - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+            return false;
+        item = slot.item;
+        _release(slot, pos);
+        return true;
+    }
+
+    /**
+     * (Consumer only) Passes each ready item to the function in place
+     * and then releases the slot back to the producers.
+     *
+     * @returns The number of items consumed.
+     */
+    template<typename F> unsigned drain(F f) {
+        unsigned count = 0;
+        while (true) {
+            const unsigned pos = _head.load(std::memory_order_relaxed);
+            Slot& slot = _slots[pos & (N - 1)];
+            if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+                break;
+            f(slot.item);
+            _release(slot, pos);
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * @returns An approximate count of waiting items. Safe to call
+     * from any thread.
+     */
+    unsigned size() const {
+        return _tail.load(std::memory_order_acquire) -
+            _head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    static constexpr unsigned capacity() { return N; }
+
+private:
+
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<unsigned> seq;
+        T item;
+    };
+
+    void _release(Slot& slot, unsigned pos) {
+        // The slot becomes available to the producer that wraps around to it
+        slot.seq.store(pos + N, std::memory_order_release);
+        _head.store(pos + 1, std::memory_order_release);
+    }
+
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> _head { 0 };
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> _tail { 0 };
+    Slot _slots[N];
+};
+
+    }
+}
@@ -0,0 +1,285 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "NodeDb.h"
+
+using namespace std;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+static_assert(sizeof(NodeDb::Record) == 104, "Record layout is part of the file format");
+
+void NodeDb::Record::getAddr(sockaddr_storage& a) const {
+    memset(&a, 0, sizeof(a));
+    if (family == AF_INET6) {
+        sockaddr_in6& a6 = (sockaddr_in6&)a;
+        a6.sin6_family = AF_INET6;
+        memcpy(&a6.sin6_addr, addr, 16);
+        a6.sin6_port = htons(port);
+    } else {
+        sockaddr_in& a4 = (sockaddr_in&)a;
+        a4.sin_family = AF_INET;
+        memcpy(&a4.sin_addr, addr, 4);
+        a4.sin_port = htons(port);
+    }
+}
+
+NodeDb::~NodeDb() {
+    close();
+}
+
+void NodeDb::close() {
+    if (_map)
+        munmap(_map, _mapSize);
+    _map = nullptr;
+    _mapSize = 0;
+    _owned.clear();
+    _owned.shrink_to_fit();
+    _table = nullptr;
+    _mask = 0;
+    _count = 0;
+}
+
+uint32_t NodeDb::hash(const char* node) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (; *node; node++)
+        h = (h ^ (uint8_t)*node) * 16777619u;
+    return h;
+}
+
+const NodeDb::Record* NodeDb::find(const char* node) const {
+    if (!_table || node[0] == 0)
+        return nullptr;
+    // The table is never full, so there is always an empty bucket to
+    // stop at
+    for (uint32_t i = hash(node) & _mask; ; i = (i + 1) & _mask) {
+        const Record& r = _table[i];
+        if (r.node[0] == 0)
+            return nullptr;
+        if (strncmp(r.node, node, sizeof(r.node)) == 0)
+            return &r;
+    }
+}
+
+int NodeDb::open(const char* fileName) {
+    close();
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    Header h;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(h) ||
+        pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) ||
+        memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        ::close(fd);
+        return _openText(fileName);
+    }
+    if (h.version != VERSION || h.recordSize != sizeof(Record) ||
+        h.bucketCount == 0 || (h.bucketCount & (h.bucketCount - 1)) != 0 ||
+        h.count >= h.bucketCount ||
+        (size_t)st.st_size != sizeof(h) + (size_t)h.bucketCount * sizeof(Record)) {
+        ::close(fd);
+        return -1;
+    }
+    // Populated up front so that the first calls after a restart don't
+    // wait on page faults
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+    _map = map;
+    _mapSize = st.st_size;
+    _table = (const Record*)((const uint8_t*)map + sizeof(Header));
+    _mask = h.bucketCount - 1;
+    _count = h.count;
+    return 0;
+}
+
+int NodeDb::_openText(const char* fileName) {
+    ifstream str(fileName);
+    if (!str.is_open())
+        return -1;
+    vector<Entry> entries;
+    vector<Record> table;
+    int count;
+    if (parseText(str, entries) != 0 || (count = _build(entries, table)) < 0)
+        return -1;
+    _owned.swap(table);
+    _table = _owned.data();
+    _mask = _owned.size() - 1;
+    _count = count;
+    return 0;
+}
+
+/**
+ * Parses <addr>, <addr>:<port> or [<addr>]:<port>.
+ *
+ * @returns 0 on success, -1 if it isn't a numeric address.
+ */
+static int parseAddr(const string& s, sockaddr_storage& addr) {
+    string host = s;
+    int port = NodeDb::DEFAULT_PORT;
+    size_t colon = s.rfind(':');
+    if (!s.empty() && s[0] == '[') {
+        size_t close = s.find(']');
+        if (close == string::npos)
+            return -1;
+        host = s.substr(1, close - 1);
+        if (close + 1 < s.size()) {
+            if (s[close + 1] != ':')
+                return -1;
+            colon = close + 1;
+        } else
+            colon = string::npos;
+    }
+    // More than one colon without brackets is an IPv6 address alone
+    else if (colon != string::npos && s.find(':') == colon)
+        host = s.substr(0, colon);
+    else
+        colon = string::npos;
+    if (colon != string::npos) {
+        char* end;
+        const string p = s.substr(colon + 1);
+        long v = strtol(p.c_str(), &end, 10);
+        if (p.empty() || *end != 0 || v < 1 || v > 65535)
+            return -1;
+        port = v;
+    }
+    memset(&addr, 0, sizeof(addr));
+    sockaddr_in& a4 = (sockaddr_in&)addr;
+    sockaddr_in6& a6 = (sockaddr_in6&)addr;
+    if (inet_pton(AF_INET, host.c_str(), &a4.sin_addr) == 1) {
+        a4.sin_family = AF_INET;
+        a4.sin_port = htons(port);
+    } else if (inet_pton(AF_INET6, host.c_str(), &a6.sin6_addr) == 1) {
+        a6.sin6_family = AF_INET6;
+        a6.sin6_port = htons(port);
+    } else
+        return -1;
+    return 0;
+}
+
+int NodeDb::parseText(std::istream& str, std::vector<Entry>& entries) {
+    string line;
+    for (int lineNumber = 1; getline(str, line); lineNumber++) {
+        size_t hash = line.find('#');
+        if (hash != string::npos)
+            line.resize(hash);
+        istringstream fields(line);
+        string addr, extra;
+        Entry e;
+        if (!(fields >> e.node))
+            continue;
+        if (!(fields >> addr) || parseAddr(addr, e.addr) != 0)
+            return lineNumber;
+        fields >> e.user >> e.password;
+        if (fields >> extra)
+            return lineNumber;
+        if (e.node.size() > MAX_NODE_LEN || e.user.size() > MAX_USER_LEN ||
+            e.password.size() > MAX_PASSWORD_LEN)
+            return lineNumber;
+        entries.push_back(e);
+    }
+    return 0;
+}
+
+int NodeDb::_build(const std::vector<Entry>& entries, std::vector<Record>& table) {
+    // At most half full keeps the probes short
+    uint32_t buckets = 16;
+    while (buckets < 2 * entries.size())
+        buckets <<= 1;
+    table.assign(buckets, Record());
+    const uint32_t mask = buckets - 1;
+    int count = 0;
+    for (const Entry& e : entries) {
+        if (e.node.empty() || e.node.size() > MAX_NODE_LEN ||
+            e.user.size() > MAX_USER_LEN || e.password.size() > MAX_PASSWORD_LEN ||
+            (e.addr.ss_family != AF_INET && e.addr.ss_family != AF_INET6))
+            return -1;
+        uint32_t i = hash(e.node.c_str()) & mask;
+        while (table[i].node[0] != 0 && strcmp(table[i].node, e.node.c_str()) != 0)
+            i = (i + 1) & mask;
+        Record& r = table[i];
+        if (r.node[0] == 0)
+            count++;
+        memset(&r, 0, sizeof(r));
+        strcpy(r.node, e.node.c_str());
+        strcpy(r.user, e.user.c_str());
+        strcpy(r.password, e.password.c_str());
+        r.family = e.addr.ss_family;
+        if (r.family == AF_INET6) {
+            const sockaddr_in6& a6 = (const sockaddr_in6&)e.addr;
+            memcpy(r.addr, &a6.sin6_addr, 16);
+            r.port = ntohs(a6.sin6_port);
+        } else {
+            const sockaddr_in& a4 = (const sockaddr_in&)e.addr;
+            memcpy(r.addr, &a4.sin_addr, 4);
+            r.port = ntohs(a4.sin_port);
+        }
+    }
+    return count;
+}
+
+int NodeDb::write(const char* fileName, const std::vector<Entry>& entries) {
+    vector<Record> table;
+    const int count = _build(entries, table);
+    if (count < 0)
+        return -1;
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.recordSize = sizeof(Record);
+    h.count = count;
+    h.bucketCount = table.size();
+
+    const string tempName = string(fileName) + ".tmp";
+    {
+        ofstream str(tempName, ios::binary | ios::trunc);
+        if (!str.is_open())
+            return -1;
+        str.write((const char*)&h, sizeof(h));
+        str.write((const char*)table.data(), table.size() * sizeof(Record));
+        if (!str.good()) {
+            str.close();
+            remove(tempName.c_str());
+            return -1;
+        }
+    }
+    if (rename(tempName.c_str(), fileName) != 0) {
+        remove(tempName.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+    }
+}
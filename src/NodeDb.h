@@ -0,0 +1,170 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <sys/socket.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A read-only table of node number -> address and credentials.
+ *
+ * The file is the hash table itself: a header followed by a power-of-two
+ * number of fixed-size buckets, filled by linear probing. Opening it is
+ * an mmap() and a lookup is a hash and (usually) one bucket, there is
+ * nothing to parse or allocate. The file is written in the byte order
+ * of the machine that builds it.
+ *
+ * A database can also be opened from the text form, which is loaded into
+ * the same layout in memory:
+ *
+ *   # Comment
+ *   <node> <address>[:<port>] [<user> [<password>]]
+ *
+ * The address is numeric, an IPv6 address with a port is written as
+ * [addr]:port. The port defaults to 4569.
+ */
+class NodeDb {
+public:
+
+    static constexpr unsigned MAX_NODE_LEN = 15;
+    static constexpr unsigned MAX_USER_LEN = 31;
+    static constexpr unsigned MAX_PASSWORD_LEN = 31;
+    static constexpr uint16_t DEFAULT_PORT = 4569;
+
+    /**
+     * One bucket of the file.
+     */
+    struct Record {
+        // NUL-terminated, empty for an unused bucket
+        char node[MAX_NODE_LEN + 1];
+        char user[MAX_USER_LEN + 1];
+        char password[MAX_PASSWORD_LEN + 1];
+        // Network order, IPv4 uses the first 4 bytes
+        uint8_t addr[16];
+        // AF_INET or AF_INET6
+        uint16_t family;
+        uint16_t port;
+        uint32_t reserved;
+
+        void getAddr(sockaddr_storage& addr) const;
+    };
+
+    /**
+     * A node as it is given to write().
+     */
+    struct Entry {
+        std::string node;
+        sockaddr_storage addr;
+        std::string user;
+        std::string password;
+    };
+
+    NodeDb() { }
+    ~NodeDb();
+    NodeDb(const NodeDb&) = delete;
+    NodeDb& operator=(const NodeDb&) = delete;
+
+    /**
+     * Opens a database, either a file made by write() or the text form.
+     * Anything that was open before is closed.
+     *
+     * @returns 0 on success, -1 if the file can't be read or isn't valid.
+     */
+    int open(const char* fileName);
+
+    void close();
+
+    bool isOpen() const { return _table != nullptr; }
+
+    /**
+     * @returns The node's record, or nullptr if it isn't in the database.
+     */
+    const Record* find(const char* node) const;
+
+    unsigned getCount() const { return _count; }
+
+    unsigned getBucketCount() const { return _table ? _mask + 1 : 0; }
+
+    /**
+     * For walking the whole table, an unused bucket has an empty node.
+     */
+    const Record& getBucket(unsigned i) const { return _table[i]; }
+
+    /**
+     * Reads the text form.
+     *
+     * @returns 0 on success, otherwise the (1-based) number of the first
+     *   line that can't be used.
+     */
+    static int parseText(std::istream& str, std::vector<Entry>& entries);
+
+    /**
+     * Writes a database file. The file is replaced atomically, so a
+     * process that has the old one open keeps a consistent view. If a node
+     * appears more than once the last one is used.
+     *
+     * @returns 0 on success, -1 if an entry doesn't fit in a Record or the
+     *   file can't be written.
+     */
+    static int write(const char* fileName, const std::vector<Entry>& entries);
+
+    static uint32_t hash(const char* node);
+
+private:
+
+    static constexpr char MAGIC[8] = { 'A', 'M', 'P', 'N', 'O', 'D', 'E', 'S' };
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint32_t count;
+        uint32_t bucketCount;
+        uint64_t reserved;
+    };
+
+    /**
+     * Lays the entries out as a table.
+     *
+     * @returns The number of distinct nodes, or -1 if an entry is invalid.
+     */
+    static int _build(const std::vector<Entry>& entries, std::vector<Record>& table);
+
+    int _openText(const char* fileName);
+
+    const Record* _table = nullptr;
+    uint32_t _mask = 0;
+    unsigned _count = 0;
+
+    // Set when the table is mapped from a file
+    void* _map = nullptr;
+    size_t _mapSize = 0;
+    // Set when the table came from the text form
+    std::vector<Record> _owned;
+};
+
+    }
+}
@@ -0,0 +1,269 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "PolyphaseResampler.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+// ===== Compile-time filter design ===========================================
+
+static constexpr double PI = 3.14159265358979323846;
+
+/**
+ * A constexpr sine (std::sin isn't constexpr). Reduces to [-pi, pi] and
+ * then uses enough Taylor terms for double precision.
+ */
+static constexpr double csin(double x) {
+    const double turns = x / (2.0 * PI);
+    const long n = (long)(turns + (turns >= 0 ? 0.5 : -0.5));
+    x -= 2.0 * PI * n;
+    double term = x, sum = x;
+    for (int i = 1; i < 14; i++) {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+static constexpr double ccos(double x) {
+    return csin(x + PI / 2.0);
+}
+
+/**
+ * Designs a Blackman-windowed sinc low-pass for resampling by a factor of R
+ * with T taps per phase. The cutoff is a bit below the Nyquist frequency
+ * of the lower rate. The result has unity DC gain.
+ */
+template<unsigned R, unsigned T> static constexpr std::array<float, R * T> designLowpass() {
+    constexpr unsigned N = R * T;
+    const double fc = 0.45 / R;
+    const double center = (N - 1) / 2.0;
+    double h[N] = { };
+    double sum = 0;
+    for (unsigned k = 0; k < N; k++) {
+        const double t = k - center;
+        const double arg = 2.0 * PI * fc * t;
+        const double sinc = (t == 0) ? 2.0 * fc : csin(arg) / (PI * t);
+        const double w = 0.42 - 0.5 * ccos(2.0 * PI * (k + 0.5) / N) +
+            0.08 * ccos(4.0 * PI * (k + 0.5) / N);
+        h[k] = sinc * w;
+        sum += h[k];
+    }
+    std::array<float, N> result = { };
+    for (unsigned k = 0; k < N; k++)
+        result[k] = h[k] / sum;
+    return result;
+}
+
+static constexpr auto H_2_8 = designLowpass<2, 8>();
+static constexpr auto H_2_16 = designLowpass<2, 16>();
+static constexpr auto H_2_32 = designLowpass<2, 32>();
+static constexpr auto H_3_8 = designLowpass<3, 8>();
+static constexpr auto H_3_16 = designLowpass<3, 16>();
+static constexpr auto H_3_32 = designLowpass<3, 32>();
+static constexpr auto H_6_8 = designLowpass<6, 8>();
+static constexpr auto H_6_16 = designLowpass<6, 16>();
+static constexpr auto H_6_32 = designLowpass<6, 32>();
+
+/**
+ * @returns The prototype filter for the factor/taps combination.
+ */
+static const float* prototype(unsigned r, unsigned t) {
+    if (r == 2)
+        return (t == 8) ? H_2_8.data() : (t == 16) ? H_2_16.data() : H_2_32.data();
+    else if (r == 3)
+        return (t == 8) ? H_3_8.data() : (t == 16) ? H_3_16.data() : H_3_32.data();
+    else
+        return (t == 8) ? H_6_8.data() : (t == 16) ? H_6_16.data() : H_6_32.data();
+}
+
+// ===== Dot product kernels ==================================================
+
+static float dotScalar(const float* a, const float* b, unsigned n) {
+    float sum = 0;
+    for (unsigned i = 0; i < n; i++)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2")))
+static float dotAvx2(const float* a, const float* b, unsigned n) {
+    __m256 acc = _mm256_setzero_ps();
+    unsigned i = 0;
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s) + dotScalar(a + i, b + i, n - i);
+}
+
+#endif
+
+#if defined(__aarch64__)
+
+static float dotNeon(const float* a, const float* b, unsigned n) {
+    float32x4_t acc0 = vdupq_n_f32(0);
+    float32x4_t acc1 = vdupq_n_f32(0);
+    unsigned i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    return vaddvq_f32(vaddq_f32(acc0, acc1)) + dotScalar(a + i, b + i, n - i);
+}
+
+#endif
+
+static inline int16_t toInt16(float v) {
+    if (v >= 32767.0f)
+        return 32767;
+    else if (v <= -32768.0f)
+        return -32768;
+    else
+        return (int16_t)lrintf(v);
+}
+
+// ===== PolyphaseResampler ===================================================
+
+PolyphaseResampler::PolyphaseResampler(SimdImpl impl)
+:   _impl(SimdImpl::SCALAR),
+    _dot(dotScalar) {
+#if defined(__x86_64__)
+    if (impl == SimdImpl::AVX2 && isSupported(impl)) {
+        _impl = impl;
+        _dot = dotAvx2;
+    }
+#endif
+#if defined(__aarch64__)
+    if (impl == SimdImpl::NEON) {
+        _impl = impl;
+        _dot = dotNeon;
+    }
+#endif
+    setRates(8000, 8000);
+}
+
+unsigned PolyphaseResampler::tapsPerPhase(Quality quality) {
+    switch (quality) {
+    case Quality::LOW: return 8;
+    case Quality::HIGH: return 32;
+    default: return 16;
+    }
+}
+
+int PolyphaseResampler::setRates(unsigned inRate, unsigned outRate, Quality quality) {
+    if (!(inRate == 8000 || inRate == 16000 || inRate == 48000) ||
+        !(outRate == 8000 || outRate == 16000 || outRate == 48000))
+        return -1;
+
+    _up = (outRate > inRate) ? outRate / inRate : 1;
+    _down = (inRate > outRate) ? inRate / outRate : 1;
+    _taps = tapsPerPhase(quality);
+
+    if (_up > 1) {
+        // Phase p uses every R'th tap starting at p, reversed so that
+        // the dot product runs forward through the input history. The
+        // gain of R makes up for the zero-stuffing.
+        const float* h = prototype(_up, _taps);
+        for (unsigned p = 0; p < _up; p++)
+            for (unsigned j = 0; j < _taps; j++)
+                _coeffs[p * _taps + j] = _up * h[(_taps - 1 - j) * _up + p];
+        _histLen = _taps - 1;
+    }
+    else if (_down > 1) {
+        const unsigned n = _down * _taps;
+        const float* h = prototype(_down, _taps);
+        for (unsigned j = 0; j < n; j++)
+            _coeffs[j] = h[n - 1 - j];
+        _histLen = n - 1;
+    }
+    else {
+        _histLen = 0;
+    }
+
+    reset();
+    return 0;
+}
+
+void PolyphaseResampler::reset() {
+    memset(_buf, 0, sizeof(_buf));
+}
+
+unsigned PolyphaseResampler::getOutputLen(unsigned inLen) const {
+    return (inLen * _up) / _down;
+}
+
+float PolyphaseResampler::getDelay() const {
+    if (_up > 1)
+        return (_up * _taps - 1) / 2.0f;
+    else if (_down > 1)
+        return (_down * _taps - 1) / (2.0f * _down);
+    else
+        return 0;
+}
+
+unsigned PolyphaseResampler::process(const int16_t* in, unsigned inLen, int16_t* out) {
+
+    assert(inLen <= MAX_FRAME_LEN);
+    assert(inLen % _down == 0);
+    assert(getOutputLen(inLen) <= MAX_FRAME_LEN);
+
+    if (_up == 1 && _down == 1) {
+        memcpy(out, in, inLen * sizeof(int16_t));
+        return inLen;
+    }
+
+    // The new input goes right after the history
+    float* x = _buf + _histLen;
+    for (unsigned i = 0; i < inLen; i++)
+        x[i] = in[i];
+
+    unsigned outLen = 0;
+    if (_up > 1) {
+        for (unsigned n = 0; n < inLen; n++) {
+            const float* window = x + n - (_taps - 1);
+            for (unsigned p = 0; p < _up; p++)
+                out[outLen++] = toInt16(_dot(window, _coeffs + p * _taps, _taps));
+        }
+    } else {
+        const unsigned len = _down * _taps;
+        for (unsigned n = 0; n < inLen; n += _down)
+            out[outLen++] = toInt16(_dot(x + n - (len - 1), _coeffs, len));
+    }
+
+    // Keep the tail of this frame as the history for the next one
+    memmove(_buf, _buf + inLen, _histLen * sizeof(float));
+    return outLen;
+}
+
+    }
+}
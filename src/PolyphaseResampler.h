@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "CpuFeatures.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A polyphase FIR resampler for the fixed 8K/16K/48K rates used on the
+ * audio paths. Every supported conversion is an integer factor R (2, 3,
+ * or 6) up or down:
+ *
+ * - Interpolation by R runs R short filters (one per phase) on each
+ *   input sample, so none of the zero-stuffed samples are multiplied.
+ * - Decimation by R only computes the output samples that are kept.
+ *
+ * The prototype low-pass filters (Blackman-windowed sinc) are computed
+ * at compile time. The quality setting picks the number of taps per
+ * phase. The dot products are vectorized on AVX2 and NEON.
+ *
+ * The resampler is streaming: filter history is carried from one
+ * frame to the next.
+ */
+class PolyphaseResampler {
+public:
+
+    enum class Quality { LOW, MEDIUM, HIGH };
+
+    /**
+     * The largest input or output frame (20ms at 48K).
+     */
+    static constexpr unsigned MAX_FRAME_LEN = 960;
+
+    PolyphaseResampler(SimdImpl impl = detectSimd());
+
+    /**
+     * Configures the conversion and clears the history.
+     *
+     * @returns 0 on success, -1 if the rate pair is not supported.
+     */
+    int setRates(unsigned inRate, unsigned outRate, Quality quality = Quality::MEDIUM);
+
+    /**
+     * Clears the filter history.
+     */
+    void reset();
+
+    /**
+     * @returns The number of output samples produced for an input
+     * frame of the given length.
+     */
+    unsigned getOutputLen(unsigned inLen) const;
+
+    /**
+     * @returns The delay through the filter, in output samples.
+     */
+    float getDelay() const;
+
+    /**
+     * @param inLen Must be a multiple of the decimation factor (if any)
+     *   and the output must fit in MAX_FRAME_LEN.
+     * @returns The number of output samples written.
+     */
+    unsigned process(const int16_t* in, unsigned inLen, int16_t* out);
+
+    static unsigned tapsPerPhase(Quality quality);
+
+    SimdImpl getImpl() const { return _impl; }
+
+private:
+
+    static constexpr unsigned MAX_TAPS = 6 * 32;
+
+    using DotFn = float (*)(const float* a, const float* b, unsigned n);
+
+    SimdImpl _impl;
+    DotFn _dot;
+    unsigned _up = 1;
+    unsigned _down = 1;
+    // Taps per phase
+    unsigned _taps = 0;
+    // Input samples carried between frames
+    unsigned _histLen = 0;
+    // Interpolation: one reversed, gain-adjusted set of taps per phase.
+    // Decimation: the whole reversed prototype.
+    alignas(32) float _coeffs[MAX_TAPS];
+    // History followed by the current input frame
+    alignas(32) float _buf[MAX_TAPS + MAX_FRAME_LEN];
+};
+
+    }
+}
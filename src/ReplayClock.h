@@ -0,0 +1,50 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "kc1fsz-tools/Clock.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A Clock that only moves when it is told to. This lets the real lines
+ * and bridges run in simulated time.
+ */
+class ReplayClock : public Clock {
+public:
+
+    /**
+     * @param startMs Lines treat 0 as "never", so start somewhere else.
+     */
+    ReplayClock(uint32_t startMs = 1000000) : _ms(startMs) { }
+
+    virtual uint32_t time() const { return _ms; }
+
+    void set(uint32_t ms) { _ms = ms; }
+    void advance(uint32_t ms) { _ms += ms; }
+
+private:
+
+    uint32_t _ms;
+};
+
+    }
+}
@@ -0,0 +1,296 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "BinaryTrace.h"
+#include "LatencyProbe.h"
+#include "MixKernel.h"
+#include "EncodeCache.h"
+#include "ReplayHarness.h"
+#include "UlawCodec.h"
+
+using namespace std;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+static const unsigned CODEC_ULAW = 1;
+static const uint64_t TICK_US = JitterBuffer::FRAME_MS * 1000;
+
+static double cpuSec() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t wallUs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static double wallSec() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+uint32_t ReplayHarness::Report::latencyPercentile(double p) const {
+    if (latencyMs.empty())
+        return 0;
+    std::vector<uint32_t> sorted(latencyMs);
+    size_t i = std::min(sorted.size() - 1, (size_t)(p / 100.0 * sorted.size()));
+    std::nth_element(sorted.begin(), sorted.begin() + i, sorted.end());
+    return sorted[i];
+}
+
+double ReplayHarness::Report::cpuUsPerCallSecond() const {
+    if (calls == 0 || simulatedSec == 0)
+        return 0;
+    return cpuSec * 1e6 / (calls * simulatedSec);
+}
+
+int ReplayHarness::loadCapture(std::istream& str, std::vector<ReplayEvent>& events) {
+    int count = 0;
+    string line;
+    while (getline(str, line)) {
+        vector<string> tokens;
+        stringstream ss(line);
+        string token;
+        while (getline(ss, token, ','))
+            tokens.push_back(token);
+        if (tokens.size() < 2)
+            continue;
+        for (string& t : tokens) {
+            t.erase(0, t.find_first_not_of(" \t\r"));
+            t.erase(t.find_last_not_of(" \t\r") + 1);
+        }
+        ReplayEvent ev;
+        char* end;
+        ev.timeUs = strtoull(tokens[0].c_str(), &end, 10);
+        if (*end != 0)
+            return -1;
+        if (tokens[1] == "RXV") {
+            if (tokens.size() < 3)
+                return -1;
+            ev.type = ReplayEvent::Type::VOICE;
+            ev.originMs = strtoul(tokens[2].c_str(), nullptr, 10);
+            ev.callId = (tokens.size() > 3) ? strtoul(tokens[3].c_str(), nullptr, 10) : 0;
+        } 
+        else if (tokens[1] == "UNK") {
+            ev.type = ReplayEvent::Type::UNKEY;
+            ev.originMs = 0;
+            ev.callId = (tokens.size() > 2) ? strtoul(tokens[2].c_str(), nullptr, 10) : 0;
+        }
+        else
+            continue;
+        events.push_back(ev);
+        count++;
+    }
+    return count;
+}
+
+void ReplayHarness::synthesize(const SynthOptions& opts, std::vector<ReplayEvent>& events) {
+
+    std::mt19937 rng(opts.seed);
+    std::normal_distribution<double> flight(opts.flightMeanMs, sqrt(opts.flightVariance));
+    std::uniform_real_distribution<double> uniform(0, 1);
+    const double meanSpurtMs = 3000;
+    const double meanGapMs = meanSpurtMs * (1.0 - opts.talkFraction) / 
+        std::max(0.01, opts.talkFraction);
+    std::exponential_distribution<double> spurtLen(1.0 / meanSpurtMs);
+    std::exponential_distribution<double> gapLen(1.0 / std::max(1.0, meanGapMs));
+    const uint64_t endMs = opts.seconds * 1000ULL;
+
+    for (unsigned c = 0; c < opts.calls; c++) {
+        // Each peer's timestamps start somewhere different
+        const uint32_t originOffset = rng() % 100000;
+        uint64_t t = (uint64_t)gapLen(rng) / 20 * 20;
+        while (t < endMs) {
+            uint64_t spurtEnd = std::min(endMs, t + 20 + (uint64_t)spurtLen(rng) / 20 * 20);
+            for (; t < spurtEnd; t += 20) {
+                if (uniform(rng) * 100.0 < opts.lossPct)
+                    continue;
+                double f = std::max(1.0, flight(rng));
+                events.push_back({ (uint64_t)((t + f) * 1000), c, ReplayEvent::Type::VOICE,
+                    (uint32_t)(t + originOffset) });
+            }
+            double f = std::max(1.0, flight(rng));
+            events.push_back({ (uint64_t)((t + f) * 1000), c, ReplayEvent::Type::UNKEY, 0 });
+            t += 20 + (uint64_t)gapLen(rng) / 20 * 20;
+        }
+    }
+}
+
+ReplayHarness::Report ReplayHarness::run(std::vector<ReplayEvent> events, BinaryTrace* trace,
+    LatencyProbe* probe) {
+
+    Report report;
+    if (events.empty())
+        return report;
+
+    std::stable_sort(events.begin(), events.end(), 
+        [](const ReplayEvent& a, const ReplayEvent& b) { return a.timeUs < b.timeUs; });
+
+    // Calls are numbered in the order they are first seen
+    std::map<uint32_t, unsigned> callIndex;
+    for (const ReplayEvent& ev : events)
+        if (callIndex.find(ev.callId) == callIndex.end())
+            callIndex[ev.callId] = callIndex.size();
+    const unsigned n = callIndex.size();
+    std::vector<uint32_t> callIds(n);
+    for (const auto& [callId, i] : callIndex)
+        callIds[i] = callId;
+    report.calls = n;
+
+    std::vector<std::unique_ptr<JitterBuffer>> jbs;
+    for (unsigned i = 0; i < n; i++)
+        jbs.push_back(std::make_unique<JitterBuffer>(FRAME_LEN));
+    auto mixer = std::make_unique<MixKernel>();
+    auto cache = std::make_unique<EncodeCache>();
+    const UlawCodec codec;
+
+    // Each call sends a different tone
+    std::vector<std::vector<int16_t>> tones(n, std::vector<int16_t>(FRAME_LEN));
+    for (unsigned i = 0; i < n; i++)
+        for (unsigned k = 0; k < FRAME_LEN; k++)
+            tones[i][k] = 4000 * sin(2.0 * M_PI * (300 + 50 * (i % 40)) * k / 8000.0);
+
+    std::vector<std::vector<int16_t>> inFrames(n, std::vector<int16_t>(FRAME_LEN));
+    std::vector<std::vector<int16_t>> outFrames(n, std::vector<int16_t>(FRAME_LEN));
+    std::vector<const int16_t*> inputs(n);
+    std::vector<int16_t*> outputs(n);
+    std::vector<int16_t> gains(n, MixKernel::UNITY_GAIN);
+    for (unsigned i = 0; i < n; i++)
+        outputs[i] = outFrames[i].data();
+    int16_t fullMix[FRAME_LEN];
+    uint8_t encodeOverflow[EncodeCache::MAX_ENCODED_SIZE];
+    std::vector<LatencyStamp> stamps(n);
+    const int probePath = probe ? probe->addPath("IAX2->IAX2") : -1;
+
+    const uint64_t startUs = events.front().timeUs / TICK_US * TICK_US;
+    // Leave time for the buffers to drain
+    const uint64_t endUs = events.back().timeUs + 1000000;
+    size_t next = 0;
+
+    const double cpu0 = cpuSec();
+    const double wall0 = wallSec();
+
+    for (uint64_t nowUs = startUs; nowUs < endUs; nowUs += TICK_US) {
+
+        // Everything that arrived since the last tick
+        for (; next < events.size() && events[next].timeUs <= nowUs; next++) {
+            const ReplayEvent& ev = events[next];
+            JitterBuffer& jb = *jbs[callIndex[ev.callId]];
+            if (ev.type == ReplayEvent::Type::VOICE) {
+                if (trace)
+                    trace->traceAt(ev.timeUs, BinaryTrace::RXV, ev.callId, ev.originMs);
+                LatencyStamp stamp;
+                if (probePath >= 0) {
+                    stamp.mark(LatencyStamp::CAPTURE, ev.timeUs);
+                    stamp.mark(LatencyStamp::QUEUED, ev.timeUs);
+                }
+                jb.consume(ev.originMs, ev.timeUs / 1000, tones[callIndex[ev.callId]].data(),
+                    &stamp);
+            }
+            else {
+                if (trace)
+                    trace->traceAt(ev.timeUs, BinaryTrace::UNK, ev.callId);
+                jb.endSpurt();
+            }
+        }
+
+        // The audio tick
+        const uint64_t tickStartUs = probe ? wallUs() : 0;
+        const uint32_t nowMs = nowUs / 1000;
+        for (unsigned i = 0; i < n; i++) {
+            const uint32_t played = jbs[i]->getStats().played;
+            stamps[i].clear();
+            if (jbs[i]->playOut(nowMs, inFrames[i].data(), &stamps[i])) {
+                inputs[i] = inFrames[i].data();
+                if (jbs[i]->getStats().played != played) {
+                    report.latencyMs.push_back(nowMs - jbs[i]->getLastPlayedRxMs());
+                    stamps[i].mark(LatencyStamp::PLAYOUT, nowUs);
+                    if (trace)
+                        trace->traceAt(nowUs, BinaryTrace::POV, callIds[i], 
+                            jbs[i]->getLastPlayedOriginMs());
+                } 
+                else if (trace) 
+                    trace->traceAt(nowUs, BinaryTrace::POI, callIds[i]);
+            }
+            else 
+                inputs[i] = nullptr;
+        }
+        mixer->mix(n, inputs.data(), gains.data(), outputs.data(), fullMix, FRAME_LEN);
+        cache->startFrame();
+        for (unsigned i = 0; i < n; i++) {
+            // Talkers hear their own mix, everyone else shares the full mix
+            const int16_t* frame = inputs[i] ? outputs[i] : fullMix;
+            unsigned len;
+            cache->get(inputs[i] ? i + 1 : EncodeCache::FULL_MIX, CODEC_ULAW, len,
+                [frame, &codec](uint8_t* out, unsigned capacity) {
+                    if (capacity < FRAME_LEN)
+                        return -1;
+                    codec.encode(frame, out, FRAME_LEN);
+                    return (int)FRAME_LEN;
+                }, encodeOverflow);
+        }
+        if (probePath >= 0) {
+            const uint64_t sentUs = nowUs + (wallUs() - tickStartUs);
+            for (unsigned i = 0; i < n; i++) {
+                if (stamps[i].has(LatencyStamp::PLAYOUT)) {
+                    stamps[i].mark(LatencyStamp::SENT, sentUs);
+                    probe->record(probePath, stamps[i]);
+                }
+            }
+        }
+        report.ticks++;
+        if (trace)
+            trace->collect();
+    }
+
+    report.cpuSec = cpuSec() - cpu0;
+    report.wallSec = wallSec() - wall0;
+    report.simulatedSec = (endUs - startUs) / 1e6;
+    report.encodes = cache->getEncodeCount();
+    report.encodesSaved = cache->getSavedCount();
+    for (auto& jb : jbs) {
+        const JitterBuffer::Stats& s = jb->getStats();
+        report.jb.received += s.received;
+        report.jb.played += s.played;
+        report.jb.late += s.late;
+        report.jb.concealed += s.concealed;
+        report.jb.duplicate += s.duplicate;
+        report.jb.overflow += s.overflow;
+        report.jb.dropped += s.dropped;
+        report.jb.spurts += s.spurts;
+    }
+    return report;
+}
+
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+#include "JitterBuffer.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+class BinaryTrace;
+class LatencyProbe;
+
+/**
+ * One entry in a packet timeline.
+ */
+struct ReplayEvent {
+
+    enum class Type { VOICE, UNKEY };
+
+    // Local arrival time
+    uint64_t timeUs;
+    uint32_t callId;
+    Type type;
+    // Origin timestamp (VOICE only)
+    uint32_t originMs;
+};
+
+/**
+ * Drives the audio kernels in this tree (per-call JitterBuffer -> 
+ * MixKernel mix-minus -> EncodeCache/G.711 encode) from a recorded or 
+ * synthetic packet timeline. LineReplay drives the server's real 
+ * LineIAX2 and Bridge from the same timelines. Time is simulated, so the run goes as fast as the 
+ * CPU allows and two runs of the same timeline make exactly the same 
+ * decisions.
+ */
+class ReplayHarness {
+public:
+
+    /**
+     * Parameters for a generated timeline.
+     */
+    struct SynthOptions {
+        unsigned calls = 10;
+        unsigned seconds = 60;
+        // Network flight time
+        double flightMeanMs = 50;
+        double flightVariance = 12;
+        double lossPct = 0;
+        // Fraction of the time that each call is talking
+        double talkFraction = 0.5;
+        unsigned seed = 1;
+    };
+
+    struct Report {
+        unsigned calls = 0;
+        double simulatedSec = 0;
+        double cpuSec = 0;
+        double wallSec = 0;
+        uint64_t ticks = 0;
+        // Time from arrival to mixed output for each played frame
+        std::vector<uint32_t> latencyMs;
+        // Summed across all calls
+        JitterBuffer::Stats jb;
+        uint32_t encodes = 0;
+        uint32_t encodesSaved = 0;
+
+        /**
+         * @param p In the range 0-100.
+         */
+        uint32_t latencyPercentile(double p) const;
+
+        double cpuUsPerCallSecond() const;
+    };
+
+    static constexpr unsigned FRAME_LEN = 160;
+
+    /**
+     * Reads a capture file (the format used by analyzer-jb.py). Lines look 
+     * like "timeUs, RXV, originMs[, callId]" or "timeUs, UNK[, callId]". 
+     * Other event types are ignored.
+     *
+     * @returns The number of events read, or -1 on a format error.
+     */
+    static int loadCapture(std::istream& str, std::vector<ReplayEvent>& events);
+
+    /**
+     * Generates a timeline of calls that talk in bursts over a network
+     * with normally distributed flight times.
+     */
+    static void synthesize(const SynthOptions& opts, std::vector<ReplayEvent>& events);
+
+    /**
+     * Runs a timeline through the audio path.
+     *
+     * @param trace If not nullptr, the arrivals (RXV/UNK) and the jitter
+     *   buffer decisions (POV/POI) are traced in simulated time and 
+     *   collected on every tick.
+     * @param probe If not nullptr, a "IAX2->IAX2" direction is added and
+     *   every played frame is recorded in it. The arrival is both the
+     *   capture and the queue time, and the frame is sent at its playout
+     *   tick plus the real time that the tick's mixing and encoding took
+     *   (simulated time stands still while the tick runs).
+     */
+    static Report run(std::vector<ReplayEvent> events, BinaryTrace* trace = nullptr,
+        LatencyProbe* probe = nullptr);
+};
+
+    }
+}
@@ -0,0 +1,400 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <arpa/nameser.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <resolv.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "NodeDb.h"
+#include "ResolverCache.h"
+
+using namespace std;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+static uint64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * The calling thread's CPU time, which doesn't count the time that the
+ * thread wasn't running.
+ */
+static uint64_t threadCpuUs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+ResolverCache::ResolverCache(Resolver resolver, const Options& options, Clock clock)
+:   _resolver(resolver),
+    _options(options),
+    _clock(clock ? clock : steadyMs) {
+    // The buckets never change, so a scan can pick up where it left off
+    _entries.reserve(_options.maxEntries);
+}
+
+ResolverCache::~ResolverCache() {
+    stop();
+}
+
+void ResolverCache::start(unsigned threadCount) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = false;
+        _nextSaveMs = _now() + _options.saveIntervalMs;
+    }
+    for (unsigned i = 0; i < threadCount; i++)
+        _threads.emplace_back([this]() { _threadMain(); });
+}
+
+void ResolverCache::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    const bool wasRunning = !_threads.empty();
+    for (std::thread& t : _threads)
+        t.join();
+    _threads.clear();
+    if (wasRunning && !_saveFileName.empty())
+        save(_saveFileName.c_str());
+}
+
+void ResolverCache::_threadMain() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stopping) {
+        lock.unlock();
+        service();
+        lock.lock();
+        if (_options.saveIntervalMs && !_saveFileName.empty() && _now() >= _nextSaveMs) {
+            _nextSaveMs = _now() + _options.saveIntervalMs;
+            lock.unlock();
+            save(_saveFileName.c_str());
+            lock.lock();
+        }
+        // Woken early by new work, otherwise once a second for the
+        // refresh scan
+        if (_pending.empty() && !_stopping)
+            _wake.wait_for(lock, std::chrono::seconds(1));
+    }
+}
+
+void ResolverCache::_noteHold(uint64_t startCpuUs) {
+    const uint64_t us = threadCpuUs() - startCpuUs;
+    if (us > _stats.longestHoldUs)
+        _stats.longestHoldUs = us;
+}
+
+void ResolverCache::_queue(const std::string& node, Entry& e) {
+    if (e.queued)
+        return;
+    e.queued = true;
+    _pending.push_back(node);
+    _wake.notify_one();
+}
+
+ResolverCache::Result ResolverCache::lookup(const char* node, sockaddr_storage& addr) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const uint64_t now = _now();
+    auto it = _entries.find(node);
+    if (it == _entries.end()) {
+        _stats.misses++;
+        if (_entries.size() < _options.maxEntries) {
+            it = _entries.emplace(node, Entry()).first;
+            it->second.lastUsedMs = now;
+            _queue(it->first, it->second);
+        }
+        return Result::MISS;
+    }
+    Entry& e = it->second;
+    e.lastUsedMs = now;
+    if (e.state == State::FOUND) {
+        if (now < e.expiresMs) {
+            _stats.hits++;
+            addr = e.addr;
+            return Result::HIT;
+        }
+        if (now >= e.retryAtMs)
+            _queue(it->first, e);
+        if (now < e.expiresMs + _options.staleMs) {
+            _stats.staleHits++;
+            addr = e.addr;
+            return Result::HIT;
+        }
+    }
+    else if (e.state == State::NOT_FOUND) {
+        if (now < e.expiresMs) {
+            _stats.negativeHits++;
+            return Result::NEGATIVE;
+        }
+        _queue(it->first, e);
+    }
+    _stats.misses++;
+    return Result::MISS;
+}
+
+void ResolverCache::prefetch(const char* node) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const uint64_t now = _now();
+    auto it = _entries.find(node);
+    if (it == _entries.end()) {
+        if (_entries.size() >= _options.maxEntries)
+            return;
+        it = _entries.emplace(node, Entry()).first;
+    }
+    Entry& e = it->second;
+    e.lastUsedMs = now;
+    if (e.state == State::PENDING || (now >= e.expiresMs && now >= e.retryAtMs))
+        _queue(it->first, e);
+}
+
+size_t ResolverCache::_scan(uint64_t now, size_t first) {
+    const size_t last = std::min(first + SCAN_BATCH, _entries.bucket_count());
+    for (size_t b = first; b < last; b++) {
+        for (auto it = _entries.begin(b); it != _entries.end(b); ) {
+            Entry& e = it->second;
+            // Erasing only invalidates the erased entry
+            auto cur = it++;
+            if (e.queued)
+                continue;
+            // Nobody has wanted it for a long time
+            if (now > std::max(e.lastUsedMs, e.expiresMs) + _options.staleMs) {
+                _stats.evictions++;
+                const string node = cur->first;
+                _entries.erase(node);
+                continue;
+            }
+            // In use and about to expire (a loaded entry that hasn't been
+            // looked up has a lastUsedMs of 0)
+            if (e.state == State::FOUND && e.lastUsedMs != 0 &&
+                now + _options.refreshAheadMs >= e.expiresMs &&
+                now < e.lastUsedMs + _options.ttlMs &&
+                now >= e.retryAtMs) {
+                _stats.refreshes++;
+                _queue(cur->first, e);
+            }
+        }
+    }
+    return last;
+}
+
+unsigned ResolverCache::service() {
+    unsigned count = 0;
+    std::unique_lock<std::mutex> lock(_mutex);
+    uint64_t now = _now();
+    if (now >= _nextScanMs) {
+        _nextScanMs = now + 1000;
+        // A batch at a time, lookup() gets a turn in between
+        for (size_t b = 0; b < _entries.bucket_count(); ) {
+            const uint64_t startCpuUs = threadCpuUs();
+            b = _scan(now, b);
+            _noteHold(startCpuUs);
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+        }
+    }
+    while (!_pending.empty() && !_stopping) {
+        const string node = std::move(_pending.front());
+        _pending.pop_front();
+
+        // The query is made without holding the lock
+        lock.unlock();
+        sockaddr_storage addr;
+        memset(&addr, 0, sizeof(addr));
+        const int rc = _resolver(node, addr);
+        lock.lock();
+
+        count++;
+        _stats.queries++;
+        now = _now();
+        auto it = _entries.find(node);
+        if (it == _entries.end())
+            continue;
+        Entry& e = it->second;
+        e.queued = false;
+        if (rc == 0) {
+            e.state = State::FOUND;
+            e.addr = addr;
+            e.expiresMs = now + _options.ttlMs;
+            e.retryAtMs = 0;
+        } else if (rc == 1) {
+            e.state = State::NOT_FOUND;
+            e.expiresMs = now + _options.negativeTtlMs;
+        } else {
+            _stats.queryFailures++;
+            // A known address is better than nothing
+            if (e.state == State::FOUND)
+                e.retryAtMs = now + _options.retryMs;
+            else {
+                e.state = State::NOT_FOUND;
+                e.expiresMs = now + _options.retryMs;
+            }
+        }
+    }
+    return count;
+}
+
+int ResolverCache::load(const char* fileName) {
+    NodeDb db;
+    if (db.open(fileName) < 0)
+        return -1;
+    std::lock_guard<std::mutex> lock(_mutex);
+    const uint64_t now = _now();
+    int count = 0;
+    for (unsigned i = 0; i < db.getBucketCount(); i++) {
+        const NodeDb::Record& r = db.getBucket(i);
+        if (r.node[0] == 0 || _entries.size() >= _options.maxEntries)
+            continue;
+        Entry& e = _entries[r.node];
+        if (e.state != State::PENDING)
+            continue;
+        e.state = State::FOUND;
+        r.getAddr(e.addr);
+        // Stale from the start, it gets refreshed on first use
+        e.expiresMs = now;
+        count++;
+    }
+    return count;
+}
+
+int ResolverCache::save(const char* fileName) {
+    vector<NodeDb::Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        // Grown outside of the lock
+        entries.reserve(_entries.size());
+    }
+    // A batch at a time, like the scan
+    for (size_t b = 0; ; ) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const uint64_t startCpuUs = threadCpuUs();
+        const size_t last = std::min(b + SCAN_BATCH, _entries.bucket_count());
+        if (b >= last)
+            break;
+        for (; b < last; b++) {
+            for (auto it = _entries.begin(b); it != _entries.end(b); it++) {
+                if (it->second.state != State::FOUND)
+                    continue;
+                NodeDb::Entry de;
+                de.node = it->first;
+                de.addr = it->second.addr;
+                entries.push_back(de);
+            }
+        }
+        _noteHold(startCpuUs);
+    }
+    return NodeDb::write(fileName, entries);
+}
+
+ResolverCache::Stats ResolverCache::getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Stats s = _stats;
+    s.entries = _entries.size();
+    return s;
+}
+
+/**
+ * @returns 0 if found, 1 if the name doesn't exist, -1 on failure.
+ */
+static int resolveHost(const string& host, uint16_t port, sockaddr_storage& addr) {
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    const int rc = getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &result);
+    if (rc == EAI_NONAME || rc == EAI_NODATA)
+        return 1;
+    if (rc != 0 || !result)
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    memcpy(&addr, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+    return 0;
+}
+
+/**
+ * Finds the SRV target with the lowest priority.
+ *
+ * @returns 0 if found, 1 if there is no record, -1 on failure.
+ */
+static int resolveSrv(const string& name, string& target, uint16_t& port) {
+    struct __res_state state;
+    memset(&state, 0, sizeof(state));
+    if (res_ninit(&state) != 0)
+        return -1;
+    uint8_t answer[4096];
+    const int len = res_nquery(&state, name.c_str(), ns_c_in, ns_t_srv,
+        answer, sizeof(answer));
+    int rc = 1;
+    if (len < 0) {
+        if (state.res_h_errno != HOST_NOT_FOUND && state.res_h_errno != NO_DATA)
+            rc = -1;
+    } else {
+        ns_msg msg;
+        unsigned best = 0x10000;
+        if (ns_initparse(answer, len, &msg) < 0)
+            rc = -1;
+        else for (int i = 0; i < ns_msg_count(msg, ns_s_an); i++) {
+            ns_rr rr;
+            if (ns_parserr(&msg, ns_s_an, i, &rr) < 0)
+                break;
+            // Priority, weight, port, target
+            const uint8_t* data = ns_rr_rdata(rr);
+            if (ns_rr_type(rr) != ns_t_srv || ns_rr_rdlen(rr) < 7)
+                continue;
+            const unsigned priority = ns_get16(data);
+            char host[NS_MAXDNAME];
+            if (priority >= best ||
+                dn_expand(ns_msg_base(msg), ns_msg_end(msg), data + 6, host, sizeof(host)) < 0)
+                continue;
+            best = priority;
+            port = ns_get16(data + 4);
+            target = host;
+            rc = 0;
+        }
+    }
+    res_nclose(&state);
+    return rc;
+}
+
+ResolverCache::Resolver ResolverCache::makeDnsResolver(const std::string& domain) {
+    return [domain](const std::string& node, sockaddr_storage& addr) {
+        string target;
+        uint16_t port = NodeDb::DEFAULT_PORT;
+        const int rc = resolveSrv("_iax._udp." + node + "." + domain, target, port);
+        if (rc == 0)
+            return resolveHost(target, port, addr);
+        if (rc < 0)
+            return -1;
+        return resolveHost(node + "." + domain, NodeDb::DEFAULT_PORT, addr);
+    };
+}
+
+    }
+}
@@ -0,0 +1,232 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <sys/socket.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * Remembers the addresses of the nodes that have been looked up so that
+ * calls don't wait on DNS. lookup() never blocks on the network: an
+ * address that isn't known yet is resolved in the background and the
+ * caller is told to use its own (slow) path this time.
+ *
+ * - A found address is good for ttlMs. After that it is still used for
+ *   up to staleMs while a fresh one is fetched.
+ * - Addresses that were used recently are fetched again shortly before
+ *   they expire, so busy nodes never go stale.
+ * - A node that doesn't exist is remembered for negativeTtlMs so that
+ *   repeated calls to it don't each cost a query. A failed query (ex:
+ *   no network) keeps whatever was there and is tried again after
+ *   retryMs.
+ * - The found addresses can be saved to a file (in the NodeDb format)
+ *   and loaded at startup, so a restart doesn't begin with an empty
+ *   cache. Loaded addresses are treated as stale.
+ *
+ * lookup() and prefetch() are safe to call from any thread. The
+ * resolving happens on the cache's own threads (start()), or on the
+ * caller of service() for tests.
+ *
+ * lookup() is called on the audio threads, so nothing holds the lock
+ * for long: the table is sized for maxEntries up front (it never
+ * rehashes) and the refresh scan and save() walk it SCAN_BATCH buckets
+ * at a time, letting go of the lock in between.
+ */
+class ResolverCache {
+public:
+
+    /**
+     * The number of hash buckets that the refresh scan and save() look
+     * at each time they hold the lock.
+     */
+    static constexpr unsigned SCAN_BATCH = 64;
+
+    enum class Result {
+        // The address was filled in
+        HIT,
+        // The node is known not to exist
+        NEGATIVE,
+        // Not known yet, it is being resolved
+        MISS
+    };
+
+    /**
+     * Resolves a node number into an address (with the port). Called
+     * on the resolver threads and allowed to block.
+     *
+     * @returns 0 if found, 1 if the node doesn't exist, -1 if the
+     *   query failed.
+     */
+    using Resolver = std::function<int(const std::string& node, sockaddr_storage& addr)>;
+
+    /**
+     * @returns Milliseconds on any steady timeline.
+     */
+    using Clock = std::function<uint64_t()>;
+
+    struct Options {
+        unsigned ttlMs = 5 * 60 * 1000;
+        unsigned staleMs = 60 * 60 * 1000;
+        unsigned negativeTtlMs = 60 * 1000;
+        unsigned retryMs = 10 * 1000;
+        unsigned refreshAheadMs = 30 * 1000;
+        unsigned maxEntries = 65536;
+        // 0 for no periodic saving
+        unsigned saveIntervalMs = 5 * 60 * 1000;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t staleHits = 0;
+        uint64_t negativeHits = 0;
+        uint64_t misses = 0;
+        uint64_t queries = 0;
+        uint64_t queryFailures = 0;
+        uint64_t refreshes = 0;
+        uint64_t evictions = 0;
+        unsigned entries = 0;
+        // The most CPU time that the refresh scan or save() spent
+        // holding the lock at once
+        uint32_t longestHoldUs = 0;
+    };
+
+    /**
+     * @param clock Defaults to std::chrono::steady_clock.
+     */
+    ResolverCache(Resolver resolver, const Options& options, Clock clock = nullptr);
+    ~ResolverCache();
+
+    /**
+     * Starts the threads that do the resolving.
+     */
+    void start(unsigned threadCount = 2);
+
+    /**
+     * Stops the threads and saves the cache if there is a save file.
+     */
+    void stop();
+
+    /**
+     * Never blocks on the network.
+     *
+     * @param addr Filled in on a HIT.
+     */
+    Result lookup(const char* node, sockaddr_storage& addr);
+
+    /**
+     * Resolves a node in the background if its address isn't fresh,
+     * for nodes that are likely to be called soon.
+     */
+    void prefetch(const char* node);
+
+    /**
+     * Does the pending queries and starts the refreshes that are due.
+     * This is what the resolver threads run.
+     *
+     * @returns The number of queries made.
+     */
+    unsigned service();
+
+    /**
+     * Loads addresses that were saved by save(). They are used right
+     * away and refreshed in the background.
+     *
+     * @returns The number loaded, or -1 if the file can't be read.
+     */
+    int load(const char* fileName);
+
+    /**
+     * Writes the found addresses.
+     *
+     * @returns 0 on success, -1 on error.
+     */
+    int save(const char* fileName);
+
+    /**
+     * (Call before start()) Where the cache is saved every saveIntervalMs
+     * and on stop().
+     */
+    void setSaveFile(const std::string& fileName) { _saveFileName = fileName; }
+
+    Stats getStats() const;
+
+    /**
+     * A Resolver that uses the SRV record _iax._udp.<node>.<domain>,
+     * falling back to the A/AAAA record <node>.<domain> on the default
+     * IAX2 port.
+     */
+    static Resolver makeDnsResolver(const std::string& domain);
+
+private:
+
+    enum class State { PENDING, FOUND, NOT_FOUND };
+
+    struct Entry {
+        State state = State::PENDING;
+        sockaddr_storage addr;
+        uint64_t expiresMs = 0;
+        uint64_t lastUsedMs = 0;
+        // After a failed refresh
+        uint64_t retryAtMs = 0;
+        bool queued = false;
+    };
+
+    uint64_t _now() const { return _clock(); }
+
+    // Under _mutex
+    void _queue(const std::string& node, Entry& e);
+    void _noteHold(uint64_t startCpuUs);
+    /**
+     * (Under _mutex) Scans the buckets from first up to SCAN_BATCH.
+     * @returns The next bucket to scan.
+     */
+    size_t _scan(uint64_t now, size_t first);
+
+    void _threadMain();
+
+    const Resolver _resolver;
+    const Options _options;
+    const Clock _clock;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::unordered_map<std::string, Entry> _entries;
+    std::deque<std::string> _pending;
+    Stats _stats;
+    uint64_t _nextScanMs = 0;
+    uint64_t _nextSaveMs = 0;
+
+    std::string _saveFileName;
+    std::vector<std::thread> _threads;
+    bool _stopping = false;
+};
+
+    }
+}
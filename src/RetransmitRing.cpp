@@ -0,0 +1,106 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cassert>
+#include <cstring>
+
+#include "RetransmitRing.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+RetransmitRing::RetransmitRing(unsigned slots, unsigned frameCapacity)
+:   _slotCount(slots),
+    _mask(slots - 1),
+    _frameCapacity(frameCapacity),
+    _meta(std::make_unique<Slot[]>(slots)),
+    _frames(std::make_unique<uint8_t[]>(slots * frameCapacity)) {
+    assert(slots > 0 && slots <= MAX_SLOTS && (slots & (slots - 1)) == 0);
+    for (unsigned i = 0; i < slots; i++)
+        _meta[i].used = false;
+}
+
+int RetransmitRing::push(uint8_t seq, const uint8_t* frame, unsigned len, uint64_t nowMs) {
+    if (len > _frameCapacity) {
+        _stats.rejected++;
+        return -1;
+    }
+    if (_count == 0) {
+        // Nothing is waiting, so the window starts here
+        _head = seq;
+        _tail = seq;
+    }
+    // Must be at or after the tail and within the slots
+    else if ((uint8_t)(seq - _tail) >= MAX_SLOTS || 
+        (uint8_t)(seq - _head) >= _slotCount) {
+        _stats.rejected++;
+        return -1;
+    }
+    // Sequence numbers that were skipped
+    for (; _tail != seq; _tail++)
+        _meta[_tail & _mask].used = false;
+    const unsigned slot = seq & _mask;
+    Slot& s = _meta[slot];
+    memcpy(_frames.get() + slot * _frameCapacity, frame, len);
+    s.sentMs = nowMs;
+    s.len = len;
+    s.tries = 1;
+    s.used = true;
+    _tail = seq + 1;
+    _count++;
+    _stats.stored++;
+    if (_count > _stats.highWater)
+        _stats.highWater = _count;
+    return 0;
+}
+
+unsigned RetransmitRing::ack(uint8_t iseq) {
+    const unsigned advance = (uint8_t)(iseq - _head);
+    if (_count == 0 || advance == 0 || advance > (uint8_t)(_tail - _head))
+        return 0;
+    unsigned released = 0;
+    for (; _head != iseq; _head++) {
+        Slot& s = _meta[_head & _mask];
+        if (s.used) {
+            s.used = false;
+            released++;
+        }
+    }
+    _count -= released;
+    _stats.acked += released;
+    return released;
+}
+
+void RetransmitRing::clear() {
+    for (; _head != _tail; _head++)
+        _meta[_head & _mask].used = false;
+    _count = 0;
+}
+
+uint64_t RetransmitRing::getOldestSentMs() const {
+    uint64_t oldest = UINT64_MAX;
+    const unsigned window = (uint8_t)(_tail - _head);
+    for (unsigned i = 0; i < window; i++) {
+        const Slot& s = _meta[(_head + i) & _mask];
+        if (s.used && s.sentMs < oldest)
+            oldest = s.sentMs;
+    }
+    return oldest;
+}
+
+    }
+}
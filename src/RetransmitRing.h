@@ -0,0 +1,157 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * The unacknowledged IAX2 full frames of one call, indexed by their 
+ * 8-bit outbound sequence number (oseq).
+ *
+ * Each frame is copied into a fixed slot (seq modulo the number of 
+ * slots) of storage that is allocated once in the constructor. The 
+ * ring covers the sequence numbers from the oldest unacknowledged frame
+ * (the head) to the newest, with empty slots for the sequence numbers 
+ * that weren't stored (ex: frames that don't need an ACK). Since the 
+ * peer's iseq acknowledges everything before it, an ACK just moves the
+ * head forward.
+ *
+ * Not thread-safe, a ring belongs to its call's thread.
+ */
+class RetransmitRing {
+public:
+
+    static constexpr unsigned DEFAULT_SLOTS = 16;
+    // A full frame header and 20ms of 16-bit 16kHz audio
+    static constexpr unsigned DEFAULT_FRAME_CAPACITY = 12 + 640;
+    // Half of the sequence space, anything further apart is ambiguous
+    static constexpr unsigned MAX_SLOTS = 128;
+
+    struct Stats {
+        uint32_t stored = 0;
+        uint32_t acked = 0;
+        uint32_t retransmits = 0;
+        // Didn't fit (window full or frame too long)
+        uint32_t rejected = 0;
+        // The most frames held at once
+        unsigned highWater = 0;
+    };
+
+    /**
+     * @param slots A power of 2, no more than MAX_SLOTS. The most frames
+     *   that can be waiting for an ACK at once.
+     * @param frameCapacity The longest frame that can be stored.
+     */
+    RetransmitRing(unsigned slots = DEFAULT_SLOTS, 
+        unsigned frameCapacity = DEFAULT_FRAME_CAPACITY);
+
+    /**
+     * Stores a frame that was just sent. Sequence numbers must go 
+     * forward (gaps are fine).
+     *
+     * @returns 0 on success, -1 if the frame doesn't fit. 
+     */
+    int push(uint8_t seq, const uint8_t* frame, unsigned len, uint64_t nowMs);
+
+    /**
+     * Releases every frame before iseq. An iseq that is outside of the 
+     * window (old or duplicate ACKs) does nothing.
+     *
+     * @returns The number of frames released.
+     */
+    unsigned ack(uint8_t iseq);
+
+    /**
+     * Releases everything (ex: the call ended).
+     */
+    void clear();
+
+    unsigned getCount() const { return _count; }
+
+    bool isEmpty() const { return _count == 0; }
+
+    unsigned getSlotCount() const { return _slotCount; }
+
+    /**
+     * @returns When the oldest frame was last sent, or UINT64_MAX if the 
+     *   ring is empty. This is when the retransmit timer should be based.
+     */
+    uint64_t getOldestSentMs() const;
+
+    /**
+     * Resends every frame that was last sent at least rtoMs ago, oldest
+     * sequence number first. The frames are passed in-place, so the 
+     * caller can set the retransmit bit before sending.
+     *
+     * @param send Called as send(uint8_t* frame, unsigned len).
+     * @returns The number of frames resent, or -1 (and nothing is sent)
+     *   if a frame that is due has already been sent maxTries times.
+     */
+    template<typename F> int retransmitDue(uint64_t nowMs, uint32_t rtoMs, 
+        unsigned maxTries, F send) {
+        const unsigned window = (uint8_t)(_tail - _head);
+        for (unsigned i = 0; i < window; i++) {
+            const Slot& s = _meta[(_head + i) & _mask];
+            if (s.used && nowMs - s.sentMs >= rtoMs && s.tries >= maxTries)
+                return -1;
+        }
+        int sent = 0;
+        for (unsigned i = 0; i < window; i++) {
+            const unsigned slot = (_head + i) & _mask;
+            Slot& s = _meta[slot];
+            if (!s.used || nowMs - s.sentMs < rtoMs)
+                continue;
+            send(_frames.get() + slot * _frameCapacity, (unsigned)s.len);
+            s.sentMs = nowMs;
+            s.tries++;
+            _stats.retransmits++;
+            sent++;
+        }
+        return sent;
+    }
+
+    const Stats& getStats() const { return _stats; }
+
+private:
+
+    struct Slot {
+        uint64_t sentMs;
+        uint16_t len;
+        uint8_t tries;
+        bool used;
+    };
+
+    unsigned _slotCount;
+    unsigned _mask;
+    unsigned _frameCapacity;
+    std::unique_ptr<Slot[]> _meta;
+    std::unique_ptr<uint8_t[]> _frames;
+    // The oldest sequence number that may be waiting
+    uint8_t _head = 0;
+    // One past the newest sequence number stored
+    uint8_t _tail = 0;
+    unsigned _count = 0;
+    Stats _stats;
+};
+
+    }
+}
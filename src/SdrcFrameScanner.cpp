@@ -0,0 +1,243 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <unistd.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "SdrcFrameScanner.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+// ===== Scalar ===============================================================
+
+static const uint8_t* findZeroScalar(const uint8_t* p, const uint8_t* end) {
+    for (; p < end; p++)
+        if (*p == 0)
+            return p;
+    return end;
+}
+
+#if defined(__x86_64__)
+
+// ===== SSE4.1 ===============================================================
+
+__attribute__((target("sse4.1")))
+static const uint8_t* findZeroSse41(const uint8_t* p, const uint8_t* end) {
+    const __m128i zero = _mm_setzero_si128();
+    for (; p + 16 <= end; p += 16) {
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_loadu_si128((const __m128i*)p), zero));
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+    return findZeroScalar(p, end);
+}
+
+// ===== AVX2 =================================================================
+
+__attribute__((target("avx2")))
+static const uint8_t* findZeroAvx2(const uint8_t* p, const uint8_t* end) {
+    const __m256i zero = _mm256_setzero_si256();
+    for (; p + 32 <= end; p += 32) {
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i*)p), zero));
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+    return findZeroSse41(p, end);
+}
+
+#endif
+
+#if defined(__aarch64__)
+
+// ===== NEON =================================================================
+
+static const uint8_t* findZeroNeon(const uint8_t* p, const uint8_t* end) {
+    for (; p + 16 <= end; p += 16) {
+        uint8x16_t eq = vceqzq_u8(vld1q_u8(p));
+        // Narrow each byte of the comparison to 4 bits
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        if (mask)
+            return p + __builtin_ctzll(mask) / 4;
+    }
+    return findZeroScalar(p, end);
+}
+
+#endif
+
+// ===== SdrcFrameScanner =====================================================
+
+const uint8_t* SdrcFrameScanner::findZero(Impl impl, const uint8_t* p, const uint8_t* end) {
+#if defined(__x86_64__)
+    if (impl == Impl::AVX2)
+        return findZeroAvx2(p, end);
+    if (impl == Impl::SSE41)
+        return findZeroSse41(p, end);
+#endif
+#if defined(__aarch64__)
+    if (impl == Impl::NEON)
+        return findZeroNeon(p, end);
+#endif
+    return findZeroScalar(p, end);
+}
+
+int SdrcFrameScanner::cobsDecodeInPlace(uint8_t* buf, unsigned len) {
+    unsigned in = 0, out = 0;
+    while (in < len) {
+        const unsigned code = buf[in++];
+        if (code == 0 || in + code - 1 > len)
+            return -1;
+        memmove(buf + out, buf + in, code - 1);
+        out += code - 1;
+        in += code - 1;
+        // Every block but the last (and the full ones) ends with a zero
+        if (code != 0xff && in < len)
+            buf[out++] = 0;
+    }
+    return out;
+}
+
+SdrcFrameScanner::SdrcFrameScanner(unsigned frameLen, unsigned cobsOffset, Impl impl)
+:   _frameLen(frameLen),
+    _cobsOffset(cobsOffset),
+    _impl(isSupported(impl) ? impl : Impl::SCALAR),
+    _find(findZeroScalar) {
+    assert(frameLen > 0 && frameLen <= BUFFER_SIZE / 2);
+#if defined(__x86_64__)
+    if (_impl == Impl::SSE41)
+        _find = findZeroSse41;
+    else if (_impl == Impl::AVX2)
+        _find = findZeroAvx2;
+#endif
+#if defined(__aarch64__)
+    if (_impl == Impl::NEON)
+        _find = findZeroNeon;
+#endif
+}
+
+int SdrcFrameScanner::readFrom(int fd, const FrameCb& cb) {
+    int frames = 0;
+    while (true) {
+        _compact();
+        if (_tail == BUFFER_SIZE)
+            break;
+        ssize_t rc = ::read(fd, _buf + _tail, BUFFER_SIZE - _tail);
+        if (rc > 0) {
+            _stats.reads++;
+            _stats.bytes += rc;
+            _tail += rc;
+            frames += _scan(cb);
+            // A short read means the device is drained
+            if (_tail < BUFFER_SIZE)
+                break;
+        }
+        else if (rc == 0)
+            return -1;
+        else if (errno == EINTR)
+            continue;
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        else
+            return -1;
+    }
+    return frames;
+}
+
+int SdrcFrameScanner::feed(const uint8_t* data, unsigned len, const FrameCb& cb) {
+    int frames = 0;
+    while (len) {
+        _compact();
+        unsigned n = std::min(len, BUFFER_SIZE - _tail);
+        memcpy(_buf + _tail, data, n);
+        _stats.reads++;
+        _stats.bytes += n;
+        _tail += n;
+        data += n;
+        len -= n;
+        frames += _scan(cb);
+    }
+    return frames;
+}
+
+void SdrcFrameScanner::_compact() {
+    if (_head == 0)
+        return;
+    memmove(_buf, _buf + _head, _tail - _head);
+    _tail -= _head;
+    _scanned = (_scanned > _head) ? _scanned - _head : 0;
+    _head = 0;
+}
+
+int SdrcFrameScanner::_scan(const FrameCb& cb) {
+    int frames = 0;
+    while (_head < _tail) {
+
+        // Find the start of a message
+        if (_buf[_head] != 0) {
+            const unsigned z = _find(_buf + _head, _buf + _tail) - _buf;
+            _stats.skipped += z - _head;
+            _head = z;
+            if (_head == _tail)
+                break;
+        }
+
+        // Look for a zero inside the message, starting where the last
+        // look stopped
+        const unsigned end = std::min(_tail, _head + _frameLen);
+        const unsigned from = std::max(_scanned, _head + 1);
+        const unsigned z = _find(_buf + std::min(from, end), _buf + end) - _buf;
+        if (z < end) {
+            _stats.truncated++;
+            _head = z;
+            continue;
+        }
+        _scanned = end;
+        if (end - _head < _frameLen)
+            break;
+
+        Frame frame;
+        uint8_t* raw = _buf + _head;
+        frame.raw = raw;
+        frame.rawLen = _frameLen;
+        frame.data = raw + _cobsOffset;
+        frame.dataLen = (_cobsOffset < _frameLen) ?
+            cobsDecodeInPlace(raw + _cobsOffset, _frameLen - _cobsOffset) : 0;
+        if (frame.dataLen < 0)
+            _stats.decodeErrors++;
+        _stats.frames++;
+        _head += _frameLen;
+        frames++;
+        cb(frame);
+    }
+    return frames;
+}
+
+    }
+}
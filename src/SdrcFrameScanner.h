@@ -0,0 +1,144 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "CpuFeatures.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * The receive side of an SDRC serial link. The link carries fixed-length
+ * messages that start with a 0x00 delimiter and contain no other zeros
+ * (the body is COBS encoded).
+ *
+ * Instead of framing byte by byte, the serial device is read in large
+ * non-blocking chunks straight into one aligned buffer, the delimiters
+ * are found with a vectorized scan (AVX2/SSE4.1/NEON, picked at runtime
+ * like MixKernel), and the COBS part of each message is decoded in place.
+ * Nothing is copied between the read() and the callback except to move
+ * a trailing partial message back to the front of the buffer.
+ *
+ * A zero inside a message means that bytes were lost. The message is
+ * dropped and framing restarts at that zero. Anything before the first
+ * delimiter is skipped.
+ */
+class SdrcFrameScanner {
+public:
+
+    static constexpr unsigned BUFFER_SIZE = 16384;
+
+    using Impl = SimdImpl;
+
+    /**
+     * One message, in the scanner's buffer. Only valid during the callback.
+     */
+    struct Frame {
+        // The message as received, starting with the delimiter. The bytes
+        // from the COBS offset onwards have been overwritten by the decode.
+        const uint8_t* raw;
+        unsigned rawLen;
+        // The decoded COBS part
+        const uint8_t* data;
+        // -1 if the COBS part was malformed
+        int dataLen;
+    };
+
+    using FrameCb = std::function<void(const Frame& frame)>;
+
+    struct Stats {
+        uint32_t bytes = 0;
+        uint32_t reads = 0;
+        uint32_t frames = 0;
+        // Bytes thrown away looking for a delimiter
+        uint32_t skipped = 0;
+        // Messages cut short by a zero
+        uint32_t truncated = 0;
+        uint32_t decodeErrors = 0;
+    };
+
+    /**
+     * @param frameLen The length of every message, including the delimiter.
+     *   No more than half of BUFFER_SIZE.
+     * @param cobsOffset Where the COBS encoded part starts (counting the
+     *   delimiter). The bytes in front of it are passed through as-is.
+     */
+    SdrcFrameScanner(unsigned frameLen, unsigned cobsOffset, Impl impl = detectSimd());
+
+    Impl getImpl() const { return _impl; }
+
+    /**
+     * Reads everything that is waiting on a non-blocking descriptor (or
+     * until the buffer is full) and calls cb for each complete message.
+     *
+     * @returns The number of messages, or -1 on a read error or EOF.
+     */
+    int readFrom(int fd, const FrameCb& cb);
+
+    /**
+     * Same as readFrom() for bytes that came from somewhere else.
+     *
+     * @returns The number of messages.
+     */
+    int feed(const uint8_t* data, unsigned len, const FrameCb& cb);
+
+    const Stats& getStats() const { return _stats; }
+
+    void resetStats() { _stats = Stats(); }
+
+    /**
+     * Decodes a COBS block over itself. The output is never longer than
+     * the input, so decoding front-to-back never overwrites anything
+     * that hasn't been read yet.
+     *
+     * @returns The decoded length, or -1 if the block is malformed.
+     */
+    static int cobsDecodeInPlace(uint8_t* buf, unsigned len);
+
+    /**
+     * @returns A pointer to the first zero in [p, end), or end.
+     */
+    static const uint8_t* findZero(Impl impl, const uint8_t* p, const uint8_t* end);
+
+private:
+
+    using FindFn = const uint8_t* (*)(const uint8_t* p, const uint8_t* end);
+
+    void _compact();
+    int _scan(const FrameCb& cb);
+
+    const unsigned _frameLen;
+    const unsigned _cobsOffset;
+    Impl _impl;
+    FindFn _find;
+
+    // Unconsumed bytes are [_head, _tail). Everything up to _scanned
+    // is known to be free of zeros (other than the one at _head).
+    unsigned _head = 0;
+    unsigned _tail = 0;
+    unsigned _scanned = 0;
+    Stats _stats;
+
+    alignas(64) uint8_t _buf[BUFFER_SIZE];
+};
+
+    }
+}
@@ -0,0 +1,392 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <pthread.h>
+#include <sched.h>
+
+#include <cassert>
+#include <chrono>
+#include <string>
+
+#include "kc1fsz-tools/Log.h"
+
+// amp-core
+#include "EventLoop.h"
+#include "ThreadUtil.h"
+
+#include "BinaryTrace.h"
+#include "Shard.h"
+#include "UringEventLoop.h"
+
+using namespace std;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+thread_local int Shard::_current = -1;
+
+static uint64_t steadyUs() {
+    return chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Shard::Shard(Log& log, Clock& clock, unsigned id, int core)
+:   _log(log),
+    _clock(clock),
+    _id(id),
+    _core(core) {
+    assert(id < MAX_SHARDS);
+    // The shard always services its own mailboxes first
+    _tasks.push_back(this);
+}
+
+void Shard::addTask(Runnable2* task, const char* name) {
+    const unsigned index = _timedTasks.size();
+    string n = name ? string(name) : "task-" + to_string(index);
+    _timedTasks.push_back(std::make_unique<TimedTask>(*this, task, n.c_str(), index));
+    _tasks.push_back(_timedTasks.back().get());
+}
+
+const TimedTask* Shard::getWorstOffender() const {
+    int i = _worstOffender.load(std::memory_order_relaxed);
+    return (i < 0) ? nullptr : _timedTasks[i].get();
+}
+
+void Shard::addMailbox(ShardMailbox* mb) {
+    assert(mb->getShardId() == _id);
+    _mailboxes.push_back(mb);
+}
+
+void Shard::post(std::function<void()> f) {
+    std::lock_guard<std::mutex> lock(_postLock);
+    _posted.push_back(f);
+    _postedWaiting.store(true, std::memory_order_release);
+}
+
+void Shard::start() {
+    _thread = std::thread([this]() {
+        string name = "amp-shard-" + to_string(_id);
+        amp::setThreadName(name.c_str());
+        run();
+    });
+    _thread.detach();
+}
+
+void Shard::run() {
+    _current = _id;
+    _pin();
+    _log.info("Shard %u running %u tasks on core %d", _id, (unsigned)_tasks.size(), _core);
+    if (_useUring) {
+        UringEventLoop loop(_log, _clock);
+        if (loop.isOpen()) {
+            _log.info("Shard %u using io_uring event loop", _id);
+            loop.run(_tasks.data(), _tasks.size());
+            return;
+        }
+        _log.error("Shard %u io_uring not available, using standard event loop", _id);
+    }
+    EventLoop::run(_log, _clock, 0, 0, _tasks.data(), _tasks.size(), nullptr, false);
+}
+
+void Shard::_pin() {
+    if (_core < 0)
+        return;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(_core, &cpus);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (rc != 0)
+        _log.error("Shard %u unable to pin to core %d (%d)", _id, _core, rc);
+}
+
+bool Shard::run2() {
+    bool worked = false;
+    for (ShardMailbox* mb : _mailboxes)
+        if (mb->drain())
+            worked = true;
+    // Cheap check to avoid taking the lock on every pass
+    if (_postedWaiting.load(std::memory_order_acquire)) {
+        std::vector<std::function<void()>> work;
+        {
+            std::lock_guard<std::mutex> lock(_postLock);
+            work.swap(_posted);
+            _postedWaiting.store(false, std::memory_order_relaxed);
+        }
+        for (auto& f : work)
+            f();
+        worked = true;
+    }
+    return worked;
+}
+
+void Shard::audioRateTick(uint32_t) {
+    // The shard is the first task, so this closes out the previous tick
+    uint64_t now = steadyUs();
+    if (_lastTickUs != 0) {
+        uint32_t gap = now - _lastTickUs;
+        _tickIntervalHist.record(gap);
+        _tickWorkHist.record(_tickWorkUs);
+        if (gap > OVERRUN_THRESHOLD_US) {
+            _overrunCount.fetch_add(1, std::memory_order_relaxed);
+            if (_slowestTask >= 0) {
+                _timedTasks[_slowestTask]->_overrunCount.fetch_add(1, std::memory_order_relaxed);
+                _worstOffender.store(_slowestTask, std::memory_order_relaxed);
+            }
+            if (_trace)
+                _trace->trace(BinaryTrace::OVR, 0, _id, gap);
+        }
+        if (gap > _worstTickUs.load(std::memory_order_relaxed))
+            _worstTickUs.store(gap, std::memory_order_relaxed);
+    }
+    _lastTickUs = now;
+    _tickWorkUs = 0;
+    _slowestCallUs = 0;
+    _slowestTask = -1;
+    _tickCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Shard::tenSecTick() {
+    uint32_t overruns = getOverrunCount();
+    if (overruns != _lastReportedOverrunCount) {
+        const TimedTask* worst = getWorstOffender();
+        _log.info("Shard %u tick overruns %u (worst tick %u us, worst offender %s)", _id, 
+            overruns, getWorstTickUs(), worst ? worst->getName().c_str() : "none");
+        _lastReportedOverrunCount = overruns;
+    }
+    uint32_t drops = 0;
+    for (ShardMailbox* mb : _mailboxes)
+        drops += mb->getDropCount();
+    if (drops)
+        _log.error("Shard %u mailbox drops %u", _id, drops);
+    if (_pool && _pool->getHighWater() != _lastReportedHighWater) {
+        _lastReportedHighWater = _pool->getHighWater();
+        _log.info("Message pool in use %u, high water %u/%u, exhausted %u", 
+            _pool->getInUse(), _pool->getHighWater(), _pool->getCapacity(),
+            _pool->getExhaustedCount());
+    }
+}
+
+// ===== TimedTask ============================================================
+
+TimedTask::TimedTask(Shard& shard, Runnable2* task, const char* name, unsigned index)
+:   _shard(shard),
+    _task(task),
+    _name(name),
+    _index(index) {
+}
+
+int TimedTask::getPolls(pollfd* fds, unsigned fdsCapacity) {
+    return _task->getPolls(fds, fdsCapacity);
+}
+
+bool TimedTask::run2() {
+    const uint64_t start = steadyUs();
+    const bool worked = _task->run2();
+    const uint64_t us = steadyUs() - start;
+    _runHist.record(us);
+    _shard._noteCall(_index, us);
+    return worked;
+}
+
+void TimedTask::audioRateTick(uint32_t tickTimeMs) {
+    const uint64_t start = steadyUs();
+    _task->audioRateTick(tickTimeMs);
+    const uint64_t us = steadyUs() - start;
+    _tickHist.record(us);
+    _shard._tickWorkUs += us;
+    _shard._noteCall(_index, us);
+}
+
+void TimedTask::oneSecTick() {
+    const uint64_t start = steadyUs();
+    _task->oneSecTick();
+    _shard._noteCall(_index, steadyUs() - start);
+}
+
+void TimedTask::tenSecTick() {
+    const uint64_t start = steadyUs();
+    _task->tenSecTick();
+    _shard._noteCall(_index, steadyUs() - start);
+}
+
+// ===== DispatchBus ==========================================================
+
+thread_local uint32_t DispatchBus::_epoch = 0;
+thread_local uint32_t DispatchBus::_lastEpoch = 0;
+
+void DispatchBus::consume(const Message& msg) {
+    // A consumer on this thread can produce in the middle of a dispatch,
+    // the outer dispatch carries on with its own epoch afterwards.
+    const uint32_t outer = _epoch;
+    if (++_lastEpoch == 0)
+        ++_lastEpoch;
+    _epoch = _lastEpoch;
+    _router.consume(msg);
+    ShardMailbox::endDispatch();
+    _epoch = outer;
+}
+
+// ===== ShardMailbox =========================================================
+
+namespace {
+
+/**
+ * The copy that the calling thread pooled most recently. The cache holds
+ * its own reference so the slot can't be recycled (and refilled with a 
+ * different message) while it's being shared.
+ */
+struct SharedCopy {
+    uint32_t epoch = 0;
+    const Message* msg = nullptr;
+    MessagePool* pool = nullptr;
+    MessagePool::Handle handle = MessagePool::NO_HANDLE;
+};
+
+thread_local SharedCopy sharedCopy;
+
+}
+
+void ShardMailbox::endDispatch() {
+    SharedCopy& c = sharedCopy;
+    if (c.handle != MessagePool::NO_HANDLE) {
+        c.pool->release(c.handle);
+        c.handle = MessagePool::NO_HANDLE;
+    }
+}
+
+MessagePool::Handle ShardMailbox::_share(const Message& msg) {
+    const uint32_t epoch = DispatchBus::currentEpoch();
+    // Not produced through a DispatchBus, so nothing to share with
+    if (epoch == 0)
+        return _pool.alloc(msg);
+    SharedCopy& c = sharedCopy;
+    if (c.handle != MessagePool::NO_HANDLE && c.epoch == epoch && c.msg == &msg && 
+        c.pool == &_pool) {
+        _pool.addRef(c.handle);
+        return c.handle;
+    }
+    endDispatch();
+    // One reference for this mailbox and one for the cache
+    MessagePool::Handle h = _pool.alloc(msg, 2);
+    if (h != MessagePool::NO_HANDLE) {
+        c.epoch = epoch;
+        c.msg = &msg;
+        c.pool = &_pool;
+        c.handle = h;
+    }
+    return h;
+}
+
+void ShardMailbox::setProbe(LatencyProbe* probe, unsigned path) {
+    _probe = probe;
+    _probePath = path;
+    if (!_handedUs)
+        _handedUs = std::make_unique<uint64_t[]>(_pool.getCapacity());
+}
+
+void ShardMailbox::_consume(const Message& msg, uint64_t handedUs) {
+    if (!_probe) {
+        _target.consume(msg);
+        return;
+    }
+    LatencyStamp stamp;
+    stamp.mark(LatencyStamp::CAPTURE, handedUs);
+    stamp.mark(LatencyStamp::QUEUED, steadyUs());
+    _target.consume(msg);
+    stamp.mark(LatencyStamp::SENT, steadyUs());
+    _probe->record(_probePath, stamp);
+}
+
+void ShardMailbox::_deliver(MessagePool::Handle h) {
+    _consume(_pool.get(h), _probe ? _handedUs[h] : 0);
+    _pool.release(h);
+}
+
+void ShardMailbox::consume(const Message& msg) {
+    if (Shard::current() == (int)_shardId) {
+        _consume(msg, _probe ? steadyUs() : 0);
+        return;
+    }
+    MessagePool::Handle h = _share(msg);
+    if (h == MessagePool::NO_HANDLE) {
+        _dropCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (_probe)
+        _handedUs[h] = steadyUs();
+    if (!_push(h)) {
+        _pool.release(h);
+        _dropCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+#ifdef AMP_MPSC_MAILBOX
+
+ShardMailbox::ShardMailbox(MessageConsumer& target, MessagePool& pool, unsigned shardId, 
+    unsigned shardCount)
+:   _target(target),
+    _pool(pool),
+    _shardId(shardId),
+    _ring(std::make_unique<Ring>()) {
+    assert(shardCount <= Shard::MAX_SHARDS);
+}
+
+bool ShardMailbox::_push(MessagePool::Handle h) {
+    return _ring->push(h);
+}
+
+bool ShardMailbox::drain() {
+    return _ring->drain([this](MessagePool::Handle h) { _deliver(h); }) > 0;
+}
+
+#else
+
+ShardMailbox::ShardMailbox(MessageConsumer& target, MessagePool& pool, unsigned shardId, 
+    unsigned shardCount)
+:   _target(target),
+    _pool(pool),
+    _shardId(shardId),
+    _foreignRing(std::make_unique<Ring>()) {
+    assert(shardCount <= Shard::MAX_SHARDS);
+    // Everything is allocated up front, nothing is allocated while
+    // messages are moving.
+    for (unsigned i = 0; i < shardCount; i++)
+        if (i != shardId)
+            _rings[i] = std::make_unique<Ring>();
+}
+
+bool ShardMailbox::_push(MessagePool::Handle h) {
+    int producer = Shard::current();
+    if (producer >= 0)
+        return _rings[producer]->push(h);
+    std::lock_guard<std::mutex> lock(_foreignLock);
+    return _foreignRing->push(h);
+}
+
+bool ShardMailbox::drain() {
+    unsigned count = 0;
+    for (unsigned i = 0; i < Shard::MAX_SHARDS; i++)
+        if (_rings[i])
+            count += _rings[i]->drain([this](MessagePool::Handle h) { _deliver(h); });
+    count += _foreignRing->drain([this](MessagePool::Handle h) { _deliver(h); });
+    return count > 0;
+}
+
+#endif
+
+    }
+}
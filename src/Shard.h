@@ -0,0 +1,406 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kc1fsz-tools/Runnable2.h"
+
+#include "Message.h"
+#include "MessageConsumer.h"
+
+#include "SpscRing.h"
+#include "MpscRing.h"
+#include "FramePool.h"
+#include "LatencyHistogram.h"
+#include "LatencyProbe.h"
+
+namespace kc1fsz {
+
+class Log;
+class Clock;
+
+    namespace amp {
+
+class ShardMailbox;
+class BinaryTrace;
+class Shard;
+
+using MessagePool = FramePool<Message>;
+
+/**
+ * Wraps a shard's task so that every call the EventLoop makes into it is
+ * timed. The run2() calls (one per pass) and the audioRateTick() calls
+ * go into separate histograms. Everything else is passed straight 
+ * through to the task.
+ */
+class TimedTask : public Runnable2 {
+public:
+
+    TimedTask(Shard& shard, Runnable2* task, const char* name, unsigned index);
+
+    const std::string& getName() const { return _name; }
+    Runnable2* getTask() const { return _task; }
+
+    const LatencyHistogram& getRunHistogram() const { return _runHist; }
+    const LatencyHistogram& getTickHistogram() const { return _tickHist; }
+
+    /**
+     * @returns The number of tick overruns where this task made the 
+     *   slowest call.
+     */
+    uint32_t getOverrunCount() const { return _overrunCount.load(std::memory_order_relaxed); }
+
+    // ----- Runnable2 ----------------------------------------------------
+
+    int getPolls(pollfd* fds, unsigned fdsCapacity) override;
+    bool run2() override;
+    void audioRateTick(uint32_t tickTimeMs) override;
+    void oneSecTick() override;
+    void tenSecTick() override;
+
+private:
+
+    friend class Shard;
+
+    Shard& _shard;
+    Runnable2* _task;
+    const std::string _name;
+    const unsigned _index;
+    LatencyHistogram _runHist;
+    LatencyHistogram _tickHist;
+    std::atomic<uint32_t> _overrunCount = 0;
+};
+
+/**
+ * A shard is one EventLoop running on its own (pinned) thread with its own
+ * set of tasks. Shard 0 runs on the main thread. Components that talk to
+ * components on other shards do so through ShardMailbox objects so
+ * that every Message is consumed on the thread that owns the consumer.
+ *
+ * The shard is itself a task in its own EventLoop. It drains the mailboxes
+ * that it owns and keeps track of audio ticks that run late.
+ *
+ * Every other task is wrapped in a TimedTask, so the shard knows how the
+ * 20ms tick budget is being spent: a histogram per task, a histogram of
+ * the total audioRateTick() work per tick and of the interval between
+ * ticks. When a tick runs late the task that made the slowest call since
+ * the previous tick is blamed for it (the worst offender).
+ */
+class Shard : public Runnable2 {
+public:
+
+    static const unsigned MAX_SHARDS = 16;
+
+    /**
+     * A tick that arrives this long after the previous one is counted
+     * as an overrun.
+     */
+    static const uint32_t OVERRUN_THRESHOLD_US = 25000;
+
+    /**
+     * @param core The CPU core to pin the shard thread to, or -1 to
+     * leave the thread unpinned.
+     */
+    Shard(Log& log, Clock& clock, unsigned id, int core);
+
+    unsigned getId() const { return _id; }
+
+    /**
+     * @param name Used for reporting, or nullptr for a generated name.
+     */
+    void addTask(Runnable2* task, const char* name = nullptr);
+
+    /**
+     * Makes this shard responsible for draining the mailbox.
+     */
+    void addMailbox(ShardMailbox* mb);
+
+    /**
+     * Asks this shard to report the usage of the message pool.
+     */
+    void setPool(const MessagePool* pool) { _pool = pool; }
+
+    /**
+     * Runs this shard on the io_uring event loop (UringEventLoop) instead
+     * of the standard EventLoop. Falls back to the standard EventLoop if
+     * io_uring is not available.
+     */
+    void setUseUring(bool b) { _useUring = b; }
+
+    /**
+     * Traces each audio tick that runs late (OVR).
+     */
+    void setTrace(BinaryTrace* trace) { _trace = trace; }
+
+    /**
+     * Queues a function to be run on this shard's thread. This is
+     * used for things that are not on the audio path (i.e. configuration
+     * changes) so a mutex is fine here.
+     */
+    void post(std::function<void()> f);
+
+    /**
+     * Starts a new thread that runs this shard's EventLoop.
+     */
+    void start();
+
+    /**
+     * Runs this shard's EventLoop on the calling thread. Does not return.
+     */
+    void run();
+
+    /**
+     * @returns The ID of the shard that owns the calling thread, or -1
+     * if the calling thread is not a shard thread (ex: the service thread).
+     */
+    static int current() { return _current; }
+
+    uint32_t getTickCount() const { return _tickCount.load(std::memory_order_relaxed); }
+    uint32_t getOverrunCount() const { return _overrunCount.load(std::memory_order_relaxed); }
+    uint32_t getWorstTickUs() const { return _worstTickUs.load(std::memory_order_relaxed); }
+
+    /**
+     * The timed tasks (everything but the shard itself). This list is 
+     * fixed once the shard is running, after that it's safe to read 
+     * from any thread.
+     */
+    const std::vector<std::unique_ptr<TimedTask>>& getTimedTasks() const { return _timedTasks; }
+
+    /**
+     * @returns The total audioRateTick() time of all tasks, per tick.
+     */
+    const LatencyHistogram& getTickWorkHistogram() const { return _tickWorkHist; }
+
+    /**
+     * @returns The time between the starts of consecutive ticks.
+     */
+    const LatencyHistogram& getTickIntervalHistogram() const { return _tickIntervalHist; }
+
+    /**
+     * @returns The task that was blamed for the most recent overrun, or
+     *   nullptr if there hasn't been one.
+     */
+    const TimedTask* getWorstOffender() const;
+
+    // ----- Runnable2 ----------------------------------------------------
+
+    bool run2() override;
+    void audioRateTick(uint32_t tickTimeMs) override;
+    void tenSecTick() override;
+
+private:
+
+    void _pin();
+
+    friend class TimedTask;
+
+    /**
+     * (Shard thread) Called by the timed tasks after each call.
+     */
+    void _noteCall(unsigned index, uint64_t us) {
+        if (us > _slowestCallUs) {
+            _slowestCallUs = us;
+            _slowestTask = index;
+        }
+    }
+
+    static thread_local int _current;
+
+    Log& _log;
+    Clock& _clock;
+    const unsigned _id;
+    const int _core;
+    std::vector<Runnable2*> _tasks;
+    std::vector<std::unique_ptr<TimedTask>> _timedTasks;
+    std::vector<ShardMailbox*> _mailboxes;
+    const MessagePool* _pool = nullptr;
+    bool _useUring = false;
+    BinaryTrace* _trace = nullptr;
+    std::thread _thread;
+
+    std::mutex _postLock;
+    std::vector<std::function<void()>> _posted;
+    std::atomic<bool> _postedWaiting = false;
+
+    uint64_t _lastTickUs = 0;
+    std::atomic<uint32_t> _tickCount = 0;
+    std::atomic<uint32_t> _overrunCount = 0;
+    std::atomic<uint32_t> _worstTickUs = 0;
+    uint32_t _lastReportedOverrunCount = 0;
+
+    LatencyHistogram _tickWorkHist;
+    LatencyHistogram _tickIntervalHist;
+    // Since the start of the current tick
+    uint64_t _tickWorkUs = 0;
+    uint64_t _slowestCallUs = 0;
+    int _slowestTask = -1;
+    std::atomic<int> _worstOffender = -1;
+    unsigned _lastReportedHighWater = 0;
+};
+
+/**
+ * Stands between the producers and the MultiRouter. Each consume() is 
+ * one dispatch: the router hands the Message to every matching consumer
+ * before it returns. The dispatch is given a number (the epoch) that is 
+ * unique on the calling thread for as long as it is in progress, which
+ * is how a ShardMailbox knows that it is being handed the same Message
+ * as the previous mailbox.
+ */
+class DispatchBus : public MessageConsumer {
+public:
+
+    DispatchBus(MessageConsumer& router) : _router(router) { }
+
+    /**
+     * (Any thread)
+     */
+    void consume(const Message& msg) override;
+
+    /**
+     * @returns The epoch of the dispatch in progress on the calling 
+     *   thread, or 0 if there isn't one.
+     */
+    static uint32_t currentEpoch() { return _epoch; }
+
+private:
+
+    static thread_local uint32_t _epoch;
+    static thread_local uint32_t _lastEpoch;
+
+    MessageConsumer& _router;
+};
+
+/**
+ * Stands in for a MessageConsumer that lives on a different shard. This
+ * is what gets registered with the MultiRouter in place of the real
+ * consumer.
+ *
+ * Messages produced on the owning shard are passed straight through.
+ * Messages produced on another shard are copied into the shared
+ * MessagePool and a handle goes into a lock-free SPSC ring dedicated to
+ * the producing shard. The handle is delivered when the owning shard
+ * drains the mailbox. Messages produced on a non-shard thread (ex: 
+ * service thread) are serialized through a mutex on the producer side
+ * since that is not on the audio path.
+ *
+ * When the router fans the same Message out to several mailboxes (ex: 
+ * a Bridge and the BROADCAST route to the WebUi) during one DispatchBus
+ * dispatch the mailboxes share one copy in the pool.
+ *
+ * When built with AMP_MPSC_MAILBOX all producers share a single lock-free
+ * MPSC ring instead.
+ *
+ * A mailbox can record the latency of everything that passes through it
+ * into one direction of a LatencyProbe (see setProbe()).
+ */
+class ShardMailbox : public MessageConsumer {
+public:
+
+    static const unsigned RING_SIZE = 1024;
+
+    /**
+     * @param pool Where messages are held while they are in transit.
+     * @param shardId The shard that owns the target consumer.
+     * @param shardCount The total number of shards in the system.
+     */
+    ShardMailbox(MessageConsumer& target, MessagePool& pool, unsigned shardId, 
+        unsigned shardCount);
+
+    unsigned getShardId() const { return _shardId; }
+
+    /**
+     * (Any thread)
+     */
+    void consume(const Message& msg) override;
+
+    /**
+     * (Owning shard only) Delivers everything that is waiting.
+     * @returns true if anything was delivered.
+     */
+    bool drain();
+
+    /**
+     * Called by the DispatchBus when a dispatch is finished. Lets go of
+     * the copy that the calling thread was sharing.
+     */
+    static void endDispatch();
+
+    uint32_t getDropCount() const { return _dropCount.load(std::memory_order_relaxed); }
+
+    /**
+     * (Call before the shards start) Records every message into one 
+     * direction of the probe: CAPTURE when the producer handed it to 
+     * this mailbox, QUEUED when the owning shard delivered it and SENT
+     * when the consumer returned. So the input stage is the time spent
+     * waiting to cross shards (0 for a message produced on the owning
+     * shard) and the total adds the consumer's own time.
+     *
+     * @param pool The pool that this mailbox was created with.
+     */
+    void setProbe(LatencyProbe* probe, unsigned path);
+
+private:
+
+    /**
+     * @returns A handle to a pooled copy of the message, shared with 
+     * the previous mailbox if it was given the same message in the 
+     * same dispatch.
+     */
+    MessagePool::Handle _share(const Message& msg);
+
+    bool _push(MessagePool::Handle h);
+
+    void _deliver(MessagePool::Handle h);
+
+    /**
+     * (Owning shard) Hands a message to the target, recording it if 
+     * there is a probe.
+     */
+    void _consume(const Message& msg, uint64_t handedUs);
+
+    MessageConsumer& _target;
+    MessagePool& _pool;
+    const unsigned _shardId;
+#ifdef AMP_MPSC_MAILBOX
+    using Ring = MpscRing<MessagePool::Handle, RING_SIZE>;
+    // Shared by all producers
+    std::unique_ptr<Ring> _ring;
+#else
+    using Ring = SpscRing<MessagePool::Handle, RING_SIZE>;
+    // One ring per producing shard
+    std::unique_ptr<Ring> _rings[Shard::MAX_SHARDS];
+    // Used by producers that are not shard threads
+    std::mutex _foreignLock;
+    std::unique_ptr<Ring> _foreignRing;
+#endif
+    std::atomic<uint32_t> _dropCount = 0;
+    LatencyProbe* _probe = nullptr;
+    unsigned _probePath = 0;
+    // When each pooled message was handed over, by handle. Written by
+    // the producer before the handle is pushed.
+    std::unique_ptr<uint64_t[]> _handedUs;
+};
+
+    }
+}
@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <string>
+
+#include "Shard.h"
+#include "ShardStatus.h"
+
+using namespace std;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+ShardStatus::ShardStatus(Log& log, StatusBoard& board, const std::vector<Shard*>& shards, 
+    unsigned periodMs)
+:   _board(board),
+    _shards(shards),
+    _periodTicks(periodMs < TICK_MS ? 1 : periodMs / TICK_MS) {
+    // The fields are laid out in the order that update() sets them. 
+    // Each group of fields is only added if all of it fits.
+    auto fits = [this](unsigned n) {
+        return _board.getFieldCount() + n <= StatusBoard::MAX_FIELDS;
+    };
+    unsigned dropped = 0;
+    for (const Shard* shard : _shards) {
+        const string prefix = "shard" + to_string(shard->getId()) + ".";
+        const auto& tasks = shard->getTimedTasks();
+        if (!fits(SHARD_FIELDS)) {
+            _firstField.push_back(-1);
+            _taskCount.push_back(0);
+            dropped += SHARD_FIELDS + TASK_FIELDS * tasks.size();
+            continue;
+        }
+        _firstField.push_back(_board.getFieldCount());
+        _board.addField(prefix + "overruns");
+        _board.addField(prefix + "worstTickUs");
+        _board.addField(prefix + "tickWorkP99Us");
+        unsigned shown = 0;
+        for (; shown < tasks.size() && fits(TASK_FIELDS); shown++) {
+            _board.addField(prefix + tasks[shown]->getName() + ".overruns");
+            _board.addField(prefix + tasks[shown]->getName() + ".tickP99Us");
+        }
+        _taskCount.push_back(shown);
+        dropped += TASK_FIELDS * (tasks.size() - shown);
+    }
+    if (dropped)
+        log.error("Status board is full, %u fields not shown", dropped);
+}
+
+void ShardStatus::update() {
+    for (unsigned s = 0; s < _shards.size(); s++) {
+        if (_firstField[s] < 0)
+            continue;
+        const Shard* shard = _shards[s];
+        unsigned id = _firstField[s];
+        _board.set(id++, shard->getOverrunCount());
+        _board.set(id++, shard->getWorstTickUs());
+        _board.set(id++, shard->getTickWorkHistogram().percentileUs(99));
+        // Tasks added after this object (itself, for one) aren't shown
+        for (unsigned i = 0; i < _taskCount[s]; i++) {
+            const TimedTask& t = *shard->getTimedTasks()[i];
+            _board.set(id++, t.getOverrunCount());
+            _board.set(id++, t.getTickHistogram().percentileUs(99));
+        }
+    }
+    _board.publish();
+}
+
+void ShardStatus::audioRateTick(uint32_t) {
+    if (++_tickCount == _periodTicks) {
+        _tickCount = 0;
+        update();
+    }
+}
+
+    }
+}
@@ -0,0 +1,82 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/Runnable2.h"
+
+#include "StatusBoard.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+class Shard;
+
+/**
+ * A task that publishes the shard counters on a StatusBoard every so
+ * often. Fields are named like "shard0.overruns" and 
+ * "shard0.Bridge.tickP99Us". Percentiles are the histogram bucket 
+ * bounds, so they only change when the timing really moves. Counters
+ * that move on every publication (the tick count) are left out, 
+ * they're in the metrics, so a quiet server has nothing to push.
+ *
+ * The board has room for StatusBoard::MAX_FIELDS fields. A shard or 
+ * task that doesn't fit isn't shown (and an error is logged).
+ */
+class ShardStatus : public Runnable2 {
+public:
+
+    /**
+     * @param shards Must all exist (with all of their tasks added) for 
+     *   the life of this object.
+     * @param periodMs How often to publish, rounded to audio ticks.
+     */
+    ShardStatus(Log& log, StatusBoard& board, const std::vector<Shard*>& shards, 
+        unsigned periodMs);
+
+    /**
+     * Collects and publishes the current values.
+     */
+    void update();
+
+    // ----- Runnable2 ----------------------------------------------------
+
+    void audioRateTick(uint32_t tickTimeMs) override;
+
+private:
+
+    static constexpr unsigned TICK_MS = 20;
+    static constexpr unsigned SHARD_FIELDS = 3;
+    static constexpr unsigned TASK_FIELDS = 2;
+
+    StatusBoard& _board;
+    const std::vector<Shard*> _shards;
+    unsigned _periodTicks;
+    unsigned _tickCount = 0;
+    // The board field of the first value for each shard, or -1 if the
+    // shard didn't fit
+    std::vector<int> _firstField;
+    // The tasks shown for each shard, the first ones that fit
+    std::vector<unsigned> _taskCount;
+};
+
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A bounded, lock-free, single-producer/single-consumer ring. Exactly one
+ * thread may call push() and exactly one (other) thread may call pop()/drain().
+ *
+ * All of the slots are allocated up front so nothing is allocated while
+ * items are moving through the ring. The producer and consumer indices
+ * live on separate cache lines to avoid false sharing.
+ *
+ * @tparam N The capacity, must be a power of two.
+ */
+template<typename T, unsigned N> class SpscRing {
+
+    static_assert(N > 0 && (N & (N - 1)) == 0, "Capacity must be a power of two");
+
+public:
+
+    static constexpr unsigned CACHE_LINE_SIZE = 64;
+
+    /**
+     * (Producer side)
+     * @returns false if the ring is full.
+     */
+    bool push(const T& item) {
+        const unsigned tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _headCache == N) {
+            _headCache = _head.load(std::memory_order_acquire);
+            if (tail - _headCache == N)
+                return false;
+        }
+        _slots[tail & (N - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * (Consumer side)
+     * @returns false if the ring is empty.
+     */
+    bool pop(T& item) {
+        const unsigned head = _head.load(std::memory_order_relaxed);
+        if (head == _tailCache) {
+            _tailCache = _tail.load(std::memory_order_acquire);
+            if (head == _tailCache)
+                return false;
+        }
+        item = _slots[head & (N - 1)];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * (Consumer side) Passes each waiting item to the function in place
+     * (i.e. without copying it out of the ring) and then releases the slot.
+     *
+     * @returns The number of items consumed.
+     */
+    template<typename F> unsigned drain(F f) {
+        unsigned head = _head.load(std::memory_order_relaxed);
+        _tailCache = _tail.load(std::memory_order_acquire);
+        unsigned count = 0;
+        while (head != _tailCache) {
+            f(_slots[head & (N - 1)]);
+            head++;
+            count++;
+            _head.store(head, std::memory_order_release);
+        }
+        return count;
+    }
+
+    /**
+     * @returns An approximate count of waiting items. Safe to call
+     * from any thread.
+     */
+    unsigned size() const {
+        return _tail.load(std::memory_order_acquire) -
+            _head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    static constexpr unsigned capacity() { return N; }
+
+private:
+
+    // Consumer-owned
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> _head { 0 };
+    unsigned _tailCache = 0;
+    // Producer-owned
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned> _tail { 0 };
+    unsigned _headCache = 0;
+
+    alignas(CACHE_LINE_SIZE) T _slots[N];
+};
+
+    }
+}
@@ -0,0 +1,61 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <sys/socket.h>
+
+#include <map>
+#include <string>
+
+#include "kc1fsz-tools/fixedstring.h"
+
+#include "LineIAX2.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A LocalRegistry with a fixed list of nodes, for the test clients
+ * (amp-replay, amp-loadgen) that call a known address. Every node is
+ * called as a guest.
+ */
+class StaticRegistry : public LocalRegistry {
+public:
+
+    void add(const std::string& node, const sockaddr_storage& addr) {
+        _nodes[node] = addr;
+    }
+
+    virtual bool lookup(const char* destNumber, sockaddr_storage& addr,
+        fixedstring& user, fixedstring& password) {
+        auto it = _nodes.find(destNumber);
+        if (it == _nodes.end())
+            return false;
+        addr = it->second;
+        user = "radio";
+        password = "";
+        return true;
+    }
+
+private:
+
+    std::map<std::string, sockaddr_storage> _nodes;
+};
+
+    }
+}
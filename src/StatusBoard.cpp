@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <nlohmann/json.hpp>
+
+#include "StatusBoard.h"
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace kc1fsz {
+
+    namespace amp {
+
+StatusBoard::StatusBoard() {
+    _names.reserve(MAX_FIELDS);
+    for (unsigned i = 0; i < MAX_FIELDS; i++) {
+        _working[i] = 0;
+        _published[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+int StatusBoard::addField(const std::string& name) {
+    if (_names.size() == MAX_FIELDS)
+        return -1;
+    _names.push_back(name);
+    return _names.size() - 1;
+}
+
+void StatusBoard::publish() {
+    const uint64_t seq = _seq.load(std::memory_order_relaxed);
+    _seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (unsigned i = 0; i < _names.size(); i++)
+        _published[i].store(_working[i], std::memory_order_relaxed);
+    _seq.store(seq + 2, std::memory_order_release);
+}
+
+uint64_t StatusBoard::snapshot(int64_t* values) const {
+    while (true) {
+        const uint64_t before = _seq.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+        for (unsigned i = 0; i < _names.size(); i++)
+            values[i] = _published[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_seq.load(std::memory_order_relaxed) == before)
+            return before / 2;
+    }
+}
+
+string StatusBoard::renderDelta(uint64_t seq, const int64_t* prev, const int64_t* cur) const {
+    json doc;
+    doc["seq"] = seq;
+    if (!prev)
+        doc["full"] = true;
+    json values = json::object();
+    for (unsigned i = 0; i < _names.size(); i++)
+        if (!prev || prev[i] != cur[i])
+            values[_names[i]] = cur[i];
+    doc["values"] = values;
+    return doc.dump();
+}
+
+    }
+}
@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A set of named integer status values (counters, for now)
+ * that one thread keeps up to date and any number of other threads read.
+ *
+ * The owner set()s values in a private working copy, which costs nothing
+ * more than a store, and publish()es them all at once every so often.
+ * Readers copy the most recent publication under a sequence lock, so
+ * they never block the owner and always see a consistent set. Anything
+ * expensive (formatting, diffing, I/O) happens on the reader's thread.
+ *
+ * Fields are added during setup, before the first publish().
+ */
+class StatusBoard {
+public:
+
+    static constexpr unsigned MAX_FIELDS = 256;
+
+    StatusBoard();
+
+    /**
+     * (Setup only)
+     *
+     * @returns The field's id, or -1 if there are too many.
+     */
+    int addField(const std::string& name);
+
+    unsigned getFieldCount() const { return _names.size(); }
+
+    const std::string& getFieldName(unsigned id) const { return _names[id]; }
+
+    /**
+     * (Owner only)
+     *
+     * @param id Returned by addField().
+     */
+    void set(unsigned id, int64_t value) {
+        assert(id < _names.size());
+        _working[id] = value;
+    }
+
+    /**
+     * (Owner only) Makes the working values visible to the readers.
+     */
+    void publish();
+
+    /**
+     * Copies the most recently published values.
+     *
+     * @param values getFieldCount() entries.
+     * @returns The number of the publication (1, 2, ...), or 0 if nothing
+     *   has been published yet.
+     */
+    uint64_t snapshot(int64_t* values) const;
+
+    /**
+     * Renders the fields that differ between two snapshots as JSON:
+     * {"seq":N,"values":{"name":value,...}}. Everything is included
+     * when prev is nullptr (and "full":true is added).
+     */
+    std::string renderDelta(uint64_t seq, const int64_t* prev, const int64_t* cur) const;
+
+private:
+
+    std::vector<std::string> _names;
+    int64_t _working[MAX_FIELDS];
+    std::atomic<int64_t> _published[MAX_FIELDS];
+    // Odd while a publish is in progress
+    std::atomic<uint64_t> _seq = 0;
+};
+
+    }
+}
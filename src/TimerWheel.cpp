@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TimerWheel.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+TimerWheel::TimerWheel(uint64_t nowMs)
+:   _nowMs(nowMs) {
+    for (unsigned i = 0; i < LEVELS * SLOTS; i++)
+        _slots[i] = nullptr;
+    for (unsigned l = 0; l < LEVELS; l++)
+        _occupied[l] = 0;
+}
+
+TimerWheel::~TimerWheel() {
+    for (unsigned i = 0; i < LEVELS * SLOTS; i++)
+        while (_slots[i])
+            _pop(i)->_wheel = nullptr;
+}
+
+void TimerWheel::scheduleAt(Timer& t, uint64_t expiresMs) {
+    if (t._wheel)
+        t._wheel->cancel(t);
+    t._expiresMs = (expiresMs > _nowMs) ? expiresMs : _nowMs + 1;
+    t._wheel = this;
+    _insert(t);
+    _armedCount++;
+}
+
+void TimerWheel::cancel(Timer& t) {
+    if (t._wheel != this)
+        return;
+    _unlink(t);
+    t._wheel = nullptr;
+    _armedCount--;
+}
+
+unsigned TimerWheel::advance(uint64_t nowMs) {
+    unsigned fired = 0;
+    while (_nowMs < nowMs) {
+        if (_armedCount == 0) {
+            _nowMs = nowMs;
+            break;
+        }
+        // If the lower levels are empty nothing happens until the next
+        // slot of the first level with something in it comes up
+        unsigned level = 0;
+        while (_occupied[level] == 0)
+            level++;
+        if (level > 0) {
+            const uint64_t idleUntil = _nowMs | ((1ULL << (level * SLOT_BITS)) - 1);
+            if (idleUntil >= nowMs) {
+                _nowMs = nowMs;
+                break;
+            }
+            _nowMs = idleUntil;
+        }
+        _nowMs++;
+        // At the start of each rotation of a level the next slot of the 
+        // level above is moved down. Higher levels go first since their
+        // timers can land in the slot that the level below is about to 
+        // move.
+        for (unsigned l = LEVELS - 1; l > 0; l--) {
+            const uint64_t mask = (1ULL << (l * SLOT_BITS)) - 1;
+            if ((_nowMs & mask) != 0)
+                continue;
+            const unsigned slot = l * SLOTS + ((_nowMs >> (l * SLOT_BITS)) & (SLOTS - 1));
+            while (_slots[slot]) {
+                Timer* t = _pop(slot);
+                _insert(*t);
+            }
+        }
+        const unsigned slot = _nowMs & (SLOTS - 1);
+        while (_slots[slot]) {
+            Timer* t = _pop(slot);
+            t->_wheel = nullptr;
+            _armedCount--;
+            fired++;
+            if (t->_cb)
+                t->_cb();
+        }
+    }
+    return fired;
+}
+
+void TimerWheel::_insert(Timer& t) {
+    // Only called for times after _nowMs, or at _nowMs while its level
+    // 0 slot is being fired
+    const uint64_t delta = t._expiresMs - _nowMs;
+    unsigned level = 0;
+    uint64_t placeMs = t._expiresMs;
+    if (delta >= SPAN_MS) {
+        // Parked at the far end of the wheel until it gets closer
+        level = LEVELS - 1;
+        placeMs = _nowMs + SPAN_MS - 1;
+    }
+    else {
+        while (delta >= (1ULL << ((level + 1) * SLOT_BITS)))
+            level++;
+    }
+    const unsigned index = (placeMs >> (level * SLOT_BITS)) & (SLOTS - 1);
+    const unsigned slot = level * SLOTS + index;
+    t._slot = slot;
+    t._prev = nullptr;
+    t._next = _slots[slot];
+    if (t._next)
+        t._next->_prev = &t;
+    _slots[slot] = &t;
+    _occupied[level] |= (1ULL << index);
+}
+
+void TimerWheel::_unlink(Timer& t) {
+    if (t._prev)
+        t._prev->_next = t._next;
+    else 
+        _slots[t._slot] = t._next;
+    if (t._next)
+        t._next->_prev = t._prev;
+    if (!_slots[t._slot])
+        _occupied[t._slot / SLOTS] &= ~(1ULL << (t._slot % SLOTS));
+    t._next = nullptr;
+    t._prev = nullptr;
+}
+
+TimerWheel::Timer* TimerWheel::_pop(unsigned slot) {
+    Timer* t = _slots[slot];
+    _unlink(*t);
+    return t;
+}
+
+    }
+}
@@ -0,0 +1,152 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * A hierarchical timing wheel with 1ms resolution: four levels of 64 
+ * slots, so level 0 covers the next 64ms, level 1 the next 4s, level 2
+ * the next 4.5 minutes and level 3 the next 4.6 hours (anything further 
+ * out waits at the end of level 3 and is placed again from there).
+ *
+ * Scheduling and cancelling are O(1) (an intrusive list insert/unlink).
+ * advance() only touches the slots that come due and skips over 
+ * stretches where the lower levels are empty, so its cost doesn't 
+ * depend on the number of timers that are armed. Timers further out are moved down a
+ * level when their slot comes up, each is moved at most three times.
+ *
+ * The timers are owned by the caller (ex: embedded in the call state) 
+ * and nothing is allocated after a timer's callback is set. The wheel
+ * belongs to one thread.
+ */
+class TimerWheel {
+public:
+
+    static constexpr unsigned LEVELS = 4;
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr unsigned SLOTS = 1 << SLOT_BITS;
+    // The furthest out that a timer can be placed directly
+    static constexpr uint64_t SPAN_MS = 1ULL << (LEVELS * SLOT_BITS);
+
+    /**
+     * Something to be done at a time. A timer can't be copied or moved
+     * and it cancels itself when destroyed.
+     */
+    class Timer {
+    public:
+
+        Timer() { }
+        Timer(std::function<void()> cb) : _cb(cb) { }
+        ~Timer() { cancel(); }
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+        /**
+         * (Not while armed)
+         */
+        void setCallback(std::function<void()> cb) { _cb = cb; }
+
+        bool isArmed() const { return _wheel != nullptr; }
+
+        uint64_t getExpiresMs() const { return _expiresMs; }
+
+        void cancel() {
+            if (_wheel)
+                _wheel->cancel(*this);
+        }
+
+    private:
+
+        friend class TimerWheel;
+
+        std::function<void()> _cb;
+        TimerWheel* _wheel = nullptr;
+        Timer* _next = nullptr;
+        Timer* _prev = nullptr;
+        uint64_t _expiresMs = 0;
+        unsigned _slot = 0;
+    };
+
+    TimerWheel(uint64_t nowMs = 0);
+
+    /**
+     * Disarms anything that is still armed.
+     */
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * Arms a timer (re-arms it if it's already armed) to fire delayMs
+     * after the current wheel time. A delay of 0 fires on the next 
+     * advance() that moves the time forward.
+     */
+    void schedule(Timer& t, uint64_t delayMs) { scheduleAt(t, _nowMs + delayMs); }
+
+    /**
+     * Arms a timer to fire at an absolute time. A time that has already
+     * passed is treated like a delay of 0.
+     */
+    void scheduleAt(Timer& t, uint64_t expiresMs);
+
+    /**
+     * Does nothing if the timer isn't armed.
+     */
+    void cancel(Timer& t);
+
+    /**
+     * Moves the wheel time forward and fires every timer that comes due,
+     * earliest first (timers due in the same millisecond are in no 
+     * particular order). The timers are disarmed before their callbacks
+     * are called, so a callback can re-arm its own timer or schedule/
+     * cancel any other.
+     *
+     * @returns The number of timers fired.
+     */
+    unsigned advance(uint64_t nowMs);
+
+    uint64_t getNowMs() const { return _nowMs; }
+
+    unsigned getArmedCount() const { return _armedCount; }
+
+private:
+
+    void _insert(Timer& t);
+    void _unlink(Timer& t);
+    /**
+     * Detaches the first timer in a slot.
+     */
+    Timer* _pop(unsigned slot);
+
+    Timer* _slots[LEVELS * SLOTS];
+    // A bit for each slot that has something in it
+    uint64_t _occupied[LEVELS];
+    // Everything at or before this time has fired
+    uint64_t _nowMs;
+    unsigned _armedCount = 0;
+};
+
+    }
+}
@@ -0,0 +1,194 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <sys/socket.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "UdpBatchIO.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+UdpBatchIO::UdpBatchIO(int fd, bool batched)
+:   _fd(fd),
+#ifdef __linux__
+    _batched(batched) {
+#else
+    _batched(false) {
+#endif
+}
+
+int UdpBatchIO::receive(const PacketCb& cb, unsigned maxPackets) {
+    int rc = _batched ? _receiveBatch(cb, maxPackets) : _receiveSingle(cb, maxPackets);
+    if (rc > 0)
+        _stats.rxMaxBatch = std::max(_stats.rxMaxBatch, (uint32_t)rc);
+    return rc;
+}
+
+int UdpBatchIO::_receiveSingle(const PacketCb& cb, unsigned maxPackets) {
+    unsigned count = 0;
+    Packet& p = _rx[0];
+    while (count < maxPackets) {
+        p.addrLen = sizeof(p.addr);
+        int rc = recvfrom(_fd, p.data, MAX_PACKET_SIZE, 0, (sockaddr*)&p.addr, &p.addrLen);
+        _stats.rxSyscalls++;
+        if (rc < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                break;
+            return -1;
+        }
+        _stats.rxPackets++;
+        count++;
+        cb(p.data, rc, p.addr);
+    }
+    return count;
+}
+
+int UdpBatchIO::_receiveBatch(const PacketCb& cb, unsigned maxPackets) {
+#ifdef __linux__
+    mmsghdr msgs[MAX_BATCH];
+    iovec iovs[MAX_BATCH];
+    unsigned count = 0;
+    while (count < maxPackets) {
+        const unsigned want = std::min(MAX_BATCH, maxPackets - count);
+        for (unsigned i = 0; i < want; i++) {
+            iovs[i].iov_base = _rx[i].data;
+            iovs[i].iov_len = MAX_PACKET_SIZE;
+            memset(&msgs[i].msg_hdr, 0, sizeof(msghdr));
+            msgs[i].msg_hdr.msg_name = &_rx[i].addr;
+            msgs[i].msg_hdr.msg_namelen = sizeof(_rx[i].addr);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int rc = recvmmsg(_fd, msgs, want, MSG_DONTWAIT, nullptr);
+        _stats.rxSyscalls++;
+        if (rc < 0) {
+            if (errno == ENOSYS) {
+                // Old kernel, fall back permanently
+                _batched = false;
+                int rc2 = _receiveSingle(cb, maxPackets - count);
+                return (rc2 < 0) ? -1 : count + rc2;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                break;
+            return -1;
+        }
+        _stats.rxPackets += rc;
+        count += rc;
+        for (int i = 0; i < rc; i++)
+            cb(_rx[i].data, msgs[i].msg_len, _rx[i].addr);
+        // A short batch means the socket is empty
+        if ((unsigned)rc < want)
+            break;
+    }
+    return count;
+#else
+    return _receiveSingle(cb, maxPackets);
+#endif
+}
+
+int UdpBatchIO::queue(const uint8_t* data, unsigned len, const sockaddr* to, socklen_t toLen) {
+    if (len > MAX_PACKET_SIZE || toLen > sizeof(sockaddr_storage))
+        return -1;
+    if (_txCount == MAX_BATCH)
+        flush();
+    Packet& p = _tx[_txCount++];
+    memcpy(p.data, data, len);
+    p.len = len;
+    memcpy(&p.addr, to, toLen);
+    p.addrLen = toLen;
+    return 0;
+}
+
+int UdpBatchIO::flush() {
+    if (_txCount == 0)
+        return 0;
+    _stats.txMaxBatch = std::max(_stats.txMaxBatch, (uint32_t)_txCount);
+    int rc = _batched ? _flushBatch() : _flushSingle();
+    _txCount = 0;
+    return rc;
+}
+
+int UdpBatchIO::_flushSingle() {
+    int sent = 0;
+    for (unsigned i = 0; i < _txCount; i++) {
+        const Packet& p = _tx[i];
+        _stats.txSyscalls++;
+        if (sendto(_fd, p.data, p.len, 0, (const sockaddr*)&p.addr, p.addrLen) < 0)
+            _stats.txErrors++;
+        else
+            sent++;
+    }
+    _stats.txPackets += sent;
+    return sent;
+}
+
+int UdpBatchIO::_flushBatch() {
+#ifdef __linux__
+    mmsghdr msgs[MAX_BATCH];
+    iovec iovs[MAX_BATCH];
+    for (unsigned i = 0; i < _txCount; i++) {
+        iovs[i].iov_base = _tx[i].data;
+        iovs[i].iov_len = _tx[i].len;
+        memset(&msgs[i].msg_hdr, 0, sizeof(msghdr));
+        msgs[i].msg_hdr.msg_name = &_tx[i].addr;
+        msgs[i].msg_hdr.msg_namelen = _tx[i].addrLen;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    unsigned done = 0;
+    unsigned errors = 0;
+    while (done < _txCount) {
+        int rc = sendmmsg(_fd, msgs + done, _txCount - done, MSG_DONTWAIT);
+        _stats.txSyscalls++;
+        if (rc < 0) {
+            if (errno == ENOSYS) {
+                _batched = false;
+                // Shift the unsent packets down and send them one at a time
+                memmove(_tx, _tx + done, (_txCount - done) * sizeof(Packet));
+                _txCount -= done;
+                return done + _flushSingle();
+            }
+            // sendmmsg() reports an error only for the first message, so
+            // skip that one and carry on with the rest.
+            _stats.txErrors++;
+            errors++;
+            done++;
+            continue;
+        }
+        _stats.txPackets += rc;
+        done += rc;
+    }
+    return done - errors;
+#else
+    return _flushSingle();
+#endif
+}
+
+float UdpBatchIO::getRxPacketsPerSyscall() const {
+    return _stats.rxSyscalls ? (float)_stats.rxPackets / _stats.rxSyscalls : 0;
+}
+
+float UdpBatchIO::getTxPacketsPerSyscall() const {
+    return _stats.txSyscalls ? (float)_stats.txPackets / _stats.txSyscalls : 0;
+}
+
+    }
+}
@@ -0,0 +1,135 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <cstdint>
+#include <functional>
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * Moves datagrams through a non-blocking UDP socket in batches so that
+ * a busy line pays for one system call per batch instead of one per
+ * packet. On Linux this uses recvmmsg()/sendmmsg(). If those are not 
+ * available (at compile time or at run time) it quietly falls back to
+ * recvfrom()/sendto() with the same interface.
+ *
+ * The intended use is once per EventLoop pass: call receive() to drain
+ * everything that is waiting, queue() outbound packets as they are 
+ * produced, and flush() at the end of the pass.
+ *
+ * The caller owns the socket. All buffers are allocated inside the
+ * object.
+ */
+class UdpBatchIO {
+public:
+
+    static constexpr unsigned MAX_BATCH = 32;
+
+    /**
+     * Big enough for any IAX2 frame.
+     */
+    static constexpr unsigned MAX_PACKET_SIZE = 1500;
+
+    /**
+     * Called once for each received datagram.
+     */
+    using PacketCb = std::function<void(const uint8_t* data, unsigned len, 
+        const sockaddr_storage& from)>;
+
+    struct Stats {
+        uint32_t rxPackets = 0;
+        uint32_t rxSyscalls = 0;
+        uint32_t txPackets = 0;
+        uint32_t txSyscalls = 0;
+        uint32_t txErrors = 0;
+        // The largest number of packets handled by a single receive() or 
+        // flush() call
+        uint32_t rxMaxBatch = 0;
+        uint32_t txMaxBatch = 0;
+    };
+
+    /**
+     * @param batched Pass false to force the one-packet-per-call path.
+     */
+    UdpBatchIO(int fd, bool batched = true);
+
+    /**
+     * Drains up to maxPackets waiting datagrams, calling cb for each one.
+     *
+     * @returns The number of datagrams received, or -1 on a socket error.
+     */
+    int receive(const PacketCb& cb, unsigned maxPackets = MAX_BATCH * 4);
+
+    /**
+     * Copies a datagram into the outbound batch. A full batch is flushed
+     * automatically.
+     *
+     * @returns 0 on success, -1 if the packet is too big.
+     */
+    int queue(const uint8_t* data, unsigned len, const sockaddr* to, socklen_t toLen);
+
+    /**
+     * Sends everything in the outbound batch.
+     *
+     * @returns The number of datagrams sent.
+     */
+    int flush();
+
+    unsigned getQueuedCount() const { return _txCount; }
+
+    bool isBatched() const { return _batched; }
+
+    const Stats& getStats() const { return _stats; }
+
+    void resetStats() { _stats = Stats(); }
+
+    /**
+     * @returns Average packets per system call in each direction.
+     */
+    float getRxPacketsPerSyscall() const;
+    float getTxPacketsPerSyscall() const;
+
+private:
+
+    int _receiveBatch(const PacketCb& cb, unsigned maxPackets);
+    int _receiveSingle(const PacketCb& cb, unsigned maxPackets);
+    int _flushBatch();
+    int _flushSingle();
+
+    struct Packet {
+        sockaddr_storage addr;
+        socklen_t addrLen;
+        unsigned len;
+        uint8_t data[MAX_PACKET_SIZE];
+    };
+
+    const int _fd;
+    bool _batched;
+    Packet _rx[MAX_BATCH];
+    Packet _tx[MAX_BATCH];
+    unsigned _txCount = 0;
+    Stats _stats;
+};
+
+    }
+}
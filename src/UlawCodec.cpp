@@ -0,0 +1,204 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "UlawCodec.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+// The 14-bit magnitude is biased by 33 and limited to 13 bits
+static const int BIAS = 33;
+static const int MAX_MAGNITUDE = 0x1fff;
+
+/**
+ * Expands every code once (the G.191 ulaw_expand() formula).
+ */
+struct DecodeTable {
+    int16_t values[256];
+    DecodeTable() {
+        for (unsigned u = 0; u < 256; u++) {
+            const int sign = (u < 0x80) ? -1 : 1;
+            const int inverted = ~u;
+            const int exponent = (inverted >> 4) & 7;
+            const int mantissa = inverted & 0xf;
+            const int step = 4 << (exponent + 1);
+            values[u] = sign * ((0x80 << exponent) + step * mantissa + step / 2 - 4 * BIAS);
+        }
+    }
+};
+
+static const DecodeTable decodeTable;
+
+// ===== Scalar ===============================================================
+
+uint8_t UlawCodec::encodeSample(int16_t x) {
+    // Ones' complement for negative values, as in the reference
+    int absno = ((x < 0) ? (~x >> 2) : (x >> 2)) + BIAS;
+    if (absno > MAX_MAGNITUDE)
+        absno = MAX_MAGNITUDE;
+    // absno >= 33, so absno | 32 doesn't change the bit length and keeps
+    // the argument of clz non-zero
+    const int segno = 1 + (26 - __builtin_clz((unsigned)absno | 32));
+    const int high = 8 - segno;
+    const int low = 0xf - ((absno >> segno) & 0xf);
+    return (high << 4) | low | ((x >= 0) ? 0x80 : 0);
+}
+
+int16_t UlawCodec::decodeSample(uint8_t code) {
+    return decodeTable.values[code];
+}
+
+static void encodeScalar(const int16_t* in, uint8_t* out, unsigned n) {
+    for (unsigned k = 0; k < n; k++)
+        out[k] = UlawCodec::encodeSample(in[k]);
+}
+
+#if defined(__x86_64__)
+
+// ===== SSE4.1 ===============================================================
+
+// The segment is 1 plus the number of thresholds (64, 128, ... 4096) that
+// the magnitude reaches. Each one also halves the multiplier that does
+// the shift (mulhi(a, 2^(16 - segno)) == a >> segno).
+
+__attribute__((target("sse4.1")))
+static inline __m128i encode8Sse41(__m128i x) {
+    const __m128i sign = _mm_srai_epi16(x, 15);
+    __m128i absno = _mm_add_epi16(_mm_srli_epi16(_mm_xor_si128(x, sign), 2),
+        _mm_set1_epi16(BIAS));
+    absno = _mm_min_epi16(absno, _mm_set1_epi16(MAX_MAGNITUDE));
+    __m128i seg = _mm_setzero_si128();
+    __m128i mult = _mm_set1_epi16((short)0x8000);
+    for (int t = 64; t <= 4096; t <<= 1) {
+        const __m128i m = _mm_cmpgt_epi16(absno, _mm_set1_epi16(t - 1));
+        seg = _mm_sub_epi16(seg, m);
+        mult = _mm_sub_epi16(mult, _mm_and_si128(_mm_srli_epi16(mult, 1), m));
+    }
+    const __m128i f = _mm_set1_epi16(0xf);
+    const __m128i low = _mm_sub_epi16(f, _mm_and_si128(_mm_mulhi_epu16(absno, mult), f));
+    // 8 - segno == 7 - seg
+    const __m128i high = _mm_slli_epi16(_mm_sub_epi16(_mm_set1_epi16(7), seg), 4);
+    return _mm_or_si128(_mm_or_si128(high, low),
+        _mm_andnot_si128(sign, _mm_set1_epi16(0x80)));
+}
+
+__attribute__((target("sse4.1")))
+static void encodeSse41(const int16_t* in, uint8_t* out, unsigned n) {
+    unsigned k = 0;
+    for (; k + 8 <= n; k += 8) {
+        const __m128i r = encode8Sse41(_mm_loadu_si128((const __m128i*)(in + k)));
+        _mm_storel_epi64((__m128i*)(out + k), _mm_packus_epi16(r, r));
+    }
+    encodeScalar(in + k, out + k, n - k);
+}
+
+// ===== AVX2 =================================================================
+
+__attribute__((target("avx2")))
+static void encodeAvx2(const int16_t* in, uint8_t* out, unsigned n) {
+    const __m256i bias = _mm256_set1_epi16(BIAS);
+    const __m256i maxMag = _mm256_set1_epi16(MAX_MAGNITUDE);
+    const __m256i f = _mm256_set1_epi16(0xf);
+    const __m256i seven = _mm256_set1_epi16(7);
+    const __m256i positive = _mm256_set1_epi16(0x80);
+    unsigned k = 0;
+    for (; k + 16 <= n; k += 16) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(in + k));
+        const __m256i sign = _mm256_srai_epi16(x, 15);
+        __m256i absno = _mm256_add_epi16(_mm256_srli_epi16(_mm256_xor_si256(x, sign), 2),
+            bias);
+        absno = _mm256_min_epi16(absno, maxMag);
+        __m256i seg = _mm256_setzero_si256();
+        __m256i mult = _mm256_set1_epi16((short)0x8000);
+        for (int t = 64; t <= 4096; t <<= 1) {
+            const __m256i m = _mm256_cmpgt_epi16(absno, _mm256_set1_epi16(t - 1));
+            seg = _mm256_sub_epi16(seg, m);
+            mult = _mm256_sub_epi16(mult, _mm256_and_si256(_mm256_srli_epi16(mult, 1), m));
+        }
+        const __m256i low = _mm256_sub_epi16(f,
+            _mm256_and_si256(_mm256_mulhi_epu16(absno, mult), f));
+        const __m256i high = _mm256_slli_epi16(_mm256_sub_epi16(seven, seg), 4);
+        const __m256i r = _mm256_or_si256(_mm256_or_si256(high, low),
+            _mm256_andnot_si256(sign, positive));
+        // The pack works within each 128-bit lane, so gather the two
+        // halves from quadwords 0 and 2
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(r, r), 0x08);
+        _mm_storeu_si128((__m128i*)(out + k), _mm256_castsi256_si128(packed));
+    }
+    encodeSse41(in + k, out + k, n - k);
+}
+
+#endif
+
+#if defined(__aarch64__)
+
+// ===== NEON =================================================================
+
+static void encodeNeon(const int16_t* in, uint8_t* out, unsigned n) {
+    unsigned k = 0;
+    for (; k + 8 <= n; k += 8) {
+        const int16x8_t x = vld1q_s16(in + k);
+        const uint16x8_t sign = vreinterpretq_u16_s16(vshrq_n_s16(x, 15));
+        uint16x8_t absno = vaddq_u16(vshrq_n_u16(veorq_u16(vreinterpretq_u16_s16(x), sign), 2),
+            vdupq_n_u16(BIAS));
+        absno = vminq_u16(absno, vdupq_n_u16(MAX_MAGNITUDE));
+        // segno = 1 + the bit length of (absno >> 6)
+        const int16x8_t segno = vsubq_s16(vdupq_n_s16(17),
+            vreinterpretq_s16_u16(vclzq_u16(vshrq_n_u16(absno, 6))));
+        const uint16x8_t low = vsubq_u16(vdupq_n_u16(0xf),
+            vandq_u16(vshlq_u16(absno, vnegq_s16(segno)), vdupq_n_u16(0xf)));
+        const uint16x8_t high = vshlq_n_u16(vreinterpretq_u16_s16(
+            vsubq_s16(vdupq_n_s16(8), segno)), 4);
+        const uint16x8_t r = vorrq_u16(vorrq_u16(high, low),
+            vbicq_u16(vdupq_n_u16(0x80), sign));
+        vst1_u8(out + k, vmovn_u16(r));
+    }
+    encodeScalar(in + k, out + k, n - k);
+}
+
+#endif
+
+// ===== UlawCodec ============================================================
+
+UlawCodec::UlawCodec(Impl impl)
+:   _impl(isSupported(impl) ? impl : Impl::SCALAR),
+    _encode(encodeScalar) {
+#if defined(__x86_64__)
+    if (_impl == Impl::SSE41)
+        _encode = encodeSse41;
+    else if (_impl == Impl::AVX2)
+        _encode = encodeAvx2;
+#endif
+#if defined(__aarch64__)
+    if (_impl == Impl::NEON)
+        _encode = encodeNeon;
+#endif
+}
+
+void UlawCodec::decode(const uint8_t* in, int16_t* out, unsigned n) {
+    for (unsigned k = 0; k < n; k++)
+        out[k] = decodeTable.values[in[k]];
+}
+
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "CpuFeatures.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+/**
+ * G.711 mu-law conversion a frame at a time, bit-exact with the ITU
+ * reference (ulaw_compress()/ulaw_expand() in the G.191 g711.c).
+ *
+ * Decoding is a 256-entry table lookup. Encoding is branch-free: the
+ * segment comes from a handful of comparisons (a count-leading-zeros on
+ * NEON) and the mantissa shift is done with a multiply, so AVX2 does 16
+ * samples per step and SSE4.1/NEON do 8. The best implementation for the
+ * running CPU is picked at runtime, with a scalar fallback.
+ */
+class UlawCodec {
+public:
+
+    using Impl = SimdImpl;
+
+    UlawCodec(Impl impl = detectSimd());
+
+    Impl getImpl() const { return _impl; }
+
+    /**
+     * Converts n linear samples to mu-law.
+     */
+    void encode(const int16_t* in, uint8_t* out, unsigned n) const {
+        _encode(in, out, n);
+    }
+
+    /**
+     * Converts n mu-law samples to linear.
+     */
+    static void decode(const uint8_t* in, int16_t* out, unsigned n);
+
+    static uint8_t encodeSample(int16_t sample);
+
+    static int16_t decodeSample(uint8_t code);
+
+private:
+
+    using EncodeFn = void (*)(const int16_t* in, uint8_t* out, unsigned n);
+
+    Impl _impl;
+    EncodeFn _encode;
+};
+
+    }
+}
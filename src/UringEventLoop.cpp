@@ -0,0 +1,345 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/Clock.h"
+#include "kc1fsz-tools/Runnable2.h"
+
+#include "UringEventLoop.h"
+
+namespace kc1fsz {
+
+    namespace amp {
+
+// What a completion is for
+static constexpr uint64_t TAG_POLL = 0;
+static constexpr uint64_t TAG_TIMER = 1;
+
+static uint64_t monoUs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+UringEventLoop::UringEventLoop(Log& log, Clock& clock)
+:   _log(log),
+    _clock(clock) {
+
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = syscall(__NR_io_uring_setup, RING_ENTRIES, &p);
+    if (fd < 0) {
+        _log.error("io_uring_setup failed (%d)", errno);
+        return;
+    }
+
+    _sqMapLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    _cqMapLen = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMap = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap)
+        _sqMapLen = _cqMapLen = std::max(_sqMapLen, _cqMapLen);
+
+    _sqMap = mmap(0, _sqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, 
+        fd, IORING_OFF_SQ_RING);
+    if (_sqMap == MAP_FAILED) {
+        _log.error("io_uring SQ map failed (%d)", errno);
+        _sqMap = nullptr;
+        close(fd);
+        return;
+    }
+    if (singleMap) {
+        _cqMap = _sqMap;
+    } else {
+        _cqMap = mmap(0, _cqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, 
+            fd, IORING_OFF_CQ_RING);
+        if (_cqMap == MAP_FAILED) {
+            _log.error("io_uring CQ map failed (%d)", errno);
+            _cqMap = nullptr;
+            munmap(_sqMap, _sqMapLen);
+            _sqMap = nullptr;
+            close(fd);
+            return;
+        }
+    }
+    _sqesLen = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(0, _sqesLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, 
+        fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        _log.error("io_uring SQE map failed (%d)", errno);
+        if (_cqMap != _sqMap)
+            munmap(_cqMap, _cqMapLen);
+        munmap(_sqMap, _sqMapLen);
+        _sqMap = _cqMap = nullptr;
+        close(fd);
+        return;
+    }
+    _sqes = (io_uring_sqe*)sqes;
+
+    char* sq = (char*)_sqMap;
+    _sqHead = (unsigned*)(sq + p.sq_off.head);
+    _sqTail = (unsigned*)(sq + p.sq_off.tail);
+    _sqMask = (unsigned*)(sq + p.sq_off.ring_mask);
+    _sqArray = (unsigned*)(sq + p.sq_off.array);
+    _sqEntries = p.sq_entries;
+    char* cq = (char*)_cqMap;
+    _cqHead = (unsigned*)(cq + p.cq_off.head);
+    _cqTail = (unsigned*)(cq + p.cq_off.tail);
+    _cqMask = (unsigned*)(cq + p.cq_off.ring_mask);
+    _cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epollFd < 0) {
+        _log.error("epoll_create1 failed (%d)", errno);
+        munmap(_sqes, _sqesLen);
+        if (_cqMap != _sqMap)
+            munmap(_cqMap, _cqMapLen);
+        munmap(_sqMap, _sqMapLen);
+        _sqMap = _cqMap = nullptr;
+        _sqes = nullptr;
+        close(fd);
+        return;
+    }
+
+    _ringFd = fd;
+}
+
+UringEventLoop::~UringEventLoop() {
+    if (_ringFd < 0)
+        return;
+    munmap(_sqes, _sqesLen);
+    if (_cqMap != _sqMap)
+        munmap(_cqMap, _cqMapLen);
+    munmap(_sqMap, _sqMapLen);
+    close(_ringFd);
+    close(_epollFd);
+}
+
+void UringEventLoop::run(Runnable2** tasks, unsigned taskCount) {
+
+    if (!isOpen())
+        return;
+
+    _stopping = false;
+    uint64_t now = monoUs();
+    _nextTickUs = now + TICK_MS * 1000;
+    _nextOneSecUs = now + 1000000;
+    _nextTenSecUs = now + 10000000;
+
+    while (!_stopping) {
+        // Keep going as long as anyone is getting work done
+        bool worked = true;
+        while (worked && !_stopping) {
+            worked = false;
+            for (unsigned i = 0; i < taskCount; i++)
+                if (tasks[i]->run2())
+                    worked = true;
+            _tick(tasks, taskCount, monoUs());
+        }
+        if (_stopping)
+            break;
+        _watchPolls(tasks, taskCount);
+        _armTimer();
+        _wait(!_overflowing);
+        _tick(tasks, taskCount, monoUs());
+    }
+}
+
+void UringEventLoop::_tick(Runnable2** tasks, unsigned taskCount, uint64_t nowUs) {
+    if (nowUs >= _nextTickUs) {
+        for (unsigned i = 0; i < taskCount; i++)
+            tasks[i]->audioRateTick(_clock.time());
+        _tickCount++;
+        _nextTickUs += TICK_MS * 1000;
+        // Don't try to make up for a long stall with a burst of ticks
+        if (_nextTickUs <= nowUs)
+            _nextTickUs = nowUs + TICK_MS * 1000;
+    }
+    if (nowUs >= _nextOneSecUs) {
+        for (unsigned i = 0; i < taskCount; i++)
+            tasks[i]->oneSecTick();
+        _nextOneSecUs = nowUs + 1000000;
+    }
+    if (nowUs >= _nextTenSecUs) {
+        for (unsigned i = 0; i < taskCount; i++)
+            tasks[i]->tenSecTick();
+        _nextTenSecUs = nowUs + 10000000;
+    }
+}
+
+void UringEventLoop::_watchPolls(Runnable2** tasks, unsigned taskCount) {
+
+    // Room for more than can be watched, so that an overflow is seen
+    pollfd fds[MAX_POLLS * 2];
+    const unsigned fdCapacity = MAX_POLLS * 2;
+    unsigned fdCount = 0;
+    bool overflow = false;
+    for (unsigned i = 0; i < taskCount && fdCount < fdCapacity; i++) {
+        int rc = tasks[i]->getPolls(fds + fdCount, fdCapacity - fdCount);
+        if (rc > 0)
+            fdCount += rc;
+    }
+
+    // Forget anything that no task is interested in anymore (ex: a 
+    // closed device) before anything new is added, it may have the same 
+    // number. A closed descriptor has already left the set.
+    for (unsigned w = 0; w < _watchedCount; w++)
+        _watched[w].wanted = false;
+    for (unsigned i = 0; i < fdCount; i++)
+        for (unsigned w = 0; w < _watchedCount; w++)
+            if (_watched[w].fd == fds[i].fd)
+                _watched[w].wanted = true;
+    for (unsigned w = 0; w < _watchedCount; ) {
+        if (_watched[w].wanted) {
+            w++;
+            continue;
+        }
+        epoll_ctl(_epollFd, EPOLL_CTL_DEL, _watched[w].fd, nullptr);
+        _watched[w] = _watched[--_watchedCount];
+    }
+
+    for (unsigned i = 0; i < fdCount; i++) {
+        if (fds[i].fd < 0)
+            continue;
+        unsigned w = 0;
+        for (; w < _watchedCount && _watched[w].fd != fds[i].fd; w++);
+        if (w < _watchedCount) {
+            // Added again in case it was closed and reopened
+            if (!_watch(fds[i].fd, fds[i].events, _watched[w].events != fds[i].events))
+                overflow = true;
+            _watched[w].events = fds[i].events;
+            continue;
+        }
+        if (_watchedCount == MAX_POLLS || !_watch(fds[i].fd, fds[i].events, false)) {
+            overflow = true;
+            continue;
+        }
+        _watched[_watchedCount++] = { fds[i].fd, fds[i].events, true };
+    }
+
+    if (!_pollArmed) {
+        io_uring_sqe* sqe = _getSqe();
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = _epollFd;
+        sqe->poll32_events = POLLIN;
+        sqe->user_data = TAG_POLL;
+        _pollArmed = true;
+    }
+
+    if (overflow) {
+        _pollOverflowCount++;
+        if (!_overflowing)
+            _log.error("io_uring event loop can't watch every descriptor (at most %u), polling instead of sleeping",
+                MAX_POLLS);
+    }
+    else if (_overflowing)
+        _log.info("io_uring event loop descriptors fit again, sleeping");
+    _overflowing = overflow;
+}
+
+bool UringEventLoop::_watch(int fd, short events, bool modify) {
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = (uint16_t)events;
+    ev.data.fd = fd;
+    if (modify && epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &ev) == 0)
+        return true;
+    // Already in the set (the same file) is fine
+    return epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &ev) == 0 || errno == EEXIST;
+}
+
+void UringEventLoop::_armTimer() {
+    if (_timerArmed)
+        return;
+    _timerTs.tv_sec = _nextTickUs / 1000000;
+    _timerTs.tv_nsec = (_nextTickUs % 1000000) * 1000;
+    io_uring_sqe* sqe = _getSqe();
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t)&_timerTs;
+    sqe->len = 1;
+    sqe->off = 0;
+    sqe->timeout_flags = IORING_TIMEOUT_ABS;
+    sqe->user_data = TAG_TIMER;
+    _timerArmed = true;
+}
+
+void UringEventLoop::_wait(bool block) {
+
+    _submit(block ? 1 : 0);
+    if (block)
+        _wakeCount++;
+
+    unsigned head = *_cqHead;
+    const unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        const io_uring_cqe& cqe = _cqes[head & *_cqMask];
+        if (cqe.user_data == TAG_TIMER) {
+            _timerArmed = false;
+        } 
+        else if (cqe.user_data == TAG_POLL) {
+            // One-shot, so it needs to be armed again next time
+            _pollArmed = false;
+            if (cqe.res >= 0)
+                _pollCompletionCount++;
+        }
+    }
+    __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+}
+
+io_uring_sqe* UringEventLoop::_getSqe() {
+    unsigned tail = *_sqTail;
+    if (tail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) == _sqEntries) {
+        _submit(0);
+        tail = *_sqTail;
+    }
+    const unsigned index = tail & *_sqMask;
+    io_uring_sqe* sqe = &_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    _sqArray[index] = index;
+    __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+    _toSubmit++;
+    return sqe;
+}
+
+void UringEventLoop::_submit(unsigned waitCount) {
+    while (true) {
+        int rc = syscall(__NR_io_uring_enter, _ringFd, _toSubmit, waitCount, 
+            waitCount ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (rc >= 0) {
+            _toSubmit -= std::min((unsigned)rc, _toSubmit);
+            return;
+        }
+        if (errno == EINTR)
+            continue;
+        _log.error("io_uring_enter failed (%d)", errno);
+        // Avoid spinning on a persistent error
+        usleep(TICK_MS * 1000);
+        return;
+    }
+}
+
+    }
+}
@@ -0,0 +1,177 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <poll.h>
+#include <linux/io_uring.h>
+
+#include <cstdint>
+#include <cstddef>
+
+namespace kc1fsz {
+
+class Log;
+class Clock;
+class Runnable2;
+
+    namespace amp {
+
+/**
+ * An alternative to EventLoop::run() that sleeps in io_uring instead of 
+ * spinning/polling. It drives the same Runnable2 tasks in the same way:
+ *
+ * - run2() is called on every task until none of them reports any work.
+ * - audioRateTick() is called every 20ms, oneSecTick() every second and
+ *   tenSecTick() every ten seconds.
+ *
+ * Between passes the thread blocks in io_uring_enter() until one of the
+ * file descriptors that the tasks report through getPolls() is ready or
+ * the next audio tick is due, whichever comes first, so an idle node 
+ * costs one wakeup per tick. 
+ *
+ * The descriptors are watched through an epoll set, and the ring has a 
+ * one-shot POLL_ADD on the epoll descriptor. A POLL_ADD on a task's own 
+ * descriptor would hold a reference to its file: a task that closed and
+ * reopened a socket (ex: a line reopened on a configuration change) 
+ * would find the old one still bound to its port, and the new one, with
+ * the same descriptor number, would look like it was already armed. 
+ * epoll lets go of a file when it's closed, and every descriptor is 
+ * added to the set again on each pass, which the kernel only accepts 
+ * (instead of returning EEXIST) when it's a different file.
+ *
+ * Only MAX_POLLS descriptors can be watched. If the tasks report more
+ * than that, or one can't be watched by epoll, it's logged and the loop 
+ * stops sleeping (it polls the ring without waiting, like EventLoop) 
+ * until they fit again.
+ *
+ * The system calls are made directly (no liburing dependency). If the 
+ * kernel does not support io_uring (or it is blocked by a seccomp 
+ * profile) isOpen() returns false and the caller should fall back to 
+ * EventLoop.
+ */
+class UringEventLoop {
+public:
+
+    static constexpr unsigned TICK_MS = 20;
+    static constexpr unsigned MAX_POLLS = 64;
+    static constexpr unsigned RING_ENTRIES = 128;
+
+    /**
+     * @param clock The time passed to audioRateTick(), the same as 
+     *   EventLoop::run().
+     */
+    UringEventLoop(Log& log, Clock& clock);
+    ~UringEventLoop();
+
+    /**
+     * @returns true if the io_uring instance was created.
+     */
+    bool isOpen() const { return _ringFd >= 0; }
+
+    /**
+     * Runs the tasks until stop() is called.
+     */
+    void run(Runnable2** tasks, unsigned taskCount);
+
+    /**
+     * Makes run() return at the end of the current pass. Only valid on
+     * the thread that is running the loop (i.e. from inside a task).
+     */
+    void stop() { _stopping = true; }
+
+    uint32_t getWakeCount() const { return _wakeCount; }
+    uint32_t getPollCompletionCount() const { return _pollCompletionCount; }
+    uint32_t getTickCount() const { return _tickCount; }
+
+    /**
+     * @returns The number of passes where the tasks reported more 
+     *   descriptors than could be watched.
+     */
+    uint32_t getPollOverflowCount() const { return _pollOverflowCount; }
+
+private:
+
+    void _tick(Runnable2** tasks, unsigned taskCount, uint64_t nowUs);
+    void _watchPolls(Runnable2** tasks, unsigned taskCount);
+    /**
+     * Adds a descriptor to the epoll set, or changes its events.
+     * @returns true if it is being watched.
+     */
+    bool _watch(int fd, short events, bool modify);
+    void _armTimer();
+    /**
+     * @param block false to only reap what has already completed.
+     */
+    void _wait(bool block);
+
+    io_uring_sqe* _getSqe();
+    void _submit(unsigned waitCount);
+
+    Log& _log;
+    Clock& _clock;
+    int _ringFd = -1;
+
+    // Mapped ring state
+    void* _sqMap = nullptr;
+    size_t _sqMapLen = 0;
+    void* _cqMap = nullptr;
+    size_t _cqMapLen = 0;
+    io_uring_sqe* _sqes = nullptr;
+    size_t _sqesLen = 0;
+    unsigned* _sqHead = nullptr;
+    unsigned* _sqTail = nullptr;
+    unsigned* _sqMask = nullptr;
+    unsigned* _sqArray = nullptr;
+    unsigned _sqEntries = 0;
+    unsigned _toSubmit = 0;
+    unsigned* _cqHead = nullptr;
+    unsigned* _cqTail = nullptr;
+    unsigned* _cqMask = nullptr;
+    io_uring_cqe* _cqes = nullptr;
+
+    int _epollFd = -1;
+    // The descriptors in the epoll set
+    struct Watched {
+        int fd;
+        short events;
+        // Still wanted by a task on the most recent pass
+        bool wanted;
+    };
+    Watched _watched[MAX_POLLS];
+    unsigned _watchedCount = 0;
+    // Some descriptors couldn't be watched on the most recent pass
+    bool _overflowing = false;
+    // The POLL_ADD on the epoll descriptor is in the kernel
+    bool _pollArmed = false;
+
+    bool _timerArmed = false;
+    // Absolute CLOCK_MONOTONIC deadline handed to the kernel
+    __kernel_timespec _timerTs;
+
+    uint64_t _nextTickUs = 0;
+    uint64_t _nextOneSecUs = 0;
+    uint64_t _nextTenSecUs = 0;
+    bool _stopping = false;
+
+    uint32_t _wakeCount = 0;
+    uint32_t _pollCompletionCount = 0;
+    uint32_t _tickCount = 0;
+    uint32_t _pollOverflowCount = 0;
+};
+
+    }
+}
@@ -0,0 +1,233 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Places a configurable number of IAX2 calls into a running server,
+ * plays a talkspurt pattern into them, and reports the audio latency,
+ * loss and (optionally) the CPU used by the server process. This 
+ * replaces scripts/run-load.sh for finding the calls-per-core limit.
+ */
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <argparse/argparse.hpp>
+
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/linux/StdClock.h"
+
+#include "LoadGenerator.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+/**
+ * @returns The utime + stime of a process in clock ticks, or -1 if
+ *   it can't be read.
+ */
+static long long processCpuTicks(int pid) {
+    ifstream str("/proc/" + to_string(pid) + "/stat");
+    string line;
+    if (!getline(str, line))
+        return -1;
+    // The command name can contain spaces, so skip past the closing paren
+    size_t p = line.rfind(')');
+    if (p == string::npos)
+        return -1;
+    istringstream fields(line.substr(p + 2));
+    string f;
+    long long utime = 0, stime = 0;
+    // utime and stime are fields 14 and 15, counting the pid as field 1
+    for (unsigned i = 3; i <= 15 && (fields >> f); i++) {
+        if (i == 14) utime = stoll(f);
+        else if (i == 15) stime = stoll(f);
+    }
+    return utime + stime;
+}
+
+int main(int argc, const char** argv) {
+
+    argparse::ArgumentParser program("amp-loadgen");
+
+    string host;
+    program.add_argument("--host")
+        .store_into(host)
+        .default_value(string("127.0.0.1"))
+        .help("Server address");
+
+    int port = 4569;
+    program.add_argument("--port")
+        .store_into(port)
+        .default_value(4569)
+        .help("Server IAX2 port");
+
+    amp::LoadGenerator::Options opts;
+    int calls = opts.calls;
+    program.add_argument("--calls")
+        .store_into(calls)
+        .default_value(100)
+        .help("Number of simultaneous calls");
+
+    int ramp = opts.rampRate;
+    program.add_argument("--ramp")
+        .store_into(ramp)
+        .default_value(20)
+        .help("New calls per second");
+
+    int seconds = 60;
+    program.add_argument("--seconds")
+        .store_into(seconds)
+        .default_value(60)
+        .help("Length of the test, including the ramp");
+
+    string codec;
+    program.add_argument("--codec")
+        .store_into(codec)
+        .default_value(string("ulaw"))
+        .help("Codec offered on every call (ulaw or slin16)");
+
+    int talkers = opts.talkers;
+    program.add_argument("--talkers")
+        .store_into(talkers)
+        .default_value(1)
+        .help("Number of calls talking at the same time");
+
+    program.add_argument("--called")
+        .store_into(opts.calledNumber)
+        .default_value(string("1000"))
+        .help("Called number (i.e. the conference)");
+
+    int calling = opts.firstCallingNumber;
+    program.add_argument("--calling")
+        .store_into(calling)
+        .default_value(2000)
+        .help("Calling number of the first call, the others count up from it");
+
+    int localPort = opts.localPort;
+    program.add_argument("--localport")
+        .store_into(localPort)
+        .default_value(4570)
+        .help("Local IAX2 port that the calls are placed from");
+
+    int serverPid = 0;
+    program.add_argument("--serverpid")
+        .store_into(serverPid)
+        .default_value(0)
+        .help("Server process to measure CPU usage on");
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception& err) {
+        cerr << "Argument error: " << err.what() << endl;
+        return -2;
+    }
+
+    if (codec == "ulaw")
+        opts.codec = amp::LoadGenerator::Codec::ULAW;
+    else if (codec == "slin16")
+        opts.codec = amp::LoadGenerator::Codec::SLIN16;
+    else {
+        cerr << "Argument error: unknown codec " << codec << endl;
+        return -2;
+    }
+    if (calls < 2 || talkers < 1 || talkers >= calls || ramp < 1) {
+        cerr << "Argument error: need at least one listener" << endl;
+        return -2;
+    }
+
+    addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &res) != 0) {
+        cerr << "Unable to resolve " << host << endl;
+        return -1;
+    }
+    memset(&opts.target, 0, sizeof(opts.target));
+    memcpy(&opts.target, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+
+    if (calling < 0 || localPort < 1 || localPort > 65535) {
+        cerr << "Argument error: invalid --calling or --localport" << endl;
+        return -2;
+    }
+
+    opts.calls = calls;
+    opts.rampRate = ramp;
+    opts.talkers = talkers;
+    opts.firstCallingNumber = calling;
+    opts.localPort = localPort;
+
+    Log log;
+    StdClock clock;
+    amp::LoadGenerator gen(log, clock, opts);
+    if (gen.open() < 0) {
+        cerr << "Unable to open port " << localPort << endl;
+        return -1;
+    }
+
+    // CPU is only measured once the ramp is over
+    const uint64_t start = clock.time();
+    const uint64_t rampEnd = start + 1000 * calls / ramp + 1000;
+    const uint64_t end = start + 1000 * (uint64_t)seconds;
+    long long cpuStartTicks = -1;
+    uint64_t cpuStartMs = 0;
+
+    uint64_t now;
+    while ((now = start + (uint32_t)(clock.time() - start)) < end) {
+        pollfd fds[16];
+        int n = gen.getPolls(fds, 16);
+        poll(fds, n > 0 ? n : 0, 5);
+        gen.service();
+        if (serverPid && cpuStartTicks < 0 && now >= rampEnd) {
+            cpuStartTicks = processCpuTicks(serverPid);
+            cpuStartMs = now;
+        }
+    }
+    const unsigned active = gen.getActiveCount();
+    long long cpuTicks = -1;
+    if (serverPid && cpuStartTicks >= 0)
+        cpuTicks = processCpuTicks(serverPid) - cpuStartTicks;
+    const uint64_t cpuMs = now - cpuStartMs;
+
+    const amp::LoadGenerator::Stats& s = gen.getStats();
+    printf("calls                 started %u answered %u failed %u ended %u, "
+        "%u up at the end\n", s.callsStarted, s.callsAnswered, s.callsFailed,
+        s.callsEnded, active);
+    printf("voice frames          sent %u received %u with voice (%u expected, %.2f%% short)\n", 
+        s.voiceSent, s.voiceReceived, s.voiceExpected,
+        (s.voiceExpected && s.voiceReceived < s.voiceExpected) ? 
+            100.0 * (s.voiceExpected - s.voiceReceived) / s.voiceExpected : 0);
+    printf("talkspurts            %u, %u listener onsets missed\n", 
+        s.spurts, s.missedOnsets);
+    printf("audio latency (ms)    p50 %u  p90 %u  p99 %u  max %u\n", 
+        s.latencyPercentile(50), s.latencyPercentile(90), s.latencyPercentile(99),
+        s.latencyPercentile(100));
+    if (cpuTicks >= 0 && cpuMs > 0) {
+        const double cpuPct = 100.0 * (cpuTicks / (double)sysconf(_SC_CLK_TCK)) / 
+            (cpuMs / 1000.0);
+        printf("server cpu            %.1f%%", cpuPct);
+        if (cpuPct > 0)
+            printf(", %.0f calls per core", active / (cpuPct / 100.0));
+        printf("\n");
+    }
+    return 0;
+}
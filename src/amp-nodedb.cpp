@@ -0,0 +1,107 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Compiles the text form of a node database into the file that
+ * amp-server --nodedb maps, or looks a node up in an existing one.
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <fstream>
+#include <iostream>
+
+#include <argparse/argparse.hpp>
+
+#include "NodeDb.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+int main(int argc, const char** argv) {
+
+    argparse::ArgumentParser program("amp-nodedb");
+
+    string input;
+    program.add_argument("--input")
+        .store_into(input)
+        .required()
+        .help("Text node list, or a database with --lookup");
+
+    string output;
+    program.add_argument("--output")
+        .store_into(output)
+        .help("Database file to write");
+
+    string lookup;
+    program.add_argument("--lookup")
+        .store_into(lookup)
+        .help("Node to look up");
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception& err) {
+        cerr << "Argument error: " << err.what() << endl;
+        return -2;
+    }
+
+    if (!lookup.empty()) {
+        amp::NodeDb db;
+        if (db.open(input.c_str()) < 0) {
+            cerr << "Unable to open " << input << endl;
+            return -1;
+        }
+        const amp::NodeDb::Record* r = db.find(lookup.c_str());
+        if (!r) {
+            cout << lookup << " not found" << endl;
+            return 1;
+        }
+        char addr[INET6_ADDRSTRLEN];
+        inet_ntop(r->family, r->addr, addr, sizeof(addr));
+        cout << r->node << " " << (r->family == AF_INET6 ? "[" : "") << addr
+            << (r->family == AF_INET6 ? "]" : "") << ":" << r->port
+            << " " << r->user << endl;
+        return 0;
+    }
+
+    if (output.empty()) {
+        cerr << "An output file is needed" << endl;
+        return -2;
+    }
+
+    ifstream str(input);
+    if (!str.is_open()) {
+        cerr << "Unable to open " << input << endl;
+        return -1;
+    }
+    vector<amp::NodeDb::Entry> entries;
+    int line = amp::NodeDb::parseText(str, entries);
+    if (line != 0) {
+        cerr << input << ":" << line << ": Invalid entry" << endl;
+        return -1;
+    }
+    if (amp::NodeDb::write(output.c_str(), entries) < 0) {
+        cerr << "Unable to write " << output << endl;
+        return -1;
+    }
+    amp::NodeDb db;
+    if (db.open(output.c_str()) < 0) {
+        cerr << "Unable to read back " << output << endl;
+        return -1;
+    }
+    cout << "Wrote " << db.getCount() << " nodes in " << db.getBucketCount()
+        << " buckets to " << output << endl;
+    return 0;
+}
@@ -0,0 +1,202 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Replays a packet timeline (a capture file or a generated one) through
+ * the server's LineIAX2 and Bridge in simulated time and reports the CPU 
+ * cost and the talkspurt latency. This is a repeatable alternative to 
+ * loading a live node with scripts/run-load.sh. With --kernels the 
+ * timeline goes through the in-tree audio kernels instead (jitter 
+ * buffer, mixer, encode cache), which also reports the jitter buffer
+ * decisions.
+ */
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+
+#include "kc1fsz-tools/Log.h"
+
+#include "BinaryTrace.h"
+#include "LatencyProbe.h"
+#include "LineReplay.h"
+#include "ReplayHarness.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+int main(int argc, const char** argv) {
+
+    argparse::ArgumentParser program("amp-replay");
+
+    string captureFileName;
+    program.add_argument("--capture")
+        .help("Capture file to replay (otherwise a timeline is generated)")
+        .store_into(captureFileName);
+
+    amp::ReplayHarness::SynthOptions synth;
+    int calls = synth.calls;
+    program.add_argument("--calls")
+        .store_into(calls)
+        .default_value(10)
+        .help("Number of generated calls");
+
+    int seconds = synth.seconds;
+    program.add_argument("--seconds")
+        .store_into(seconds)
+        .default_value(60)
+        .help("Length of the generated timeline");
+
+    program.add_argument("--jitter")
+        .store_into(synth.flightVariance)
+        .default_value(12.0)
+        .help("Variance of the generated network flight time (ms^2)");
+
+    program.add_argument("--loss")
+        .store_into(synth.lossPct)
+        .default_value(0.0)
+        .help("Generated packet loss percentage");
+
+    program.add_argument("--talk")
+        .store_into(synth.talkFraction)
+        .default_value(0.5)
+        .help("Fraction of the time each generated call is talking");
+
+    int seed = synth.seed;
+    program.add_argument("--seed")
+        .store_into(seed)
+        .default_value(1)
+        .help("Random seed for the generated timeline");
+
+    int port = 46000;
+    program.add_argument("--port")
+        .store_into(port)
+        .default_value(46000)
+        .help("Loopback UDP port for the server, the calls use the ones after it");
+
+    program.add_argument("--iaxtrace")
+        .help("Turn on network tracing in the server's LineIAX2")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("--kernels")
+        .help("Replay through the audio kernels instead of LineIAX2 and Bridge")
+        .default_value(false)
+        .implicit_value(true);
+
+    string traceFileName;
+    program.add_argument("--trace")
+        .help("With --kernels, write a binary trace of the arrivals and jitter buffer decisions")
+        .store_into(traceFileName);
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception& err) {
+        cerr << "Argument error: " << err.what() << endl;
+        return -2;
+    }
+
+    std::vector<amp::ReplayEvent> events;
+    if (!captureFileName.empty()) {
+        ifstream str(captureFileName);
+        if (!str.is_open()) {
+            cerr << "Unable to open " << captureFileName << endl;
+            return -1;
+        }
+        if (amp::ReplayHarness::loadCapture(str, events) < 0) {
+            cerr << "Format error in " << captureFileName << endl;
+            return -1;
+        }
+    } else {
+        synth.calls = calls;
+        synth.seconds = seconds;
+        synth.seed = seed;
+        amp::ReplayHarness::synthesize(synth, events);
+    }
+
+    if (program["--kernels"] == false) {
+        if (port < 1 || port > 65535 - (int)events.size()) {
+            cerr << "Invalid --port" << endl;
+            return -2;
+        }
+        Log log;
+        amp::LineReplay::Options opts;
+        opts.basePort = port;
+        opts.trace = program["--iaxtrace"] == true;
+        amp::LineReplay::Report r = amp::LineReplay::run(log, events, opts);
+        if (r.calls == 0 || r.connected < r.calls) {
+            cerr << "Nothing replayed" << endl;
+            return -1;
+        }
+        printf("calls                 %u\n", r.calls);
+        printf("simulated             %.1f s (%.0fx real time)\n", r.simulatedSec, 
+            r.wallSec > 0 ? r.simulatedSec / r.wallSec : 0);
+        printf("server cpu            %.3f s, %.2f us per call-second\n", r.serverCpuSec, 
+            r.cpuUsPerCallSecond());
+        printf("onset latency (ms)    p50 %u  p90 %u  p99 %u  max %u\n", 
+            r.latencyPercentile(50), r.latencyPercentile(90), r.latencyPercentile(99),
+            r.latencyPercentile(100));
+        printf("onsets                %u, %u missed by a listener\n", r.onsets, 
+            r.missedOnsets);
+        printf("frames                sent %u received %u voice %u (expected %llu)\n",
+            r.voiceSent, r.framesReceived, r.voiceReceived, 
+            (unsigned long long)r.voiceExpected);
+        return 0;
+    }
+
+    // Every frame is traced when it arrives and when it is played or
+    // concealed, the rest is for the unkeys.
+    std::unique_ptr<amp::BinaryTrace> trace;
+    if (!traceFileName.empty()) {
+        trace = std::make_unique<amp::BinaryTrace>();
+        if (trace->openSpill(traceFileName.c_str(), 3 * events.size() + 4096) < 0) {
+            cerr << "Unable to open " << traceFileName << endl;
+            return -1;
+        }
+    }
+
+    auto probe = std::make_unique<amp::LatencyProbe>();
+    amp::ReplayHarness::Report r = amp::ReplayHarness::run(events, trace.get(), probe.get());
+
+    printf("calls                 %u\n", r.calls);
+    printf("simulated             %.1f s (%.0fx real time)\n", r.simulatedSec, 
+        r.wallSec > 0 ? r.simulatedSec / r.wallSec : 0);
+    printf("cpu                   %.3f s, %.2f us per call-second\n", r.cpuSec, 
+        r.cpuUsPerCallSecond());
+    printf("frame latency (ms)    p50 %u  p90 %u  p99 %u  max %u\n", 
+        r.latencyPercentile(50), r.latencyPercentile(90), r.latencyPercentile(99),
+        r.latencyPercentile(100));
+    for (unsigned path = 0; path < probe->getPathCount(); path++) {
+        for (auto stage : { amp::LatencyProbe::JITTER, amp::LatencyProbe::BRIDGE }) {
+            const amp::LatencyHistogram& h = probe->getHistogram(path, stage);
+            printf("%-6s %-15s(us) p50 %llu  p90 %llu  p99 %llu  max %llu\n",
+                amp::LatencyProbe::stageName(stage), probe->getPathName(path),
+                (unsigned long long)h.percentileUs(50), (unsigned long long)h.percentileUs(90),
+                (unsigned long long)h.percentileUs(99), (unsigned long long)h.getMaxUs());
+        }
+    }
+    printf("jitter buffer         received %u played %u late %u concealed %u "
+        "duplicate %u overflow %u dropped %u spurts %u\n", 
+        r.jb.received, r.jb.played, r.jb.late, r.jb.concealed, r.jb.duplicate,
+        r.jb.overflow, r.jb.dropped, r.jb.spurts);
+    printf("encoder               %u encodes, %u shared\n", r.encodes, r.encodesSaved);
+    if (trace)
+        printf("trace                 %llu records, %u dropped\n", 
+            (unsigned long long)trace->getCollectedCount(), trace->getDroppedCount());
+    return 0;
+}
@@ -14,7 +14,13 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
+#include <errno.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
 #include <stdexcept>
+#include <utility>
 
 #include "sound-map.h"
 
@@ -27,6 +33,7 @@
 #include "Bridge.h"
 
 // amp-server
+#include "Shard.h"
 #include "config-handler.h"
 
 using namespace std;
@@ -35,33 +42,164 @@ namespace kc1fsz {
 
     namespace amp {
 
-int configHandler(Log& log, const json& cfg, WebUi& webUi, LineIAX2& iax2Channel1, 
+unsigned hostedNodeCount(const json& cfg) {
+    if (!cfg.contains("nodes") || !cfg["nodes"].is_array())
+        return 0;
+    return cfg["nodes"].size();
+}
+
+/**
+ * Runs one step of a configuration change and logs how long it took.
+ */
+template<typename F> static auto timedStep(Log& log, const char* name, F step) {
+    const auto start = chrono::steady_clock::now();
+    auto rc = step();
+    const auto us = chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now() - start).count();
+    log.info("Configuration step %s took %ld us", name, (long)us);
+    return rc;
+}
+
+/**
+ * @returns The part of the document that a component is configured 
+ *   from (null for the keys that are missing).
+ */
+static json settingsOf(const json& cfg, std::initializer_list<const char*> keys) {
+    json settings = json::object();
+    for (const char* key : keys)
+        settings[key] = cfg.contains(key) ? cfg[key] : json();
+    return settings;
+}
+
+/**
+ * @returns The port number, or -1 if it isn't one.
+ */
+static int parsePort(const string& text) {
+    char* end;
+    errno = 0;
+    const long port = strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != 0 || errno != 0 || port < 1 || port > 65535)
+        return -1;
+    return port;
+}
+
+int configHandler(Log& log, const json& cfg, AppliedConfig& applied, WebUi& webUi, 
+    LineIAX2& iax2Channel1, 
     LocalRegistryStd& locReg,
     LineUsb& radio2, SignalIn& signalIn3, Bridge& bridge10, LineSDRC& sdrcLine5,
-    int iaxPortOverride) {
+    vector<HostedNode>& hostedNodes,
+    int iaxPortOverride,
+    Shard& home, std::function<void()> retry) {
+
+    int result = 0;
+
+    // True unless the component was already configured with these settings
+    auto needs = [&applied](const string& component, const json& settings) {
+        auto it = applied.find(component);
+        return it == applied.end() || it->second != settings;
+    };
 
     // Transfer the new configuration into the various places it is needed
-    webUi.setConfig(cfg);
+    timedStep(log, "WebUi", [&]() { webUi.setConfig(cfg); return 0; });
 
     //iax2Channel1.setPrivateKey(getenv("AMP_PRIVATE_KEY"));
     //iax2Channel1.setDNSRoot(getenv("AMP_ASL_DNS_ROOT"));
     
-    if (cfg.contains("node")) {
-        string localNode = cfg["node"];
-        if (!localNode.empty())
-            bridge10.setLocalNodeNumber(localNode.c_str());
+    const json nodeSettings = settingsOf(cfg, { "node" });
+    if (needs("node", nodeSettings)) {
+        if (cfg.contains("node")) {
+            string localNode = cfg["node"];
+            if (!localNode.empty())
+                bridge10.setLocalNodeNumber(localNode.c_str());
+        }
+        applied["node"] = nodeSettings;
     }
 
-    int iaxPort = iaxPortOverride;
-    if (iaxPort == 0) {
-        if (!cfg["iaxPort"].is_string())
-            throw invalid_argument("iaxPort is missing/invalid");
-        iaxPort = std::stoi(cfg["iaxPort"].get<std::string>());
+    // A port given on the command line never changes
+    const json iaxSettings = iaxPortOverride ? json(iaxPortOverride) : 
+        settingsOf(cfg, { "iaxPort" });
+    if (needs("LineIAX2", iaxSettings)) {
+        int iaxPort = iaxPortOverride;
+        if (iaxPort == 0) {
+            if (!cfg.contains("iaxPort") || !cfg["iaxPort"].is_string())
+                throw invalid_argument("iaxPort is missing/invalid");
+            iaxPort = std::stoi(cfg["iaxPort"].get<std::string>());
+        }
+        int rc = timedStep(log, "LineIAX2", [&]() { 
+            return iax2Channel1.open(AF_INET, iaxPort, "radio"); 
+        });
+        if (rc < 0) {
+            log.error("Failed to open IAX2 line %d", rc);
+            result = -1;
+        }
+        else 
+            applied["LineIAX2"] = iaxSettings;
     }
-    
-    int rc = iax2Channel1.open(AF_INET, iaxPort, "radio");
-    if (rc < 0) {
-        log.error("Failed to open IAX2 line %d", rc);
+
+    // ----- Additional Hosted Nodes ----------------------------------
+
+    // NOTE: The hosted nodes are created at startup, so a change in 
+    // the number of entries requires a restart.
+    if (hostedNodeCount(cfg) != hostedNodes.size())
+        log.error("Number of hosted nodes changed, restart required");
+
+    for (unsigned i = 0; i < hostedNodes.size() && i < hostedNodeCount(cfg); i++) {
+        const json& nodeCfg = cfg["nodes"][i];
+        const string component = "nodes/" + to_string(i);
+        if (!needs(component, nodeCfg))
+            continue;
+        HostedNode& hn = hostedNodes[i];
+        // A bad entry only takes its own node out (and is tried again)
+        if (!nodeCfg.is_object() || !nodeCfg.contains("node") || !nodeCfg["node"].is_string()) {
+            log.error("Hosted node %u: node is missing/invalid", i);
+            result = -1;
+            continue;
+        }
+        string hostedNode = nodeCfg["node"];
+        const int hostedPort = (nodeCfg.contains("iaxPort") && nodeCfg["iaxPort"].is_string()) ?
+            parsePort(nodeCfg["iaxPort"].get<std::string>()) : -1;
+        if (hostedPort < 0) {
+            log.error("Hosted node %u: iaxPort is missing/invalid", i);
+            result = -1;
+            continue;
+        }
+
+        auto apply = [&log, &hn, hostedNode, hostedPort]() {
+            return timedStep(log, "HostedNode", [&]() {
+                if (!hostedNode.empty())
+                    hn.bridge->setLocalNodeNumber(hostedNode.c_str());
+                int rc = hn.iax2Channel->open(AF_INET, hostedPort, "radio");
+                if (rc < 0) {
+                    log.error("Failed to open IAX2 line for node %s %d", hostedNode.c_str(), rc);
+                }
+                return rc;
+            });
+        };
+        // A node running on another shard is only touched from that 
+        // shard's thread. Nothing here waits for it: it is recorded as 
+        // applied right away (so that it isn't posted again while it's 
+        // in progress) and the other shard posts the result back. A
+        // failure is taken back out and tried again.
+        if (hn.shard) {
+            applied[component] = nodeCfg;
+            hn.shard->post([apply, &home, &applied, retry, component, nodeCfg]() {
+                const int rc = apply();
+                home.post([rc, &applied, retry, component, nodeCfg]() {
+                    if (rc >= 0)
+                        return;
+                    // Unless a newer configuration has been posted since
+                    auto it = applied.find(component);
+                    if (it != applied.end() && it->second == nodeCfg) {
+                        applied.erase(it);
+                        retry();
+                    }
+                });
+            });
+        }
+        else if (apply() < 0)
+            result = -1;
+        else 
+            applied[component] = nodeCfg;
     }
 
     /*
@@ -81,12 +219,15 @@ int configHandler(Log& log, const json& cfg, WebUi& webUi, LineIAX2& iax2Channel
 
         // Resolve the audio device
         string aslAudioDevice = cfg["aslAudioDevice"].get<std::string>();
-        if (aslAudioDevice.starts_with("usb ")) {
+        const json usbSettings = settingsOf(cfg, { "setupMode", "aslAudioDevice", 
+            "aslTxMixASet", "aslTxMixBSet", "aslRxMixerSet" });
+        if (aslAudioDevice.starts_with("usb ") && needs("LineUsb", usbSettings)) {
             int alsaCard;
             string ossDevice;
             int rc2 = querySoundMap(aslAudioDevice.substr(4).c_str(), alsaCard, ossDevice);
             if (rc2 < 0) {
                 log.error("Unable to resolve sound device %d", rc2);
+                result = -1;
             } 
             else {
                 log.info("Audio %s mapped to ALSA card %d", 
@@ -105,35 +246,46 @@ int configHandler(Log& log, const json& cfg, WebUi& webUi, LineIAX2& iax2Channel
                     throw invalid_argument("aslRxMixerSet is missing/invalid");
                 int rxMixerSet = std::stoi(cfg["aslRxMixerSet"].get<std::string>());
 
-                rc = radio2.open(alsaCard, txMixASet, txMixBSet, rxMixerSet);
+                int rc = timedStep(log, "LineUsb", [&]() {
+                    return radio2.open(alsaCard, txMixASet, txMixBSet, rxMixerSet);
+                });
                 if (rc < 0) {
                     if (rc == -12)
                         log.error("Unable to open sound device, busy");
                     else 
                         log.error("Unable to open sound device");
-                    return -1;
+                    result = -1;
                 }
+                else 
+                    applied["LineUsb"] = usbSettings;
             }
         }
 
         // Resolve the COS signal
         string aslCosFrom = cfg["aslCosFrom"].get<std::string>();
-        if (aslAudioDevice.starts_with("usb ") && aslCosFrom.starts_with("usb")) {
+        const json cosSettings = settingsOf(cfg, { "setupMode", "aslAudioDevice", 
+            "aslCosFrom" });
+        if (aslAudioDevice.starts_with("usb ") && aslCosFrom.starts_with("usb") &&
+            needs("SignalIn", cosSettings)) {
 
             string cosSignalDevice;
             int rc3 = queryHidMap(aslAudioDevice.substr(4).c_str(), cosSignalDevice);
             if (rc3 < 0) {
                 log.error("Unable to resolve HID device %d", rc3);
-                return -1;
+                result = -1;
             } 
             else {
                 log.info("HID %s mapped to %s", aslAudioDevice.c_str(),
                     cosSignalDevice.c_str());
-                rc = signalIn3.openHid(cosSignalDevice.c_str());
+                int rc = timedStep(log, "SignalIn", [&]() {
+                    return signalIn3.openHid(cosSignalDevice.c_str());
+                });
                 if (rc < 0) {
                     log.error("Failed to open HID signal connection %d", rc);
-                    return -1;
+                    result = -1;
                 }
+                else 
+                    applied["SignalIn"] = cosSettings;
             }
 
             // ##### TODO: DEAL WITH INVERT
@@ -144,7 +296,7 @@ int configHandler(Log& log, const json& cfg, WebUi& webUi, LineIAX2& iax2Channel
         return -1;
     }
 
-    return 0;
+    return result;
 }
 
     }
@@ -16,6 +16,12 @@
  */
 #pragma once
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -32,17 +38,70 @@ namespace amp {
 
 class SignalIn;
 class Bridge;
+class WebUi;
+class Shard;
+
+/**
+ * An additional node hosted in this process. Each hosted node gets its 
+ * own Bridge and its own IAX2 line, but shares the router, WebUi, and
+ * service thread with the primary node.
+ */
+struct HostedNode {
+    unsigned bridgeLineId;
+    unsigned iaxLineId;
+    std::unique_ptr<Bridge> bridge;
+    std::unique_ptr<LineIAX2> iax2Channel;
+    /**
+     * The shard that runs this node, or nullptr if it runs on the 
+     * main thread.
+     */
+    Shard* shard = nullptr;
+};
+
+/**
+ * @returns The number of additional nodes listed in the "nodes" array
+ * of the configuration document (zero if there is no such array).
+ */
+unsigned hostedNodeCount(const json& cfg);
+
+/**
+ * The settings that each component was last configured with 
+ * successfully, by component ("LineIAX2", "LineUsb", "nodes/0", ...).
+ */
+using AppliedConfig = std::map<std::string, json>;
 
 /**
  * Transfers the configuration settings in a JSON document to all of the 
  * various components in the system.
  *
+ * Only the components whose settings differ from the ones that they were
+ * last configured with are touched (re-opening a line interrupts its 
+ * audio), and the time that each step takes is logged. A component that
+ * fails is left out of applied, so it is tried again the next time
+ * and the ones that worked are not. Hosted nodes that run on other shards
+ * are configured on their own threads without waiting for them. Their 
+ * results are posted back to home, where one that failed is taken out 
+ * of applied and retry is called.
+ *
+ * @param applied Updated as each component is configured, empty to 
+ * configure everything.
+ * @param hostedNodes The additional nodes that were created at startup. 
+ * These are configured from the "nodes" array in the document.
+ * @param home The shard that this is called on. applied is only
+ * touched from here.
+ * @param retry Called on home when a hosted node on another shard 
+ * couldn't be configured.
+ * @returns 0 on success, -1 if any component couldn't be configured
+ * (not counting the hosted nodes on other shards, see retry).
  * @throws json::exception On a JSON error (i.e. missing element)
  */
-int configHandler(Log& log, const json& cfg, WebUi& webUi, LineIAX2& iax2Channel1, 
+int configHandler(Log& log, const json& cfg, AppliedConfig& applied, WebUi& webUi, 
+    LineIAX2& iax2Channel1, 
     LocalRegistryStd& locReg,
     LineUsb& radio2, SignalIn& signalIn3, Bridge& bridge10, LineSDRC&,
-    int iaxPortOverride);
+    std::vector<HostedNode>& hostedNodes,
+    int iaxPortOverride,
+    Shard& home, std::function<void()> retry);
 }
 
 }
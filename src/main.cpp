@@ -21,7 +21,10 @@
  */
 #include <execinfo.h>
 #include <signal.h>
+#include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <vector>
 
 // 3rd party HTTP/HTTPS client
 #include <curl/curl.h>
@@ -31,7 +34,6 @@
 // Non-AMP stuff from my C++ tools library
 #include "kc1fsz-tools/Log.h"
 #include "kc1fsz-tools/linux/StdClock.h"
-#include "kc1fsz-tools/linux/MTLog.h"
 #include "kc1fsz-tools/threadsafequeue2.h"
 
 // All of this comes from AMP Core
@@ -47,10 +49,18 @@
 #include "BridgeCall.h"
 #include "WebUi.h"
 #include "ConfigPoller.h"
+#include "ConfigWatcher.h"
 #include "SignalIn.h"
 
 // And a few things from AMP Server
 #include "LocalRegistryStd.h"
+#include "ResolverCache.h"
+#include "AsyncLog.h"
+#include "MetricsServer.h"
+#include "StatusBoard.h"
+#include "ShardStatus.h"
+#include "BinaryTrace.h"
+#include "Shard.h"
 #include "config-handler.h"
 
 using namespace std;
@@ -69,7 +79,8 @@ int main(int argc, const char** argv) {
     // Install the crash stack handler
     signal(SIGSEGV, sigHandler);
 
-    MTLog log;
+    // Synchronous until the command line has been parsed
+    amp::AsyncLog log;
     log.info("AMP Server");
     log.info("Powered by the Ampersand ASL Project https://github.com/Ampersand-ASL");
     log.info("Copyright (C) 2026, Bruce MacKinnon KC1FSZ");
@@ -122,6 +133,69 @@ int main(int argc, const char** argv) {
         .help("Node to call immediately")
         .store_into(callNode);
 
+    int shardCount = 1;
+    program.add_argument("--shards")
+        .store_into(shardCount)
+        .default_value(1)
+        .help("Number of EventLoop threads, hosted nodes are spread across them");
+
+    int poolSize = 2048;
+    program.add_argument("--poolsize")
+        .store_into(poolSize)
+        .default_value(2048)
+        .help("Number of messages that can be in transit between shards");
+
+    string eventLoop = "poll";
+    program.add_argument("--eventloop")
+        .store_into(eventLoop)
+        .default_value(string("poll"))
+        .help("EventLoop backend: poll or uring");
+
+    int metricsPort = 0;
+    program.add_argument("--metricsport")
+        .store_into(metricsPort)
+        .default_value(0)
+        .help("Port number for the metrics (Prometheus/JSON) server, 0 for none");
+
+    int statusMs = 250;
+    program.add_argument("--statusms")
+        .store_into(statusMs)
+        .default_value(250)
+        .help("How often (ms) status changes are pushed to /status/stream");
+
+    program.add_argument("--latency")
+        .help("Measure how long messages take to reach each line (published with the metrics)")
+        .default_value(false)
+        .implicit_value(true);
+
+    program.add_argument("--asynclog")
+        .help("Format and write log messages on a background thread")
+        .default_value(false)
+        .implicit_value(true);
+
+    string traceFileName;
+    program.add_argument("--tracefile")
+        .store_into(traceFileName)
+        .help("Spill the binary trace to this (circular) file");
+
+    int traceFileRecords = 1048576;
+    program.add_argument("--tracerecords")
+        .store_into(traceFileRecords)
+        .default_value(1048576)
+        .help("Number of records the trace file holds");
+
+    string nodeDbFileName;
+    program.add_argument("--nodedb")
+        .store_into(nodeDbFileName)
+        .help("Node database (made by amp-nodedb, or the text form) consulted before DNS");
+
+    string dnsCacheFileName = getenv("HOME");
+    dnsCacheFileName += "/amp-server-dns.db";
+    program.add_argument("--dnscache")
+        .store_into(dnsCacheFileName)
+        .default_value(dnsCacheFileName)
+        .help("Where resolved node addresses are saved across restarts");
+
     try {
         program.parse_args(argc, argv);
     } catch (const std::exception& err) {
@@ -129,6 +203,43 @@ int main(int argc, const char** argv) {
         std::exit(-2);
     }
 
+    if (shardCount < 1 || shardCount > (int)amp::Shard::MAX_SHARDS) {
+        log.error("Shard count must be between 1 and %u", amp::Shard::MAX_SHARDS);
+        std::exit(-2);
+    }
+
+    if (poolSize < 1) {
+        log.error("Pool size must be at least 1");
+        std::exit(-2);
+    }
+
+    if (statusMs < (int)amp::MetricsServer::MIN_STATUS_PERIOD_MS) {
+        log.error("Status period must be at least %u ms", amp::MetricsServer::MIN_STATUS_PERIOD_MS);
+        std::exit(-2);
+    }
+
+    if (eventLoop != "poll" && eventLoop != "uring") {
+        log.error("Event loop must be poll or uring");
+        std::exit(-2);
+    }
+
+    if (program["--asynclog"] == true) {
+        log.start();
+        log.info("Logging asynchronously");
+    }
+
+    // The binary trace is always on. It keeps the most recent events in 
+    // memory and can also spill them to a file.
+    amp::BinaryTrace binaryTrace;
+    if (!traceFileName.empty()) {
+        if (traceFileRecords < 1 || 
+            binaryTrace.openSpill(traceFileName.c_str(), traceFileRecords) < 0) {
+            log.error("Unable to open trace file %s", traceFileName.c_str());
+            std::exit(-2);
+        }
+        log.info("Tracing to %s", traceFileName.c_str());
+    }
+
     log.info("Using configuration file %s", cfgFileName.c_str());
 
     // Create a default/starting config file if this is the first time.
@@ -148,6 +259,74 @@ int main(int argc, const char** argv) {
     // wired to the router one way or the other.
     threadsafequeue2<Message> respQueue;
     MultiRouter router(respQueue);
+    // The producers send through the bus, which numbers each dispatch so 
+    // that the shard mailboxes can share one copy of a fanned-out Message.
+    amp::DispatchBus bus(router);
+
+    // Each shard is an EventLoop on its own thread. Shard 0 runs on the 
+    // main thread and owns everything except the hosted nodes. Shard 0
+    // is left unpinned when it is the only one.
+    std::vector<std::unique_ptr<amp::Shard>> shards;
+    unsigned coreCount = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < shardCount; i++)
+        shards.push_back(std::make_unique<amp::Shard>(log, clock, i, 
+            (shardCount == 1) ? -1 : (int)(i % coreCount)));
+    if (eventLoop == "uring")
+        for (auto& shard : shards)
+            shard->setUseUring(true);
+    for (auto& shard : shards)
+        shard->setTrace(&binaryTrace);
+
+    // A TraceLog is not thread-safe, so every shard after shard 0 gets 
+    // its own. Shard 0 shares traceLog with the WebUi that displays it.
+    std::vector<std::unique_ptr<std::string[]>> shardTraceLogData;
+    std::vector<std::unique_ptr<TraceLog>> shardTraceLogs;
+    for (int i = 1; i < shardCount; i++) {
+        shardTraceLogData.push_back(std::make_unique<std::string[]>(traceLogDataLen));
+        shardTraceLogs.push_back(std::make_unique<TraceLog>(clock, 
+            shardTraceLogData.back().get(), traceLogDataLen));
+    }
+    auto traceLogFor = [&traceLog, &shardTraceLogs](unsigned shardId) -> TraceLog& {
+        return (shardId == 0) ? traceLog : *shardTraceLogs[shardId - 1];
+    };
+
+    // When there is more than one shard every consumer is registered 
+    // with the router through a mailbox owned by the consumer's shard.
+    // Messages in transit between shards live in a fixed-size pool.
+    // Measuring the latency needs the mailboxes even with one shard.
+    const bool measureLatency = (program["--latency"] == true);
+    const bool useMailboxes = (shardCount > 1 || measureLatency);
+    std::unique_ptr<amp::MessagePool> msgPool;
+    if (useMailboxes) {
+        msgPool = std::make_unique<amp::MessagePool>(poolSize);
+        shards[0]->setPool(msgPool.get());
+    }
+    std::unique_ptr<amp::LatencyProbe> latencyProbe;
+    if (measureLatency)
+        latencyProbe = std::make_unique<amp::LatencyProbe>();
+    std::vector<std::unique_ptr<amp::ShardMailbox>> mailboxes;
+    auto addRoute = [&log, &router, &shards, &mailboxes, &msgPool, &latencyProbe, 
+        useMailboxes, shardCount]
+        (MessageConsumer* consumer, int lineId, unsigned shardId) {
+        if (!useMailboxes) {
+            router.addRoute(consumer, lineId);
+        } else {
+            auto mb = std::make_unique<amp::ShardMailbox>(*consumer, *msgPool, 
+                shardId, shardCount);
+            if (latencyProbe) {
+                string name = (lineId == MultiRouter::BROADCAST) ? 
+                    string("broadcast") : "line" + to_string(lineId);
+                int path = latencyProbe->addPath(name.c_str());
+                if (path < 0)
+                    log.error("Too many lines, not measuring the latency of %s", name.c_str());
+                else
+                    mb->setProbe(latencyProbe.get(), path);
+            }
+            shards[shardId]->addMailbox(mb.get());
+            router.addRoute(mb.get(), lineId);
+            mailboxes.push_back(std::move(mb));
+        }
+    };
 
     // Get the service thread running. This handles non-time-sensitive
     // stuff like registration, stats, etc.
@@ -155,51 +334,123 @@ int main(int argc, const char** argv) {
 
     // The Bridge is what provides the audio conference capability. The various 
     // Lines connect to the Bridge.
-    amp::Bridge bridge10(log, traceLog, clock, router, amp::BridgeCall::Mode::NORMAL, 10, 
+    amp::Bridge bridge10(log, traceLog, clock, bus, amp::BridgeCall::Mode::NORMAL, 10, 
         0, 0, 0, 1);
-    router.addRoute(&bridge10, 10);
+    addRoute(&bridge10, 10, 0);
 
     // This is the Line that connects to the USB sound interface
-    LineUsb radio2(log, clock, router, 2, 1, 10, 1);
-    router.addRoute(&radio2, 2);
+    LineUsb radio2(log, clock, bus, 2, 1, 10, 1);
+    addRoute(&radio2, 2, 0);
 
     // This manages the COS signal detect
-    amp::SignalIn signalIn3(log, clock, router, 2, 
+    amp::SignalIn signalIn3(log, clock, bus, 2, 
         Message::SignalType::COS_ON, Message::SignalType::COS_OFF);
-    router.addRoute(&signalIn3, 3);
+    addRoute(&signalIn3, 3, 0);
 
     // This manages the interface to the SDRC (if any)
-    LineSDRC sdrcLine5(log, traceLog, clock, 5, 1, router, 10);
-    router.addRoute(&sdrcLine5, 5);
+    LineSDRC sdrcLine5(log, traceLog, clock, 5, 1, bus, 10);
+    addRoute(&sdrcLine5, 5, 0);
+
+    // Node addresses that have been resolved before come from memory, 
+    // so calls don't wait on DNS. The queries are made on the cache's 
+    // own threads and the addresses are saved for the next start.
+    amp::ResolverCache resolverCache(
+        amp::ResolverCache::makeDnsResolver("nodes.allstarlink.org"), 
+        amp::ResolverCache::Options());
+    int cachedCount = resolverCache.load(dnsCacheFileName.c_str());
+    if (cachedCount > 0)
+        log.info("Loaded %d node addresses from %s", cachedCount, dnsCacheFileName.c_str());
+    resolverCache.setSaveFile(dnsCacheFileName);
+    resolverCache.start();
+    if (!callNode.empty())
+        resolverCache.prefetch(callNode.c_str());
+
+    // This is where the IAX2 lines look up a node before going to DNS
+    LocalRegistryStd locReg;
+    locReg.setResolverCache(&resolverCache);
+    if (!nodeDbFileName.empty()) {
+        if (locReg.openDatabase(nodeDbFileName.c_str()) < 0) {
+            log.error("Unable to open node database %s", nodeDbFileName.c_str());
+            std::exit(-2);
+        }
+        log.info("Node database %s has %u nodes", nodeDbFileName.c_str(), 
+            locReg.getDatabaseCount());
+    }
 
     // This is the Line that makes the IAX2 network connection
-    LocalRegistryStd locReg;
-    LineIAX2 iax2Channel1(log, traceLog, clock, 1, router, 0, 0, &locReg, 10);
-    router.addRoute(&iax2Channel1, 1);
+    LineIAX2 iax2Channel1(log, traceLog, clock, 1, bus, 0, 0, &locReg, 10);
+    addRoute(&iax2Channel1, 1, 0);
     if (program["--trace"] == true)
         iax2Channel1.setTrace(true);
 
+    // Any additional nodes listed in the configuration document are hosted
+    // in this same process. Each one gets a Bridge and an IAX2 line that 
+    // are wired to each other. Hosted node N (starting at zero) uses 
+    // Bridge line 10 * (N + 2) and IAX2 line 10 * (N + 2) + 1. The 
+    // Bridge and the IAX2 line of a node always live on the same shard.
+    std::vector<amp::HostedNode> hostedNodes;
+    {
+        unsigned count = 0;
+        try {
+            ifstream cfgStream(cfgFileName);
+            count = amp::hostedNodeCount(json::parse(cfgStream));
+        }
+        catch (json::exception& ex) {
+            log.error("Unable to read hosted nodes %s", ex.what());
+        }
+        for (unsigned i = 0; i < count; i++) {
+            amp::HostedNode hn;
+            hn.bridgeLineId = 10 * (i + 2);
+            hn.iaxLineId = hn.bridgeLineId + 1;
+            hn.shard = (shardCount == 1) ? nullptr : 
+                shards[1 + (i % (shardCount - 1))].get();
+            unsigned shardId = hn.shard ? hn.shard->getId() : 0;
+            TraceLog& hnTraceLog = traceLogFor(shardId);
+            hn.bridge = std::make_unique<amp::Bridge>(log, hnTraceLog, clock, bus, 
+                amp::BridgeCall::Mode::NORMAL, hn.bridgeLineId, 0, 0, 0, 1);
+            hn.iax2Channel = std::make_unique<LineIAX2>(log, hnTraceLog, clock, 
+                hn.iaxLineId, bus, 0, 0, &locReg, hn.bridgeLineId);
+            addRoute(hn.bridge.get(), hn.bridgeLineId, shardId);
+            addRoute(hn.iax2Channel.get(), hn.iaxLineId, shardId);
+            if (program["--trace"] == true)
+                hn.iax2Channel->setTrace(true);
+            hostedNodes.push_back(std::move(hn));
+        }
+        if (count > 0)
+            log.info("Hosting %u additional node(s)", count);
+    }
+
     // This is the HTTP server that provides the UI
-    amp::WebUi webUi(log, clock, router, uiPort, 1, 2, cfgFileName.c_str(), VERSION,
+    amp::WebUi webUi(log, clock, bus, uiPort, 1, 2, cfgFileName.c_str(), VERSION,
         traceLog);
     // This allow the WebUi to watch all traffic and pull out the things 
     // that are relevant for status display.
-    router.addRoute(&webUi, MultiRouter::BROADCAST);
+    addRoute(&webUi, MultiRouter::BROADCAST, 0);
 
-    // This is a poller that watches for changes to the configuration file
-    // and applies those changes to everything on the main thread.
-    amp::ConfigPoller cfgPoller(log, cfgFileName.c_str(), 
+    // What each component was last configured with, so that a change 
+    // only touches the components that it affects. The configuration 
+    // is applied on shard 0.
+    amp::AppliedConfig appliedCfg;
+    amp::Shard& shard0 = *shards[0];
+
+    // This watches for changes to the configuration file and applies 
+    // those changes to everything on the main thread.
+    amp::ConfigWatcher cfgPoller(log, cfgFileName.c_str(), 
         // This function will be called on any update to the configuration document.
         [&log, &webUi, &iax2Channel1, &locReg, &radio2, &signalIn3, &bridge10, &sdrcLine5,
-         iaxPort]
+         &hostedNodes, iaxPort, &appliedCfg, &cfgPoller, &shard0]
         (const json& cfg) {
 
             log.info("Configuration change detected");
             cout << cfg.dump() << endl;
 
             try {
-                amp::configHandler(log, cfg, webUi, iax2Channel1, locReg, radio2, signalIn3, 
-                    bridge10, sdrcLine5, iaxPort);
+                // Anything that failed is tried again in a while, the 
+                // rest is left alone
+                if (amp::configHandler(log, cfg, appliedCfg, webUi, iax2Channel1, locReg, 
+                    radio2, signalIn3, bridge10, sdrcLine5, hostedNodes, iaxPort,
+                    shard0, [&cfgPoller]() { cfgPoller.retry(); }) < 0)
+                    cfgPoller.retry();
             }
             // ### TODO MORE SPECIFIC
             catch (json::exception& ex) {
@@ -220,10 +471,48 @@ int main(int argc, const char** argv) {
         }
     );
 
-    // Setup the EventLoop with all of the tasks that need to be run on this thread
-    Runnable2* tasks[] = { &radio2, &signalIn3, &iax2Channel1, &bridge10, &webUi, 
-        &cfgPoller, &sdrcLine5 };
-    EventLoop::run(log, clock, 0, 0, tasks, std::size(tasks), nullptr, false);
+    // Setup the EventLoops with all of the tasks that need to be run
+    // The names are used for the per-task timing metrics
+    shard0.addTask(&radio2, "LineUsb");
+    shard0.addTask(&signalIn3, "SignalIn");
+    shard0.addTask(&iax2Channel1, "LineIAX2");
+    shard0.addTask(&bridge10, "Bridge");
+    shard0.addTask(&webUi, "WebUi");
+    shard0.addTask(&cfgPoller, "ConfigPoller");
+    shard0.addTask(&sdrcLine5, "LineSDRC");
+    shard0.addTask(&binaryTrace, "BinaryTrace");
+    for (amp::HostedNode& hn : hostedNodes) {
+        amp::Shard& shard = hn.shard ? *hn.shard : shard0;
+        string suffix = "-" + to_string(hn.bridgeLineId);
+        shard.addTask(hn.iax2Channel.get(), ("LineIAX2" + suffix).c_str());
+        shard.addTask(hn.bridge.get(), ("Bridge" + suffix).c_str());
+    }
+
+    // Publishes the task timing. This has to wait until all of the 
+    // tasks have been added.
+    std::unique_ptr<amp::MetricsServer> metricsServer;
+    amp::StatusBoard statusBoard;
+    std::unique_ptr<amp::ShardStatus> shardStatus;
+    if (metricsPort) {
+        std::vector<amp::Shard*> shardPtrs;
+        for (auto& shard : shards)
+            shardPtrs.push_back(shard.get());
+        metricsServer = std::make_unique<amp::MetricsServer>(log, shardPtrs);
+        // The snapshot is published on shard 0, the streams are built on
+        // the metrics server's threads
+        shardStatus = std::make_unique<amp::ShardStatus>(log, statusBoard, shardPtrs, statusMs);
+        shard0.addTask(shardStatus.get(), "Status");
+        metricsServer->setStatusBoard(&statusBoard, statusMs);
+        metricsServer->setLatencyProbe(latencyProbe.get());
+        if (metricsServer->start(metricsPort) < 0)
+            std::exit(-2);
+    }
+    else if (latencyProbe)
+        log.error("The latency is only published with --metricsport");
+
+    for (unsigned i = 1; i < shards.size(); i++)
+        shards[i]->start();
+    shard0.run();
 
     // #### TODO: At the moment there is no clean way to get out of the loop
 
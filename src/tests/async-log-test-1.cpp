@@ -0,0 +1,166 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AsyncLog.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+/**
+ * Makes sure the captured formatting matches vsnprintf.
+ */
+static void check(const char* fmt, ...) {
+    char expected[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(expected, sizeof(expected), fmt, args);
+    va_end(args);
+    va_start(args, fmt);
+    string actual = amp::AsyncLog::formatCaptured(fmt, args);
+    va_end(args);
+    if (actual != expected) {
+        cout << "Mismatch for \"" << fmt << "\": \"" << actual << "\" != \"" 
+            << expected << "\"" << endl;
+        assert(false);
+    }
+}
+
+static vector<string> readLines(FILE* f) {
+    vector<string> result;
+    fflush(f);
+    rewind(f);
+    char line[2048];
+    while (fgets(line, sizeof(line), f))
+        result.push_back(line);
+    return result;
+}
+
+int main(int, const char**) {
+    // Formatting
+    {
+        check("No arguments");
+        check("100%% sure");
+        check("%d %i %u %x %X %o", -12, 34, 56u, 0xabcu, 0xdefu, 8u);
+        check("%hhd %hd %hhu %hx", 300, 70000, 300, 70000);
+        check("%ld %lu %lld %llu %lx", -1234567890123L, 1234567890123UL, 
+            -9000000000000000000LL, 18000000000000000000ULL, 0xdeadbeefUL);
+        check("%zu %zd %jd %td", (size_t)123456, (ssize_t)-7, (intmax_t)-8, (ptrdiff_t)-9);
+        check("%c%c%c", 'a', 'b', 'c');
+        check("%f %.2f %e %g %10.3f %-8.1f|", 3.14159, 2.71828, 1e-10, 12345678.9, -1.5, 2.25);
+        check("%Lf", (long double)1.25);
+        check("%s and %s", "this", "that");
+        check("[%10s] [%-10s] [%.3s]", "right", "left", "truncated");
+        check("%s", (const char*)nullptr);
+        check("%p", (void*)0x1234);
+        check("%*d|%-*d|%.*f|%*.*s", 6, 42, 6, 42, 3, 3.14159, 8, 3, "abcdef");
+        check("%+d % d %05d %#x %#o", 5, 5, 42, 255u, 8u);
+        check("Call %u from %s:%d state %d took %.1f ms", 17u, "192.168.1.1", 4569, 3, 12.5);
+        // Too many arguments and too much string are formatted up front
+        check("%d %d %d %d %d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 
+            11, 12, 13, 14);
+        string big(300, 'x');
+        check("%s!", big.c_str());
+    }
+    // Synchronous before start()
+    {
+        FILE* f = tmpfile();
+        amp::AsyncLog log(f);
+        assert(!log.isAsync());
+        log.info("Hello %s %d", "world", 1);
+        vector<string> lines = readLines(f);
+        assert(lines.size() == 1);
+        assert(lines[0].find(" I Hello world 1\n") != string::npos);
+        fclose(f);
+    }
+    // Asynchronous, several threads
+    {
+        FILE* f = tmpfile();
+        amp::AsyncLog log(f);
+        log.setRateLimit(amp::AsyncLog::INFO, 0);
+        log.start();
+        assert(log.isAsync());
+        vector<std::thread> threads;
+        const unsigned perThread = 500;
+        for (unsigned t = 0; t < 4; t++) {
+            threads.emplace_back([&log, t]() {
+                char name[16];
+                for (unsigned i = 0; i < perThread; i++) {
+                    // The buffer changes right after the call
+                    snprintf(name, sizeof(name), "thread-%u", t);
+                    log.info("%s message %u", name, i);
+                    strcpy(name, "garbage");
+                    if (i % 100 == 99)
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+        log.stop();
+        vector<string> lines = readLines(f);
+        assert(log.getFullDroppedCount() == 0);
+        assert(lines.size() == 4 * perThread);
+        assert(log.getWrittenCount() == 4 * perThread);
+        for (const string& l : lines)
+            assert(l.find(" I thread-") != string::npos);
+        fclose(f);
+    }
+    // Rate limit and ring full
+    {
+        FILE* f = tmpfile();
+        amp::AsyncLog log(f);
+        log.setRateLimit(amp::AsyncLog::ERROR, 10);
+        log.setRateLimit(amp::AsyncLog::INFO, 0);
+        log.start();
+        for (unsigned i = 0; i < 100; i++)
+            log.error("Error %u", i);
+        // Overrun the ring before the writer wakes up
+        for (unsigned i = 0; i < amp::AsyncLog::RING_SIZE * 4; i++)
+            log.info("Info %u", i);
+        log.stop();
+        // The counts depend on the second boundary and the writer's timing
+        assert(log.getRateDroppedCount(amp::AsyncLog::ERROR) >= 80);
+        assert(log.getRateDroppedCount(amp::AsyncLog::INFO) == 0);
+        assert(log.getFullDroppedCount() > 0);
+        const unsigned dropped = log.getRateDroppedCount(amp::AsyncLog::ERROR) + 
+            log.getFullDroppedCount();
+        assert(log.getWrittenCount() + dropped == 100 + amp::AsyncLog::RING_SIZE * 4);
+        fclose(f);
+    }
+    // Cost on the caller
+    {
+        FILE* f = fopen("/dev/null", "w");
+        amp::AsyncLog log(f);
+        log.setRateLimit(amp::AsyncLog::INFO, 0);
+        log.start();
+        const unsigned count = 100000;
+        unsigned accepted = 0;
+        int64_t ns = 0;
+        for (unsigned i = 0; i < count; i += 500) {
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned k = i; k < i + 500; k++)
+                log.info("Call %u from %s:%d jitter %.1f ms", k, "192.168.1.1", 4569, 12.5);
+            ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            // Let the writer keep up
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        log.stop();
+        accepted = log.getWrittenCount();
+        cout << "Caller cost about " << (double)ns / count << " ns/message, " 
+            << accepted << " written, " << log.getFullDroppedCount() << " dropped" << endl;
+        fclose(f);
+    }
+    cout << "OK" << endl;
+}
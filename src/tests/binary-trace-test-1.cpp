@@ -0,0 +1,134 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "BinaryTrace.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+int main(int, const char**) {
+    // Decoding
+    {
+        amp::BinaryTrace trace;
+        trace.traceAt(1000, amp::BinaryTrace::RXV, 7, 12345);
+        trace.traceAt(2000, amp::BinaryTrace::UNK, 7);
+        trace.traceAt(1500, amp::BinaryTrace::POI, 8);
+        assert(trace.defineEvent(20, "XYZ", 2) == 0);
+        assert(trace.defineEvent(20, "TOOLONGNAME", 2) == -1);
+        assert(trace.defineEvent(amp::BinaryTrace::MAX_EVENTS, "X", 0) == -1);
+        trace.traceAt(3000, 20, 9, -1, 2);
+        // Nothing is seen until it is collected
+        assert(trace.getCollectedCount() == 0);
+        stringstream ss;
+        trace.dump(ss);
+        assert(trace.getCollectedCount() == 4);
+        // In time order, in the capture file format
+        assert(ss.str() == 
+            "1000, RXV, 12345, 7\n"
+            "1500, POI, 8\n"
+            "2000, UNK, 7\n"
+            "3000, XYZ, -1, 2, 9\n");
+        // Disabled
+        trace.setEnabled(false);
+        trace.trace(amp::BinaryTrace::RXV, 1, 1);
+        assert(trace.collect() == 0);
+    }
+    // Full ring drops instead of blocking
+    {
+        amp::BinaryTrace trace;
+        for (unsigned i = 0; i < amp::BinaryTrace::RING_SIZE + 10; i++)
+            trace.traceAt(i, amp::BinaryTrace::POI, 1);
+        assert(trace.getDroppedCount() == 10);
+        assert(trace.collect() == amp::BinaryTrace::RING_SIZE);
+        // The history keeps the most recent
+        vector<amp::TraceRecord> recs;
+        trace.snapshot(recs, 10);
+        assert(recs.size() == 10);
+        assert(recs.back().timeUs == amp::BinaryTrace::RING_SIZE - 1);
+    }
+    // Several threads writing while the collector runs, spilling to a file
+    {
+        const char* fn = "/tmp/binary-trace-test-1.bin";
+        const unsigned threads = 4;
+        const unsigned perThread = 50000;
+        const unsigned capacity = 1000;
+        amp::BinaryTrace trace;
+        assert(trace.openSpill(fn, capacity) == 0);
+        atomic<unsigned> running = threads;
+        vector<std::thread> writers;
+        for (unsigned t = 0; t < threads; t++) {
+            writers.emplace_back([&trace, &running, t]() {
+                for (unsigned i = 0; i < perThread; i++) {
+                    trace.traceAt(i, amp::BinaryTrace::RXV, t, i);
+                    // Stay under the ring capacity between collections
+                    if (i % 1024 == 1023)
+                        std::this_thread::sleep_for(std::chrono::microseconds(500));
+                }
+                running--;
+            });
+        }
+        uint64_t collected = 0;
+        while (running > 0) 
+            collected += trace.collect();
+        for (auto& w : writers)
+            w.join();
+        collected += trace.collect();
+        assert(collected + trace.getDroppedCount() == threads * perThread);
+        assert(trace.getCollectedCount() == collected);
+        cout << "Collected " << collected << " dropped " << trace.getDroppedCount() << endl;
+
+        // Read back the spill file
+        ifstream str(fn, ios::binary);
+        amp::BinaryTrace::SpillHeader h;
+        str.read((char*)&h, sizeof(h));
+        assert(memcmp(h.magic, amp::BinaryTrace::SPILL_MAGIC, 8) == 0);
+        assert(h.version == amp::BinaryTrace::SPILL_VERSION);
+        assert(h.recordSize == sizeof(amp::TraceRecord));
+        assert(h.capacity == capacity);
+        assert(h.count == collected);
+        amp::BinaryTrace::SpillEventDef defs[amp::BinaryTrace::MAX_EVENTS];
+        str.read((char*)defs, sizeof(defs));
+        assert(strcmp(defs[amp::BinaryTrace::RXV].name, "RXV") == 0);
+        assert(defs[amp::BinaryTrace::RXV].argCount == 1);
+        str.seekg(amp::BinaryTrace::SPILL_HEADER_SIZE);
+        vector<amp::TraceRecord> recs(capacity);
+        str.read((char*)recs.data(), capacity * sizeof(amp::TraceRecord));
+        assert(str.good());
+        // Every record is intact (the arg matches the timestamp)
+        for (const amp::TraceRecord& r : recs) {
+            assert(r.event == amp::BinaryTrace::RXV);
+            assert(r.args[0] == (int64_t)r.timeUs);
+            assert(r.callId < threads);
+            assert(r.thread < threads);
+        }
+        unlink(fn);
+    }
+    // Overhead
+    {
+        amp::BinaryTrace trace;
+        const unsigned count = 1000;
+        const unsigned rounds = 1000;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned r = 0; r < rounds; r++) {
+            for (unsigned i = 0; i < count; i++)
+                trace.trace(amp::BinaryTrace::RXV, i, i);
+            trace.collect();
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        cout << "Trace + collect " << (double)ns / (count * rounds) << " ns/event" << endl;
+        assert(trace.getDroppedCount() == 0);
+    }
+    cout << "OK" << endl;
+}
@@ -0,0 +1,82 @@
+/**
+ * Measures the CallIndex mini/full frame lookup cost as the number of 
+ * active calls grows. A linear scan of a call table (the way a small 
+ * line finds its calls) is shown for comparison.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "CallIndex.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+struct Call {
+    sockaddr_in peer;
+    uint16_t remoteCallNum;
+    uint16_t localCallNum;
+};
+
+int main(int, const char**) {
+
+    const unsigned lookups = 2000000;
+
+    for (unsigned callCount : { 1, 10, 100, 1000, 4000 }) {
+
+        auto index = std::make_unique<amp::CallIndex>();
+        vector<Call> calls(callCount);
+        std::mt19937 rng(callCount);
+        for (unsigned i = 0; i < callCount; i++) {
+            memset(&calls[i].peer, 0, sizeof(sockaddr_in));
+            calls[i].peer.sin_family = AF_INET;
+            calls[i].peer.sin_addr.s_addr = rng();
+            calls[i].peer.sin_port = htons(4569);
+            calls[i].remoteCallNum = 1 + rng() % 32767;
+            calls[i].localCallNum = i + 1;
+            index->add((sockaddr&)calls[i].peer, calls[i].remoteCallNum, 
+                calls[i].localCallNum, i);
+        }
+
+        // Random order so that the cache isn't doing all of the work
+        vector<uint32_t> order(lookups);
+        for (auto& o : order)
+            o = rng() % callCount;
+
+        int64_t check = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (uint32_t o : order)
+            check += index->findMini((const sockaddr&)calls[o].peer, calls[o].remoteCallNum);
+        auto t1 = chrono::steady_clock::now();
+        for (uint32_t o : order)
+            check += index->findFull(calls[o].localCallNum);
+        auto t2 = chrono::steady_clock::now();
+        for (uint32_t o : order) {
+            for (unsigned i = 0; i < callCount; i++) {
+                if (calls[i].remoteCallNum == calls[o].remoteCallNum &&
+                    calls[i].peer.sin_addr.s_addr == calls[o].peer.sin_addr.s_addr &&
+                    calls[i].peer.sin_port == calls[o].peer.sin_port) {
+                    check += i;
+                    break;
+                }
+            }
+        }
+        auto t3 = chrono::steady_clock::now();
+
+        auto ns = [lookups](auto a, auto b) {
+            return (double)chrono::duration_cast<chrono::nanoseconds>(b - a).count() / lookups;
+        };
+        cout << "calls=" << callCount 
+            << " mini ns=" << ns(t0, t1)
+            << " full ns=" << ns(t1, t2)
+            << " linear ns=" << ns(t2, t3)
+            << " (" << check << ")" << endl;
+    }
+}
@@ -0,0 +1,145 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+#include <arpa/inet.h>
+
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <tuple>
+
+#include "CallIndex.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+static sockaddr_in v4(uint32_t addr, uint16_t port) {
+    sockaddr_in a;
+    memset(&a, 0, sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(addr);
+    a.sin_port = htons(port);
+    return a;
+}
+
+int main(int, const char**) {
+
+    auto index = std::make_unique<amp::CallIndex>();
+
+    // Basic IPv4
+    {
+        sockaddr_in a = v4(0x0a000001, 4569);
+        sockaddr_in b = v4(0x0a000002, 4569);
+        assert(index->add((sockaddr&)a, 100, 1, 7) == 0);
+        assert(index->add((sockaddr&)b, 100, 2, 8) == 0);
+        // Same peer/call number
+        assert(index->add((sockaddr&)a, 100, 3, 9) == -1);
+        // Same local call number
+        assert(index->add((sockaddr&)a, 101, 1, 9) == -1);
+        assert(index->findMini((sockaddr&)a, 100) == 7);
+        assert(index->findMini((sockaddr&)b, 100) == 8);
+        assert(index->findMini((sockaddr&)a, 101) == amp::CallIndex::NOT_FOUND);
+        // Different port is a different peer
+        sockaddr_in a2 = v4(0x0a000001, 4570);
+        assert(index->findMini((sockaddr&)a2, 100) == amp::CallIndex::NOT_FOUND);
+        assert(index->findFull(1) == 7);
+        // The retransmit bit is ignored
+        assert(index->findFull(0x8000 | 2) == 8);
+        assert(index->findFull(3) == amp::CallIndex::NOT_FOUND);
+        // Late call number assignment
+        assert(index->setRemoteCallNum((sockaddr&)a, 100, 200, 1) == 0);
+        assert(index->findMini((sockaddr&)a, 100) == amp::CallIndex::NOT_FOUND);
+        assert(index->findMini((sockaddr&)a, 200) == 7);
+        // The wrong local call number doesn't take out another call
+        assert(index->remove((sockaddr&)a, 200, 2) == -1);
+        assert(index->findFull(2) == 8);
+        assert(index->findMini((sockaddr&)a, 200) == 7);
+        assert(index->remove((sockaddr&)a, 200, 1) == 0);
+        assert(index->remove((sockaddr&)a, 200, 1) == -1);
+        assert(index->findFull(1) == amp::CallIndex::NOT_FOUND);
+        assert(index->size() == 1);
+        // Call slots have to fit in 16 bits
+        assert(index->add((sockaddr&)a, 300, 4, amp::CallIndex::MAX_CALL_SLOT) == 0);
+        assert(index->findFull(4) == (int)amp::CallIndex::MAX_CALL_SLOT);
+        assert(index->add((sockaddr&)a, 301, 5, amp::CallIndex::MAX_CALL_SLOT + 1) == -1);
+        assert(index->findFull(5) == amp::CallIndex::NOT_FOUND);
+        assert(index->findMini((sockaddr&)a, 301) == amp::CallIndex::NOT_FOUND);
+        index->clear();
+        assert(index->size() == 0);
+    }
+
+    // IPv6
+    {
+        sockaddr_in6 a;
+        memset(&a, 0, sizeof(a));
+        a.sin6_family = AF_INET6;
+        inet_pton(AF_INET6, "2001:db8::1", &a.sin6_addr);
+        a.sin6_port = htons(4569);
+        assert(index->add((sockaddr&)a, 5, 5, 3) == 0);
+        assert(index->findMini((sockaddr&)a, 5) == 3);
+        a.sin6_addr.s6_addr[15] = 2;
+        assert(index->findMini((sockaddr&)a, 5) == amp::CallIndex::NOT_FOUND);
+        index->clear();
+    }
+
+    // Random churn against a reference map, including a full table. This 
+    // exercises the backward-shift deletion.
+    {
+        using RefKey = tuple<uint32_t, uint16_t, uint16_t>;
+        map<RefKey, pair<uint16_t, unsigned>> ref;
+        std::mt19937 rng(1);
+        uint16_t nextLocal = 1;
+        for (unsigned iter = 0; iter < 200000; iter++) {
+            // Small address space to get lots of collisions
+            uint32_t addr = 0x0a000000 | (rng() % 64);
+            uint16_t port = 4569 + rng() % 2;
+            uint16_t callNum = 1 + rng() % 64;
+            sockaddr_in a = v4(addr, port);
+            RefKey k(addr, port, callNum);
+            auto it = ref.find(k);
+            if (it == ref.end() && ref.size() < amp::CallIndex::MAX_CALLS && (rng() % 3)) {
+                // Find a free local call number
+                while (index->findFull(nextLocal) != amp::CallIndex::NOT_FOUND)
+                    nextLocal = 1 + (nextLocal % 32767);
+                unsigned slot = rng() % amp::CallIndex::MAX_CALLS;
+                assert(index->add((sockaddr&)a, callNum, nextLocal, slot) == 0);
+                ref[k] = { nextLocal, slot };
+            } 
+            else if (it != ref.end()) {
+                assert(index->findMini((sockaddr&)a, callNum) == (int)it->second.second);
+                assert(index->findFull(it->second.first) == (int)it->second.second);
+                if (rng() % 2) {
+                    assert(index->remove((sockaddr&)a, callNum, it->second.first) == 0);
+                    ref.erase(it);
+                }
+            } 
+            else {
+                assert(index->findMini((sockaddr&)a, callNum) == amp::CallIndex::NOT_FOUND);
+            }
+            assert(index->size() == ref.size());
+        }
+        for (auto& [k, v] : ref) {
+            sockaddr_in a = v4(get<0>(k), get<1>(k));
+            assert(index->findMini((sockaddr&)a, get<2>(k)) == (int)v.second);
+        }
+    }
+
+    // Fill completely
+    {
+        index->clear();
+        for (unsigned i = 0; i < amp::CallIndex::MAX_CALLS; i++) {
+            sockaddr_in a = v4(0xc0a80000 + i, 4569);
+            assert(index->add((sockaddr&)a, 1, i + 1, i) == 0);
+        }
+        sockaddr_in a = v4(0x01010101, 4569);
+        assert(index->add((sockaddr&)a, 1, 30000, 0) == -1);
+        for (unsigned i = 0; i < amp::CallIndex::MAX_CALLS; i++) {
+            sockaddr_in a = v4(0xc0a80000 + i, 4569);
+            assert(index->findMini((sockaddr&)a, 1) == (int)i);
+        }
+    }
+
+    cout << "OK" << endl;
+}
@@ -0,0 +1,122 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "kc1fsz-tools/Log.h"
+
+#include "ConfigWatcher.h"
+
+using namespace std;
+using namespace kc1fsz;
+using json = nlohmann::json;
+
+static void writeFile(const string& fn, const string& text) {
+    ofstream str(fn);
+    str << text;
+}
+
+/**
+ * Writes a new file and renames it into place, like an editor.
+ */
+static void replaceFile(const string& fn, const string& text) {
+    writeFile(fn + ".tmp", text);
+    assert(rename((fn + ".tmp").c_str(), fn.c_str()) == 0);
+}
+
+/**
+ * Waits (briefly) for the watcher's descriptor and runs it.
+ */
+static bool runWatcher(amp::ConfigWatcher& w) {
+    pollfd fds[1];
+    int n = w.getPolls(fds, 1);
+    assert(n == 1);
+    poll(fds, 1, 100);
+    return w.run2();
+}
+
+int main(int, const char**) {
+    // Watching
+    {
+        char dirTemplate[] = "/tmp/config-watch-XXXXXX";
+        const string dir = mkdtemp(dirTemplate);
+        const string fn = dir + "/config.json";
+        writeFile(fn, R"({"iaxPort":"4569"})");
+
+        Log log;
+        json last;
+        unsigned starts = 0;
+        amp::ConfigWatcher w(log, fn.c_str(), 
+            [&last](const json& cfg) { last = cfg; },
+            [&starts](const json&) { starts++; });
+        assert(w.isWatching());
+
+        // Startup
+        assert(w.run2());
+        assert(w.getChangeCount() == 1);
+        assert(starts == 1);
+        assert(last["iaxPort"] == "4569");
+        assert(!w.run2());
+
+        // Same contents
+        writeFile(fn, R"({"iaxPort":"4569"})");
+        runWatcher(w);
+        assert(w.getChangeCount() == 1);
+
+        // Written in place
+        writeFile(fn, R"({"iaxPort":"4570"})");
+        assert(runWatcher(w));
+        assert(w.getChangeCount() == 2);
+        assert(last["iaxPort"] == "4570");
+
+        // Renamed into place
+        replaceFile(fn, R"({"iaxPort":"4571"})");
+        assert(runWatcher(w));
+        assert(w.getChangeCount() == 3);
+        assert(last["iaxPort"] == "4571");
+        assert(starts == 1);
+
+        // Broken document
+        writeFile(fn, R"({"iaxPort":)");
+        runWatcher(w);
+        assert(w.getChangeCount() == 3);
+        assert(last["iaxPort"] == "4571");
+
+        // Other files in the directory
+        writeFile(dir + "/other.json", R"({"iaxPort":"1"})");
+        runWatcher(w);
+        assert(w.getChangeCount() == 3);
+
+        // Fixed
+        writeFile(fn, R"({"iaxPort":"4572"})");
+        runWatcher(w);
+        assert(w.getChangeCount() == 4);
+        assert(last["iaxPort"] == "4572");
+
+        // Tried again on request, once
+        last = json();
+        w.tenSecTick();
+        assert(w.getChangeCount() == 4);
+        w.retry();
+        w.tenSecTick();
+        assert(w.getChangeCount() == 5);
+        assert(last["iaxPort"] == "4572");
+        w.tenSecTick();
+        assert(w.getChangeCount() == 5);
+        assert(starts == 1);
+
+        unlink(fn.c_str());
+        unlink((dir + "/other.json").c_str());
+        rmdir(dir.c_str());
+    }
+    cout << "OK" << endl;
+}
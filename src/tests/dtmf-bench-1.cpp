@@ -0,0 +1,69 @@
+/**
+ * Measures the DTMF detection cost (ns per frame for all channels, and 
+ * per channel) for 1, 8, 64 and 256 channels using each DtmfBank 
+ * implementation that the CPU supports.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "DtmfBank.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+static const unsigned FRAME_LEN = 160;
+
+/**
+ * Runs the function repeatedly for about 200ms.
+ * @returns ns per call
+ */
+template<typename F> static double timeIt(F f) {
+    unsigned iterations = 0;
+    auto start = chrono::steady_clock::now();
+    auto end = start;
+    do {
+        for (unsigned i = 0; i < 16; i++)
+            f();
+        iterations += 16;
+        end = chrono::steady_clock::now();
+    } while (end - start < chrono::milliseconds(200));
+    return (double)chrono::duration_cast<chrono::nanoseconds>(end - start).count() / iterations;
+}
+
+int main(int, const char**) {
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> sample(-4000, 4000);
+
+    cout << "Frame length " << FRAME_LEN << " samples" << endl;
+
+    for (unsigned n : { 1u, 8u, 64u, 256u }) {
+
+        std::vector<std::vector<int16_t>> in(n, std::vector<int16_t>(FRAME_LEN));
+        std::vector<const int16_t*> frames(n);
+        for (unsigned i = 0; i < n; i++) {
+            for (unsigned k = 0; k < FRAME_LEN; k++)
+                in[i][k] = sample(rng);
+            frames[i] = in[i].data();
+        }
+        std::vector<char> digits(n);
+
+        for (auto impl : { amp::SimdImpl::SCALAR, amp::SimdImpl::SSE41,
+            amp::SimdImpl::AVX2, amp::SimdImpl::NEON }) {
+            if (!amp::isSupported(impl))
+                continue;
+            amp::DtmfBank bank(n, FRAME_LEN, 8000, impl);
+            double ns = timeIt([&]() { 
+                bank.process(frames.data(), digits.data());
+            });
+            cout << "channels=" << n << " impl=" << amp::simdImplName(impl) 
+                << " ns/frame=" << (uint64_t)ns << " ns/channel=" << (uint64_t)(ns / n) 
+                << endl;
+        }
+    }
+}
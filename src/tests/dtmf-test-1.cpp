@@ -0,0 +1,219 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "DtmfBank.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+static const unsigned LEN = 160;
+static const float FS = 8000;
+static const char* KEYS = "123A456B789C*0#D";
+
+static float rowHz(char key) { return amp::DtmfBank::TONES_HZ[string(KEYS).find(key) / 4]; }
+static float colHz(char key) { return amp::DtmfBank::TONES_HZ[4 + string(KEYS).find(key) % 4]; }
+
+/**
+ * Generates tones (and optionally noise) into consecutive frames.
+ */
+class Generator {
+public:
+    Generator(unsigned seed) : _rng(seed) { }
+
+    void tones(float f1, float a1, float f2, float a2) {
+        _f1 = f1; _a1 = a1; _f2 = f2; _a2 = a2;
+    }
+    void noise(float rms) { _noise = rms; }
+
+    void frame(int16_t* out) {
+        std::normal_distribution<float> n(0, _noise > 0 ? _noise : 1);
+        for (unsigned k = 0; k < LEN; k++, _t++) {
+            float v = _a1 * sin(2 * M_PI * _f1 * _t / FS + 1.0) + 
+                _a2 * sin(2 * M_PI * _f2 * _t / FS + 2.0);
+            if (_noise > 0)
+                v += n(_rng);
+            out[k] = std::max(-32768.0f, std::min(32767.0f, v));
+        }
+    }
+
+private:
+    std::mt19937 _rng;
+    uint64_t _t = 0;
+    float _f1 = 0, _a1 = 0, _f2 = 0, _a2 = 0, _noise = 0;
+};
+
+/**
+ * Plays the key into a single channel for some frames (then silence) and 
+ * returns what was detected.
+ */
+static string detect(amp::SimdImpl impl, float f1, float a1, float f2, float a2,
+    float noise = 0, unsigned frames = 5, unsigned seed = 1) {
+    amp::DtmfBank bank(1, LEN, FS, impl);
+    Generator gen(seed);
+    gen.noise(noise);
+    string result;
+    int16_t f[LEN];
+    const int16_t* frame = f;
+    char digit;
+    for (unsigned i = 0; i < frames + 5; i++) {
+        if (i < frames)
+            gen.tones(f1, a1, f2, a2);
+        else
+            gen.tones(0, 0, 0, 0);
+        gen.frame(f);
+        if (bank.process(&frame, &digit))
+            result += digit;
+    }
+    return result;
+}
+
+int main(int, const char**) {
+
+    const amp::SimdImpl impls[] = { amp::SimdImpl::SCALAR, amp::SimdImpl::SSE41,
+        amp::SimdImpl::AVX2, amp::SimdImpl::NEON };
+
+    // -10 dBFS per tone
+    const float A = 32767 * pow(10, -10 / 20.0);
+
+    // Every implementation computes the same tone powers (to within
+    // float rounding) on a mix of channel counts and silent channels
+    {
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> sample(-20000, 20000);
+        const unsigned n = 37;
+        std::vector<std::vector<int16_t>> in(n, std::vector<int16_t>(LEN));
+        std::vector<const int16_t*> frames(n);
+        for (unsigned c = 0; c < n; c++) {
+            for (unsigned k = 0; k < LEN; k++)
+                in[c][k] = sample(rng);
+            frames[c] = (c % 5 == 3) ? nullptr : in[c].data();
+        }
+        std::vector<float> ref(n * amp::DtmfBank::TONE_COUNT), refE(n);
+        amp::DtmfBank(n, LEN, FS, amp::SimdImpl::SCALAR).analyze(frames.data(), 
+            ref.data(), refE.data());
+        for (auto impl : impls) {
+            if (!amp::isSupported(impl))
+                continue;
+            amp::DtmfBank bank(n, LEN, FS, impl);
+            std::vector<float> p(n * amp::DtmfBank::TONE_COUNT), e(n);
+            bank.analyze(frames.data(), p.data(), e.data());
+            for (unsigned i = 0; i < p.size(); i++)
+                assert(fabs(p[i] - ref[i]) <= 1e-3 * ref[i] + 1);
+            for (unsigned c = 0; c < n; c++)
+                assert(e[c] == refE[c]);
+        }
+    }
+
+    for (auto impl : impls) {
+
+        if (!amp::isSupported(impl))
+            continue;
+
+        // All 16 keys
+        for (const char* k = KEYS; *k; k++)
+            assert(detect(impl, rowHz(*k), A, colHz(*k), A) == string(1, *k));
+
+        // Frequency tolerance: +/-1.5% is detected, +/-3.5% is not
+        for (float dev : { -0.015f, 0.015f })
+            for (const char* k = KEYS; *k; k++)
+                assert(detect(impl, rowHz(*k) * (1 + dev), A, colHz(*k) * (1 + dev), A) == 
+                    string(1, *k));
+        for (float dev : { -0.035f, 0.035f, -0.06f, 0.06f })
+            for (const char* k = KEYS; *k; k++)
+                assert(detect(impl, rowHz(*k) * (1 + dev), A, colHz(*k) * (1 + dev), A) == "");
+
+        // Twist: 6 dB normal (row stronger) and 3 dB reverse are accepted,
+        // 10 dB normal and 6 dB reverse are not
+        const auto db = [](float d) { return (float)pow(10, d / 20.0); };
+        assert(detect(impl, rowHz('5'), A, colHz('5'), A / db(6)) == "5");
+        assert(detect(impl, rowHz('5'), A / db(3), colHz('5'), A) == "5");
+        assert(detect(impl, rowHz('5'), A, colHz('5'), A / db(10)) == "");
+        assert(detect(impl, rowHz('5'), A / db(6), colHz('5'), A) == "");
+
+        // Level: -30 dBFS is detected, -45 dBFS is not
+        const float quiet = 32767 * pow(10, -30 / 20.0);
+        assert(detect(impl, rowHz('9'), quiet, colHz('9'), quiet) == "9");
+        const float tooQuiet = 32767 * pow(10, -45 / 20.0);
+        assert(detect(impl, rowHz('9'), tooQuiet, colHz('9'), tooQuiet) == "");
+
+        // Noise: 15 dB SNR (per tone) is detected every time
+        for (unsigned seed = 1; seed <= 20; seed++) {
+            const char key = KEYS[seed % 16];
+            const float noise = A / sqrt(2.0f) * pow(10, -15 / 20.0);
+            assert(detect(impl, rowHz(key), A, colHz(key), A, noise, 5, seed) == 
+                string(1, key));
+        }
+
+        // Duration: one frame is too short, two is enough
+        assert(detect(impl, rowHz('#'), A, colHz('#'), A, 0, 1) == "");
+        assert(detect(impl, rowHz('#'), A, colHz('#'), A, 0, 2) == "#");
+
+        // Not DTMF: one tone, two row tones, noise alone
+        assert(detect(impl, rowHz('1'), A, 0, 0) == "");
+        assert(detect(impl, 697, A, 852, A) == "");
+        assert(detect(impl, 0, 0, 0, 0, A, 500) == "");
+        // Two keys at once
+        {
+            amp::DtmfBank bank(1, LEN, FS, impl);
+            Generator g1(1), g2(2);
+            g1.tones(rowHz('1'), A, colHz('1'), A);
+            g2.tones(rowHz('9'), A, colHz('9'), A);
+            int16_t f1[LEN], f2[LEN];
+            const int16_t* frame = f1;
+            for (unsigned i = 0; i < 10; i++) {
+                g1.frame(f1);
+                g2.frame(f2);
+                for (unsigned k = 0; k < LEN; k++)
+                    f1[k] = (f1[k] + f2[k]) / 2;
+                assert(bank.process(&frame, nullptr) == 0);
+            }
+        }
+    }
+
+    // Many channels, each dialing its own sequence, with a key held down
+    // across frames reported only once
+    {
+        const unsigned n = 50;
+        amp::DtmfBank bank(n, LEN, FS);
+        std::vector<Generator> gens;
+        for (unsigned c = 0; c < n; c++)
+            gens.emplace_back(c + 1);
+        std::vector<std::vector<int16_t>> in(n, std::vector<int16_t>(LEN));
+        std::vector<const int16_t*> frames(n);
+        std::vector<string> dialed(n), heard(n);
+        char digits[n];
+        for (unsigned step = 0; step < 40; step++) {
+            for (unsigned c = 0; c < n; c++) {
+                // 4 frames on, 3 off, and some channels stay silent
+                if (c % 7 == 6) {
+                    frames[c] = nullptr;
+                    continue;
+                }
+                const char key = KEYS[(c + step / 7) % 16];
+                if (step % 7 == 0)
+                    dialed[c] += key;
+                if (step % 7 < 4)
+                    gens[c].tones(rowHz(key), A, colHz(key), A);
+                else
+                    gens[c].tones(0, 0, 0, 0);
+                gens[c].frame(in[c].data());
+                frames[c] = in[c].data();
+            }
+            bank.process(frames.data(), digits);
+            for (unsigned c = 0; c < n; c++)
+                if (digits[c])
+                    heard[c] += digits[c];
+        }
+        for (unsigned c = 0; c < n; c++)
+            assert(heard[c] == dialed[c]);
+    }
+
+    cout << "OK" << endl;
+}
@@ -0,0 +1,127 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "MixKernel.h"
+#include "EncodeCache.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+static const unsigned FRAME_LEN = 160;
+
+enum Codec { CODEC_A, CODEC_B };
+
+/**
+ * Stand-in encoders. Codec A keeps the high byte, codec B keeps
+ * the whole sample.
+ */
+static int encode(Codec codec, const int16_t* frame, uint8_t* out, unsigned outCapacity) {
+    if (codec == CODEC_A) {
+        if (outCapacity < FRAME_LEN)
+            return -1;
+        for (unsigned k = 0; k < FRAME_LEN; k++)
+            out[k] = (frame[k] >> 8) & 0xff;
+        return FRAME_LEN;
+    } else {
+        if (outCapacity < FRAME_LEN * 2)
+            return -1;
+        memcpy(out, frame, FRAME_LEN * 2);
+        return FRAME_LEN * 2;
+    }
+}
+
+int main(int, const char**) {
+    // A 20 participant bridge with 2 talkers. Participants alternate
+    // between the two codecs.
+    {
+        const unsigned n = 20;
+        std::vector<std::vector<int16_t>> in(n, std::vector<int16_t>(FRAME_LEN));
+        std::vector<std::vector<int16_t>> out(n, std::vector<int16_t>(FRAME_LEN));
+        std::vector<const int16_t*> inPtrs(n, nullptr);
+        std::vector<int16_t*> outPtrs(n, nullptr);
+        std::vector<int16_t> gains(n, amp::MixKernel::UNITY_GAIN);
+        for (unsigned k = 0; k < FRAME_LEN; k++) {
+            in[3][k] = 1000 + k;
+            in[8][k] = -3000 + 7 * k;
+        }
+        inPtrs[3] = in[3].data();
+        inPtrs[8] = in[8].data();
+        // Only the talkers need their own mix, everyone else hears the full mix
+        outPtrs[3] = out[3].data();
+        outPtrs[8] = out[8].data();
+        std::vector<int16_t> fullMix(FRAME_LEN);
+
+        amp::MixKernel kernel;
+        amp::EncodeCache cache;
+
+        for (unsigned frame = 0; frame < 3; frame++) {
+            cache.startFrame();
+            kernel.mix(n, inPtrs.data(), gains.data(), outPtrs.data(), fullMix.data(), 
+                FRAME_LEN);
+            for (unsigned i = 0; i < n; i++) {
+                Codec codec = (i % 2 == 0) ? CODEC_A : CODEC_B;
+                const int16_t* mix = inPtrs[i] ? out[i].data() : fullMix.data();
+                uint32_t mixId = inPtrs[i] ? 1 + i : amp::EncodeCache::FULL_MIX;
+                unsigned len = 0;
+                uint8_t overflow[amp::EncodeCache::MAX_ENCODED_SIZE];
+                const uint8_t* encoded = cache.get(mixId, codec, len, 
+                    [codec, mix](uint8_t* buf, unsigned cap) { 
+                        return encode(codec, mix, buf, cap); 
+                    }, overflow);
+                assert(encoded);
+                // Must be the same as encoding directly
+                uint8_t direct[amp::EncodeCache::MAX_ENCODED_SIZE];
+                int directLen = encode(codec, mix, direct, sizeof(direct));
+                assert((int)len == directLen);
+                assert(memcmp(encoded, direct, len) == 0);
+            }
+        }
+        // Per frame: two talkers plus the full mix in two codecs
+        assert(cache.getEncodeCount() == 3 * 4);
+        assert(cache.getSavedCount() == 3 * (n - 4));
+    }
+    // More distinct mixes than the table holds still works. All of the
+    // slots are used, the overflow goes into the caller's storage and
+    // what the cache returned earlier stays put.
+    {
+        const unsigned N = amp::EncodeCache::MAX_ENTRIES;
+        amp::EncodeCache cache;
+        cache.startFrame();
+        std::vector<const uint8_t*> first(40, nullptr);
+        for (unsigned round = 0; round < 2; round++) {
+            for (uint32_t mixId = 0; mixId < 40; mixId++) {
+                unsigned len;
+                uint8_t overflow[amp::EncodeCache::MAX_ENCODED_SIZE];
+                const uint8_t* e = cache.get(mixId, 0, len, [mixId](uint8_t* buf, unsigned) {
+                    buf[0] = mixId;
+                    return 1;
+                }, overflow);
+                assert(e && len == 1 && e[0] == mixId);
+                assert((e == overflow) == (mixId >= N));
+                if (round == 0)
+                    first[mixId] = e;
+                else if (mixId < N)
+                    assert(e == first[mixId]);
+            }
+        }
+        for (uint32_t mixId = 0; mixId < N; mixId++)
+            assert(first[mixId][0] == mixId);
+        assert(cache.getSavedCount() == N);
+        assert(cache.getEncodeCount() == 80 - N);
+        assert(cache.getOverflowCount() == 2 * (40 - N));
+    }
+    // Encoder failure
+    {
+        amp::EncodeCache cache;
+        cache.startFrame();
+        unsigned len;
+        uint8_t overflow[amp::EncodeCache::MAX_ENCODED_SIZE];
+        assert(cache.get(1, 0, len, [](uint8_t*, unsigned) { return -1; }, overflow) == nullptr);
+    }
+    cout << "OK" << endl;
+}
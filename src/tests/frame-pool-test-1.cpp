@@ -0,0 +1,98 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "FramePool.h"
+#include "SpscRing.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+struct Frame {
+    uint32_t seq;
+    int16_t samples[160];
+};
+
+int main(int, const char**) {
+    // Basic allocation, sharing, and exhaustion
+    {
+        amp::FramePool<Frame> pool(2);
+        Frame f;
+        f.seq = 7;
+        auto h0 = pool.alloc(f, 2);
+        assert(h0 != amp::FramePool<Frame>::NO_HANDLE);
+        assert(pool.get(h0).seq == 7);
+        f.seq = 8;
+        auto h1 = pool.alloc(f);
+        assert(h1 != h0);
+        assert(pool.getInUse() == 2);
+        // Exhausted
+        assert(pool.alloc(f) == amp::FramePool<Frame>::NO_HANDLE);
+        assert(pool.getExhaustedCount() == 1);
+        // First release of a shared frame doesn't free it
+        pool.release(h0);
+        assert(pool.getInUse() == 2);
+        assert(pool.tryAddRef(h0));
+        pool.release(h0);
+        pool.release(h0);
+        assert(pool.getInUse() == 1);
+        // Can't add a reference to a frame that went back to the pool
+        assert(!pool.tryAddRef(h0));
+        // The slot is reused
+        f.seq = 9;
+        auto h2 = pool.alloc(f);
+        assert(h2 == h0);
+        assert(pool.get(h2).seq == 9);
+        pool.release(h1);
+        pool.release(h2);
+        assert(pool.getInUse() == 0);
+        assert(pool.getHighWater() == 2);
+        assert(pool.getAllocCount() == 3);
+    }
+    // One producer thread fans each frame out to two consumer threads
+    {
+        const unsigned count = 200000;
+        amp::FramePool<Frame> pool(64);
+        amp::SpscRing<uint32_t, 16> ringA, ringB;
+        std::thread producer([&]() {
+            Frame f;
+            for (uint32_t i = 0; i < count; i++) {
+                f.seq = i;
+                for (unsigned k = 0; k < 160; k++)
+                    f.samples[k] = i + k;
+                uint32_t h;
+                while ((h = pool.alloc(f, 2)) == amp::FramePool<Frame>::NO_HANDLE)
+                    std::this_thread::yield();
+                while (!ringA.push(h)) std::this_thread::yield();
+                while (!ringB.push(h)) std::this_thread::yield();
+            }
+        });
+        auto consumer = [&](amp::SpscRing<uint32_t, 16>& ring) {
+            uint32_t expected = 0;
+            while (expected < count) {
+                uint32_t h;
+                if (!ring.pop(h)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const Frame& f = pool.get(h);
+                assert(f.seq == expected);
+                assert(f.samples[159] == (int16_t)(expected + 159));
+                pool.release(h);
+                expected++;
+            }
+        };
+        std::thread consumerA(consumer, std::ref(ringA));
+        std::thread consumerB(consumer, std::ref(ringB));
+        producer.join();
+        consumerA.join();
+        consumerB.join();
+        assert(pool.getInUse() == 0);
+        assert(pool.getAllocCount() == count);
+    }
+    cout << "OK" << endl;
+}
@@ -0,0 +1,215 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+
+#include "JitterBuffer.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+static const unsigned LEN = 160;
+
+/**
+ * Records what it was asked to do.
+ */
+class TestConcealer : public amp::Concealer {
+public:
+    void goodFrame(const int16_t*, unsigned len) override { 
+        assert(len == LEN);
+        good++; 
+    }
+    void badFrame(int16_t* out, unsigned len) override { 
+        for (unsigned i = 0; i < len; i++)
+            out[i] = -1;
+        bad++; 
+    }
+    unsigned good = 0;
+    unsigned bad = 0;
+};
+
+static void makeFrame(int16_t* f, int16_t mark) {
+    for (unsigned i = 0; i < LEN; i++)
+        f[i] = mark;
+}
+
+int main(int, const char**) {
+
+    int16_t f[LEN], out[LEN];
+
+    // Steady stream with a fixed transit: everything plays in order after 
+    // the initial allowance (b * initial variation).
+    {
+        TestConcealer plc;
+        auto jb = std::make_unique<amp::JitterBuffer>(LEN, &plc);
+        const uint32_t offset = 1000000;
+        // Frames arrive, tick shortly after each one
+        for (unsigned i = 0; i < 10; i++) {
+            makeFrame(f, i);
+            assert(jb->consume(i * 20, offset + i * 20, f) == 0);
+        }
+        const float expectedDelay = amp::JitterBuffer::BETA * 
+            amp::JitterBuffer::INITIAL_VARIATION_MS;
+        assert(jb->getPlayoutDelayMs() == expectedDelay);
+        // Not yet
+        assert(!jb->playOut(offset + expectedDelay - 1, out));
+        for (unsigned i = 0; i < 10; i++) {
+            assert(jb->playOut(offset + expectedDelay + i * 20, out));
+            assert(out[0] == (int16_t)i);
+        }
+        assert(jb->getStats().played == 10);
+        assert(jb->getStats().concealed == 0);
+        assert(plc.good == 10);
+        assert(jb->getAvgBufferedMs() == expectedDelay);
+    }
+
+    // Reordering, loss, duplicates, a late frame and a talkspurt boundary
+    {
+        TestConcealer plc;
+        auto jb = std::make_unique<amp::JitterBuffer>(LEN, &plc);
+        // Playout at origin + 40
+        makeFrame(f, 0); assert(jb->consume(0, 0, f) == 0);
+        makeFrame(f, 2); assert(jb->consume(40, 41, f) == 0);
+        makeFrame(f, 1); assert(jb->consume(20, 42, f) == 0);
+        assert(jb->consume(20, 43, f) == -2);
+        // Origin timestamps a little off the 20ms grid
+        makeFrame(f, 3); assert(jb->consume(61, 60, f) == 0);
+        // 4 is lost
+        makeFrame(f, 5); assert(jb->consume(99, 100, f) == 0);
+        // Way ahead
+        assert(jb->consume(100 + 20 * amp::JitterBuffer::SLOT_COUNT, 101, f) == -3);
+
+        for (int16_t expected : { 0, 1, 2, 3, -1, 5 }) {
+            static uint32_t now = 40;
+            assert(jb->playOut(now, out));
+            assert(out[0] == expected);
+            now += 20;
+        }
+        // 4 shows up after it was concealed
+        makeFrame(f, 4); assert(jb->consume(80, 141, f) == -1);
+        assert(jb->getStats().concealed == 1);
+        assert(jb->getStats().late == 1);
+        assert(jb->getStats().duplicate == 1);
+        assert(jb->getStats().overflow == 1);
+        assert(plc.bad == 1);
+
+        // The talkspurt stops: three concealed frames and then silence
+        assert(jb->playOut(160, out) && out[0] == -1);
+        assert(jb->playOut(180, out) && out[0] == -1);
+        assert(jb->playOut(200, out) && out[0] == -1);
+        assert(!jb->playOut(220, out));
+        assert(!jb->isPlaying());
+        // The trailing concealment isn't counted
+        assert(jb->getStats().concealed == 1);
+        // A straggler from the old talkspurt doesn't start a new one
+        assert(jb->consume(100, 230, f) == -1);
+        assert(!jb->isPlaying());
+        // The next talkspurt
+        makeFrame(f, 9); assert(jb->consume(2000, 2010, f) == 0);
+        assert(jb->isPlaying());
+        assert(jb->getStats().spurts == 2);
+        // An unkey that overtakes the last frame of the talkspurt
+        makeFrame(f, 10); assert(jb->consume(2020, 2030, f) == 0);
+        jb->endSpurt();
+        makeFrame(f, 11); assert(jb->consume(2040, 2050, f) == 0);
+        assert(jb->isPlaying());
+        assert(jb->playOut(2050, out) && out[0] == 9);
+        assert(jb->playOut(2070, out) && out[0] == 10);
+        assert(jb->playOut(2090, out) && out[0] == 11);
+        // Stops at the gap without concealing
+        const uint32_t bad = plc.bad;
+        assert(!jb->playOut(2110, out));
+        assert(!jb->isPlaying());
+        assert(plc.bad == bad);
+    }
+
+    // The jitter.py model: normally distributed flight times with a 
+    // variance of 12, in 2 second talkspurts. The playout allowance should
+    // settle near b * E|n - d| and very few frames should be lost.
+    {
+        auto jb = std::make_unique<amp::JitterBuffer>(LEN, nullptr);
+        std::mt19937 rng(1);
+        std::normal_distribution<double> flight(50.0, sqrt(12.0));
+        // Arrival time -> origin
+        std::multimap<uint32_t, uint32_t> inFlight;
+        uint32_t sent = 0;
+        const uint32_t endMs = 600000;
+        for (uint32_t now = 0; now < endMs; now++) {
+            // Send during the first 2s of every 3s
+            if (now % 20 == 0 && (now % 3000) < 2000) {
+                inFlight.insert({ now + (uint32_t)std::max(0.0, round(flight(rng))), now });
+                sent++;
+            }
+            while (!inFlight.empty() && inFlight.begin()->first <= now) {
+                jb->consume(inFlight.begin()->second, now, f);
+                inFlight.erase(inFlight.begin());
+            }
+            // The audio tick is not aligned with the sender
+            if (now % 20 == 7)
+                jb->playOut(now, out);
+        }
+        const amp::JitterBuffer::Stats& s = jb->getStats();
+        float lossPct = 100.0f * s.late / s.received;
+        cout << "sent " << sent << " played " << s.played << " late " << s.late 
+            << " (" << lossPct << "%) concealed " << s.concealed
+            << " spurts " << s.spurts 
+            << " allowance " << jb->getPlayoutDelayMs() << " ms"
+            << " variation " << jb->getVariationMs() << " ms"
+            << " avg buffered " << jb->getAvgBufferedMs() << " ms" << endl;
+        assert(s.received == sent);
+        assert(s.spurts == endMs / 3000);
+        assert(lossPct < 1.0f);
+        assert(s.played + s.late == sent);
+        // E|X - mu| = sd * sqrt(2 / pi) = 2.76
+        assert(fabs(jb->getVariationMs() - 2.76) < 0.5);
+        assert(jb->getAvgBufferedMs() < 30);
+    }
+
+    // Latency stamps travel with the frames and are cleared for 
+    // concealment.
+    {
+        auto jb = std::make_unique<amp::JitterBuffer>(LEN);
+        amp::LatencyStamp in, played;
+        in.mark(amp::LatencyStamp::CAPTURE, 1000);
+        in.mark(amp::LatencyStamp::QUEUED, 1500);
+        makeFrame(f, 1);
+        assert(jb->consume(0, 100, f, &in) == 0);
+        // Frame 1 is missing, frame 2 has no stamp
+        assert(jb->consume(40, 140, f) == 0);
+        uint32_t now = 100;
+        while (!jb->playOut(now, out, &played))
+            now++;
+        assert(played.us[amp::LatencyStamp::CAPTURE] == 1000);
+        assert(played.us[amp::LatencyStamp::QUEUED] == 1500);
+        assert(!played.has(amp::LatencyStamp::PLAYOUT));
+        assert(jb->playOut(now + 20, out, &played));
+        assert(!played.has(amp::LatencyStamp::CAPTURE));
+        played.mark(amp::LatencyStamp::CAPTURE, 1);
+        assert(jb->playOut(now + 40, out, &played));
+        assert(!played.has(amp::LatencyStamp::CAPTURE));
+
+        amp::LatencyProbe probe;
+        assert(probe.addPath("USB->IAX2") == 0);
+        amp::LatencyStamp st;
+        st.mark(amp::LatencyStamp::CAPTURE, 1000);
+        st.mark(amp::LatencyStamp::QUEUED, 1100);
+        st.mark(amp::LatencyStamp::PLAYOUT, 41100);
+        probe.record(0, st);
+        st.mark(amp::LatencyStamp::SENT, 41300);
+        probe.record(0, st);
+        assert(probe.getHistogram(0, amp::LatencyProbe::INPUT).getCount() == 2);
+        assert(probe.getHistogram(0, amp::LatencyProbe::JITTER).getMaxUs() == 40000);
+        assert(probe.getHistogram(0, amp::LatencyProbe::BRIDGE).getCount() == 1);
+        assert(probe.getHistogram(0, amp::LatencyProbe::BRIDGE).getSumUs() == 200);
+        assert(probe.getHistogram(0, amp::LatencyProbe::TOTAL).getSumUs() == 40300);
+        assert(!strcmp(probe.getPathName(0), "USB->IAX2"));
+    }
+
+    cout << "OK" << endl;
+}
@@ -0,0 +1,146 @@
+/**
+ * The load generator against the server's own LineIAX2 and Bridge, in
+ * this process on loopback ports.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/linux/StdClock.h"
+#include "kc1fsz-tools/threadsafequeue2.h"
+
+// amp-core
+#include "TraceLog.h"
+#include "MultiRouter.h"
+#include "LineIAX2.h"
+#include "Bridge.h"
+#include "BridgeCall.h"
+
+#include "LoadGenerator.h"
+#include "StaticRegistry.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+static const uint16_t SERVER_PORT = 46200;
+static const uint16_t CLIENT_PORT = 46201;
+static const uint16_t SILENT_PORT = 46202;
+
+static void loopback(sockaddr_storage& addr, uint16_t port) {
+    memset(&addr, 0, sizeof(addr));
+    sockaddr_in& a = (sockaddr_in&)addr;
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    a.sin_port = htons(port);
+}
+
+int main(int, const char**) {
+
+    Log log;
+    StdClock clock;
+
+    // The server, wired the way amp-server wires node 1000
+    std::unique_ptr<string[]> traceLogData(new string[64]);
+    TraceLog traceLog(clock, traceLogData.get(), 64);
+    threadsafequeue2<Message> respQueue;
+    MultiRouter router(respQueue);
+    amp::StaticRegistry registry;
+    amp::Bridge bridge(log, traceLog, clock, router, amp::BridgeCall::Mode::NORMAL, 10,
+        0, 0, 0, 1);
+    bridge.setLocalNodeNumber("1000");
+    router.addRoute(&bridge, 10);
+    LineIAX2 server(log, traceLog, clock, 1, router, 0, 0, &registry, 10);
+    router.addRoute(&server, 1);
+    assert(server.open(AF_INET, SERVER_PORT, "radio") == 0);
+
+    amp::LoadGenerator::Options opts;
+    loopback(opts.target, SERVER_PORT);
+    opts.localPort = CLIENT_PORT;
+    opts.calls = 20;
+    opts.rampRate = 200;
+    opts.spurtMeanMs = 300;
+    opts.gapMeanMs = 100;
+    amp::LoadGenerator gen(log, clock, opts);
+    assert(gen.open() == 0);
+
+    uint32_t start = clock.time();
+    uint32_t nextTickMs = start;
+    unsigned ticks = 0;
+    while (clock.time() - start < 4000) {
+        gen.service();
+        while (server.run2() || bridge.run2());
+        const uint32_t now = clock.time();
+        if ((int32_t)(now - nextTickMs) >= 0) {
+            server.audioRateTick(now);
+            bridge.audioRateTick(now);
+            if (++ticks % 50 == 0) {
+                server.oneSecTick();
+                bridge.oneSecTick();
+            }
+            nextTickMs += 20;
+        }
+        usleep(1000);
+    }
+
+    const amp::LoadGenerator::Stats& s = gen.getStats();
+    cout << "answered " << s.callsAnswered << " sent " << s.voiceSent
+        << " received " << s.voiceReceived << " expected " << s.voiceExpected
+        << " spurts " << s.spurts << " missed " << s.missedOnsets
+        << " latency p50 " << s.latencyPercentile(50)
+        << " max " << s.latencyPercentile(100) << " ms" << endl;
+
+    assert(gen.getActiveCount() == 20);
+    assert(s.callsStarted == 20);
+    assert(s.callsAnswered == 20);
+    assert(s.callsFailed == 0 && s.callsEnded == 0);
+    assert(s.spurts >= 2);
+    assert(s.voiceSent > 50);
+    // What a talker sends is heard by the other calls, give or take
+    // the jitter buffer's start and end of each talkspurt
+    assert(s.voiceReceived >= s.voiceExpected * 8 / 10);
+    // Each listener heard each talkspurt, through the jitter buffer
+    assert(!s.latencyMs.empty());
+    assert(s.missedOnsets <= s.spurts);
+    assert(s.latencyPercentile(100) <= 300);
+
+    // A server that never answers: every call fails once the setup
+    // timeout passes
+    {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_storage silent;
+        loopback(silent, SILENT_PORT);
+        assert(bind(fd, (sockaddr*)&silent, sizeof(sockaddr_in)) == 0);
+
+        amp::LoadGenerator::Options opts2;
+        opts2.target = silent;
+        opts2.localPort = CLIENT_PORT + 10;
+        opts2.calls = 3;
+        opts2.rampRate = 1000;
+        opts2.setupTimeoutMs = 1000;
+        amp::LoadGenerator gen2(log, clock, opts2);
+        assert(gen2.open() == 0);
+
+        start = clock.time();
+        while (clock.time() - start < 1500) {
+            gen2.service();
+            usleep(1000);
+        }
+        assert(gen2.getStats().callsStarted == 3);
+        assert(gen2.getStats().callsAnswered == 0);
+        assert(gen2.getStats().callsFailed == 3);
+        assert(gen2.getActiveCount() == 0);
+        close(fd);
+    }
+
+    cout << "OK" << endl;
+}
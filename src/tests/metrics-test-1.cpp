@@ -0,0 +1,167 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include "LatencyHistogram.h"
+#include "MetricsFormat.h"
+
+using namespace std;
+using namespace kc1fsz;
+using json = nlohmann::json;
+
+int main(int, const char**) {
+    // Bucket boundaries
+    {
+        using H = amp::LatencyHistogram;
+        unsigned lastBucket = 0;
+        for (uint64_t v = 0; v < 1000000; v++) {
+            unsigned b = H::bucketOf(v);
+            assert(b < H::BUCKET_COUNT);
+            // Monotonic and contiguous
+            assert(b == lastBucket || b == lastBucket + 1);
+            lastBucket = b;
+            assert(v <= H::bucketUpperUs(b));
+            // Within the precision
+            assert(b == 0 || H::bucketUpperUs(b - 1) < v);
+            assert(H::bucketUpperUs(b) - v <= v / H::SUB_COUNT);
+        }
+        assert(H::bucketOf(H::MAX_VALUE_US - 1) == H::BUCKET_COUNT - 1);
+        assert(H::bucketOf(H::MAX_VALUE_US * 10) == H::BUCKET_COUNT - 1);
+    }
+    // Percentiles
+    {
+        amp::LatencyHistogram h;
+        assert(h.percentileUs(99) == 0);
+        for (unsigned i = 1; i <= 1000; i++)
+            h.record(i);
+        assert(h.getCount() == 1000);
+        assert(h.getSumUs() == 500500);
+        assert(h.getMaxUs() == 1000);
+        auto near = [](uint64_t a, uint64_t b) { return a >= b && a <= b + b / 16; };
+        assert(near(h.percentileUs(50), 500));
+        assert(near(h.percentileUs(90), 900));
+        assert(near(h.percentileUs(99), 990));
+        assert(h.percentileUs(100) == 1000);
+        assert(h.percentileUs(0) == 1);
+    }
+    // One writer, one reader
+    {
+        auto h = std::make_unique<amp::LatencyHistogram>();
+        std::atomic<bool> done = false;
+        std::thread writer([&h, &done]() {
+            std::mt19937 rng(1);
+            std::exponential_distribution<double> d(1.0 / 200);
+            for (unsigned i = 0; i < 1000000; i++)
+                h->record((uint64_t)d(rng));
+            done = true;
+        });
+        uint64_t last = 0;
+        while (!done) {
+            uint64_t c = h->getCount();
+            assert(c >= last);
+            last = c;
+            h->percentileUs(99);
+        }
+        writer.join();
+        assert(h->getCount() == 1000000);
+        uint64_t total = 0;
+        for (unsigned i = 0; i < amp::LatencyHistogram::BUCKET_COUNT; i++)
+            total += h->getBucketCount(i);
+        assert(total == 1000000);
+        cout << "Exponential(200us) p50 " << h->percentileUs(50) << " p99 " 
+            << h->percentileUs(99) << endl;
+    }
+    // Rendering
+    {
+        amp::LatencyHistogram work, interval, run, tick;
+        for (unsigned i = 0; i < 100; i++) {
+            work.record(300 + i);
+            interval.record(20000);
+            run.record(5);
+            tick.record(100);
+        }
+        tick.record(30000);
+        amp::ShardMetrics m;
+        m.id = 0;
+        m.ticks = 101;
+        m.overruns = 1;
+        m.worstTickUs = 31000;
+        m.worstOffender = "Bridge";
+        m.tickWork = &work;
+        m.tickInterval = &interval;
+        amp::ShardMetrics::Task t;
+        t.name = "Bridge";
+        t.overruns = 1;
+        t.run = &run;
+        t.tick = &tick;
+        m.tasks.push_back(t);
+        std::vector<amp::ShardMetrics> shards { m };
+
+        json doc = json::parse(amp::renderMetricsJson(shards));
+        assert(doc["shards"].size() == 1);
+        assert(doc["shards"][0]["overruns"] == 1);
+        assert(doc["shards"][0]["worstOffender"] == "Bridge");
+        assert(doc["shards"][0]["tickWork"]["count"] == 100);
+        assert(doc["shards"][0]["tasks"][0]["name"] == "Bridge");
+        assert(doc["shards"][0]["tasks"][0]["tick"]["maxUs"] == 30000);
+        assert(doc["shards"][0]["tasks"][0]["tick"]["p50Us"] == 103);
+
+        string prom = amp::renderMetricsPrometheus(shards);
+        auto has = [&prom](const string& line) { 
+            return prom.find(line + "\n") != string::npos; 
+        };
+        assert(has("# TYPE amp_tick_work_us histogram"));
+        assert(has("amp_shard_overruns_total{shard=\"0\"} 1"));
+        assert(has("amp_tick_work_us_bucket{shard=\"0\",le=\"250\"} 0"));
+        assert(has("amp_tick_work_us_bucket{shard=\"0\",le=\"500\"} 100"));
+        assert(has("amp_tick_work_us_bucket{shard=\"0\",le=\"+Inf\"} 100"));
+        assert(has("amp_tick_work_us_count{shard=\"0\"} 100"));
+        assert(has("amp_task_tick_us_bucket{shard=\"0\",task=\"Bridge\",le=\"20000\"} 100"));
+        assert(has("amp_task_tick_us_bucket{shard=\"0\",task=\"Bridge\",le=\"+Inf\"} 101"));
+        assert(has("amp_task_overruns_total{shard=\"0\",task=\"Bridge\"} 1"));
+        assert(has("amp_tick_work_quantile_us{shard=\"0\",quantile=\"0.99\"} 399"));
+        // Every line is a comment or "name{labels} value"
+        istringstream lines(prom);
+        string line;
+        while (getline(lines, line))
+            assert(line[0] == '#' || (line.find("} ") != string::npos && line.find('{') != string::npos));
+        // No latency unless it's being measured
+        assert(prom.find("amp_message_latency_us") == string::npos);
+        assert(!doc.contains("latency"));
+
+        // A mailbox's direction: waits of 100us, 120us with the consumer
+        amp::LatencyProbe probe;
+        unsigned path = probe.addPath("line10");
+        for (unsigned i = 0; i < 10; i++) {
+            amp::LatencyStamp stamp;
+            stamp.mark(amp::LatencyStamp::CAPTURE, 1000);
+            stamp.mark(amp::LatencyStamp::QUEUED, 1100);
+            stamp.mark(amp::LatencyStamp::SENT, 1120);
+            probe.record(path, stamp);
+        }
+        doc = json::parse(amp::renderMetricsJson(shards, &probe));
+        assert(doc["latency"].size() == 1);
+        assert(doc["latency"][0]["path"] == "line10");
+        assert(doc["latency"][0]["input"]["count"] == 10);
+        assert(doc["latency"][0]["input"]["maxUs"] == 100);
+        assert(doc["latency"][0]["total"]["maxUs"] == 120);
+        assert(doc["latency"][0]["jitter"]["count"] == 0);
+        prom = amp::renderMetricsPrometheus(shards, &probe);
+        assert(has("# TYPE amp_message_latency_us histogram"));
+        assert(has("amp_message_latency_us_bucket{path=\"line10\",stage=\"input\",le=\"50\"} 0"));
+        assert(has("amp_message_latency_us_bucket{path=\"line10\",stage=\"input\",le=\"250\"} 10"));
+        assert(has("amp_message_latency_us_count{path=\"line10\",stage=\"total\"} 10"));
+        assert(has("amp_message_latency_us_count{path=\"line10\",stage=\"jitter\"} 0"));
+    }
+    cout << "OK" << endl;
+}
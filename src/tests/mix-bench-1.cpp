@@ -0,0 +1,89 @@
+/**
+ * Measures the conference mix cost (ns per frame) for 2, 8, 32, and 128
+ * participants using each MixKernel implementation that the CPU supports,
+ * along with the O(N^2) scalar mix for comparison.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "MixKernel.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+static const unsigned FRAME_LEN = 320;
+
+static void naiveMix(unsigned n, const int16_t* const* inputs, const int16_t* gains,
+    int16_t* const* outputs, unsigned frameLen) {
+    for (unsigned i = 0; i < n; i++) {
+        for (unsigned k = 0; k < frameLen; k++) {
+            int32_t acc = 0;
+            for (unsigned j = 0; j < n; j++)
+                if (j != i && inputs[j])
+                    acc += ((int32_t)inputs[j][k] * gains[j]) >> 12;
+            outputs[i][k] = acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc);
+        }
+    }
+}
+
+/**
+ * Runs the function repeatedly for about 200ms.
+ * @returns ns per call
+ */
+template<typename F> static double timeIt(F f) {
+    unsigned iterations = 0;
+    auto start = chrono::steady_clock::now();
+    auto end = start;
+    do {
+        for (unsigned i = 0; i < 16; i++)
+            f();
+        iterations += 16;
+        end = chrono::steady_clock::now();
+    } while (end - start < chrono::milliseconds(200));
+    return (double)chrono::duration_cast<chrono::nanoseconds>(end - start).count() / iterations;
+}
+
+int main(int, const char**) {
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> sample(-4000, 4000);
+
+    cout << "Frame length " << FRAME_LEN << " samples" << endl;
+
+    for (unsigned n : { 2u, 8u, 32u, 128u }) {
+
+        std::vector<std::vector<int16_t>> in(n, std::vector<int16_t>(FRAME_LEN));
+        std::vector<std::vector<int16_t>> out(n, std::vector<int16_t>(FRAME_LEN));
+        std::vector<const int16_t*> inPtrs(n);
+        std::vector<int16_t*> outPtrs(n);
+        std::vector<int16_t> gains(n, amp::MixKernel::UNITY_GAIN);
+        for (unsigned i = 0; i < n; i++) {
+            for (unsigned k = 0; k < FRAME_LEN; k++)
+                in[i][k] = sample(rng);
+            inPtrs[i] = in[i].data();
+            outPtrs[i] = out[i].data();
+        }
+
+        double ns = timeIt([&]() { 
+            naiveMix(n, inPtrs.data(), gains.data(), outPtrs.data(), FRAME_LEN);
+        });
+        cout << "participants=" << n << " impl=naive ns/frame=" << (uint64_t)ns << endl;
+
+        for (auto impl : { amp::MixKernel::Impl::SCALAR, amp::MixKernel::Impl::SSE41,
+            amp::MixKernel::Impl::AVX2, amp::MixKernel::Impl::NEON }) {
+            if (!amp::isSupported(impl))
+                continue;
+            amp::MixKernel kernel(impl);
+            ns = timeIt([&]() { 
+                kernel.mix(n, inPtrs.data(), gains.data(), outPtrs.data(), nullptr, FRAME_LEN);
+            });
+            cout << "participants=" << n << " impl=" << amp::simdImplName(impl) 
+                << " ns/frame=" << (uint64_t)ns << endl;
+        }
+    }
+}
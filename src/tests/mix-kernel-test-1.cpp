@@ -0,0 +1,82 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "MixKernel.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+/**
+ * The obvious O(N^2) mix, used as the reference.
+ */
+static void naiveMix(unsigned n, const int16_t* const* inputs, const int16_t* gains,
+    int16_t* const* outputs, unsigned frameLen) {
+    for (unsigned i = 0; i < n; i++) {
+        for (unsigned k = 0; k < frameLen; k++) {
+            int32_t acc = 0;
+            for (unsigned j = 0; j < n; j++)
+                if (j != i && inputs[j])
+                    acc += ((int32_t)inputs[j][k] * gains[j]) >> 12;
+            outputs[i][k] = acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc);
+        }
+    }
+}
+
+int main(int, const char**) {
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> sample(-32768, 32767);
+    std::uniform_int_distribution<int> quiet(-2000, 2000);
+    std::uniform_int_distribution<int> gain(0, 2 * amp::MixKernel::UNITY_GAIN);
+
+    const amp::MixKernel::Impl impls[] = { amp::MixKernel::Impl::SCALAR,
+        amp::MixKernel::Impl::SSE41, amp::MixKernel::Impl::AVX2, 
+        amp::MixKernel::Impl::NEON };
+
+    for (auto impl : impls) {
+        if (!amp::isSupported(impl))
+            continue;
+        amp::MixKernel kernel(impl);
+        assert(kernel.getImpl() == impl);
+
+        // Odd frame lengths exercise the scalar tails
+        for (unsigned frameLen : { 160u, 163u, 320u, 960u }) {
+            for (unsigned n : { 1u, 2u, 3u, 8u, 33u }) {
+                for (unsigned trial = 0; trial < 4; trial++) {
+                    // Trial 0 is loud enough to clip
+                    std::vector<std::vector<int16_t>> in(n, std::vector<int16_t>(frameLen));
+                    std::vector<std::vector<int16_t>> out(n, std::vector<int16_t>(frameLen));
+                    std::vector<std::vector<int16_t>> ref(n, std::vector<int16_t>(frameLen));
+                    std::vector<const int16_t*> inPtrs(n);
+                    std::vector<int16_t*> outPtrs(n), refPtrs(n);
+                    std::vector<int16_t> gains(n);
+                    for (unsigned i = 0; i < n; i++) {
+                        for (unsigned k = 0; k < frameLen; k++)
+                            in[i][k] = (trial == 0) ? sample(rng) : quiet(rng);
+                        // Some participants aren't talking
+                        inPtrs[i] = (i % 3 == 2) ? nullptr : in[i].data();
+                        outPtrs[i] = out[i].data();
+                        refPtrs[i] = ref[i].data();
+                        gains[i] = gain(rng);
+                    }
+                    std::vector<int16_t> fullMix(frameLen);
+                    kernel.mix(n, inPtrs.data(), gains.data(), outPtrs.data(), 
+                        fullMix.data(), frameLen);
+                    naiveMix(n, inPtrs.data(), gains.data(), refPtrs.data(), frameLen);
+                    for (unsigned i = 0; i < n; i++) {
+                        assert(out[i] == ref[i]);
+                        // Someone who isn't talking hears the full mix
+                        if (!inPtrs[i])
+                            assert(out[i] == fullMix);
+                    }
+                }
+            }
+        }
+        cout << amp::simdImplName(impl) << " OK" << endl;
+    }
+}
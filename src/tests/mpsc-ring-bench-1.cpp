@@ -0,0 +1,130 @@
+/**
+ * A microbenchmark that compares the lock-free MpscRing with the
+ * mutex-protected threadsafequeue2 for 1, 2, and 8 producers feeding
+ * a single consumer. The item is about the size of a 20ms 8K audio frame.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "kc1fsz-tools/threadsafequeue2.h"
+
+#include "MpscRing.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+struct Item {
+    uint64_t stampNs;
+    uint32_t producer;
+    uint32_t seq;
+    uint8_t payload[320];
+};
+
+static uint64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const unsigned ITEMS_PER_PRODUCER = 200000;
+
+struct Result {
+    double itemsPerSec;
+    uint64_t pushNsAvg;
+    uint64_t latencyNsP50;
+    uint64_t latencyNsP99;
+};
+
+/**
+ * @param push Function that returns false if the item could not be queued.
+ * @param pop Function that returns false if nothing was waiting.
+ */
+template<typename PushFn, typename PopFn>
+static Result run(unsigned producerCount, PushFn push, PopFn pop) {
+
+    std::atomic<bool> go = false;
+    std::atomic<uint64_t> pushNsTotal = 0;
+    std::vector<std::thread> producers;
+
+    for (unsigned p = 0; p < producerCount; p++) {
+        producers.emplace_back([p, &go, &pushNsTotal, &push]() {
+            Item item;
+            memset(item.payload, p, sizeof(item.payload));
+            item.producer = p;
+            while (!go.load());
+            uint64_t total = 0;
+            for (unsigned i = 0; i < ITEMS_PER_PRODUCER; i++) {
+                item.seq = i;
+                item.stampNs = nowNs();
+                while (!push(item))
+                    std::this_thread::yield();
+                total += nowNs() - item.stampNs;
+            }
+            pushNsTotal.fetch_add(total);
+        });
+    }
+
+    const unsigned expected = producerCount * ITEMS_PER_PRODUCER;
+    std::vector<uint64_t> latencies;
+    latencies.reserve(expected);
+    std::vector<uint32_t> lastSeq(producerCount, 0);
+
+    uint64_t start = nowNs();
+    go.store(true);
+    Item item;
+    while (latencies.size() < expected) {
+        if (pop(item)) {
+            latencies.push_back(nowNs() - item.stampNs);
+            // Per-producer ordering must be preserved
+            assert(item.seq == 0 || item.seq > lastSeq[item.producer]);
+            lastSeq[item.producer] = item.seq;
+        }
+    }
+    uint64_t elapsed = nowNs() - start;
+
+    for (auto& t : producers)
+        t.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    Result r;
+    r.itemsPerSec = (double)expected / ((double)elapsed / 1e9);
+    r.pushNsAvg = pushNsTotal.load() / expected;
+    r.latencyNsP50 = latencies[expected / 2];
+    r.latencyNsP99 = latencies[(expected * 99) / 100];
+    return r;
+}
+
+static void report(const char* name, unsigned producers, const Result& r) {
+    cout << name << " producers=" << producers
+        << " items/s=" << (uint64_t)r.itemsPerSec
+        << " push_ns_avg=" << r.pushNsAvg
+        << " latency_ns_p50=" << r.latencyNsP50
+        << " latency_ns_p99=" << r.latencyNsP99 << endl;
+}
+
+int main(int, const char**) {
+    for (unsigned producers : { 1, 2, 8 }) {
+        {
+            auto ring = std::make_unique<amp::MpscRing<Item, 1024>>();
+            Result r = run(producers,
+                [&ring](const Item& item) { return ring->push(item); },
+                [&ring](Item& item) { return ring->pop(item); });
+            report("MpscRing", producers, r);
+        }
+        {
+            threadsafequeue2<Item> queue;
+            Result r = run(producers,
+                [&queue](const Item& item) { queue.push(item); return true; },
+                [&queue](Item& item) { return queue.try_pop(item); });
+            report("threadsafequeue2", producers, r);
+        }
+    }
+}
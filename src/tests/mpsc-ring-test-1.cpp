@@ -0,0 +1,91 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "MpscRing.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+int main(int, const char**) {
+    // Basic single-thread behavior
+    {
+        amp::MpscRing<int, 4> ring;
+        assert(ring.empty());
+        assert(ring.push(1));
+        assert(ring.push(2));
+        assert(ring.push(3));
+        assert(ring.push(4));
+        // Full
+        assert(!ring.push(5));
+        assert(ring.size() == 4);
+        int v;
+        assert(ring.pop(v) && v == 1);
+        assert(ring.push(5));
+        int sum = 0;
+        assert(ring.drain([&sum](const int& x) { sum += x; }) == 4);
+        assert(sum == 2 + 3 + 4 + 5);
+        assert(!ring.pop(v));
+        // Wrapping many times
+        for (int i = 0; i < 1000; i++) {
+            assert(ring.push(i));
+            assert(ring.pop(v) && v == i);
+        }
+        assert(ring.empty());
+    }
+    // Several producers with a small ring so that they keep running into
+    // a full ring and into each other. Everything must arrive exactly
+    // once and in order for each producer.
+    {
+        const unsigned PRODUCERS = 8;
+        const uint32_t COUNT = 50000;
+        auto ring = std::make_unique<amp::MpscRing<uint64_t, 64>>();
+        std::atomic<bool> go = false;
+        std::atomic<uint32_t> fullCount = 0;
+        vector<thread> producers;
+        for (unsigned p = 0; p < PRODUCERS; p++) {
+            producers.emplace_back([p, &ring, &go, &fullCount]() {
+                while (!go.load())
+                    this_thread::yield();
+                for (uint32_t i = 0; i < COUNT; i++) {
+                    const uint64_t item = ((uint64_t)p << 32) | i;
+                    while (!ring->push(item)) {
+                        fullCount++;
+                        this_thread::yield();
+                    }
+                }
+            });
+        }
+        vector<uint32_t> next(PRODUCERS, 0);
+        uint64_t received = 0;
+        go.store(true);
+        while (received < (uint64_t)PRODUCERS * COUNT) {
+            unsigned n = ring->drain([&next, &received](const uint64_t& item) {
+                const unsigned p = item >> 32;
+                assert(p < PRODUCERS);
+                // Nothing lost, duplicated or reordered
+                assert((uint32_t)item == next[p]);
+                next[p]++;
+                received++;
+            });
+            if (n == 0)
+                this_thread::yield();
+        }
+        for (thread& t : producers)
+            t.join();
+        for (unsigned p = 0; p < PRODUCERS; p++)
+            assert(next[p] == COUNT);
+        assert(ring->empty());
+        uint64_t item;
+        assert(!ring->pop(item));
+        // The full path was exercised
+        assert(fullCount > 0);
+    }
+    cout << "OK" << endl;
+}
@@ -0,0 +1,211 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <assert.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "NodeDb.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+static amp::NodeDb::Entry makeEntry(const string& node, const char* ip, uint16_t port,
+    const string& user = "", const string& password = "") {
+    amp::NodeDb::Entry e;
+    e.node = node;
+    memset(&e.addr, 0, sizeof(e.addr));
+    sockaddr_in& a = (sockaddr_in&)e.addr;
+    a.sin_family = AF_INET;
+    inet_pton(AF_INET, ip, &a.sin_addr);
+    a.sin_port = htons(port);
+    e.user = user;
+    e.password = password;
+    return e;
+}
+
+static string addrString(const sockaddr_storage& addr) {
+    char buf[64];
+    if (addr.ss_family == AF_INET6) {
+        const sockaddr_in6& a = (const sockaddr_in6&)addr;
+        inet_ntop(AF_INET6, &a.sin6_addr, buf, sizeof(buf));
+        return "[" + string(buf) + "]:" + to_string(ntohs(a.sin6_port));
+    }
+    const sockaddr_in& a = (const sockaddr_in&)addr;
+    inet_ntop(AF_INET, &a.sin_addr, buf, sizeof(buf));
+    return string(buf) + ":" + to_string(ntohs(a.sin_port));
+}
+
+int main(int, const char**) {
+
+    const string dbName = "/tmp/node-db-test-1.db";
+    const string textName = "/tmp/node-db-test-1.txt";
+
+    // Text form
+    {
+        istringstream str(
+            "# A comment\n"
+            "\n"
+            "2000 192.168.8.143 bruce hello\n"
+            "  61057   10.0.0.1:4570  # Trailing comment\n"
+            "1999 [2001:db8::1]:4571 radio\n"
+            "1998 2001:db8::2\n");
+        vector<amp::NodeDb::Entry> entries;
+        assert(amp::NodeDb::parseText(str, entries) == 0);
+        assert(entries.size() == 4);
+        assert(entries[0].node == "2000");
+        assert(addrString(entries[0].addr) == "192.168.8.143:4569");
+        assert(entries[0].user == "bruce" && entries[0].password == "hello");
+        assert(addrString(entries[1].addr) == "10.0.0.1:4570");
+        assert(entries[1].user.empty());
+        assert(addrString(entries[2].addr) == "[2001:db8::1]:4571");
+        assert(entries[2].user == "radio" && entries[2].password.empty());
+        assert(addrString(entries[3].addr) == "[2001:db8::2]:4569");
+    }
+    // Bad lines are reported by number
+    {
+        const char* bad[] = {
+            "2000\n",
+            "2000 host.example.com\n",
+            "2000 1.2.3.4:0\n",
+            "2000 1.2.3.4:99999\n",
+            "2000 [::1\n",
+            "2000 1.2.3.4 user password extra\n",
+            "0123456789abcdef 1.2.3.4\n",
+        };
+        for (const char* line : bad) {
+            istringstream str(string("1 1.2.3.4\n") + line);
+            vector<amp::NodeDb::Entry> entries;
+            assert(amp::NodeDb::parseText(str, entries) == 2);
+        }
+    }
+
+    // Write, map and look up
+    {
+        vector<amp::NodeDb::Entry> entries;
+        entries.push_back(makeEntry("2000", "192.168.8.143", 4569, "bruce", "hello"));
+        entries.push_back(makeEntry("61057", "10.0.0.1", 4570));
+        // The last one wins
+        entries.push_back(makeEntry("2000", "192.168.8.144", 4569, "bruce", "hello2"));
+        assert(amp::NodeDb::write(dbName.c_str(), entries) == 0);
+
+        amp::NodeDb db;
+        assert(!db.isOpen());
+        assert(db.find("2000") == nullptr);
+        assert(db.open(dbName.c_str()) == 0);
+        assert(db.isOpen());
+        assert(db.getCount() == 2);
+        assert(db.getBucketCount() == 16);
+        const amp::NodeDb::Record* r = db.find("2000");
+        assert(r);
+        assert(strcmp(r->user, "bruce") == 0);
+        assert(strcmp(r->password, "hello2") == 0);
+        sockaddr_storage addr;
+        r->getAddr(addr);
+        assert(addrString(addr) == "192.168.8.144:4569");
+        r = db.find("61057");
+        assert(r);
+        r->getAddr(addr);
+        assert(addrString(addr) == "10.0.0.1:4570");
+        assert(db.find("61058") == nullptr);
+        assert(db.find("") == nullptr);
+        // The whole table can be walked
+        unsigned used = 0;
+        for (unsigned i = 0; i < db.getBucketCount(); i++)
+            if (db.getBucket(i).node[0])
+                used++;
+        assert(used == 2);
+        db.close();
+        assert(!db.isOpen());
+        assert(db.find("2000") == nullptr);
+    }
+
+    // Entries that don't fit
+    {
+        vector<amp::NodeDb::Entry> entries;
+        entries.push_back(makeEntry("2000", "1.2.3.4", 4569, string(32, 'u')));
+        assert(amp::NodeDb::write(dbName.c_str(), entries) == -1);
+        entries[0] = makeEntry("", "1.2.3.4", 4569);
+        assert(amp::NodeDb::write(dbName.c_str(), entries) == -1);
+    }
+
+    // The text form opens the same way
+    {
+        ofstream str(textName);
+        str << "2000 192.168.8.143 bruce hello" << endl;
+        str << "1999 [2001:db8::1]:4571" << endl;
+        str.close();
+        amp::NodeDb db;
+        assert(db.open(textName.c_str()) == 0);
+        assert(db.getCount() == 2);
+        const amp::NodeDb::Record* r = db.find("1999");
+        assert(r);
+        sockaddr_storage addr;
+        r->getAddr(addr);
+        assert(addrString(addr) == "[2001:db8::1]:4571");
+
+        ofstream bad(textName);
+        bad << "2000 not-an-address" << endl;
+        bad.close();
+        assert(db.open(textName.c_str()) == -1);
+        assert(!db.isOpen());
+        assert(db.open("/tmp/node-db-test-1.missing") == -1);
+    }
+
+    // A damaged file is refused
+    {
+        vector<amp::NodeDb::Entry> entries;
+        entries.push_back(makeEntry("2000", "1.2.3.4", 4569));
+        assert(amp::NodeDb::write(dbName.c_str(), entries) == 0);
+        {
+            ifstream in(dbName, ios::binary);
+            string all((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+            in.close();
+            ofstream out(dbName, ios::binary | ios::trunc);
+            out.write(all.data(), all.size() - 1);
+        }
+        amp::NodeDb db;
+        assert(db.open(dbName.c_str()) == -1);
+    }
+
+    // A large database: every node is found, nothing else is
+    {
+        const unsigned N = 100000;
+        vector<amp::NodeDb::Entry> entries;
+        for (unsigned i = 0; i < N; i++) {
+            char ip[32];
+            snprintf(ip, sizeof(ip), "10.%u.%u.%u", (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff);
+            entries.push_back(makeEntry(to_string(2000 + i), ip, 4569));
+        }
+        assert(amp::NodeDb::write(dbName.c_str(), entries) == 0);
+        amp::NodeDb db;
+        assert(db.open(dbName.c_str()) == 0);
+        assert(db.getCount() == N);
+        assert(db.getBucketCount() == 262144);
+
+        auto start = chrono::steady_clock::now();
+        unsigned found = 0;
+        for (unsigned i = 0; i < N; i++) {
+            const amp::NodeDb::Record* r = db.find(to_string(2000 + i).c_str());
+            if (r && ((const uint8_t*)r->addr)[3] == (i & 0xff))
+                found++;
+        }
+        for (unsigned i = N; i < 2 * N; i++)
+            assert(db.find(to_string(2000 + i).c_str()) == nullptr);
+        auto us = chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now() - start).count();
+        assert(found == N);
+        cout << "Lookup " << (double)us * 1000.0 / (2 * N) << " ns" << endl;
+    }
+
+    remove(dbName.c_str());
+    remove(textName.c_str());
+
+    cout << "OK" << endl;
+}
@@ -0,0 +1,89 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "LatencyProbe.h"
+#include "ReplayHarness.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+int main(int, const char**) {
+
+    // Capture parsing
+    {
+        stringstream str(
+            "1000000, RXV, 100\n"
+            "1020500, RXV, 120\n"
+            "1030000, POV, 100\n"
+            "1041000, RXV, 140, 7\n"
+            "1050000, UNK\n"
+            "\n");
+        std::vector<amp::ReplayEvent> events;
+        assert(amp::ReplayHarness::loadCapture(str, events) == 4);
+        assert(events[0].timeUs == 1000000);
+        assert(events[0].type == amp::ReplayEvent::Type::VOICE);
+        assert(events[0].originMs == 100);
+        assert(events[0].callId == 0);
+        assert(events[2].callId == 7);
+        assert(events[3].type == amp::ReplayEvent::Type::UNKEY);
+
+        amp::ReplayHarness::Report r = amp::ReplayHarness::run(events);
+        assert(r.calls == 2);
+        assert(r.jb.received == 3);
+        assert(r.jb.played == 3);
+
+        stringstream bad("abc, RXV, 100\n");
+        assert(amp::ReplayHarness::loadCapture(bad, events) == -1);
+    }
+
+    // Generated timeline: every frame is accounted for and the same 
+    // timeline always gives the same result.
+    {
+        amp::ReplayHarness::SynthOptions opts;
+        opts.calls = 20;
+        opts.seconds = 30;
+        opts.flightVariance = 30;
+        opts.lossPct = 2;
+        std::vector<amp::ReplayEvent> events;
+        amp::ReplayHarness::synthesize(opts, events);
+
+        amp::ReplayHarness::Report r1 = amp::ReplayHarness::run(events);
+        amp::ReplayHarness::Report r2 = amp::ReplayHarness::run(events);
+        assert(r1.calls == 20);
+        assert(r1.simulatedSec > 30);
+        const amp::JitterBuffer::Stats& s = r1.jb;
+        assert(s.received == s.played + s.late + s.duplicate + s.overflow + s.dropped);
+        assert(s.concealed > 0);
+        assert(r1.latencyMs.size() == s.played);
+        assert(r1.latencyPercentile(50) <= r1.latencyPercentile(99));
+        assert(r1.latencyPercentile(99) < 200);
+        assert(r1.encodes + r1.encodesSaved == r1.ticks * r1.calls);
+        assert(r2.jb.played == s.played && r2.jb.late == s.late && 
+            r2.jb.concealed == s.concealed && r2.latencyMs == r1.latencyMs);
+
+        // The probe sees every played frame, and the jitter stage agrees 
+        // with the harness's own latency (to within the histogram's 
+        // resolution).
+        amp::LatencyProbe probe;
+        amp::ReplayHarness::Report r3 = amp::ReplayHarness::run(events, nullptr, &probe);
+        assert(probe.getPathCount() == 1);
+        const amp::LatencyHistogram& jitter = probe.getHistogram(0, amp::LatencyProbe::JITTER);
+        assert(jitter.getCount() == r3.jb.played);
+        assert(probe.getHistogram(0, amp::LatencyProbe::TOTAL).getCount() == r3.jb.played);
+        assert(probe.getHistogram(0, amp::LatencyProbe::INPUT).getMaxUs() == 0);
+        assert(jitter.getMaxUs() / 1000 <= r3.latencyPercentile(100) + 1);
+        assert(jitter.percentileUs(99) / 1000 + 1 >= r3.latencyPercentile(99) * 0.94);
+        assert(probe.getHistogram(0, amp::LatencyProbe::BRIDGE).getMaxUs() < 100000);
+
+        cout << "played " << s.played << " late " << s.late << " concealed " 
+            << s.concealed << " p99 " << r1.latencyPercentile(99) << " ms, "
+            << r1.cpuUsPerCallSecond() << " us/call-second" << endl;
+    }
+
+    cout << "OK" << endl;
+}
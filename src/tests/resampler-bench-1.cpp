@@ -0,0 +1,57 @@
+/**
+ * Measures the PolyphaseResampler cost (ns per 20ms frame) for each rate 
+ * conversion and quality setting using each implementation that the CPU 
+ * supports.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "PolyphaseResampler.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+using Quality = amp::PolyphaseResampler::Quality;
+
+int main(int, const char**) {
+
+    const unsigned rates[][2] = { { 8000, 16000 }, { 8000, 48000 }, { 16000, 48000 },
+        { 16000, 8000 }, { 48000, 8000 }, { 48000, 16000 } };
+
+    for (auto rate : rates) {
+        const unsigned inLen = rate[0] / 50;
+        std::vector<int16_t> in(inLen), out(amp::PolyphaseResampler::MAX_FRAME_LEN);
+        for (unsigned i = 0; i < inLen; i++)
+            in[i] = lrint(10000 * sin(2.0 * M_PI * 1000 * i / rate[0]));
+
+        for (Quality q : { Quality::LOW, Quality::MEDIUM, Quality::HIGH }) {
+            for (amp::SimdImpl impl : { amp::SimdImpl::SCALAR, amp::SimdImpl::AVX2, 
+                amp::SimdImpl::NEON }) {
+                if (!amp::isSupported(impl))
+                    continue;
+                amp::PolyphaseResampler r(impl);
+                r.setRates(rate[0], rate[1], q);
+                unsigned iterations = 0;
+                auto start = chrono::steady_clock::now();
+                auto end = start;
+                do {
+                    for (unsigned i = 0; i < 64; i++)
+                        r.process(in.data(), inLen, out.data());
+                    iterations += 64;
+                    end = chrono::steady_clock::now();
+                } while (end - start < chrono::milliseconds(200));
+                double ns = (double)chrono::duration_cast<chrono::nanoseconds>(end - start).count() 
+                    / iterations;
+                cout << rate[0] << " -> " << rate[1] 
+                    << " taps/phase=" << amp::PolyphaseResampler::tapsPerPhase(q)
+                    << " impl=" << amp::simdImplName(r.getImpl()) 
+                    << " ns/frame=" << (uint64_t)ns << endl;
+            }
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ * SNR harness for the PolyphaseResampler. Tones in the passband are 
+ * resampled and compared against the ideal signal at the output rate
+ * (shifted by the filter delay). Also checks that the vectorized
+ * implementations match the scalar one.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "PolyphaseResampler.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+using Quality = amp::PolyphaseResampler::Quality;
+
+/**
+ * @returns SNR in dB
+ */
+static double measureSnr(amp::SimdImpl impl, unsigned inRate, unsigned outRate, 
+    Quality quality, double toneHz, std::vector<int16_t>* capture = nullptr) {
+
+    amp::PolyphaseResampler r(impl);
+    assert(r.setRates(inRate, outRate, quality) == 0);
+
+    const unsigned inLen = inRate / 50;
+    const unsigned outLen = r.getOutputLen(inLen);
+    const unsigned frames = 50;
+    const double amp = 16000;
+
+    double signal = 0, noise = 0;
+    std::vector<int16_t> in(inLen), out(outLen);
+    for (unsigned f = 0; f < frames; f++) {
+        for (unsigned i = 0; i < inLen; i++) {
+            double t = (double)(f * inLen + i) / inRate;
+            in[i] = lrint(amp * sin(2.0 * M_PI * toneHz * t));
+        }
+        assert(r.process(in.data(), inLen, out.data()) == outLen);
+        if (capture)
+            capture->insert(capture->end(), out.begin(), out.end());
+        // Let the filter settle
+        if (f < 2)
+            continue;
+        for (unsigned i = 0; i < outLen; i++) {
+            double t = ((double)(f * outLen + i) - r.getDelay()) / outRate;
+            double ideal = amp * sin(2.0 * M_PI * toneHz * t);
+            signal += ideal * ideal;
+            noise += (out[i] - ideal) * (out[i] - ideal);
+        }
+    }
+    return 10.0 * log10(signal / noise);
+}
+
+int main(int, const char**) {
+
+    struct Case {
+        unsigned inRate, outRate;
+    };
+    const Case cases[] = { { 8000, 16000 }, { 8000, 48000 }, { 16000, 48000 },
+        { 16000, 8000 }, { 48000, 8000 }, { 48000, 16000 } };
+    // Minimum SNR expected for each quality setting
+    const double minSnr[] = { 25, 60, 75 };
+
+    for (const Case& c : cases) {
+        for (Quality q : { Quality::LOW, Quality::MEDIUM, Quality::HIGH }) {
+            double worst = 1000;
+            // Tones across the voice passband of the lower rate
+            unsigned lowRate = std::min(c.inRate, c.outRate);
+            for (double tone : { 300.0, 1000.0, 0.25 * lowRate }) {
+                double snr = measureSnr(amp::SimdImpl::SCALAR, c.inRate, c.outRate, q, tone);
+                worst = std::min(worst, snr);
+            }
+            cout << c.inRate << " -> " << c.outRate << " taps/phase=" 
+                << amp::PolyphaseResampler::tapsPerPhase(q) 
+                << " worst SNR=" << worst << " dB" << endl;
+            assert(worst > minSnr[(int)q]);
+        }
+    }
+
+    // A tone above the Nyquist frequency of the output must be rejected
+    {
+        double snr = measureSnr(amp::SimdImpl::SCALAR, 48000, 8000, Quality::HIGH, 6000);
+        // Nearly all of the "signal" should be gone, which shows up as an 
+        // SNR near 0 dB when compared with the (unfiltered) ideal.
+        assert(snr < 1);
+    }
+
+    // The vectorized implementations match the scalar one to within rounding
+    for (amp::SimdImpl impl : { amp::SimdImpl::AVX2, amp::SimdImpl::NEON }) {
+        if (!amp::isSupported(impl))
+            continue;
+        for (const Case& c : cases) {
+            std::vector<int16_t> a, b;
+            measureSnr(amp::SimdImpl::SCALAR, c.inRate, c.outRate, Quality::HIGH, 1000, &a);
+            measureSnr(impl, c.inRate, c.outRate, Quality::HIGH, 1000, &b);
+            assert(a.size() == b.size());
+            for (unsigned i = 0; i < a.size(); i++)
+                assert(std::abs(a[i] - b[i]) <= 1);
+        }
+        cout << amp::simdImplName(impl) << " matches scalar" << endl;
+    }
+}
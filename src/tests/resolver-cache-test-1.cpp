@@ -0,0 +1,341 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <assert.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ResolverCache.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+/**
+ * Stands in for DNS. Node "9xxx" doesn't exist, "8xxx" fails to resolve
+ * and everything else resolves to 10.0.x.y:4569 plus the version.
+ */
+struct FakeDns {
+    std::mutex mutex;
+    map<string, unsigned> queries;
+    unsigned version = 0;
+    bool down = false;
+    unsigned delayMs = 0;
+
+    int resolve(const string& node, sockaddr_storage& addr) {
+        if (delayMs)
+            this_thread::sleep_for(chrono::milliseconds(delayMs));
+        std::lock_guard<std::mutex> lock(mutex);
+        queries[node]++;
+        if (down || node[0] == '8')
+            return -1;
+        if (node[0] == '9')
+            return 1;
+        sockaddr_in& a = (sockaddr_in&)addr;
+        a.sin_family = AF_INET;
+        const unsigned n = stoi(node);
+        a.sin_addr.s_addr = htonl((10 << 24) | (n & 0xffff));
+        a.sin_port = htons(4569 + version);
+        return 0;
+    }
+
+    unsigned count(const string& node) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queries[node];
+    }
+};
+
+static unsigned portOf(const sockaddr_storage& addr) {
+    return ntohs(((const sockaddr_in&)addr).sin_port);
+}
+
+/**
+ * @param p In the range 0-100.
+ */
+static long percentile(vector<long> samples, double p) {
+    size_t i = std::min(samples.size() - 1, (size_t)(p / 100.0 * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + i, samples.end());
+    return samples[i];
+}
+
+int main(int, const char**) {
+
+    using RC = amp::ResolverCache;
+
+    // Everything with a fake clock, resolved on this thread
+    {
+        FakeDns dns;
+        uint64_t now = 1000000;
+        RC::Options opts;
+        opts.ttlMs = 300000;
+        opts.staleMs = 3600000;
+        opts.negativeTtlMs = 60000;
+        opts.retryMs = 10000;
+        opts.refreshAheadMs = 30000;
+        RC cache([&dns](const string& n, sockaddr_storage& a) { return dns.resolve(n, a); },
+            opts, [&now]() { return now; });
+        sockaddr_storage addr;
+
+        // The first lookup misses and queues a query, the second one
+        // doesn't queue another
+        assert(cache.lookup("2000", addr) == RC::Result::MISS);
+        assert(cache.lookup("2000", addr) == RC::Result::MISS);
+        assert(cache.service() == 1);
+        assert(dns.count("2000") == 1);
+        assert(cache.lookup("2000", addr) == RC::Result::HIT);
+        assert(portOf(addr) == 4569);
+        assert(cache.service() == 0);
+
+        // Negative caching
+        assert(cache.lookup("9000", addr) == RC::Result::MISS);
+        cache.service();
+        for (unsigned i = 0; i < 10; i++)
+            assert(cache.lookup("9000", addr) == RC::Result::NEGATIVE);
+        assert(dns.count("9000") == 1);
+        now += 60000;
+        assert(cache.lookup("9000", addr) == RC::Result::MISS);
+        cache.service();
+        assert(dns.count("9000") == 2);
+
+        // A failed query isn't cached for long
+        assert(cache.lookup("8000", addr) == RC::Result::MISS);
+        cache.service();
+        assert(cache.lookup("8000", addr) == RC::Result::NEGATIVE);
+        now += 10000;
+        assert(cache.lookup("8000", addr) == RC::Result::MISS);
+        cache.service();
+
+        // Past the TTL the old address is still used while a new one
+        // is fetched
+        now += 300000;
+        dns.version = 1;
+        assert(cache.lookup("2000", addr) == RC::Result::HIT);
+        assert(portOf(addr) == 4569);
+        assert(cache.getStats().staleHits == 1);
+        cache.service();
+        assert(dns.count("2000") == 2);
+        assert(cache.lookup("2000", addr) == RC::Result::HIT);
+        assert(portOf(addr) == 4570);
+
+        // A node that is in use is refreshed before it expires
+        now += 280000;
+        assert(cache.lookup("2000", addr) == RC::Result::HIT);
+        cache.service();
+        assert(dns.count("2000") == 3);
+        assert(cache.getStats().refreshes == 1);
+        // And one that isn't is left alone
+        now += 300000;
+        cache.service();
+        assert(dns.count("2000") == 3);
+
+        // A failed refresh keeps the old address and waits retryMs
+        now += 10000;
+        dns.down = true;
+        assert(cache.lookup("2000", addr) == RC::Result::HIT);
+        cache.service();
+        assert(dns.count("2000") == 4);
+        assert(cache.lookup("2000", addr) == RC::Result::HIT);
+        assert(portOf(addr) == 4570);
+        now += 1000;
+        cache.service();
+        assert(dns.count("2000") == 4);
+        now += 10000;
+        assert(cache.lookup("2000", addr) == RC::Result::HIT);
+        dns.down = false;
+        cache.service();
+        assert(dns.count("2000") == 5);
+        assert(cache.getStats().queryFailures == 3);
+
+        // Too old to use
+        now += 300000 + 3600000;
+        assert(cache.lookup("2000", addr) == RC::Result::MISS);
+        cache.service();
+        assert(cache.lookup("2000", addr) == RC::Result::HIT);
+
+        // Prefetch
+        cache.prefetch("2001");
+        cache.service();
+        assert(cache.lookup("2001", addr) == RC::Result::HIT);
+        assert(dns.count("2001") == 1);
+        cache.prefetch("2001");
+        assert(cache.service() == 0);
+
+        // Unused entries are evicted
+        const unsigned before = cache.getStats().entries;
+        const uint64_t evicted = cache.getStats().evictions;
+        assert(before >= 2);
+        now += 2 * 3600000;
+        cache.service();
+        assert(cache.getStats().entries == 0);
+        assert(cache.getStats().evictions == evicted + before);
+    }
+
+    // The size limit
+    {
+        FakeDns dns;
+        RC::Options opts;
+        opts.maxEntries = 10;
+        RC cache([&dns](const string& n, sockaddr_storage& a) { return dns.resolve(n, a); },
+            opts);
+        sockaddr_storage addr;
+        for (unsigned i = 0; i < 20; i++)
+            assert(cache.lookup(to_string(3000 + i).c_str(), addr) == RC::Result::MISS);
+        assert(cache.service() == 10);
+        assert(cache.getStats().entries == 10);
+    }
+
+    // Saved and loaded across a restart
+    {
+        const string fileName = "/tmp/resolver-cache-test-1.db";
+        FakeDns dns;
+        uint64_t now = 5000;
+        RC::Options opts;
+        {
+            RC cache([&dns](const string& n, sockaddr_storage& a) { return dns.resolve(n, a); },
+                opts, [&now]() { return now; });
+            sockaddr_storage addr;
+            cache.lookup("2000", addr);
+            cache.lookup("2001", addr);
+            cache.lookup("9000", addr);
+            cache.service();
+            assert(cache.save(fileName.c_str()) == 0);
+        }
+        {
+            RC cache([&dns](const string& n, sockaddr_storage& a) { return dns.resolve(n, a); },
+                opts, [&now]() { return now; });
+            assert(cache.load(fileName.c_str()) == 2);
+            // Used right away, then refreshed
+            sockaddr_storage addr;
+            assert(cache.lookup("2001", addr) == RC::Result::HIT);
+            assert(portOf(addr) == 4569);
+            assert(cache.lookup("9000", addr) == RC::Result::MISS);
+            assert(cache.service() == 2);
+            assert(dns.count("2001") == 2);
+            // Not used, so not refreshed
+            assert(dns.count("2000") == 1);
+            assert(cache.load("/tmp/resolver-cache-test-1.missing") == -1);
+        }
+        remove(fileName.c_str());
+    }
+
+    // A link storm on the background threads: many callers, one query
+    // per node, and the lookups never wait on the (slow) resolver
+    {
+        FakeDns dns;
+        dns.delayMs = 20;
+        RC::Options opts;
+        RC cache([&dns](const string& n, sockaddr_storage& a) { return dns.resolve(n, a); },
+            opts);
+        cache.start(4);
+        const unsigned NODES = 100;
+        std::atomic<unsigned> hits = 0;
+        std::mutex samplesMutex;
+        vector<long> samples;
+        vector<thread> callers;
+        for (unsigned t = 0; t < 8; t++) {
+            callers.emplace_back([&cache, &hits, &samplesMutex, &samples, t]() {
+                sockaddr_storage addr;
+                vector<long> mine;
+                for (unsigned pass = 0; pass < 50; pass++) {
+                    for (unsigned i = 0; i < NODES; i++) {
+                        auto start = chrono::steady_clock::now();
+                        RC::Result r = cache.lookup(to_string(4000 + (i + t) % NODES).c_str(), addr);
+                        mine.push_back(chrono::duration_cast<chrono::microseconds>(
+                            chrono::steady_clock::now() - start).count());
+                        if (r == RC::Result::HIT)
+                            hits++;
+                    }
+                    this_thread::sleep_for(chrono::milliseconds(10));
+                }
+                std::lock_guard<std::mutex> lock(samplesMutex);
+                samples.insert(samples.end(), mine.begin(), mine.end());
+            });
+        }
+        for (thread& t : callers)
+            t.join();
+        for (unsigned i = 0; i < 500 && cache.getStats().queries < NODES; i++)
+            this_thread::sleep_for(chrono::milliseconds(10));
+        cache.stop();
+        sockaddr_storage addr;
+        for (unsigned i = 0; i < NODES; i++) {
+            assert(dns.count(to_string(4000 + i)) == 1);
+            assert(cache.lookup(to_string(4000 + i).c_str(), addr) == RC::Result::HIT);
+        }
+        assert(hits > 0);
+        const long p99 = percentile(samples, 99);
+        const long worst = percentile(samples, 100);
+        cout << "Storm hits " << hits << " lookup p99 " << p99 << " us worst "
+            << worst << " us" << endl;
+        // Microseconds, not a query's delay. The worst case also counts
+        // the times that a caller was preempted, so it only has to be
+        // well under one query.
+        assert(p99 < 50);
+        assert(worst < 20000);
+    }
+
+    // A full table, scanned every second and saved over and over while
+    // the lookups go on. Neither one holds the lock for long.
+    {
+        const string fileName = "/tmp/resolver-cache-test-1-full.db";
+        FakeDns dns;
+        std::atomic<uint64_t> now = 1000000;
+        RC::Options opts;
+        RC cache([&dns](const string& n, sockaddr_storage& a) { return dns.resolve(n, a); },
+            opts, [&now]() { return now.load(); });
+        const unsigned NODES = opts.maxEntries;
+        for (unsigned i = 0; i < NODES; i++)
+            cache.prefetch(to_string(100000 + i).c_str());
+        assert(cache.service() == NODES);
+        assert(cache.getStats().entries == NODES);
+
+        std::atomic<bool> done = false;
+        // Each service() is a second later, so each one scans the table
+        thread scanner([&cache, &now, &done]() {
+            while (!done) {
+                now += 1000;
+                cache.service();
+            }
+        });
+        unsigned saves = 0;
+        thread saver([&cache, &done, &saves, &fileName]() {
+            while (!done) {
+                assert(cache.save(fileName.c_str()) == 0);
+                saves++;
+            }
+        });
+        vector<long> samples;
+        sockaddr_storage addr;
+        auto end = chrono::steady_clock::now() + chrono::seconds(2);
+        for (unsigned i = 0; chrono::steady_clock::now() < end; i++) {
+            const string node = to_string(100000 + (i * 7919) % NODES);
+            auto start = chrono::steady_clock::now();
+            RC::Result r = cache.lookup(node.c_str(), addr);
+            samples.push_back(chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now() - start).count());
+            assert(r == RC::Result::HIT);
+        }
+        done = true;
+        scanner.join();
+        saver.join();
+        remove(fileName.c_str());
+
+        const long p99 = percentile(samples, 99);
+        const uint32_t holdUs = cache.getStats().longestHoldUs;
+        cout << "Full table saves " << saves << " lookups " << samples.size()
+            << " p99 " << p99 << " ns longest hold " << holdUs << " us" << endl;
+        assert(saves > 0);
+        assert(p99 < 50000);
+        // Walking the whole table at once takes milliseconds
+        assert(holdUs < 1000);
+    }
+
+    cout << "OK" << endl;
+}
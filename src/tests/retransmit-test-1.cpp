@@ -0,0 +1,280 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "RetransmitRing.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+using R = amp::RetransmitRing;
+
+static unsigned makeFrame(uint8_t* f, uint8_t seq, uint32_t msg, unsigned len) {
+    memset(f, 0, 12);
+    f[8] = seq;
+    for (unsigned i = 12; i < len; i++)
+        f[i] = (uint8_t)(msg * 7 + i);
+    return len;
+}
+
+/**
+ * Lossy network between the two ends of many calls, in simulated time.
+ */
+struct Packet {
+    uint64_t arrivalMs;
+    unsigned call;
+    bool ack;
+    // Frame: seq, ACK: iseq
+    uint8_t seq;
+    std::vector<uint8_t> data;
+
+    bool operator>(const Packet& other) const { return arrivalMs > other.arrivalMs; }
+};
+
+int main(int, const char**) {
+    // Basics
+    {
+        R ring(8, 64);
+        uint8_t f[64];
+        assert(ring.isEmpty());
+        assert(ring.getOldestSentMs() == UINT64_MAX);
+        assert(ring.push(10, f, makeFrame(f, 10, 1, 30), 1000) == 0);
+        assert(ring.push(11, f, makeFrame(f, 11, 2, 40), 1010) == 0);
+        // A gap (an unreliable frame went out as 12)
+        assert(ring.push(13, f, makeFrame(f, 13, 3, 50), 1020) == 0);
+        assert(ring.getCount() == 3);
+        assert(ring.getOldestSentMs() == 1000);
+        // Too long
+        assert(ring.push(14, f, 65, 1030) == -1);
+        // Backwards
+        assert(ring.push(12, f, 20, 1030) == -1);
+        assert(ring.getStats().rejected == 2);
+
+        // Old and future ACKs do nothing
+        assert(ring.ack(10) == 0);
+        assert(ring.ack(9) == 0);
+        assert(ring.ack(15) == 0);
+        assert(ring.getCount() == 3);
+        // Cumulative
+        assert(ring.ack(12) == 2);
+        assert(ring.getCount() == 1);
+        assert(ring.getOldestSentMs() == 1020);
+        // Repeated
+        assert(ring.ack(12) == 0);
+
+        // Retransmits, in-place
+        unsigned sends = 0;
+        assert(ring.retransmitDue(1100, 100, 3, [&](uint8_t*, unsigned) { sends++; }) == 0);
+        assert(ring.retransmitDue(1120, 100, 3, [&](uint8_t* frame, unsigned len) { 
+            assert(len == 50);
+            assert(frame[8] == 13);
+            assert(frame[49] == (uint8_t)(3 * 7 + 49));
+            frame[2] |= 0x80;
+            sends++; 
+        }) == 1);
+        assert(ring.getOldestSentMs() == 1120);
+        assert(ring.retransmitDue(1220, 100, 3, [&](uint8_t* frame, unsigned) { 
+            assert(frame[2] & 0x80);
+            sends++; 
+        }) == 1);
+        // That was the third try
+        assert(ring.retransmitDue(1320, 100, 3, [&](uint8_t*, unsigned) { sends++; }) == -1);
+        assert(sends == 2);
+        assert(ring.getStats().retransmits == 2);
+
+        assert(ring.ack(14) == 1);
+        assert(ring.isEmpty());
+        // The window starts over anywhere once it's empty
+        assert(ring.push(200, f, 20, 2000) == 0);
+        assert(ring.getCount() == 1);
+        ring.clear();
+        assert(ring.isEmpty());
+        assert(ring.getStats().stored == 4);
+        assert(ring.getStats().acked == 3);
+        assert(ring.getStats().highWater == 3);
+    }
+    // Full window and sequence wrap
+    {
+        R ring(8, 64);
+        uint8_t f[64];
+        uint8_t seq = 250;
+        for (unsigned i = 0; i < 8; i++, seq++)
+            assert(ring.push(seq, f, makeFrame(f, seq, i, 20), 0) == 0);
+        assert(ring.push(seq, f, 20, 0) == -1);
+        assert(ring.getCount() == 8);
+        // Acknowledges 250-255 and 0-1
+        assert(ring.ack(2) == 8);
+        assert(ring.push(seq, f, 20, 0) == 0);
+        // A gap that's too big
+        assert(ring.push(seq + 8, f, 20, 0) == -1);
+        assert(ring.push(seq + 7, f, 20, 0) == 0);
+        assert(ring.getCount() == 2);
+        assert(ring.ack(seq + 8) == 2);
+    }
+    // 500 calls with 20% loss in each direction. Each call tries to send
+    // a reliable frame every 100ms (when its window has room, far more 
+    // than a real call) and the far end accepts them strictly in order,
+    // like IAX2. Everything has to arrive exactly once, in order and 
+    // intact.
+    {
+        const unsigned CALLS = 500;
+        const double LOSS = 0.2;
+        const uint32_t RTO_MS = 250;
+        const uint64_t SEND_UNTIL_MS = 60000;
+        const uint64_t END_MS = 70000;
+        const unsigned TICK_MS = 10;
+
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<double> uniform(0, 1);
+        std::uniform_int_distribution<unsigned> delay(20, 80);
+
+        struct Call {
+            R ring;
+            uint8_t oseq = 0;
+            uint32_t nextMsg = 0;
+            uint64_t nextSendMs;
+            // Far end
+            uint8_t rxSeq = 0;
+            uint32_t delivered = 0;
+        };
+        std::unique_ptr<Call[]> calls(new Call[CALLS]);
+        for (unsigned c = 0; c < CALLS; c++)
+            calls[c].nextSendMs = rng() % 100;
+
+        std::priority_queue<Packet, std::vector<Packet>, std::greater<Packet>> net;
+        uint64_t lost = 0, lostFrames = 0, blocked = 0, maxOccupancy = 0, occupancySum = 0, 
+            samples = 0;
+        auto transmit = [&](uint64_t now, unsigned c, bool ack, uint8_t seq, 
+            const uint8_t* data, unsigned len) {
+            if (uniform(rng) < LOSS) {
+                lost++;
+                if (!ack)
+                    lostFrames++;
+                return;
+            }
+            net.push({ now + delay(rng), c, ack, seq, std::vector<uint8_t>(data, data + len) });
+        };
+
+        double ringNs = 0;
+        for (uint64_t now = 0; now <= END_MS; now += TICK_MS) {
+            // Deliveries
+            while (!net.empty() && net.top().arrivalMs <= now) {
+                Packet p = net.top();
+                net.pop();
+                Call& call = calls[p.call];
+                if (p.ack) {
+                    auto t0 = chrono::steady_clock::now();
+                    call.ring.ack(p.seq);
+                    ringNs += chrono::duration_cast<chrono::nanoseconds>(
+                        chrono::steady_clock::now() - t0).count();
+                    continue;
+                }
+                if (p.seq == call.rxSeq) {
+                    // Intact and the next one
+                    uint32_t msg;
+                    memcpy(&msg, p.data.data() + 12, 4);
+                    assert(msg == call.delivered);
+                    for (unsigned i = 16; i < p.data.size(); i++)
+                        assert(p.data[i] == (uint8_t)(msg * 7 + i));
+                    call.rxSeq++;
+                    call.delivered++;
+                }
+                // Duplicates and out-of-order frames are re-acknowledged
+                transmit(now, p.call, true, call.rxSeq, nullptr, 0);
+            }
+            for (unsigned c = 0; c < CALLS; c++) {
+                Call& call = calls[c];
+                auto t0 = chrono::steady_clock::now();
+                int rc = call.ring.retransmitDue(now, RTO_MS, 1000, 
+                    [&](uint8_t* frame, unsigned len) {
+                        frame[2] |= 0x80;
+                        transmit(now, c, false, frame[8], frame, len);
+                    });
+                ringNs += chrono::duration_cast<chrono::nanoseconds>(
+                    chrono::steady_clock::now() - t0).count();
+                assert(rc >= 0);
+                if (now < SEND_UNTIL_MS && now >= call.nextSendMs && 
+                    call.ring.getCount() == call.ring.getSlotCount()) {
+                    call.nextSendMs += 100;
+                    blocked++;
+                }
+                else if (now < SEND_UNTIL_MS && now >= call.nextSendMs) {
+                    call.nextSendMs += 100;
+                    uint8_t f[R::DEFAULT_FRAME_CAPACITY];
+                    const unsigned len = makeFrame(f, call.oseq, call.nextMsg, 
+                        16 + rng() % (R::DEFAULT_FRAME_CAPACITY - 16));
+                    memcpy(f + 12, &call.nextMsg, 4);
+                    t0 = chrono::steady_clock::now();
+                    assert(call.ring.push(call.oseq, f, len, now) == 0);
+                    ringNs += chrono::duration_cast<chrono::nanoseconds>(
+                        chrono::steady_clock::now() - t0).count();
+                    transmit(now, c, false, call.oseq, f, len);
+                    call.oseq++;
+                    call.nextMsg++;
+                }
+                // Every call on every tick, after its sends
+                occupancySum += call.ring.getCount();
+                maxOccupancy = std::max<uint64_t>(maxOccupancy, call.ring.getCount());
+                samples++;
+            }
+        }
+
+        uint64_t stored = 0, acked = 0, retransmits = 0, sent = 0;
+        for (unsigned c = 0; c < CALLS; c++) {
+            const Call& call = calls[c];
+            // Everything got through and was acknowledged
+            assert(call.delivered == call.nextMsg);
+            assert(call.ring.isEmpty());
+            assert(call.ring.getStats().stored == call.nextMsg);
+            assert(call.ring.getStats().acked == call.nextMsg);
+            assert(call.ring.getStats().rejected == 0);
+            assert(call.ring.getStats().highWater <= call.ring.getSlotCount());
+            stored += call.ring.getStats().stored;
+            acked += call.ring.getStats().acked;
+            retransmits += call.ring.getStats().retransmits;
+            sent += call.nextMsg;
+        }
+        const double rate = (double)retransmits / stored;
+        const double meanOccupancy = (double)occupancySum / samples;
+        cout << "frames " << sent << " retransmits/frame " << rate 
+            << " lost packets " << lost << " (frames " << lostFrames << ")"
+            << " blocked sends " << blocked 
+            << " mean occupancy " << meanOccupancy << " max " << maxOccupancy 
+            << " ring ns per call-tick " << ringNs / samples << endl;
+        assert(stored == acked);
+        assert(sent > CALLS * 200);
+
+        // A frame that is acknowledged k ticks after it was stored was
+        // counted in k occupancy samples and resent at every RTO tick 
+        // before that: floor((k - 1) / RTO_TICKS) times. Summed over the 
+        // frames that gives the number of retransmits to within one per
+        // frame.
+        const uint64_t RTO_TICKS = RTO_MS / TICK_MS;
+        assert(RTO_TICKS * TICK_MS == RTO_MS);
+        const double due = (double)(occupancySum - stored) / RTO_TICKS;
+        assert(retransmits <= due);
+        assert(retransmits > due - stored);
+        // Every lost frame was resent, and so was (go-back-N) everything 
+        // after it that the far end dropped while it waited
+        assert(retransmits >= lostFrames);
+        assert(retransmits > 2 * lostFrames);
+
+        // The window fills up: the far end holds up everything behind a 
+        // lost frame for at least an RTO, while a call wants to send 
+        // RTO / 100ms = 2.5 more frames.
+        assert(maxOccupancy == R::DEFAULT_SLOTS);
+        for (unsigned c = 0; c < CALLS; c++)
+            assert(calls[c].ring.getStats().highWater <= maxOccupancy);
+        assert(meanOccupancy > R::DEFAULT_SLOTS * 3 / 4);
+        assert(blocked > 0);
+    }
+    cout << "OK" << endl;
+}
@@ -2,16 +2,29 @@
 #include <stdint.h>
 #include <assert.h>
 
+#include <time.h>
+
 #include <iostream>
 #include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
 
 #include "kc1fsz-tools/Common.h"
 #include "DigitalAudioPortRxHandler.h"
 #include "cobs.h"
 
+#include "SdrcFrameScanner.h"
+
 using namespace std;
 using namespace kc1fsz;
 
+static double nowSec() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
 int main(int, const char**) {
     {
         uint8_t payload[PAYLOAD_SIZE];
@@ -53,4 +66,114 @@ int main(int, const char**) {
             payload2, PAYLOAD_SIZE) == 0);
         assert(memcmp(payload, payload2, PAYLOAD_SIZE) == 0);
     }
+
+    // A stream of messages through the scanner (vectorized framing and 
+    // in-place decode) gives the same result as decoding each message 
+    // on its own, for every instruction set.
+    {
+        const unsigned MSG_COUNT = 20000;
+        const unsigned COBS_OFFSET = 2;
+        std::mt19937 rng(1);
+        std::vector<uint8_t> stream;
+        std::vector<std::vector<uint8_t>> payloads;
+        for (unsigned m = 0; m < MSG_COUNT; m++) {
+            std::vector<uint8_t> payload(PAYLOAD_SIZE);
+            // Audio-like, with plenty of zeros
+            for (uint8_t& b : payload)
+                b = (rng() % 4 == 0) ? 0 : rng();
+            uint8_t msg[NETWORK_MESSAGE_SIZE];
+            DigitalAudioPortRxHandler::encodeMsg(payload.data(), PAYLOAD_SIZE, 
+                msg, NETWORK_MESSAGE_SIZE);
+            stream.insert(stream.end(), msg, msg + NETWORK_MESSAGE_SIZE);
+            payloads.push_back(payload);
+        }
+
+        for (amp::SimdImpl impl : { amp::SimdImpl::SCALAR, amp::SimdImpl::SSE41,
+            amp::SimdImpl::AVX2, amp::SimdImpl::NEON }) {
+            if (!amp::isSupported(impl))
+                continue;
+            // The scanner decodes over its copy of the stream
+            auto scanner = std::make_unique<amp::SdrcFrameScanner>(NETWORK_MESSAGE_SIZE,
+                COBS_OFFSET, impl);
+            unsigned count = 0;
+            auto cb = [&](const amp::SdrcFrameScanner::Frame& frame) {
+                const uint8_t* msg = stream.data() + count * NETWORK_MESSAGE_SIZE;
+                assert(frame.raw[0] == 0 && frame.raw[1] == msg[1]);
+                uint8_t expected[NETWORK_MESSAGE_SIZE];
+                cobs_decode_result rd = cobs_decode(expected, sizeof(expected),
+                    msg + COBS_OFFSET, NETWORK_MESSAGE_SIZE - COBS_OFFSET);
+                assert((rd.status == COBS_DECODE_OK) == (frame.dataLen >= 0));
+                if (frame.dataLen >= 0) {
+                    assert((size_t)frame.dataLen == rd.out_len);
+                    assert(memcmp(frame.data, expected, rd.out_len) == 0);
+                }
+                count++;
+            };
+            // Serial-sized chunks
+            for (size_t i = 0; i < stream.size(); i += 1024)
+                scanner->feed(stream.data() + i, std::min((size_t)1024, stream.size() - i), cb);
+            assert(count == MSG_COUNT);
+            assert(scanner->getStats().skipped == 0);
+            assert(scanner->getStats().truncated == 0);
+        }
+
+        // Lost bytes and line noise only cost the damaged message
+        {
+            std::vector<uint8_t> damaged(stream.begin(), stream.begin() + 10 * NETWORK_MESSAGE_SIZE);
+            damaged.erase(damaged.begin() + 3 * NETWORK_MESSAGE_SIZE + 20,
+                damaged.begin() + 3 * NETWORK_MESSAGE_SIZE + 30);
+            damaged.insert(damaged.begin(), { 0x55, 0x55, 0x55 });
+            amp::SdrcFrameScanner scanner(NETWORK_MESSAGE_SIZE, COBS_OFFSET);
+            unsigned count = 0;
+            scanner.feed(damaged.data(), damaged.size(), 
+                [&count](const amp::SdrcFrameScanner::Frame&) { count++; });
+            assert(count == 9);
+            assert(scanner.getStats().skipped == 3);
+            assert(scanner.getStats().truncated == 1);
+        }
+
+        // Throughput: byte-at-a-time framing + decodeMsg() (the way the
+        // receiver works today) vs. the scanner
+        const unsigned ROUNDS = 20;
+        double t0 = nowSec();
+        unsigned decoded = 0;
+        for (unsigned r = 0; r < ROUNDS; r++) {
+            uint8_t msg[NETWORK_MESSAGE_SIZE];
+            unsigned msgLen = 0;
+            uint8_t payload[PAYLOAD_SIZE];
+            for (uint8_t b : stream) {
+                if (b == 0)
+                    msgLen = 0;
+                if (msgLen < NETWORK_MESSAGE_SIZE)
+                    msg[msgLen++] = b;
+                if (msgLen == NETWORK_MESSAGE_SIZE) {
+                    if (DigitalAudioPortRxHandler::decodeMsg(msg, NETWORK_MESSAGE_SIZE,
+                        payload, PAYLOAD_SIZE) == 0)
+                        decoded++;
+                    msgLen = NETWORK_MESSAGE_SIZE + 1;
+                }
+            }
+        }
+        double byteSec = nowSec() - t0;
+        assert(decoded == ROUNDS * MSG_COUNT);
+
+        auto scanner = std::make_unique<amp::SdrcFrameScanner>(NETWORK_MESSAGE_SIZE, 
+            COBS_OFFSET);
+        t0 = nowSec();
+        unsigned scanned = 0;
+        for (unsigned r = 0; r < ROUNDS; r++)
+            for (size_t i = 0; i < stream.size(); i += 4096)
+                scanned += scanner->feed(stream.data() + i, 
+                    std::min((size_t)4096, stream.size() - i),
+                    [](const amp::SdrcFrameScanner::Frame&) { });
+        double scanSec = nowSec() - t0;
+        assert(scanned == ROUNDS * MSG_COUNT);
+
+        const double mb = ROUNDS * stream.size() / 1e6;
+        cout << "byte-at-a-time " << mb / byteSec << " MB/s, scanner (" 
+            << amp::simdImplName(scanner->getImpl()) << ") " << mb / scanSec 
+            << " MB/s" << endl;
+    }
+
+    cout << "OK" << endl;
 }
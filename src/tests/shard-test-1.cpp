@@ -0,0 +1,232 @@
+/**
+ * Two shards wired through one MultiRouter, the way amp-server runs
+ * with --shards 2: every consumer is registered through a mailbox owned
+ * by its shard. Each shard produces messages for a consumer on the other
+ * shard and a BROADCAST consumer watches everything.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/linux/StdClock.h"
+#include "kc1fsz-tools/threadsafequeue2.h"
+
+// amp-core
+#include "Message.h"
+#include "MessageConsumer.h"
+#include "MultiRouter.h"
+
+#include "Shard.h"
+#include "ShardStatus.h"
+#include "StatusBoard.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+static const unsigned PRODUCERS = 3;
+static const unsigned COUNT = 20000;
+static const unsigned FOREIGN_COUNT = 100;
+// Well under the mailbox ring size so nothing is dropped
+static const unsigned WINDOW = 256;
+
+/**
+ * Does nothing, it's only there to be timed.
+ */
+struct Idle : public Runnable2 {
+    bool run2() override { return false; }
+};
+
+struct Tag {
+    uint32_t producer;
+    uint32_t seq;
+};
+
+/**
+ * Checks that everything arrives once, in order, on the owning shard.
+ */
+struct Sink : public MessageConsumer {
+
+    Sink(int shardId) : shardId(shardId) { }
+
+    void consume(const Message& msg) override {
+        if (amp::Shard::current() != shardId)
+            wrongThread++;
+        Tag tag;
+        memcpy(&tag, msg.body(), sizeof(tag));
+        assert(tag.producer < PRODUCERS);
+        if (tag.seq != next[tag.producer])
+            outOfOrder++;
+        next[tag.producer] = tag.seq + 1;
+        received[tag.producer]++;
+    }
+
+    const int shardId;
+    uint32_t next[PRODUCERS] = { 0 };
+    std::atomic<unsigned> received[PRODUCERS] = { 0 };
+    std::atomic<unsigned> wrongThread = 0;
+    std::atomic<unsigned> outOfOrder = 0;
+};
+
+/**
+ * Sends COUNT messages to a line on the other shard, staying no more
+ * than WINDOW ahead of the receiver.
+ */
+struct Source : public Runnable2 {
+
+    Source(MessageConsumer& bus, unsigned producer, unsigned srcLine, unsigned destLine,
+        Sink& dest)
+    :   bus(bus), producer(producer), srcLine(srcLine), destLine(destLine), dest(dest) { }
+
+    bool run2() override {
+        bool worked = false;
+        while (sent < COUNT && sent - dest.received[producer].load() < WINDOW) {
+            Tag tag = { producer, sent++ };
+            Message msg(Message::Type::AUDIO, 0, sizeof(tag), (const uint8_t*)&tag, 0, 0);
+            msg.setSource(srcLine, 0);
+            msg.setDest(destLine, 0);
+            bus.consume(msg);
+            worked = true;
+        }
+        return worked;
+    }
+
+    MessageConsumer& bus;
+    const unsigned producer;
+    const unsigned srcLine;
+    const unsigned destLine;
+    Sink& dest;
+    unsigned sent = 0;
+};
+
+int main(int, const char**) {
+
+    Log log;
+    StdClock clock;
+
+    // More tasks than the status board has room for: the ones that fit
+    // are shown and the rest are left out
+    {
+        amp::Shard shard(log, clock, 0, -1);
+        const unsigned TASKS = amp::StatusBoard::MAX_FIELDS / 2 + 10;
+        vector<Idle> tasks(TASKS);
+        for (unsigned i = 0; i < TASKS; i++)
+            shard.addTask(&tasks[i], ("Idle" + to_string(i)).c_str());
+        amp::StatusBoard board;
+        std::vector<amp::Shard*> shards = { &shard };
+        amp::ShardStatus status(log, board, shards, 250);
+        assert(board.getFieldCount() == amp::StatusBoard::MAX_FIELDS - 1);
+        assert(board.getFieldName(0) == "shard0.overruns");
+        assert(board.getFieldName(board.getFieldCount() - 1) == "shard0.Idle125.tickP99Us");
+        status.update();
+        vector<int64_t> values(board.getFieldCount());
+        assert(board.snapshot(values.data()) == 1);
+    }
+
+    threadsafequeue2<Message> respQueue;
+    MultiRouter router(respQueue);
+    amp::MessagePool pool(2048);
+
+    amp::Shard shard0(log, clock, 0, -1);
+    amp::Shard shard1(log, clock, 1, -1);
+    shard0.setPool(&pool);
+
+    // Line 1 lives on shard 0, line 2 on shard 1 and the watcher on
+    // shard 0
+    Sink sink1(0), sink2(1), watcher(0);
+    amp::ShardMailbox mb1(sink1, pool, 0, 2);
+    amp::ShardMailbox mb2(sink2, pool, 1, 2);
+    amp::ShardMailbox mbWatcher(watcher, pool, 0, 2);
+    shard0.addMailbox(&mb1);
+    shard0.addMailbox(&mbWatcher);
+    shard1.addMailbox(&mb2);
+    router.addRoute(&mb1, 1);
+    router.addRoute(&mb2, 2);
+    router.addRoute(&mbWatcher, MultiRouter::BROADCAST);
+    // Every mailbox records its latency
+    amp::LatencyProbe probe;
+    mb1.setProbe(&probe, probe.addPath("line1"));
+    mb2.setProbe(&probe, probe.addPath("line2"));
+    mbWatcher.setProbe(&probe, probe.addPath("broadcast"));
+    // The producers use the router through the bus
+    amp::DispatchBus bus(router);
+
+    Source source1(bus, 0, 1, 2, sink2);
+    Source source2(bus, 1, 2, 1, sink1);
+    shard0.addTask(&source1, "Source1");
+    shard1.addTask(&source2, "Source2");
+
+    // Something that isn't a shard thread (ex: the service thread)
+    for (uint32_t i = 0; i < FOREIGN_COUNT; i++) {
+        Tag tag = { 2, i };
+        Message msg(Message::Type::AUDIO, 0, sizeof(tag), (const uint8_t*)&tag, 0, 0);
+        msg.setSource(3, 0);
+        msg.setDest(2, 0);
+        bus.consume(msg);
+    }
+
+    shard0.start();
+    shard1.start();
+
+    const unsigned total = 2 * COUNT + FOREIGN_COUNT;
+    auto watched = [&watcher]() {
+        unsigned n = 0;
+        for (unsigned p = 0; p < PRODUCERS; p++)
+            n += watcher.received[p].load();
+        return n;
+    };
+    for (unsigned i = 0; i < 1000 && watched() < total; i++)
+        this_thread::sleep_for(chrono::milliseconds(10));
+
+    assert(sink1.received[1] == COUNT);
+    assert(sink1.received[0] == 0 && sink1.received[2] == 0);
+    assert(sink2.received[0] == COUNT);
+    assert(sink2.received[2] == FOREIGN_COUNT);
+    assert(sink2.received[1] == 0);
+    assert(watched() == total);
+    for (const Sink* s : { &sink1, &sink2, &watcher }) {
+        assert(s->wrongThread == 0);
+        assert(s->outOfOrder == 0);
+    }
+    assert(mb1.getDropCount() == 0 && mb2.getDropCount() == 0 &&
+        mbWatcher.getDropCount() == 0);
+
+    // Everything delivered was recorded, whether it crossed shards
+    // (everything to lines 1 and 2) or not (the watcher's messages from 
+    // shard 0). Only the mailbox points are marked.
+    const unsigned delivered[] = { COUNT, COUNT + FOREIGN_COUNT, total };
+    for (unsigned p = 0; p < probe.getPathCount(); p++) {
+        assert(probe.getHistogram(p, amp::LatencyProbe::INPUT).getCount() == delivered[p]);
+        assert(probe.getHistogram(p, amp::LatencyProbe::TOTAL).getCount() == delivered[p]);
+        assert(probe.getHistogram(p, amp::LatencyProbe::JITTER).getCount() == 0);
+        assert(probe.getHistogram(p, amp::LatencyProbe::BRIDGE).getCount() == 0);
+        assert(probe.getHistogram(p, amp::LatencyProbe::TOTAL).getMaxUs() >=
+            probe.getHistogram(p, amp::LatencyProbe::INPUT).getMaxUs());
+        cout << probe.getPathName(p) << " wait p50 " 
+            << probe.getHistogram(p, amp::LatencyProbe::INPUT).percentileUs(50) << " us p99 "
+            << probe.getHistogram(p, amp::LatencyProbe::INPUT).percentileUs(99) << " us" << endl;
+    }
+
+    // One pooled copy per message that crossed shards: the messages from
+    // shard 1 (and the foreign ones) are shared by a mailbox on shard 0
+    // and the watcher.
+    assert(pool.getAllocCount() == COUNT + COUNT + FOREIGN_COUNT);
+    assert(pool.getExhaustedCount() == 0);
+    for (unsigned i = 0; i < 100 && pool.getInUse() != 0; i++)
+        this_thread::sleep_for(chrono::milliseconds(10));
+    assert(pool.getInUse() == 0);
+
+    cout << "OK" << endl;
+    // The shard threads never return
+    std::quick_exit(0);
+}
@@ -0,0 +1,52 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <iostream>
+#include <thread>
+
+#include "SpscRing.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+int main(int, const char**) {
+    // Basic single-thread behavior
+    {
+        amp::SpscRing<int, 4> ring;
+        assert(ring.empty());
+        assert(ring.push(1));
+        assert(ring.push(2));
+        assert(ring.push(3));
+        assert(ring.push(4));
+        // Full
+        assert(!ring.push(5));
+        assert(ring.size() == 4);
+        int v;
+        assert(ring.pop(v) && v == 1);
+        assert(ring.push(5));
+        int sum = 0;
+        assert(ring.drain([&sum](const int& x) { sum += x; }) == 4);
+        assert(sum == 2 + 3 + 4 + 5);
+        assert(!ring.pop(v));
+    }
+    // Two threads, make sure everything arrives in order
+    {
+        const unsigned count = 1000000;
+        amp::SpscRing<uint32_t, 256> ring;
+        std::thread producer([&ring]() {
+            for (uint32_t i = 0; i < count; i++)
+                while (!ring.push(i));
+        });
+        uint32_t expected = 0;
+        while (expected < count) {
+            ring.drain([&expected](const uint32_t& x) {
+                assert(x == expected);
+                expected++;
+            });
+        }
+        producer.join();
+        assert(ring.empty());
+    }
+    cout << "OK" << endl;
+}
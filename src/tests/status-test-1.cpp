@@ -0,0 +1,127 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "StatusBoard.h"
+
+using namespace std;
+using namespace kc1fsz;
+using json = nlohmann::json;
+
+int main(int, const char**) {
+    // Snapshots and deltas
+    {
+        amp::StatusBoard board;
+        int calls = board.addField("calls");
+        int level = board.addField("level1");
+        int keyed = board.addField("keyed1");
+        assert(calls == 0 && level == 1 && keyed == 2);
+        assert(board.getFieldCount() == 3);
+        assert(board.getFieldName(1) == "level1");
+
+        int64_t v0[3], v1[3];
+        // Nothing published yet
+        assert(board.snapshot(v0) == 0);
+        assert(v0[0] == 0 && v0[1] == 0 && v0[2] == 0);
+
+        // Setting doesn't show until publish
+        board.set(calls, 2);
+        board.set(level, -20);
+        assert(board.snapshot(v0) == 0);
+        assert(v0[0] == 0);
+        board.publish();
+        uint64_t seq = board.snapshot(v0);
+        assert(seq == 1);
+        assert(v0[0] == 2 && v0[1] == -20 && v0[2] == 0);
+
+        json full = json::parse(board.renderDelta(seq, nullptr, v0));
+        assert(full["seq"] == 1);
+        assert(full["full"] == true);
+        assert(full["values"].size() == 3);
+        assert(full["values"]["calls"] == 2);
+        assert(full["values"]["level1"] == -20);
+        assert(full["values"]["keyed1"] == 0);
+
+        // Only the changed field
+        board.set(keyed, 1);
+        board.publish();
+        seq = board.snapshot(v1);
+        assert(seq == 2);
+        json delta = json::parse(board.renderDelta(seq, v0, v1));
+        assert(delta["seq"] == 2);
+        assert(!delta.contains("full"));
+        assert(delta["values"].size() == 1);
+        assert(delta["values"]["keyed1"] == 1);
+
+        // Nothing changed
+        board.publish();
+        seq = board.snapshot(v0);
+        assert(seq == 3);
+        delta = json::parse(board.renderDelta(seq, v1, v0));
+        assert(delta["values"].empty());
+    }
+    // Too many fields
+    {
+        amp::StatusBoard board;
+        for (unsigned i = 0; i < amp::StatusBoard::MAX_FIELDS; i++)
+            assert(board.addField("f" + to_string(i)) == (int)i);
+        assert(board.addField("extra") == -1);
+    }
+    // Readers always see a consistent publication while the owner is 
+    // publishing as fast as it can
+    {
+        amp::StatusBoard board;
+        const unsigned fieldCount = 64;
+        for (unsigned i = 0; i < fieldCount; i++)
+            board.addField("f" + to_string(i));
+        const uint64_t publishCount = 200000;
+        std::atomic<bool> done = false;
+        std::atomic<uint64_t> snapshots = 0;
+
+        std::thread owner([&board, &done, &snapshots, publishCount, fieldCount]() {
+            // Wait for the readers
+            while (snapshots == 0)
+                std::this_thread::yield();
+            for (uint64_t n = 1; n <= publishCount; n++) {
+                // Every field carries the publication number
+                for (unsigned i = 0; i < fieldCount; i++)
+                    board.set(i, n);
+                board.publish();
+            }
+            done = true;
+        });
+
+        std::vector<std::thread> readers;
+        for (unsigned r = 0; r < 2; r++) {
+            readers.emplace_back([&board, &done, &snapshots, fieldCount]() {
+                int64_t values[fieldCount];
+                uint64_t lastSeq = 0;
+                do {
+                    const uint64_t seq = board.snapshot(values);
+                    assert(seq >= lastSeq);
+                    for (unsigned i = 0; i < fieldCount; i++)
+                        assert(values[i] == (int64_t)seq);
+                    lastSeq = seq;
+                    snapshots++;
+                } while (!done);
+            });
+        }
+        owner.join();
+        for (auto& t : readers)
+            t.join();
+
+        int64_t values[fieldCount];
+        assert(board.snapshot(values) == publishCount);
+        assert(values[fieldCount - 1] == (int64_t)publishCount);
+        cout << "Consistent snapshots: " << snapshots << endl;
+    }
+    cout << "OK" << endl;
+}
@@ -0,0 +1,106 @@
+/**
+ * Measures the timer housekeeping cost of an audio tick (20ms) as the 
+ * number of armed timers grows. Polling every deadline on every tick 
+ * (the way the lines check their calls now) is shown for comparison.
+ *
+ * - idle: call timeouts (30-60 minutes) that don't come due during the
+ *   run. This is the cost of just having the timers armed.
+ * - busy: PING (20s) and LAGRQ (10s) timers that re-arm themselves when
+ *   they fire, a mix of firing and waiting.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "TimerWheel.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+using W = amp::TimerWheel;
+
+static const unsigned TICK_MS = 20;
+// Ten simulated minutes
+static const unsigned TICKS = 10 * 60 * 1000 / TICK_MS;
+
+struct Result {
+    double wheelNs;
+    uint64_t wheelWorstNs;
+    double pollNs;
+    uint64_t fired;
+};
+
+/**
+ * @param periodMs The re-arm period, or 0 for one-shot.
+ */
+static Result run(unsigned timerCount, unsigned minMs, unsigned maxMs, unsigned periodMs) {
+
+    std::mt19937 rng(timerCount);
+    Result r;
+    r.fired = 0;
+    r.wheelWorstNs = 0;
+
+    W wheel(0);
+    std::unique_ptr<W::Timer[]> timers(new W::Timer[timerCount]);
+    for (unsigned i = 0; i < timerCount; i++) {
+        timers[i].setCallback([&wheel, &timers, &r, i, periodMs]() {
+            r.fired++;
+            if (periodMs)
+                wheel.schedule(timers[i], periodMs);
+        });
+        wheel.schedule(timers[i], minMs + rng() % (maxMs - minMs));
+    }
+    auto t0 = chrono::steady_clock::now();
+    for (unsigned t = 1; t <= TICKS; t++) {
+        auto a = chrono::steady_clock::now();
+        wheel.advance((uint64_t)t * TICK_MS);
+        const uint64_t ns = chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now() - a).count();
+        if (ns > r.wheelWorstNs)
+            r.wheelWorstNs = ns;
+    }
+    auto t1 = chrono::steady_clock::now();
+
+    std::vector<uint64_t> deadlines(timerCount);
+    for (unsigned i = 0; i < timerCount; i++)
+        deadlines[i] = minMs + rng() % (maxMs - minMs);
+    uint64_t polledFired = 0;
+    auto t2 = chrono::steady_clock::now();
+    for (unsigned t = 1; t <= TICKS; t++) {
+        const uint64_t now = (uint64_t)t * TICK_MS;
+        for (unsigned i = 0; i < timerCount; i++) {
+            if (deadlines[i] <= now) {
+                polledFired++;
+                deadlines[i] = periodMs ? now + periodMs : UINT64_MAX;
+            }
+        }
+    }
+    auto t3 = chrono::steady_clock::now();
+    // Keep the loop
+    if (polledFired == UINT64_MAX)
+        cout << polledFired;
+
+    r.wheelNs = (double)chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count() / TICKS;
+    r.pollNs = (double)chrono::duration_cast<chrono::nanoseconds>(t3 - t2).count() / TICKS;
+    return r;
+}
+
+int main(int, const char**) {
+    for (unsigned timerCount : { 100, 1000, 10000, 100000 }) {
+        Result idle = run(timerCount, 30 * 60000, 60 * 60000, 0);
+        Result busy = run(timerCount, 1, 20000, 15000);
+        cout << "timers=" << timerCount
+            << " idle: wheel ns/tick=" << idle.wheelNs 
+            << " (worst " << idle.wheelWorstNs << ")"
+            << " poll ns/tick=" << idle.pollNs
+            << " | busy: wheel ns/tick=" << busy.wheelNs
+            << " (worst " << busy.wheelWorstNs << ")"
+            << " poll ns/tick=" << busy.pollNs
+            << " fired/tick=" << (double)busy.fired / TICKS << endl;
+    }
+}
@@ -0,0 +1,180 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "TimerWheel.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+int main(int, const char**) {
+    using W = amp::TimerWheel;
+    // Basics
+    {
+        W wheel(1000);
+        unsigned fired = 0;
+        uint64_t firedAt = 0;
+        W::Timer t([&]() { fired++; firedAt = wheel.getNowMs(); });
+        assert(!t.isArmed());
+        wheel.schedule(t, 10);
+        assert(t.isArmed());
+        assert(t.getExpiresMs() == 1010);
+        assert(wheel.getArmedCount() == 1);
+        assert(wheel.advance(1009) == 0);
+        assert(wheel.advance(1010) == 1);
+        assert(fired == 1 && firedAt == 1010);
+        assert(!t.isArmed());
+        assert(wheel.getArmedCount() == 0);
+        // Going backwards does nothing
+        assert(wheel.advance(500) == 0);
+        assert(wheel.getNowMs() == 1010);
+
+        // Zero delay and the past go out on the next millisecond
+        wheel.schedule(t, 0);
+        assert(wheel.advance(1010) == 0);
+        assert(wheel.advance(1011) == 1);
+        wheel.scheduleAt(t, 5);
+        assert(t.getExpiresMs() == 1012);
+        assert(wheel.advance(2000) == 1);
+        assert(firedAt == 1012);
+
+        // Cancel and re-arm
+        wheel.schedule(t, 100);
+        t.cancel();
+        assert(!t.isArmed());
+        assert(wheel.advance(3000) == 0);
+        wheel.schedule(t, 100);
+        wheel.schedule(t, 200);
+        assert(wheel.getArmedCount() == 1);
+        assert(wheel.advance(3100) == 0);
+        assert(wheel.advance(3200) == 1);
+
+        // Destroying an armed timer disarms it
+        {
+            W::Timer t2([&]() { assert(false); });
+            wheel.schedule(t2, 10);
+            assert(wheel.getArmedCount() == 1);
+        }
+        assert(wheel.getArmedCount() == 0);
+        assert(wheel.advance(4000) == 0);
+    }
+    // A timer that outlives its wheel
+    {
+        W::Timer t;
+        {
+            W wheel;
+            wheel.schedule(t, 10);
+        }
+        assert(!t.isArmed());
+    }
+    // Callbacks that re-arm themselves and cancel others due at the 
+    // same time
+    {
+        W wheel;
+        unsigned aCount = 0, bCount = 0;
+        W::Timer b([&]() { bCount++; });
+        W::Timer a;
+        a.setCallback([&]() { 
+            aCount++;
+            b.cancel();
+            if (aCount < 5)
+                wheel.schedule(a, 1000);
+        });
+        wheel.schedule(a, 1000);
+        wheel.schedule(b, 1000);
+        wheel.advance(1000);
+        // One or the other went first
+        assert(aCount == 1);
+        assert(bCount <= 1);
+        wheel.advance(100000);
+        assert(aCount == 5);
+        assert(wheel.getArmedCount() == 0);
+    }
+    // Beyond the span of the wheel
+    {
+        W wheel(7);
+        unsigned fired = 0;
+        uint64_t firedAt = 0;
+        W::Timer t([&]() { fired++; firedAt = wheel.getNowMs(); });
+        const uint64_t delay = 3 * W::SPAN_MS + 12345;
+        wheel.schedule(t, delay);
+        for (uint64_t now = 0; now < 7 + delay - 1; now += 3600000)
+            assert(wheel.advance(now) == 0);
+        assert(wheel.advance(7 + delay - 1) == 0);
+        assert(wheel.advance(7 + delay + 1000) == 1);
+        assert(firedAt == 7 + delay);
+    }
+    // Randomized against the obvious implementation: every timer fires
+    // in the advance() that passes its time, and inside its callback the
+    // wheel time is exactly its expiration time.
+    {
+        const unsigned N = 2000;
+        std::mt19937 rng(1);
+        const uint64_t start = 123456789;
+        W wheel(start);
+        std::unique_ptr<W::Timer[]> timers(new W::Timer[N]);
+        std::vector<uint64_t> expected(N, 0);
+        std::vector<unsigned> fireCount(N, 0);
+        for (unsigned i = 0; i < N; i++)
+            timers[i].setCallback([&, i]() {
+                assert(expected[i] != 0);
+                assert(wheel.getNowMs() == expected[i]);
+                expected[i] = 0;
+                fireCount[i]++;
+            });
+        auto randomDelay = [&rng]() -> uint64_t {
+            // Spread over all of the levels and beyond
+            switch (rng() % 5) {
+                case 0: return rng() % 64;
+                case 1: return rng() % 4096;
+                case 2: return rng() % 262144;
+                case 3: return rng() % W::SPAN_MS;
+                default: return rng() % (4 * W::SPAN_MS);
+            }
+        };
+        uint64_t now = start;
+        unsigned totalFired = 0;
+        for (unsigned round = 0; round < 20000; round++) {
+            for (unsigned k = 0; k < 5; k++) {
+                const unsigned i = rng() % N;
+                if (rng() % 4 == 0) {
+                    timers[i].cancel();
+                    expected[i] = 0;
+                }
+                else {
+                    const uint64_t d = randomDelay();
+                    wheel.schedule(timers[i], d);
+                    expected[i] = now + (d == 0 ? 1 : d);
+                }
+            }
+            // Mostly audio ticks, some long stalls
+            const uint64_t step = (rng() % 50 == 0) ? rng() % 20000000 : rng() % 40;
+            now += step;
+            unsigned due = 0;
+            for (unsigned i = 0; i < N; i++)
+                if (expected[i] != 0 && expected[i] <= now)
+                    due++;
+            const unsigned fired = wheel.advance(now);
+            assert(fired == due);
+            totalFired += fired;
+            unsigned armed = 0;
+            for (unsigned i = 0; i < N; i++) {
+                assert(timers[i].isArmed() == (expected[i] != 0));
+                if (expected[i] != 0) {
+                    assert(expected[i] > now);
+                    assert(timers[i].getExpiresMs() == expected[i]);
+                    armed++;
+                }
+            }
+            assert(wheel.getArmedCount() == armed);
+        }
+        cout << "Fired " << totalFired << " timers" << endl;
+        assert(totalFired > 10000);
+    }
+    cout << "OK" << endl;
+}
@@ -0,0 +1,96 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include <cstring>
+#include <iostream>
+
+#include "UdpBatchIO.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+static int makeSocket(sockaddr_in& addr) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd >= 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    assert(bind(fd, (sockaddr*)&addr, sizeof(addr)) == 0);
+    socklen_t len = sizeof(addr);
+    assert(getsockname(fd, (sockaddr*)&addr, &len) == 0);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+static void test(bool batched) {
+
+    sockaddr_in addrA, addrB;
+    int fdA = makeSocket(addrA);
+    int fdB = makeSocket(addrB);
+    amp::UdpBatchIO a(fdA, batched);
+    amp::UdpBatchIO b(fdB, batched);
+
+    // Nothing waiting
+    assert(b.receive([](const uint8_t*, unsigned, const sockaddr_storage&) { 
+        assert(false); }) == 0);
+
+    // More than one batch worth, with different lengths
+    const unsigned count = amp::UdpBatchIO::MAX_BATCH * 2 + 5;
+    for (unsigned i = 0; i < count; i++) {
+        uint8_t buf[64];
+        memset(buf, i, sizeof(buf));
+        assert(a.queue(buf, 1 + (i % 64), (sockaddr*)&addrB, sizeof(addrB)) == 0);
+    }
+    // Two full batches went out automatically
+    assert(a.getQueuedCount() == 5);
+    a.flush();
+    assert(a.getQueuedCount() == 0);
+    assert(a.getStats().txPackets == count);
+    assert(a.getStats().txErrors == 0);
+
+    unsigned received = 0;
+    int rc = b.receive([&received, &addrA](const uint8_t* data, unsigned len, 
+        const sockaddr_storage& from) {
+        assert(len == 1 + (received % 64));
+        for (unsigned k = 0; k < len; k++)
+            assert(data[k] == (uint8_t)received);
+        const sockaddr_in& fromIn = (const sockaddr_in&)from;
+        assert(fromIn.sin_port == addrA.sin_port);
+        received++;
+    });
+    assert(rc == (int)count);
+    assert(received == count);
+    assert(b.getStats().rxPackets == count);
+
+    // Oversized packets are refused
+    uint8_t big[amp::UdpBatchIO::MAX_PACKET_SIZE + 1];
+    assert(a.queue(big, sizeof(big), (sockaddr*)&addrB, sizeof(addrB)) == -1);
+
+    if (batched) {
+        assert(a.isBatched() && b.isBatched());
+        assert(a.getTxPacketsPerSyscall() > 10);
+        assert(b.getRxPacketsPerSyscall() > 10);
+        assert(b.getStats().rxMaxBatch == count);
+        assert(a.getStats().txMaxBatch == amp::UdpBatchIO::MAX_BATCH);
+    } else {
+        assert(a.getTxPacketsPerSyscall() == 1.0f);
+    }
+    cout << (batched ? "batched" : "single") << " tx " 
+        << a.getTxPacketsPerSyscall() << " pkt/syscall, rx "
+        << b.getRxPacketsPerSyscall() << " pkt/syscall" << endl;
+
+    close(fdA);
+    close(fdB);
+}
+
+int main(int, const char**) {
+    test(true);
+    test(false);
+    cout << "OK" << endl;
+}
@@ -0,0 +1,120 @@
+/**
+ * Measures the G.711 mu-law cost (ns per 160-sample frame) of the 
+ * sample-at-a-time ITU reference and each UlawCodec implementation that 
+ * the CPU supports.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "UlawCodec.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+static const unsigned FRAME_LEN = 160;
+
+/**
+ * ulaw_compress() from the ITU-T G.191 g711.c
+ */
+static void refCompress(long lseg, const short* linbuf, short* logbuf) {
+    for (long n = 0; n < lseg; n++) {
+        short absno = linbuf[n] < 0 ? ((~linbuf[n]) >> 2) + 33 : ((linbuf[n]) >> 2) + 33;
+        if (absno > (0x1FFF))
+            absno = (0x1FFF);
+        short i = absno >> 6;
+        short segno = 1;
+        while (i != 0) {
+            segno++;
+            i >>= 1;
+        }
+        short high_nibble = (0x0008) - segno;
+        short low_nibble = (absno >> segno) & (0x000F);
+        low_nibble = (0x000F) - low_nibble;
+        logbuf[n] = (high_nibble << 4) | low_nibble;
+        if (linbuf[n] >= 0)
+            logbuf[n] = (logbuf[n] | 0x0080);
+    }
+}
+
+/**
+ * ulaw_expand() from the ITU-T G.191 g711.c
+ */
+static void refExpand(long lseg, const short* logbuf, short* linbuf) {
+    for (long n = 0; n < lseg; n++) {
+        short sign = logbuf[n] < (0x0080) ? -1 : 1;
+        short mantissa = ~logbuf[n];
+        short exponent = (mantissa >> 4) & (0x0007);
+        short segment = exponent + 1;
+        mantissa = mantissa & (0x000F);
+        short step = (4) << segment;
+        linbuf[n] = sign * (((0x0080) << exponent) + step * mantissa + step / 2 - 4 * 33);
+    }
+}
+
+/**
+ * Runs the function repeatedly for about 200ms.
+ * @returns ns per call
+ */
+template<typename F> static double timeIt(F f) {
+    unsigned iterations = 0;
+    auto start = chrono::steady_clock::now();
+    auto end = start;
+    do {
+        for (unsigned i = 0; i < 16; i++)
+            f();
+        iterations += 16;
+        end = chrono::steady_clock::now();
+    } while (end - start < chrono::milliseconds(200));
+    return (double)chrono::duration_cast<chrono::nanoseconds>(end - start).count() / iterations;
+}
+
+int main(int, const char**) {
+
+    std::mt19937 rng(1);
+    std::normal_distribution<double> speech(0, 4000);
+
+    std::vector<int16_t> linear(FRAME_LEN);
+    for (int16_t& s : linear)
+        s = std::max(-32768.0, std::min(32767.0, speech(rng)));
+    std::vector<short> refCodes(FRAME_LEN), refLinear(FRAME_LEN);
+    std::vector<uint8_t> codes(FRAME_LEN);
+    std::vector<int16_t> decoded(FRAME_LEN);
+
+    cout << "Frame length " << FRAME_LEN << " samples" << endl;
+
+    double ns = timeIt([&]() { 
+        refCompress(FRAME_LEN, linear.data(), refCodes.data());
+        asm volatile("" : : "r"(refCodes.data()) : "memory");
+    });
+    cout << "encode impl=reference ns/frame=" << (uint64_t)ns << endl;
+
+    for (auto impl : { amp::SimdImpl::SCALAR, amp::SimdImpl::SSE41,
+        amp::SimdImpl::AVX2, amp::SimdImpl::NEON }) {
+        if (!amp::isSupported(impl))
+            continue;
+        amp::UlawCodec codec(impl);
+        ns = timeIt([&]() { 
+            codec.encode(linear.data(), codes.data(), FRAME_LEN);
+            asm volatile("" : : "r"(codes.data()) : "memory");
+        });
+        cout << "encode impl=" << amp::simdImplName(impl) << " ns/frame=" 
+            << (uint64_t)ns << endl;
+    }
+
+    ns = timeIt([&]() { 
+        refExpand(FRAME_LEN, refCodes.data(), refLinear.data());
+        asm volatile("" : : "r"(refLinear.data()) : "memory");
+    });
+    cout << "decode impl=reference ns/frame=" << (uint64_t)ns << endl;
+
+    ns = timeIt([&]() { 
+        amp::UlawCodec::decode(codes.data(), decoded.data(), FRAME_LEN);
+        asm volatile("" : : "r"(decoded.data()) : "memory");
+    });
+    cout << "decode impl=table ns/frame=" << (uint64_t)ns << endl;
+}
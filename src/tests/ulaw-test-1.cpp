@@ -0,0 +1,101 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "UlawCodec.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+/**
+ * ulaw_compress() from the ITU-T G.191 g711.c, one sample at a time.
+ */
+static uint8_t refCompress(int16_t x) {
+    short absno = x < 0 ? ((~x) >> 2) + 33 : ((x) >> 2) + 33;
+    if (absno > (0x1FFF))
+        absno = (0x1FFF);
+    short i = absno >> 6;
+    short segno = 1;
+    while (i != 0) {
+        segno++;
+        i >>= 1;
+    }
+    short high_nibble = (0x0008) - segno;
+    short low_nibble = (absno >> segno) & (0x000F);
+    low_nibble = (0x000F) - low_nibble;
+    short out = (high_nibble << 4) | low_nibble;
+    if (x >= 0)
+        out = (out | 0x0080);
+    return out;
+}
+
+/**
+ * ulaw_expand() from the ITU-T G.191 g711.c, one sample at a time.
+ */
+static int16_t refExpand(uint8_t u) {
+    short logbuf = u;
+    short sign = logbuf < (0x0080) ? -1 : 1;
+    short mantissa = ~logbuf;
+    short exponent = (mantissa >> 4) & (0x0007);
+    short segment = exponent + 1;
+    mantissa = mantissa & (0x000F);
+    short step = (4) << segment;
+    return sign * (((0x0080) << exponent) + step * mantissa + step / 2 - 4 * 33);
+}
+
+int main(int, const char**) {
+
+    // Every linear input, in one batch so that every vector path and
+    // every tail length is used
+    std::vector<int16_t> linear(65536);
+    for (unsigned i = 0; i < 65536; i++)
+        linear[i] = (int16_t)i;
+    std::vector<uint8_t> expected(65536);
+    for (unsigned i = 0; i < 65536; i++) {
+        expected[i] = refCompress(linear[i]);
+        assert(amp::UlawCodec::encodeSample(linear[i]) == expected[i]);
+    }
+
+    for (auto impl : { amp::SimdImpl::SCALAR, amp::SimdImpl::SSE41,
+        amp::SimdImpl::AVX2, amp::SimdImpl::NEON }) {
+        if (!amp::isSupported(impl))
+            continue;
+        amp::UlawCodec codec(impl);
+        assert(codec.getImpl() == impl);
+        std::vector<uint8_t> out(65536);
+        codec.encode(linear.data(), out.data(), 65536);
+        assert(out == expected);
+        // Odd lengths and offsets
+        for (unsigned len = 0; len < 40; len++) {
+            uint8_t buf[48];
+            memset(buf, 0xa5, sizeof(buf));
+            codec.encode(linear.data() + 32768 - 17 + len, buf, len);
+            for (unsigned k = 0; k < len; k++)
+                assert(buf[k] == expected[32768 - 17 + len + k]);
+            assert(buf[len] == 0xa5);
+        }
+    }
+
+    // Every code
+    std::vector<uint8_t> codes(256);
+    for (unsigned u = 0; u < 256; u++)
+        codes[u] = u;
+    std::vector<int16_t> decoded(256);
+    amp::UlawCodec::decode(codes.data(), decoded.data(), 256);
+    for (unsigned u = 0; u < 256; u++) {
+        assert(decoded[u] == refExpand(u));
+        assert(amp::UlawCodec::decodeSample(u) == refExpand(u));
+    }
+
+    // Decoding and encoding again gives the same code (except for
+    // negative zero, 0x7f, which comes back as positive zero)
+    for (unsigned u = 0; u < 256; u++)
+        if (u != 0x7f)
+            assert(amp::UlawCodec::encodeSample(decoded[u]) == u);
+
+    cout << "OK" << endl;
+}
@@ -0,0 +1,318 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/Runnable2.h"
+#include "kc1fsz-tools/linux/StdClock.h"
+
+#include "UringEventLoop.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+/**
+ * Reads from a pipe and records how long it took to notice each byte.
+ */
+class PipeTask : public Runnable2 {
+public:
+
+    PipeTask(amp::UringEventLoop& loop, Clock& clock, int fd) 
+    :   _loop(loop), _clock(clock), _fd(fd) { }
+
+    int getPolls(pollfd* fds, unsigned capacity) override {
+        if (capacity < 1)
+            return 0;
+        fds[0].fd = _fd;
+        fds[0].events = POLLIN;
+        return 1;
+    }
+
+    bool run2() override {
+        uint8_t b;
+        if (read(_fd, &b, 1) != 1)
+            return false;
+        auto now = chrono::steady_clock::now();
+        uint32_t us = chrono::duration_cast<chrono::microseconds>(now - writeTime.load()).count();
+        worstLatencyUs = max(worstLatencyUs, us);
+        if (++received == 5)
+            _loop.stop();
+        return true;
+    }
+
+    void audioRateTick(uint32_t tickTimeMs) override {
+        // The tick time comes from the clock that was passed in
+        uint32_t diff = _clock.time() - tickTimeMs;
+        worstTickTimeDiffMs = max(worstTickTimeDiffMs, diff);
+        ticks++;
+    }
+
+    void oneSecTick() override {
+        oneSecs++;
+    }
+
+    std::atomic<chrono::steady_clock::time_point> writeTime;
+    unsigned received = 0;
+    unsigned ticks = 0;
+    unsigned oneSecs = 0;
+    uint32_t worstLatencyUs = 0;
+    uint32_t worstTickTimeDiffMs = 0;
+
+private:
+
+    amp::UringEventLoop& _loop;
+    Clock& _clock;
+    int _fd;
+};
+
+/**
+ * Wants more descriptors than the loop can arm. Only the last one
+ * ever has anything on it.
+ */
+class ManyPipeTask : public Runnable2 {
+public:
+
+    static constexpr unsigned COUNT = amp::UringEventLoop::MAX_POLLS + 1;
+
+    ManyPipeTask(amp::UringEventLoop& loop) : _loop(loop) { 
+        for (unsigned i = 0; i < COUNT; i++) {
+            assert(pipe(pipes[i]) == 0);
+            fcntl(pipes[i][0], F_SETFL, fcntl(pipes[i][0], F_GETFL) | O_NONBLOCK);
+        }
+    }
+
+    ~ManyPipeTask() {
+        for (unsigned i = 0; i < COUNT; i++) {
+            close(pipes[i][0]);
+            close(pipes[i][1]);
+        }
+    }
+
+    int getPolls(pollfd* fds, unsigned capacity) override {
+        unsigned n = min(capacity, COUNT);
+        for (unsigned i = 0; i < n; i++) {
+            fds[i].fd = pipes[i][0];
+            fds[i].events = POLLIN;
+        }
+        return n;
+    }
+
+    bool run2() override {
+        uint8_t b;
+        if (read(pipes[COUNT - 1][0], &b, 1) != 1)
+            return false;
+        if (++received == 3)
+            _loop.stop();
+        return true;
+    }
+
+    int pipes[COUNT][2];
+    unsigned received = 0;
+
+private:
+
+    amp::UringEventLoop& _loop;
+};
+
+/**
+ * Closes its UDP socket and opens a new one on the same port in the
+ * middle of the run, from a tick (while the old one is being watched),
+ * the way a line is reopened when its configuration changes. The new 
+ * socket gets the same descriptor number.
+ */
+class ReopenTask : public Runnable2 {
+public:
+
+    static constexpr uint16_t PORT = 46300;
+    static constexpr unsigned REOPEN_TICK = 5;
+    static constexpr unsigned COUNT = 5;
+
+    ReopenTask(amp::UringEventLoop& loop) : _loop(loop) { 
+        _fd = _open();
+        assert(_fd >= 0);
+    }
+
+    ~ReopenTask() {
+        close(_fd);
+    }
+
+    int getPolls(pollfd* fds, unsigned capacity) override {
+        if (capacity < 1 || _fd < 0)
+            return 0;
+        fds[0].fd = _fd;
+        fds[0].events = POLLIN;
+        return 1;
+    }
+
+    bool run2() override {
+        uint8_t b;
+        if (_fd < 0 || recv(_fd, &b, 1, MSG_DONTWAIT) != 1)
+            return false;
+        auto now = chrono::steady_clock::now();
+        uint32_t us = chrono::duration_cast<chrono::microseconds>(now - sendTime.load()).count();
+        worstLatencyUs = max(worstLatencyUs, us);
+        if (++received == COUNT)
+            _loop.stop();
+        return true;
+    }
+
+    void audioRateTick(uint32_t) override {
+        if (++_ticks == REOPEN_TICK) {
+            const int oldFd = _fd;
+            close(_fd);
+            _fd = _open();
+            rebound = (_fd >= 0);
+            sameFd = (_fd == oldFd);
+            reopened = true;
+        }
+        // Don't wait forever for datagrams that never arrive
+        if (_ticks == 200)
+            _loop.stop();
+    }
+
+    std::atomic<chrono::steady_clock::time_point> sendTime;
+    std::atomic<bool> reopened = false;
+    bool rebound = false;
+    bool sameFd = false;
+    unsigned received = 0;
+    uint32_t worstLatencyUs = 0;
+
+private:
+
+    static int _open() {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(PORT);
+        if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    amp::UringEventLoop& _loop;
+    int _fd;
+    unsigned _ticks = 0;
+};
+
+int main(int, const char**) {
+
+    Log log;
+    StdClock clock;
+    amp::UringEventLoop loop(log, clock);
+    if (!loop.isOpen()) {
+        cout << "io_uring not available, skipping" << endl;
+        return 0;
+    }
+
+    int p[2];
+    assert(pipe(p) == 0);
+    fcntl(p[0], F_SETFL, fcntl(p[0], F_GETFL) | O_NONBLOCK);
+
+    PipeTask task(loop, clock, p[0]);
+    Runnable2* tasks[] = { &task };
+
+    // Write a byte every 300ms from another thread
+    std::thread writer([&task, &p]() {
+        for (unsigned i = 0; i < 5; i++) {
+            this_thread::sleep_for(chrono::milliseconds(300));
+            task.writeTime = chrono::steady_clock::now();
+            assert(write(p[1], "x", 1) == 1);
+        }
+    });
+
+    auto start = chrono::steady_clock::now();
+    loop.run(tasks, 1);
+    auto elapsedMs = chrono::duration_cast<chrono::milliseconds>(
+        chrono::steady_clock::now() - start).count();
+    writer.join();
+
+    cout << "elapsed " << elapsedMs << " ms, ticks " << task.ticks 
+        << ", wakes " << loop.getWakeCount() 
+        << ", worst latency " << task.worstLatencyUs << " us" << endl;
+
+    assert(task.received == 5);
+    assert(task.oneSecs == 1);
+    // About 75 ticks in 1.5 seconds
+    assert(task.ticks >= elapsedMs / amp::UringEventLoop::TICK_MS - 3);
+    assert(task.ticks <= elapsedMs / amp::UringEventLoop::TICK_MS + 1);
+    // Sleeping, not spinning: one wake per tick plus one per byte
+    assert(loop.getWakeCount() <= task.ticks + 5 + 2);
+    assert(loop.getPollCompletionCount() == 5);
+    // The pipe is noticed right away, not on the next tick
+    assert(task.worstLatencyUs < 10000);
+    assert(task.worstTickTimeDiffMs <= 1);
+    assert(loop.getPollOverflowCount() == 0);
+
+    close(p[0]);
+    close(p[1]);
+
+    // More descriptors than can be armed. The one that didn't fit is
+    // still noticed because the loop stops sleeping.
+    {
+        amp::UringEventLoop loop2(log, clock);
+        ManyPipeTask many(loop2);
+        Runnable2* tasks2[] = { &many };
+        std::thread writer2([&many]() {
+            for (unsigned i = 0; i < 3; i++) {
+                this_thread::sleep_for(chrono::milliseconds(100));
+                assert(write(many.pipes[ManyPipeTask::COUNT - 1][1], "x", 1) == 1);
+            }
+        });
+        loop2.run(tasks2, 1);
+        writer2.join();
+        assert(many.received == 3);
+        assert(loop2.getPollOverflowCount() > 0);
+    }
+
+    // A descriptor that is closed and opened again (with the same number)
+    // while it's being watched: the old socket lets go of the port and 
+    // the new one is watched
+    {
+        amp::UringEventLoop loop3(log, clock);
+        ReopenTask reopen(loop3);
+        Runnable2* tasks3[] = { &reopen };
+        std::thread sender([&reopen]() {
+            int fd = socket(AF_INET, SOCK_DGRAM, 0);
+            sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(ReopenTask::PORT);
+            while (!reopen.reopened)
+                this_thread::sleep_for(chrono::milliseconds(10));
+            for (unsigned i = 0; i < ReopenTask::COUNT; i++) {
+                this_thread::sleep_for(chrono::milliseconds(100));
+                reopen.sendTime = chrono::steady_clock::now();
+                sendto(fd, "x", 1, 0, (sockaddr*)&addr, sizeof(addr));
+            }
+            close(fd);
+        });
+        loop3.run(tasks3, 1);
+        sender.join();
+        cout << "reopen rebound " << reopen.rebound << ", received " << reopen.received
+            << ", worst latency " << reopen.worstLatencyUs << " us" << endl;
+        assert(reopen.rebound);
+        assert(reopen.sameFd);
+        assert(reopen.received == ReopenTask::COUNT);
+        // Noticed right away, not on the next tick
+        assert(reopen.worstLatencyUs < 10000);
+    }
+
+    cout << "OK" << endl;
+}
@@ -1,33 +1,83 @@
 # rsync bruce@wyse3040:/home/bruce/amp-server/build/capture.txt capture.txt
 
+import struct
+import sys
+
 filename = "ecr_qso_2.txt"
+if len(sys.argv) > 1:
+    filename = sys.argv[1]
+
+# Binary trace files (amp-server --tracefile, amp-replay --trace) start 
+# with this. The layout is described in src/BinaryTrace.h.
+TRACE_MAGIC = b"AMPTRACE"
+TRACE_HEADER_SIZE = 4096
+TRACE_MAX_EVENTS = 64
+
+def read_binary_trace(filename):
+    """
+    Returns the records of a binary trace file as lists of tokens in 
+    the same form as the lines of a text capture: [us, NAME, args..., callId]
+    """
+    result = []
+    with open(filename, 'rb') as file:
+        data = file.read()
+    magic, version, record_size, capacity, count = struct.unpack_from("<8sIIQQ", data, 0)
+    if magic != TRACE_MAGIC or version != 1:
+        raise Exception("Not a trace file")
+    events = {}
+    for i in range(0, TRACE_MAX_EVENTS):
+        name, arg_count = struct.unpack_from("<8sI", data, 64 + i * 16)
+        name = name.split(b"\0")[0].decode("ascii")
+        if name:
+            events[i] = (name, arg_count)
+    # The file is circular, the oldest record is at count % capacity
+    first = max(0, count - capacity)
+    for i in range(first, count):
+        offset = TRACE_HEADER_SIZE + (i % capacity) * record_size
+        us, event, thread, call_id, arg0, arg1 = struct.unpack_from("<QHHIqq", data, offset)
+        name, arg_count = events.get(event, ("E" + str(event), 2))
+        result.append([us, name] + [str(arg0), str(arg1)][0:arg_count] + [str(call_id)])
+    return result
+
+def read_text_capture(filename):
+    result = []
+    with open(filename, 'r') as file:
+        for line in file:
+            tokens = line.strip().split(",")
+            if len(tokens) < 2:
+                continue
+            clean_tokens = []
+            for token in tokens:
+                clean_tokens.append(token.strip())
+            # Make timestamp a number
+            clean_tokens[0] = int(clean_tokens[0])
+            result.append(clean_tokens)
+    return result
 
 buckets = { }
 low_bucket = 0
 high_bucket = 0
 first = True 
 
-with open(filename, 'r') as file:
-    for line in file:
-        tokens = line.strip().split(",")
-        if len(tokens) < 2:
-            continue
-        clean_tokens = []
-        for token in tokens:
-            clean_tokens.append(token.strip())
-        # Make timestamp a number
-        clean_tokens[0] = int(clean_tokens[0])
-        ms = clean_tokens[0] / 1000
-        bucket = int(ms / 5)
-        bucket = bucket * 5000
-        if not bucket in buckets:
-            buckets[bucket] = [ ]
-        buckets[bucket].append(clean_tokens)
-        if first or low_bucket > bucket:
-            low_bucket = bucket
-        if high_bucket < bucket:
-            high_bucket = bucket 
-        first = False 
+with open(filename, 'rb') as file:
+    is_binary = file.read(len(TRACE_MAGIC)) == TRACE_MAGIC
+if is_binary:
+    all_tokens = read_binary_trace(filename)
+else:
+    all_tokens = read_text_capture(filename)
+
+for clean_tokens in all_tokens:
+    ms = clean_tokens[0] / 1000
+    bucket = int(ms / 5)
+    bucket = bucket * 5000
+    if not bucket in buckets:
+        buckets[bucket] = [ ]
+    buckets[bucket].append(clean_tokens)
+    if first or low_bucket > bucket:
+        low_bucket = bucket
+    if high_bucket < bucket:
+        high_bucket = bucket 
+    first = False 
 
 sorted_buckets = {}
 # Sort all of the buckets chronologically